@@ -357,6 +357,9 @@ COMPILE_ASSERT(sizeof(ssize_t) == sizeof(int64_t));
 #define AUTOMATION_FIXED_FRAME_TIME    0.0167f
 #endif
 
+// Used for benchmarking, frames run before sampling starts, can be overridden with --warmup
+#define DEFAULT_BENCHMARK_WARMUP_FRAMES 32
+
 #if defined(TARGET_IOS) || (defined(ANDROID) && !defined(QUEST_VR)) || defined(NX64)
 #define ENABLE_FORGE_TOUCH_INPUT
 #endif
@@ -76,6 +76,64 @@ FORGE_API void dumpProfileData(const char* appName = "", uint32_t nMaxFrames = 6
 // Dump benchmark data to "benchmark-(data).txt" of recorded frames
 FORGE_API void dumpBenchmarkData(IApp::Settings* pSettings, const char* outFilename = "", const char* appName = "");
 
+typedef struct ProfileBenchmarkDesc
+{
+    // Profiler flips ignored before sampling starts, keeps pipeline creation and streaming spikes out of the statistics
+    uint32_t mWarmupFrames = DEFAULT_BENCHMARK_WARMUP_FRAMES;
+    // Frames sampled after the warm-up, capped to 16384 so runs without a frame limit (--no-auto-exit) stay bounded
+    uint32_t mMeasuredFrames = 128;
+} ProfileBenchmarkDesc;
+
+// Sample the Cpu frame time, every Cpu scope and every Gpu timer once per frame, plus memory high-water marks
+FORGE_API void beginProfileBenchmark(const ProfileBenchmarkDesc* pDesc);
+
+// True once the warm-up and all measured frames have been sampled
+FORGE_API bool isProfileBenchmarkFinished();
+
+// Dump "(outFilename)BenchmarkStats-(date).json" with mean, standard deviation, min, max, p50, p95 and p99 of every sampled
+// timer and ends the benchmark. Compare two dumps with Common_3/Tools/Benchmark/BenchmarkCompare.py
+FORGE_API void dumpProfileBenchmark(IApp::Settings* pSettings, const char* outFilename = "", const char* appName = "");
+
+typedef enum ProfileTraceFormat
+{
+    // Chrome Trace Event JSON, "(appName)Trace-(date).json", loads in chrome://tracing and ui.perfetto.dev
+    PROFILE_TRACE_FORMAT_CHROME_JSON = 0x1,
+    // Perfetto protobuf, "(appName)Trace-(date).perfetto-trace"
+    PROFILE_TRACE_FORMAT_PERFETTO = 0x2,
+    PROFILE_TRACE_FORMAT_ALL = PROFILE_TRACE_FORMAT_CHROME_JSON | PROFILE_TRACE_FORMAT_PERFETTO,
+} ProfileTraceFormat;
+
+// Export Cpu scopes, Gpu timestamp ranges, labels, counters and thread names of recorded frames as a trace, until a maximum amount
+// of frames. The logs are copied on the calling thread, the files are written on a background thread.
+FORGE_API void dumpProfileTrace(const char* appName = "", uint32_t nMaxFrames = 64, uint32_t formats = PROFILE_TRACE_FORMAT_ALL);
+
+// Block until a pending dumpProfileTrace export has been written
+FORGE_API void waitProfileTrace();
+
+typedef struct ProfileFlightRecorderDesc
+{
+    // Chunk files are "(pName)-NNN.pfr" in RD_LOG, reused in a ring. Pinned chunks are kept in "(pName)-Pinned-(date)-NNN.pfr"
+    const char* pName = "FlightRecorder";
+    // Frames compressed into one chunk, at most PROFILE_MAX_FRAME_HISTORY - PROFILE_GPU_FRAME_DELAY - 3.
+    // A chunk is closed early once its logs reach half of mMaxChunkSize
+    uint32_t    mFramesPerChunk = 64;
+    // Disk usage is bounded to (mChunkCount + mMaxPinnedChunks) * mMaxChunkSize bytes, larger chunks are dropped
+    uint32_t    mChunkCount = 16;
+    uint32_t    mMaxChunkSize = 4 * 1024 * 1024;
+    uint32_t    mMaxPinnedChunks = 12;
+    // Cpu frame times above this pin the chunks around the frame, 0 disables the trigger
+    float       mTriggerFrameTimeMs = 0.0f;
+} ProfileFlightRecorderDesc;
+
+// Continuously compress the Cpu/Gpu logs of recorded frames with LZ4 into a bounded ring of chunk files.
+// The overhead is reported through the "flightrecorder/*" profiler counters.
+// Convert the chunks to a Chrome JSON trace with Common_3/Tools/FlightRecorder/FlightRecorderDecoder.py.
+FORGE_API void startProfileFlightRecorder(const ProfileFlightRecorderDesc* pDesc);
+FORGE_API void stopProfileFlightRecorder();
+
+// Pin the chunks before, containing and after the current frame, pReason is stored in the chunk header
+FORGE_API void triggerProfileFlightRecorder(const char* pReason);
+
 //------ Profiler UI Widget --------//
 
 // Call once per frame before AppUI.Draw, draw requested Gpu profiler timers
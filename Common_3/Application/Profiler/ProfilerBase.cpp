@@ -43,6 +43,8 @@
 
 #include "../../Utilities/Math/Algorithms.h"
 
+#include "../../Utilities/ThirdParty/OpenSource/lz4/lz4.h"
+
 #include "../../Utilities/Interfaces/IMemory.h"
 
 #ifdef ENABLE_PROFILER
@@ -512,6 +514,12 @@ void profileCallbkDumpFramesToFile(void* pUserData)
     dumpProfileData(pRendererRef->pName, profileUtilDumpFramesFromFileEnum(gDumpFramesToFile));
 }
 
+void profileCallbkExportTrace(void* pUserData)
+{
+    UNREF_PARAM(pUserData);
+    dumpProfileTrace(pRendererRef->pName, profileUtilDumpFramesFromFileEnum(gDumpFramesToFile), PROFILE_TRACE_FORMAT_ALL);
+}
+
 void profileCallbkDumpFrames(void* pUserData)
 {
     UNREF_PARAM(pUserData);
@@ -1508,6 +1516,7 @@ void profileLoadWidgetUI(Profile& S)
         AGGREGATE_FRAMES,
         REFERENCE,
         DUMP,
+        EXPORT_TRACE,
         PAUSE_CHECKBOX,
         WIDGETS_MAX
     };
@@ -1592,6 +1601,16 @@ void profileLoadWidgetUI(Profile& S)
         uiSetWidgetOnEditedCallback(pDumpBase, nullptr, profileCallbkDumpFramesToFile);
     }
 
+    // Trace export, uses the dump frame count
+    UIWidget* pExportTraceBase = &columnWidgetBases[EXPORT_TRACE];
+    pExportTraceBase->mType = WIDGET_TYPE_BUTTON;
+    strcpy(pExportTraceBase->mLabel, "Export Trace");
+
+    ButtonWidget exportTrace = {};
+
+    pExportTraceBase->pWidget = &exportTrace; //-V506
+    pExportTraceBase->pOnEdited = profileCallbkExportTrace;
+
     // Pause checkbox
     UIWidget* pCheckboxBase = &columnWidgetBases[PAUSE_CHECKBOX];
     pCheckboxBase->mType = WIDGET_TYPE_CHECKBOX;
@@ -2162,6 +2181,8 @@ void unloadProfilerUI()
 
 void exitCpuProfiler()
 {
+    stopProfileFlightRecorder();
+    waitProfileTrace();
     ProfileOnThreadExit();
     ProfileWebServerStop();
     ProfileContextSwitchTraceStop();
@@ -2891,6 +2912,8 @@ void ProfileGetRange(uint32_t nPut, uint32_t nGet, uint32_t nRange[2][2])
 }
 
 void ProfileDumpToFile(Renderer* pRenderer);
+static void ProfileFlightRecorderFlip();
+static void ProfileBenchmarkFlip(uint64_t nFrameTicks);
 
 void ProfileFlipCpu()
 {
@@ -3191,6 +3214,7 @@ void ProfileFlipCpu()
                     }
                 }
             }
+            ProfileBenchmarkFlip(nFrameEndCpu - nFrameStartCpu);
             for (uint32_t i = 0; i < PROFILE_MAX_GRAPHS; ++i)
             {
                 if (S.Graph[i].nToken != PROFILE_INVALID_TOKEN)
@@ -3318,6 +3342,9 @@ void ProfileFlipCpu()
     }
     if (nNewActiveBars != S.nActiveBars)
         S.nActiveBars = nNewActiveBars;
+
+    if (S.nRunning || S.nForceEnable)
+        ProfileFlightRecorderFlip();
 }
 
 void flipProfiler()
@@ -4534,6 +4561,1296 @@ void dumpBenchmarkData(IApp::Settings* pSettings, const char* outFilename, const
     }
 }
 
+// Trace export. The frames are copied out of the thread logs under the profile mutex (a memcpy per thread plus label
+// resolution, since the label ring buffer is recycled), formatting and file IO happen on a background thread.
+struct ProfileTraceLog
+{
+    char             ThreadName[ProfileThreadLog::THREAD_MAX_LEN];
+    uint32_t         nGpu;
+    int64_t          nTickStart;
+    double           fTickToNs;
+    // stb_ds array, label entries store an offset + 1 into ProfileTraceSnapshot::pLabels (0 when the label was overwritten)
+    ProfileLogEntry* pEntries;
+};
+
+struct ProfileTraceCounter
+{
+    uint32_t nCounter;
+    int64_t  nValue;
+};
+
+struct ProfileTraceSnapshot
+{
+    char                 FileName[256];
+    char                 ProcessName[128];
+    uint32_t             nFormats;
+    uint32_t             nTotalTimers;
+    double               fCpuTickToNs;
+    // stb_ds array, cpu start tick of every frame plus the end of the last one
+    int64_t*             pFrameStart;
+    // stb_ds arrays
+    ProfileTraceLog*     pLogs;
+    char*                pLabels;
+    ProfileTraceCounter* pCounters;
+};
+
+struct ProfileTraceWriter
+{
+    ProfileWriteFileData        mData;
+    const ProfileTraceSnapshot* pSnapshot;
+    uint32_t                    nEvents;
+    // Perfetto scratch buffers for nested messages
+    bstring                     mPacket;
+    bstring                     mMessage;
+    bstring                     mNested;
+
+    void (*Track)(ProfileTraceWriter* pWriter, uint32_t nTrack, const char* pName, bool bThread);
+    void (*Begin)(ProfileTraceWriter* pWriter, uint32_t nTrack, double fNs, const char* pName, const char* pCategory);
+    void (*End)(ProfileTraceWriter* pWriter, uint32_t nTrack, double fNs);
+    void (*Instant)(ProfileTraceWriter* pWriter, uint32_t nTrack, double fNs, const char* pName);
+    void (*Counter)(ProfileTraceWriter* pWriter, uint32_t nCounter, double fNs, const char* pName, int64_t nValue);
+};
+
+static ThreadHandle gTraceExportThread = {};
+static bool         gTraceExportActive = false;
+
+static void ProfileTraceFree(ProfileTraceSnapshot* pSnapshot)
+{
+    for (ptrdiff_t i = 0; i < arrlen(pSnapshot->pLogs); ++i)
+    {
+        arrfree(pSnapshot->pLogs[i].pEntries);
+    }
+    arrfree(pSnapshot->pLogs);
+    arrfree(pSnapshot->pFrameStart);
+    arrfree(pSnapshot->pLabels);
+    arrfree(pSnapshot->pCounters);
+    tf_free(pSnapshot);
+}
+
+// Must be called with the profile mutex held
+static ProfileTraceSnapshot* ProfileTraceCapture(uint32_t nMaxFrames)
+{
+    Profile& S = g_Profile;
+
+    uint32_t nNumFrames = (PROFILE_MAX_FRAME_HISTORY - PROFILE_GPU_FRAME_DELAY - 3); // leave a few to not overwrite
+    nNumFrames = ProfileMin(nNumFrames, nMaxFrames);
+    if (!nNumFrames)
+        return NULL;
+
+    const uint32_t nFirstFrame = (S.nFrameCurrent + PROFILE_MAX_FRAME_HISTORY - nNumFrames) % PROFILE_MAX_FRAME_HISTORY;
+    const uint32_t nLastFrame = (nFirstFrame + nNumFrames) % PROFILE_MAX_FRAME_HISTORY;
+
+    ProfileTraceSnapshot* pSnapshot = (ProfileTraceSnapshot*)tf_calloc(1, sizeof(ProfileTraceSnapshot));
+    pSnapshot->nTotalTimers = S.nTotalTimers;
+    pSnapshot->fCpuTickToNs = 1e9 / (double)ProfileTicksPerSecondCpu();
+
+    for (uint32_t i = 0; i <= nNumFrames; ++i)
+    {
+        arrpush(pSnapshot->pFrameStart, S.Frames[(nFirstFrame + i) % PROFILE_MAX_FRAME_HISTORY].nFrameStartCpu);
+    }
+
+    for (uint32_t j = 0; j < PROFILE_MAX_THREADS; ++j)
+    {
+        ProfileThreadLog* pLog = S.Pool[j];
+        if (!pLog || !pLog->Log)
+            continue;
+
+        const uint32_t nLogStart = S.Frames[nFirstFrame].nLogStart[j];
+        const uint32_t nLogEnd = S.Frames[nLastFrame].nLogStart[j];
+        const uint32_t nCount = (nLogEnd + PROFILE_BUFFER_SIZE - nLogStart) % PROFILE_BUFFER_SIZE;
+        if (!nCount)
+            continue;
+
+        double fTickToNs = pSnapshot->fCpuTickToNs;
+        if (pLog->nGpu)
+        {
+            const uint64_t nTicksPerSecondGpu = getGpuProfileTicksPerSecond(pLog->nGpuToken);
+            if (!nTicksPerSecondGpu || !S.Frames[nFirstFrame].nFrameStartGpu[j])
+                continue;
+            fTickToNs = 1e9 / (double)nTicksPerSecondGpu;
+        }
+
+        ProfileTraceLog* pTraceLog = arraddnptr(pSnapshot->pLogs, 1);
+        memset(pTraceLog, 0, sizeof(*pTraceLog));
+        snprintf(pTraceLog->ThreadName, sizeof(pTraceLog->ThreadName), "%s", pLog->ThreadName);
+        pTraceLog->nGpu = pLog->nGpu;
+        // Gpu ticks are not calibrated against the cpu clock, both timelines start at the first frame like in the html dump
+        pTraceLog->nTickStart = pLog->nGpu ? S.Frames[nFirstFrame].nFrameStartGpu[j] : S.Frames[nFirstFrame].nFrameStartCpu;
+        pTraceLog->fTickToNs = fTickToNs;
+
+        arrsetlen(pTraceLog->pEntries, nCount);
+        const uint32_t nFirstPart = ProfileMin(nCount, (uint32_t)PROFILE_BUFFER_SIZE - nLogStart);
+        memcpy(pTraceLog->pEntries, &pLog->Log[nLogStart], nFirstPart * sizeof(ProfileLogEntry));
+        memcpy(pTraceLog->pEntries + nFirstPart, &pLog->Log[0], (nCount - nFirstPart) * sizeof(ProfileLogEntry));
+
+        for (uint32_t k = 0; k < nCount; ++k)
+        {
+            ProfileLogEntry& Entry = pTraceLog->pEntries[k];
+            uint32_t         nLogType = (uint32_t)ProfileLogType(Entry);
+            if (nLogType != P_LOG_LABEL && nLogType != P_LOG_LABEL_LITERAL)
+                continue;
+
+            const char* pLabelName = ProfileGetLabel(nLogType, ProfileLogGetTick(Entry));
+            uint64_t    nOffset = 0;
+            if (pLabelName)
+            {
+                nOffset = (uint64_t)arrlen(pSnapshot->pLabels) + 1;
+                size_t nLength = strlen(pLabelName) + 1;
+                memcpy(arraddnptr(pSnapshot->pLabels, nLength), pLabelName, nLength);
+            }
+            Entry = ProfileLogSetTick(Entry, (int64_t)nOffset);
+        }
+    }
+
+    for (uint32_t i = 0; i < S.nNumCounters; ++i)
+    {
+        ProfileTraceCounter Counter = { i, (int64_t)tfrg_atomic64_load_relaxed(&S.Counters[i]) };
+        arrpush(pSnapshot->pCounters, Counter);
+    }
+
+    return pSnapshot;
+}
+
+static void ProfileTraceEmit(ProfileTraceWriter* pWriter)
+{
+    const Profile&              S = g_Profile;
+    const ProfileTraceSnapshot* pSnapshot = pWriter->pSnapshot;
+    const uint32_t              nNumLogs = (uint32_t)arrlen(pSnapshot->pLogs);
+    const uint32_t              nNumFrames = (uint32_t)arrlen(pSnapshot->pFrameStart) - 1;
+    const int64_t               nTickStart = pSnapshot->pFrameStart[0];
+    const double                fEndNs = (double)(pSnapshot->pFrameStart[nNumFrames] - nTickStart) * pSnapshot->fCpuTickToNs;
+
+    for (uint32_t i = 0; i < nNumLogs; ++i)
+    {
+        pWriter->Track(pWriter, i, pSnapshot->pLogs[i].ThreadName, !pSnapshot->pLogs[i].nGpu);
+    }
+
+    // Frame boundaries get their own track after the thread logs
+    const uint32_t nFrameTrack = nNumLogs;
+    pWriter->Track(pWriter, nFrameTrack, "Frames", false);
+    for (uint32_t i = 0; i < nNumFrames; ++i)
+    {
+        char FrameName[32];
+        snprintf(FrameName, sizeof(FrameName), "Frame %u", i);
+        pWriter->Begin(pWriter, nFrameTrack, (double)(pSnapshot->pFrameStart[i] - nTickStart) * pSnapshot->fCpuTickToNs, FrameName,
+                       "Frame");
+        pWriter->End(pWriter, nFrameTrack, (double)(pSnapshot->pFrameStart[i + 1] - nTickStart) * pSnapshot->fCpuTickToNs);
+    }
+
+    uint32_t* pStack = NULL;
+    for (uint32_t i = 0; i < nNumLogs; ++i)
+    {
+        const ProfileTraceLog* pLog = &pSnapshot->pLogs[i];
+        double                 fLastNs = 0.0;
+        arrsetlen(pStack, 0);
+
+        for (ptrdiff_t k = 0; k < arrlen(pLog->pEntries); ++k)
+        {
+            const ProfileLogEntry Entry = pLog->pEntries[k];
+            const uint32_t        nLogType = (uint32_t)ProfileLogType(Entry);
+            const uint32_t        nTimerIndex = (uint32_t)ProfileLogTimerIndex(Entry);
+
+            if (nLogType == P_LOG_ENTER || nLogType == P_LOG_LEAVE)
+            {
+                if (nTimerIndex >= pSnapshot->nTotalTimers)
+                    continue;
+
+                fLastNs = (double)ProfileLogTickDifference(pLog->nTickStart, Entry) * pLog->fTickToNs;
+                if (nLogType == P_LOG_ENTER)
+                {
+                    arrpush(pStack, nTimerIndex);
+                    pWriter->Begin(pWriter, i, fLastNs, S.TimerInfo[nTimerIndex].pName,
+                                   S.GroupInfo[S.TimerInfo[nTimerIndex].nGroupIndex].pName);
+                }
+                // Scopes entered before the first frame have no begin, skip their leave
+                else if (arrlen(pStack) && arrlast(pStack) == nTimerIndex)
+                {
+                    arrpop(pStack);
+                    pWriter->End(pWriter, i, fLastNs);
+                }
+            }
+            else if (nLogType == P_LOG_LABEL || nLogType == P_LOG_LABEL_LITERAL)
+            {
+                // Labels don't carry a tick, they belong to the scope logged right before them
+                const uint64_t nOffset = (uint64_t)ProfileLogGetTick(Entry);
+                if (nOffset)
+                    pWriter->Instant(pWriter, i, fLastNs, &pSnapshot->pLabels[nOffset - 1]);
+            }
+        }
+
+        // Close scopes still open at the end of the last frame
+        while (arrlen(pStack))
+        {
+            arrpop(pStack);
+            pWriter->End(pWriter, i, ProfileMax(fLastNs, fEndNs));
+        }
+    }
+    arrfree(pStack);
+
+    for (ptrdiff_t i = 0; i < arrlen(pSnapshot->pCounters); ++i)
+    {
+        const ProfileTraceCounter& Counter = pSnapshot->pCounters[i];
+        pWriter->Counter(pWriter, Counter.nCounter, fEndNs, S.CounterInfo[Counter.nCounter].pName, Counter.nValue);
+    }
+}
+
+static void ProfileTraceJsonString(ProfileWriteCallback CB, void* Handle, const char* pString)
+{
+    ProfilePrintString(CB, Handle, "\"");
+    for (const char* pChar = pString; *pChar; ++pChar)
+    {
+        const unsigned char c = (unsigned char)*pChar;
+        if (c == '"' || c == '\\')
+        {
+            char Escaped[2] = { '\\', (char)c };
+            CB(Handle, sizeof(Escaped), Escaped);
+        }
+        else if (c < 0x20)
+        {
+            ProfilePrintf(CB, Handle, "\\u%04x", c);
+        }
+        else
+        {
+            CB(Handle, 1, pChar);
+        }
+    }
+    ProfilePrintString(CB, Handle, "\"");
+}
+
+static void ProfileTraceJsonEvent(ProfileTraceWriter* pWriter, const char* pPhase, uint32_t nTrack, double fNs)
+{
+    ProfilePrintf(ProfileWriteFile, &pWriter->mData, "%s{\"ph\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f", pWriter->nEvents ? ",\n" : "",
+                  pPhase, nTrack + 1, fNs / 1000.0);
+    pWriter->nEvents++;
+}
+
+static void ProfileTraceJsonTrack(ProfileTraceWriter* pWriter, uint32_t nTrack, const char* pName, bool bThread)
+{
+    UNREF_PARAM(bThread);
+    ProfileTraceJsonEvent(pWriter, "M", nTrack, 0.0);
+    ProfilePrintString(ProfileWriteFile, &pWriter->mData, ",\"name\":\"thread_name\",\"args\":{\"name\":");
+    ProfileTraceJsonString(ProfileWriteFile, &pWriter->mData, pName);
+    ProfilePrintString(ProfileWriteFile, &pWriter->mData, "}}");
+    ProfileTraceJsonEvent(pWriter, "M", nTrack, 0.0);
+    ProfilePrintf(ProfileWriteFile, &pWriter->mData, ",\"name\":\"thread_sort_index\",\"args\":{\"sort_index\":%u}}", nTrack);
+}
+
+static void ProfileTraceJsonBegin(ProfileTraceWriter* pWriter, uint32_t nTrack, double fNs, const char* pName, const char* pCategory)
+{
+    ProfileTraceJsonEvent(pWriter, "B", nTrack, fNs);
+    ProfilePrintString(ProfileWriteFile, &pWriter->mData, ",\"name\":");
+    ProfileTraceJsonString(ProfileWriteFile, &pWriter->mData, pName);
+    ProfilePrintString(ProfileWriteFile, &pWriter->mData, ",\"cat\":");
+    ProfileTraceJsonString(ProfileWriteFile, &pWriter->mData, pCategory);
+    ProfilePrintString(ProfileWriteFile, &pWriter->mData, "}");
+}
+
+static void ProfileTraceJsonEnd(ProfileTraceWriter* pWriter, uint32_t nTrack, double fNs)
+{
+    ProfileTraceJsonEvent(pWriter, "E", nTrack, fNs);
+    ProfilePrintString(ProfileWriteFile, &pWriter->mData, "}");
+}
+
+static void ProfileTraceJsonInstant(ProfileTraceWriter* pWriter, uint32_t nTrack, double fNs, const char* pName)
+{
+    ProfileTraceJsonEvent(pWriter, "i", nTrack, fNs);
+    ProfilePrintString(ProfileWriteFile, &pWriter->mData, ",\"s\":\"t\",\"name\":");
+    ProfileTraceJsonString(ProfileWriteFile, &pWriter->mData, pName);
+    ProfilePrintString(ProfileWriteFile, &pWriter->mData, "}");
+}
+
+static void ProfileTraceJsonCounter(ProfileTraceWriter* pWriter, uint32_t nCounter, double fNs, const char* pName, int64_t nValue)
+{
+    UNREF_PARAM(nCounter);
+    ProfileTraceJsonEvent(pWriter, "C", 0, fNs);
+    ProfilePrintString(ProfileWriteFile, &pWriter->mData, ",\"name\":");
+    ProfileTraceJsonString(ProfileWriteFile, &pWriter->mData, pName);
+    ProfilePrintf(ProfileWriteFile, &pWriter->mData, ",\"args\":{\"value\":%lld}}", (long long)nValue);
+}
+
+static void ProfileTraceWriteJson(ProfileTraceWriter* pWriter)
+{
+    pWriter->Track = ProfileTraceJsonTrack;
+    pWriter->Begin = ProfileTraceJsonBegin;
+    pWriter->End = ProfileTraceJsonEnd;
+    pWriter->Instant = ProfileTraceJsonInstant;
+    pWriter->Counter = ProfileTraceJsonCounter;
+
+    ProfilePrintString(ProfileWriteFile, &pWriter->mData, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    ProfileTraceJsonEvent(pWriter, "M", 0, 0.0);
+    ProfilePrintString(ProfileWriteFile, &pWriter->mData, ",\"name\":\"process_name\",\"args\":{\"name\":");
+    ProfileTraceJsonString(ProfileWriteFile, &pWriter->mData, pWriter->pSnapshot->ProcessName);
+    ProfilePrintString(ProfileWriteFile, &pWriter->mData, "}}");
+
+    ProfileTraceEmit(pWriter);
+
+    ProfilePrintString(ProfileWriteFile, &pWriter->mData, "\n]}\n");
+}
+
+// Minimal protobuf encoding of perfetto/trace/trace.proto, only the fields used below
+#define PROFILE_PROTO_VARINT                  0
+#define PROFILE_PROTO_LENGTH_DELIMITED        2
+
+#define PROFILE_PERFETTO_TRACE_PACKET         1
+#define PROFILE_PERFETTO_PACKET_TIMESTAMP     8
+#define PROFILE_PERFETTO_PACKET_SEQUENCE_ID   10
+#define PROFILE_PERFETTO_PACKET_TRACK_EVENT   11
+#define PROFILE_PERFETTO_PACKET_FLAGS         13
+#define PROFILE_PERFETTO_PACKET_TRACK         60
+#define PROFILE_PERFETTO_TRACK_UUID           1
+#define PROFILE_PERFETTO_TRACK_NAME           2
+#define PROFILE_PERFETTO_TRACK_PROCESS        3
+#define PROFILE_PERFETTO_TRACK_THREAD         4
+#define PROFILE_PERFETTO_TRACK_PARENT_UUID    5
+#define PROFILE_PERFETTO_TRACK_COUNTER        8
+#define PROFILE_PERFETTO_PROCESS_PID          1
+#define PROFILE_PERFETTO_PROCESS_NAME         6
+#define PROFILE_PERFETTO_THREAD_PID           1
+#define PROFILE_PERFETTO_THREAD_TID           2
+#define PROFILE_PERFETTO_THREAD_NAME          5
+#define PROFILE_PERFETTO_EVENT_TYPE           9
+#define PROFILE_PERFETTO_EVENT_TRACK_UUID     11
+#define PROFILE_PERFETTO_EVENT_CATEGORIES     22
+#define PROFILE_PERFETTO_EVENT_NAME           23
+#define PROFILE_PERFETTO_EVENT_COUNTER_VALUE  30
+#define PROFILE_PERFETTO_TYPE_SLICE_BEGIN     1
+#define PROFILE_PERFETTO_TYPE_SLICE_END       2
+#define PROFILE_PERFETTO_TYPE_INSTANT         3
+#define PROFILE_PERFETTO_TYPE_COUNTER         4
+#define PROFILE_PERFETTO_INCREMENTAL_CLEARED  1
+#define PROFILE_PERFETTO_SEQUENCE             1
+#define PROFILE_PERFETTO_PID                  1
+#define PROFILE_PERFETTO_PROCESS_TRACK        1
+#define PROFILE_PERFETTO_THREAD_TRACK(i)      (0x100 + (uint64_t)(i))
+#define PROFILE_PERFETTO_COUNTER_TRACK(i)     (0x100000 + (uint64_t)(i))
+
+static void ProfileProtoVarint(bstring* pOut, uint64_t nValue)
+{
+    unsigned char Buffer[10];
+    int           nSize = 0;
+    do
+    {
+        Buffer[nSize] = (unsigned char)(nValue & 0x7f);
+        nValue >>= 7;
+        Buffer[nSize++] |= nValue ? 0x80 : 0;
+    } while (nValue);
+    bcatblk(pOut, Buffer, nSize);
+}
+
+static void ProfileProtoUInt(bstring* pOut, uint32_t nField, uint64_t nValue)
+{
+    ProfileProtoVarint(pOut, (nField << 3) | PROFILE_PROTO_VARINT);
+    ProfileProtoVarint(pOut, nValue);
+}
+
+static void ProfileProtoBytes(bstring* pOut, uint32_t nField, const void* pData, size_t nSize)
+{
+    ProfileProtoVarint(pOut, (nField << 3) | PROFILE_PROTO_LENGTH_DELIMITED);
+    ProfileProtoVarint(pOut, nSize);
+    if (nSize)
+        bcatblk(pOut, pData, (int)nSize);
+}
+
+static void ProfileProtoString(bstring* pOut, uint32_t nField, const char* pString)
+{
+    ProfileProtoBytes(pOut, nField, pString, strlen(pString));
+}
+
+static void ProfileProtoMessage(bstring* pOut, uint32_t nField, const bstring* pMessage)
+{
+    ProfileProtoBytes(pOut, nField, bdata(pMessage), (size_t)blength(pMessage));
+}
+
+// Wraps pWriter->mMessage as a TracePacket field and appends the packet to the file
+static void ProfilePerfettoPacket(ProfileTraceWriter* pWriter, uint32_t nField, double fNs, bool bFirst)
+{
+    btrunc(&pWriter->mPacket, 0);
+    ProfileProtoUInt(&pWriter->mPacket, PROFILE_PERFETTO_PACKET_TIMESTAMP, (uint64_t)ProfileMax(fNs, 0.0));
+    ProfileProtoUInt(&pWriter->mPacket, PROFILE_PERFETTO_PACKET_SEQUENCE_ID, PROFILE_PERFETTO_SEQUENCE);
+    if (bFirst)
+        ProfileProtoUInt(&pWriter->mPacket, PROFILE_PERFETTO_PACKET_FLAGS, PROFILE_PERFETTO_INCREMENTAL_CLEARED);
+    ProfileProtoMessage(&pWriter->mPacket, nField, &pWriter->mMessage);
+
+    btrunc(&pWriter->mNested, 0);
+    ProfileProtoMessage(&pWriter->mNested, PROFILE_PERFETTO_TRACE_PACKET, &pWriter->mPacket);
+    ProfileWriteFile(&pWriter->mData, (size_t)blength(&pWriter->mNested), bdata(&pWriter->mNested));
+    pWriter->nEvents++;
+}
+
+static void ProfilePerfettoTrack(ProfileTraceWriter* pWriter, uint32_t nTrack, const char* pName, bool bThread)
+{
+    btrunc(&pWriter->mMessage, 0);
+    ProfileProtoUInt(&pWriter->mMessage, PROFILE_PERFETTO_TRACK_UUID, PROFILE_PERFETTO_THREAD_TRACK(nTrack));
+    if (bThread)
+    {
+        btrunc(&pWriter->mNested, 0);
+        ProfileProtoUInt(&pWriter->mNested, PROFILE_PERFETTO_THREAD_PID, PROFILE_PERFETTO_PID);
+        ProfileProtoUInt(&pWriter->mNested, PROFILE_PERFETTO_THREAD_TID, nTrack + 1);
+        ProfileProtoString(&pWriter->mNested, PROFILE_PERFETTO_THREAD_NAME, pName);
+        ProfileProtoMessage(&pWriter->mMessage, PROFILE_PERFETTO_TRACK_THREAD, &pWriter->mNested);
+    }
+    else
+    {
+        ProfileProtoString(&pWriter->mMessage, PROFILE_PERFETTO_TRACK_NAME, pName);
+        ProfileProtoUInt(&pWriter->mMessage, PROFILE_PERFETTO_TRACK_PARENT_UUID, PROFILE_PERFETTO_PROCESS_TRACK);
+    }
+    ProfilePerfettoPacket(pWriter, PROFILE_PERFETTO_PACKET_TRACK, 0.0, false);
+}
+
+static void ProfilePerfettoEvent(ProfileTraceWriter* pWriter, uint64_t nTrackUuid, uint32_t nType, const char* pName)
+{
+    btrunc(&pWriter->mMessage, 0);
+    ProfileProtoUInt(&pWriter->mMessage, PROFILE_PERFETTO_EVENT_TYPE, nType);
+    ProfileProtoUInt(&pWriter->mMessage, PROFILE_PERFETTO_EVENT_TRACK_UUID, nTrackUuid);
+    if (pName)
+        ProfileProtoString(&pWriter->mMessage, PROFILE_PERFETTO_EVENT_NAME, pName);
+}
+
+static void ProfilePerfettoBegin(ProfileTraceWriter* pWriter, uint32_t nTrack, double fNs, const char* pName, const char* pCategory)
+{
+    ProfilePerfettoEvent(pWriter, PROFILE_PERFETTO_THREAD_TRACK(nTrack), PROFILE_PERFETTO_TYPE_SLICE_BEGIN, pName);
+    ProfileProtoString(&pWriter->mMessage, PROFILE_PERFETTO_EVENT_CATEGORIES, pCategory);
+    ProfilePerfettoPacket(pWriter, PROFILE_PERFETTO_PACKET_TRACK_EVENT, fNs, false);
+}
+
+static void ProfilePerfettoEnd(ProfileTraceWriter* pWriter, uint32_t nTrack, double fNs)
+{
+    ProfilePerfettoEvent(pWriter, PROFILE_PERFETTO_THREAD_TRACK(nTrack), PROFILE_PERFETTO_TYPE_SLICE_END, NULL);
+    ProfilePerfettoPacket(pWriter, PROFILE_PERFETTO_PACKET_TRACK_EVENT, fNs, false);
+}
+
+static void ProfilePerfettoInstant(ProfileTraceWriter* pWriter, uint32_t nTrack, double fNs, const char* pName)
+{
+    ProfilePerfettoEvent(pWriter, PROFILE_PERFETTO_THREAD_TRACK(nTrack), PROFILE_PERFETTO_TYPE_INSTANT, pName);
+    ProfilePerfettoPacket(pWriter, PROFILE_PERFETTO_PACKET_TRACK_EVENT, fNs, false);
+}
+
+static void ProfilePerfettoCounter(ProfileTraceWriter* pWriter, uint32_t nCounter, double fNs, const char* pName, int64_t nValue)
+{
+    // Each counter is sampled once, its track descriptor goes right before the value
+    btrunc(&pWriter->mMessage, 0);
+    ProfileProtoUInt(&pWriter->mMessage, PROFILE_PERFETTO_TRACK_UUID, PROFILE_PERFETTO_COUNTER_TRACK(nCounter));
+    ProfileProtoString(&pWriter->mMessage, PROFILE_PERFETTO_TRACK_NAME, pName);
+    ProfileProtoUInt(&pWriter->mMessage, PROFILE_PERFETTO_TRACK_PARENT_UUID, PROFILE_PERFETTO_PROCESS_TRACK);
+    ProfileProtoBytes(&pWriter->mMessage, PROFILE_PERFETTO_TRACK_COUNTER, NULL, 0);
+    ProfilePerfettoPacket(pWriter, PROFILE_PERFETTO_PACKET_TRACK, 0.0, false);
+
+    ProfilePerfettoEvent(pWriter, PROFILE_PERFETTO_COUNTER_TRACK(nCounter), PROFILE_PERFETTO_TYPE_COUNTER, NULL);
+    ProfileProtoUInt(&pWriter->mMessage, PROFILE_PERFETTO_EVENT_COUNTER_VALUE, (uint64_t)nValue);
+    ProfilePerfettoPacket(pWriter, PROFILE_PERFETTO_PACKET_TRACK_EVENT, fNs, false);
+}
+
+static void ProfileTraceWritePerfetto(ProfileTraceWriter* pWriter)
+{
+    pWriter->Track = ProfilePerfettoTrack;
+    pWriter->Begin = ProfilePerfettoBegin;
+    pWriter->End = ProfilePerfettoEnd;
+    pWriter->Instant = ProfilePerfettoInstant;
+    pWriter->Counter = ProfilePerfettoCounter;
+
+    btrunc(&pWriter->mNested, 0);
+    ProfileProtoUInt(&pWriter->mNested, PROFILE_PERFETTO_PROCESS_PID, PROFILE_PERFETTO_PID);
+    ProfileProtoString(&pWriter->mNested, PROFILE_PERFETTO_PROCESS_NAME, pWriter->pSnapshot->ProcessName);
+    btrunc(&pWriter->mMessage, 0);
+    ProfileProtoUInt(&pWriter->mMessage, PROFILE_PERFETTO_TRACK_UUID, PROFILE_PERFETTO_PROCESS_TRACK);
+    ProfileProtoMessage(&pWriter->mMessage, PROFILE_PERFETTO_TRACK_PROCESS, &pWriter->mNested);
+    ProfilePerfettoPacket(pWriter, PROFILE_PERFETTO_PACKET_TRACK, 0.0, true);
+
+    ProfileTraceEmit(pWriter);
+}
+
+static void ProfileTraceWriteFile(const ProfileTraceSnapshot* pSnapshot, const char* pExtension,
+                                  void (*pWrite)(ProfileTraceWriter* pWriter))
+{
+    char Name[sizeof(pSnapshot->FileName) + 32];
+    snprintf(Name, sizeof(Name), "%s%s", pSnapshot->FileName, pExtension);
+
+    ProfileTraceWriter Writer = {};
+    Writer.pSnapshot = pSnapshot;
+    Writer.mData.mBuffer = bempty();
+    Writer.mPacket = bempty();
+    Writer.mMessage = bempty();
+    Writer.mNested = bempty();
+    if (fsOpenStreamFromPath(RD_LOG, Name, FM_WRITE, &Writer.mData.mStream))
+    {
+        pWrite(&Writer);
+        ProfileWriteFileFlush(&Writer.mData);
+        fsCloseStream(&Writer.mData.mStream);
+        LOGF(LogLevel::eINFO, "Profile trace written to '%s' (%u events)", Name, Writer.nEvents);
+    }
+    else
+    {
+        LOGF(LogLevel::eERROR, "Failed to open profile trace file '%s'", Name);
+    }
+    bdestroy(&Writer.mNested);
+    bdestroy(&Writer.mMessage);
+    bdestroy(&Writer.mPacket);
+    bdestroy(&Writer.mData.mBuffer);
+}
+
+static void ProfileTraceThreadFunc(void* pData)
+{
+    ProfileTraceSnapshot* pSnapshot = (ProfileTraceSnapshot*)pData;
+    if (pSnapshot->nFormats & PROFILE_TRACE_FORMAT_CHROME_JSON)
+        ProfileTraceWriteFile(pSnapshot, ".json", ProfileTraceWriteJson);
+    if (pSnapshot->nFormats & PROFILE_TRACE_FORMAT_PERFETTO)
+        ProfileTraceWriteFile(pSnapshot, ".perfetto-trace", ProfileTraceWritePerfetto);
+    ProfileTraceFree(pSnapshot);
+}
+
+// Takes the export in flight under the profile mutex, but joins it after releasing the mutex so the profiler keeps recording
+// while the export thread writes its files
+static void ProfileTraceJoin()
+{
+    ThreadHandle thread = {};
+    {
+        MutexLock lock(ProfileMutex());
+        if (!gTraceExportActive)
+            return;
+        thread = gTraceExportThread;
+        gTraceExportActive = false;
+    }
+    joinThread(thread);
+}
+
+void dumpProfileTrace(const char* appName, uint32_t nMaxFrames, uint32_t formats)
+{
+    if (!g_Profile.nRunning || !(formats & PROFILE_TRACE_FORMAT_ALL))
+        return;
+
+    // Only one export in flight, the previous one has to finish before its thread handle is reused
+    ProfileTraceJoin();
+
+    ProfileTraceSnapshot* pSnapshot = NULL;
+    bool                  bStarted = false;
+    {
+        MutexLock lock(ProfileMutex());
+
+        pSnapshot = ProfileTraceCapture(nMaxFrames);
+        if (!pSnapshot)
+            return;
+
+        time_t t = time(0);
+        char   time[64];
+        size_t timeLen = strftime(time, sizeof(time), R"(Trace-%Y-%m-%d-%H.%M.%S)", localtime(&t));
+        ASSERT(timeLen < 64);
+
+        snprintf(pSnapshot->FileName, sizeof(pSnapshot->FileName), "%s%s", appName, time);
+        strncpy(pSnapshot->ProcessName, appName[0] ? appName : "Profile", sizeof(pSnapshot->ProcessName) - 1);
+        pSnapshot->nFormats = formats;
+
+        // Another thread may have started an export since the join, it keeps the thread handle then
+        if (!gTraceExportActive)
+        {
+            ThreadDesc desc = {};
+            desc.pFunc = ProfileTraceThreadFunc;
+            desc.pData = pSnapshot;
+            strncpy(desc.mThreadName, "ProfilerTraceExport", sizeof(desc.mThreadName));
+            gTraceExportActive = initThread(&desc, &gTraceExportThread);
+            bStarted = gTraceExportActive;
+        }
+    }
+
+    if (!bStarted)
+    {
+        // No thread available, write on the calling thread
+        ProfileTraceThreadFunc(pSnapshot);
+    }
+}
+
+void waitProfileTrace() { ProfileTraceJoin(); }
+
+// Flight recorder. Every chunk of frames is captured like a trace export inside ProfileFlipCpu, a background thread serializes,
+// LZ4 compresses and writes it into a ring of chunk files.
+//
+// Chunk file: ProfileFlightChunkHeader followed by an LZ4 block which decompresses to
+//   double fCpuTickToNs, uint32_t nFrames, nTimers, nThreads, nLabelBytes, nCounters
+//   int64_t FrameStartCpu[nFrames + 1]
+//   nTimers x { "group\0name\0" }
+//   nThreads x { char ThreadName[64], uint32_t nGpu, int64_t nTickStart, double fTickToNs, uint32_t nEntries,
+//                ProfileLogEntry Entries[nEntries] }, label entries store an offset + 1 into the label bytes
+//   char Labels[nLabelBytes]
+//   nCounters x { "name\0", int64_t nValue }
+// Common_3/Tools/FlightRecorder/FlightRecorderDecoder.py converts chunk files to the Chrome JSON trace of dumpProfileTrace.
+#define PROFILE_FLIGHT_MAGIC            0x30524650 // "PFR0"
+#define PROFILE_FLIGHT_VERSION          1
+#define PROFILE_FLIGHT_MAX_QUEUED       4
+#define PROFILE_FLIGHT_CHUNK_PINNED     0x1
+#define PROFILE_FLIGHT_CHUNK_TRIGGERED  0x2
+#define PROFILE_FLIGHT_CHUNK_PIN_BEFORE 0x4
+#define PROFILE_FLIGHT_TIME_LEN         64
+
+struct ProfileFlightChunkHeader
+{
+    uint32_t nMagic;
+    uint32_t nVersion;
+    uint64_t nSequence;
+    uint32_t nFlags;
+    uint32_t nFrames;
+    uint32_t nCompressedSize;
+    uint32_t nUncompressedSize;
+    char     Reason[64];
+};
+
+struct ProfileFlightChunk
+{
+    ProfileTraceSnapshot* pSnapshot;
+    uint64_t              nSequence;
+    uint32_t              nFlags;
+    char                  Reason[64];
+};
+
+struct ProfileFlightRecorder
+{
+    ProfileFlightRecorderDesc mDesc;
+    char                      Name[128];
+    // Name, '-' and the pinned timestamp
+    char                      PinnedName[128 + 1 + PROFILE_FLIGHT_TIME_LEN];
+    bool                      bActive;
+
+    // Owned by the writer thread
+    ThreadHandle        mThread;
+    Mutex               mMutex;
+    ConditionVariable   mCondition;
+    ProfileFlightChunk* pQueue; // stb_ds array
+    bool                bExit;
+    uint8_t*            pRaw;      // stb_ds array
+    uint8_t*            pBlob;     // stb_ds array, header + compressed chunk
+    uint8_t*            pPrevious; // stb_ds array, last chunk written, pinned with PROFILE_FLIGHT_CHUNK_PIN_BEFORE
+    uint64_t*           pSlotSize; // stb_ds array
+    uint64_t            nDiskSize;
+    uint32_t            nPinned;
+
+    // Updated in ProfileFlipCpu with the profile mutex held
+    uint32_t nFrames;
+    uint64_t nChunkBytes;
+    int64_t  nRecorderTicks;
+    uint64_t nSequence;
+    uint32_t nPinAfter;
+    bool     bTrigger;
+    char     Reason[64];
+
+    ProfileToken nOverheadCounter;
+    ProfileToken nWriterCounter;
+    ProfileToken nChunkSizeCounter;
+    ProfileToken nDiskSizeCounter;
+    ProfileToken nPinnedCounter;
+    ProfileToken nDroppedCounter;
+};
+
+static ProfileFlightRecorder gFlightRecorder = {};
+
+static void ProfileFlightWrite(uint8_t** ppOut, const void* pData, size_t nSize) { memcpy(arraddnptr(*ppOut, nSize), pData, nSize); }
+
+static void ProfileFlightWriteString(uint8_t** ppOut, const char* pString) { ProfileFlightWrite(ppOut, pString, strlen(pString) + 1); }
+
+static void ProfileFlightSerialize(const ProfileTraceSnapshot* pSnapshot, uint8_t** ppOut)
+{
+    const Profile& S = g_Profile;
+    const uint32_t nFrames = (uint32_t)arrlen(pSnapshot->pFrameStart) - 1;
+    const uint32_t nThreads = (uint32_t)arrlen(pSnapshot->pLogs);
+    const uint32_t nLabelBytes = (uint32_t)arrlen(pSnapshot->pLabels);
+    const uint32_t nCounters = (uint32_t)arrlen(pSnapshot->pCounters);
+
+    arrsetlen(*ppOut, 0);
+    ProfileFlightWrite(ppOut, &pSnapshot->fCpuTickToNs, sizeof(pSnapshot->fCpuTickToNs));
+    ProfileFlightWrite(ppOut, &nFrames, sizeof(nFrames));
+    ProfileFlightWrite(ppOut, &pSnapshot->nTotalTimers, sizeof(pSnapshot->nTotalTimers));
+    ProfileFlightWrite(ppOut, &nThreads, sizeof(nThreads));
+    ProfileFlightWrite(ppOut, &nLabelBytes, sizeof(nLabelBytes));
+    ProfileFlightWrite(ppOut, &nCounters, sizeof(nCounters));
+    ProfileFlightWrite(ppOut, pSnapshot->pFrameStart, (nFrames + 1) * sizeof(int64_t));
+
+    for (uint32_t i = 0; i < pSnapshot->nTotalTimers; ++i)
+    {
+        ProfileFlightWriteString(ppOut, S.GroupInfo[S.TimerInfo[i].nGroupIndex].pName);
+        ProfileFlightWriteString(ppOut, S.TimerInfo[i].pName);
+    }
+
+    for (uint32_t i = 0; i < nThreads; ++i)
+    {
+        const ProfileTraceLog* pLog = &pSnapshot->pLogs[i];
+        const uint32_t         nEntries = (uint32_t)arrlen(pLog->pEntries);
+        ProfileFlightWrite(ppOut, pLog->ThreadName, sizeof(pLog->ThreadName));
+        ProfileFlightWrite(ppOut, &pLog->nGpu, sizeof(pLog->nGpu));
+        ProfileFlightWrite(ppOut, &pLog->nTickStart, sizeof(pLog->nTickStart));
+        ProfileFlightWrite(ppOut, &pLog->fTickToNs, sizeof(pLog->fTickToNs));
+        ProfileFlightWrite(ppOut, &nEntries, sizeof(nEntries));
+        ProfileFlightWrite(ppOut, pLog->pEntries, nEntries * sizeof(ProfileLogEntry));
+    }
+
+    if (nLabelBytes)
+        ProfileFlightWrite(ppOut, pSnapshot->pLabels, nLabelBytes);
+
+    for (uint32_t i = 0; i < nCounters; ++i)
+    {
+        ProfileFlightWriteString(ppOut, S.CounterInfo[pSnapshot->pCounters[i].nCounter].pName);
+        ProfileFlightWrite(ppOut, &pSnapshot->pCounters[i].nValue, sizeof(int64_t));
+    }
+}
+
+static bool ProfileFlightWriteFile(const char* pName, const uint8_t* pData)
+{
+    FileStream Stream = {};
+    if (!fsOpenStreamFromPath(RD_LOG, pName, FM_WRITE, &Stream))
+    {
+        LOGF(LogLevel::eERROR, "Failed to open flight recorder chunk '%s'", pName);
+        return false;
+    }
+    const size_t nSize = (size_t)arrlen(pData);
+    const bool   bResult = fsWriteToStream(&Stream, pData, nSize) == nSize;
+    fsCloseStream(&Stream);
+    return bResult;
+}
+
+static void ProfileFlightWritePinned(ProfileFlightRecorder* pRecorder, const uint8_t* pData)
+{
+    if (pRecorder->nPinned >= pRecorder->mDesc.mMaxPinnedChunks)
+    {
+        if (pRecorder->nPinned++ == pRecorder->mDesc.mMaxPinnedChunks)
+            LOGF(LogLevel::eWARNING, "Flight recorder reached its limit of %u pinned chunks, ignoring further triggers",
+                 pRecorder->mDesc.mMaxPinnedChunks);
+        return;
+    }
+
+    char Name[sizeof(pRecorder->PinnedName) + 16];
+    snprintf(Name, sizeof(Name), "%s-%03u.pfr", pRecorder->PinnedName, pRecorder->nPinned);
+    if (ProfileFlightWriteFile(Name, pData))
+    {
+        pRecorder->nPinned++;
+        ProfileCounterSet(pRecorder->nPinnedCounter, pRecorder->nPinned);
+        LOGF(LogLevel::eINFO, "Flight recorder pinned chunk '%s'", Name);
+    }
+}
+
+static void ProfileFlightWriteChunk(ProfileFlightRecorder* pRecorder, const ProfileFlightChunk* pChunk)
+{
+    const int64_t nTickStart = P_TICK();
+
+    ProfileFlightSerialize(pChunk->pSnapshot, &pRecorder->pRaw);
+
+    const int nRawSize = (int)arrlen(pRecorder->pRaw);
+    arrsetlen(pRecorder->pBlob, sizeof(ProfileFlightChunkHeader) + LZ4_compressBound(nRawSize));
+    const int nCompressedSize = LZ4_compress_default((const char*)pRecorder->pRaw, (char*)pRecorder->pBlob + sizeof(ProfileFlightChunkHeader),
+                                                     nRawSize, (int)arrlen(pRecorder->pBlob) - (int)sizeof(ProfileFlightChunkHeader));
+    const size_t nBlobSize = sizeof(ProfileFlightChunkHeader) + (size_t)nCompressedSize;
+    if (nCompressedSize <= 0 || nBlobSize > pRecorder->mDesc.mMaxChunkSize)
+    {
+        LOGF(LogLevel::eWARNING, "Flight recorder dropped chunk %llu of %u bytes, the limit is %u bytes",
+             (unsigned long long)pChunk->nSequence, (uint32_t)nBlobSize, pRecorder->mDesc.mMaxChunkSize);
+        ProfileCounterAdd(pRecorder->nDroppedCounter, 1);
+        arrsetlen(pRecorder->pPrevious, 0);
+        return;
+    }
+    arrsetlen(pRecorder->pBlob, nBlobSize);
+
+    ProfileFlightChunkHeader Header = {};
+    Header.nMagic = PROFILE_FLIGHT_MAGIC;
+    Header.nVersion = PROFILE_FLIGHT_VERSION;
+    Header.nSequence = pChunk->nSequence;
+    Header.nFlags = pChunk->nFlags & (PROFILE_FLIGHT_CHUNK_PINNED | PROFILE_FLIGHT_CHUNK_TRIGGERED);
+    Header.nFrames = (uint32_t)arrlen(pChunk->pSnapshot->pFrameStart) - 1;
+    Header.nCompressedSize = (uint32_t)nCompressedSize;
+    Header.nUncompressedSize = (uint32_t)nRawSize;
+    memcpy(Header.Reason, pChunk->Reason, sizeof(Header.Reason));
+    memcpy(pRecorder->pBlob, &Header, sizeof(Header));
+
+    const uint32_t nSlot = (uint32_t)(pChunk->nSequence % pRecorder->mDesc.mChunkCount);
+    char           Name[sizeof(pRecorder->Name) + 16];
+    snprintf(Name, sizeof(Name), "%s-%03u.pfr", pRecorder->Name, nSlot);
+    if (ProfileFlightWriteFile(Name, pRecorder->pBlob))
+    {
+        pRecorder->nDiskSize += nBlobSize - pRecorder->pSlotSize[nSlot];
+        pRecorder->pSlotSize[nSlot] = nBlobSize;
+    }
+
+    if ((pChunk->nFlags & PROFILE_FLIGHT_CHUNK_PIN_BEFORE) && arrlen(pRecorder->pPrevious))
+        ProfileFlightWritePinned(pRecorder, pRecorder->pPrevious);
+    if (pChunk->nFlags & PROFILE_FLIGHT_CHUNK_PINNED)
+        ProfileFlightWritePinned(pRecorder, pRecorder->pBlob);
+
+    uint8_t* pPrevious = pRecorder->pPrevious;
+    pRecorder->pPrevious = pRecorder->pBlob;
+    pRecorder->pBlob = pPrevious;
+
+    const float fWriterMs = ProfileTickToMsMultiplier(ProfileTicksPerSecondCpu()) * (P_TICK() - nTickStart);
+    ProfileCounterSet(pRecorder->nWriterCounter, (int64_t)(fWriterMs * 1000.f));
+    ProfileCounterSet(pRecorder->nChunkSizeCounter, (int64_t)nBlobSize);
+    ProfileCounterSet(pRecorder->nDiskSizeCounter, (int64_t)pRecorder->nDiskSize);
+}
+
+static void ProfileFlightThreadFunc(void* pData)
+{
+    ProfileFlightRecorder* pRecorder = (ProfileFlightRecorder*)pData;
+    for (;;)
+    {
+        acquireMutex(&pRecorder->mMutex);
+        while (!arrlen(pRecorder->pQueue) && !pRecorder->bExit)
+            waitConditionVariable(&pRecorder->mCondition, &pRecorder->mMutex, TIMEOUT_INFINITE);
+        if (!arrlen(pRecorder->pQueue))
+        {
+            releaseMutex(&pRecorder->mMutex);
+            break;
+        }
+        ProfileFlightChunk Chunk = pRecorder->pQueue[0];
+        arrdel(pRecorder->pQueue, 0);
+        releaseMutex(&pRecorder->mMutex);
+
+        ProfileFlightWriteChunk(pRecorder, &Chunk);
+        ProfileTraceFree(Chunk.pSnapshot);
+    }
+}
+
+// Called at the end of ProfileFlipCpu with the profile mutex held, once per recorded frame
+static void ProfileFlightRecorderFlip()
+{
+    ProfileFlightRecorder* pRecorder = &gFlightRecorder;
+    if (!pRecorder->bActive)
+        return;
+
+    Profile&      S = g_Profile;
+    const int64_t nTickStart = P_TICK();
+
+    // The frame before nFrameCurrent just got complete, Gpu included
+    const uint32_t nFrame = (S.nFrameCurrent + PROFILE_MAX_FRAME_HISTORY - 1) % PROFILE_MAX_FRAME_HISTORY;
+    const uint32_t nFrameNext = S.nFrameCurrent;
+    for (uint32_t j = 0; j < PROFILE_MAX_THREADS; ++j)
+    {
+        if (S.Pool[j])
+        {
+            const uint32_t nCount = (S.Frames[nFrameNext].nLogStart[j] + PROFILE_BUFFER_SIZE - S.Frames[nFrame].nLogStart[j]) %
+                                    PROFILE_BUFFER_SIZE;
+            pRecorder->nChunkBytes += nCount * sizeof(ProfileLogEntry);
+        }
+    }
+    pRecorder->nFrames++;
+
+    const float fFrameMs =
+        ProfileTickToMsMultiplier(ProfileTicksPerSecondCpu()) * (S.Frames[nFrameNext].nFrameStartCpu - S.Frames[nFrame].nFrameStartCpu);
+    if (pRecorder->mDesc.mTriggerFrameTimeMs > 0.0f && fFrameMs > pRecorder->mDesc.mTriggerFrameTimeMs && !pRecorder->bTrigger)
+    {
+        pRecorder->bTrigger = true;
+        snprintf(pRecorder->Reason, sizeof(pRecorder->Reason), "chunk frame %u took %.2fms", pRecorder->nFrames - 1, fFrameMs);
+    }
+
+    if (pRecorder->nFrames >= pRecorder->mDesc.mFramesPerChunk || pRecorder->nChunkBytes >= pRecorder->mDesc.mMaxChunkSize / 2)
+    {
+        ProfileFlightChunk Chunk = {};
+        Chunk.nSequence = pRecorder->nSequence++;
+        if (pRecorder->bTrigger)
+        {
+            Chunk.nFlags = PROFILE_FLIGHT_CHUNK_PINNED | PROFILE_FLIGHT_CHUNK_TRIGGERED | PROFILE_FLIGHT_CHUNK_PIN_BEFORE;
+            memcpy(Chunk.Reason, pRecorder->Reason, sizeof(Chunk.Reason));
+            pRecorder->nPinAfter = 1;
+            pRecorder->bTrigger = false;
+        }
+        else if (pRecorder->nPinAfter)
+        {
+            Chunk.nFlags = PROFILE_FLIGHT_CHUNK_PINNED;
+            pRecorder->nPinAfter--;
+        }
+
+        Chunk.pSnapshot = ProfileTraceCapture(pRecorder->nFrames);
+        if (Chunk.pSnapshot)
+        {
+            const int64_t nChunkTicks = arrlast(Chunk.pSnapshot->pFrameStart) - Chunk.pSnapshot->pFrameStart[0];
+
+            // Never stall the frame on the disk, drop the chunk when the writer falls behind
+            acquireMutex(&pRecorder->mMutex);
+            const bool bQueued = arrlen(pRecorder->pQueue) < PROFILE_FLIGHT_MAX_QUEUED;
+            if (bQueued)
+            {
+                arrpush(pRecorder->pQueue, Chunk);
+                wakeOneConditionVariable(&pRecorder->mCondition);
+            }
+            releaseMutex(&pRecorder->mMutex);
+
+            if (!bQueued)
+            {
+                ProfileTraceFree(Chunk.pSnapshot);
+                ProfileCounterAdd(pRecorder->nDroppedCounter, 1);
+            }
+
+            // Recorder time on this thread relative to the time of the frames it covers, in parts per million
+            const int64_t nRecorderTicks = pRecorder->nRecorderTicks + (P_TICK() - nTickStart);
+            if (nChunkTicks > 0)
+                ProfileCounterSet(pRecorder->nOverheadCounter, nRecorderTicks * 1000000 / nChunkTicks);
+        }
+
+        pRecorder->nFrames = 0;
+        pRecorder->nChunkBytes = 0;
+        pRecorder->nRecorderTicks = 0;
+        return;
+    }
+
+    pRecorder->nRecorderTicks += P_TICK() - nTickStart;
+}
+
+void startProfileFlightRecorder(const ProfileFlightRecorderDesc* pDesc)
+{
+    ASSERT(pDesc && pDesc->pName && pDesc->mFramesPerChunk && pDesc->mChunkCount && pDesc->mMaxChunkSize);
+
+    stopProfileFlightRecorder();
+
+    ProfileFlightRecorder* pRecorder = &gFlightRecorder;
+    // Counter tokens take the profile mutex, get them before the recorder is visible to ProfileFlipCpu
+    pRecorder->nOverheadCounter = ProfileGetCounterToken("flightrecorder/overhead_ppm");
+    pRecorder->nWriterCounter = ProfileGetCounterToken("flightrecorder/writer_us");
+    pRecorder->nChunkSizeCounter = ProfileGetCounterToken("flightrecorder/chunk_size");
+    pRecorder->nDiskSizeCounter = ProfileGetCounterToken("flightrecorder/disk_size");
+    pRecorder->nPinnedCounter = ProfileGetCounterToken("flightrecorder/pinned");
+    pRecorder->nDroppedCounter = ProfileGetCounterToken("flightrecorder/dropped");
+    // 1% of the frame time
+    ProfileCounterConfig("flightrecorder/overhead_ppm", PROFILE_COUNTER_FORMAT_DEFAULT, 10000, 0);
+    ProfileCounterConfig("flightrecorder/chunk_size", PROFILE_COUNTER_FORMAT_BYTES, pDesc->mMaxChunkSize, 0);
+    ProfileCounterConfig("flightrecorder/disk_size", PROFILE_COUNTER_FORMAT_BYTES,
+                         (int64_t)pDesc->mChunkCount * pDesc->mMaxChunkSize, 0);
+
+    // Chunks are captured from the frame history, frames further back than ProfileTraceCapture can reach would be lost
+    const uint32_t nMaxFramesPerChunk = PROFILE_MAX_FRAME_HISTORY - PROFILE_GPU_FRAME_DELAY - 3;
+    uint32_t       nFramesPerChunk = pDesc->mFramesPerChunk;
+    if (nFramesPerChunk > nMaxFramesPerChunk)
+    {
+        LOGF(LogLevel::eWARNING, "Flight recorder chunks are limited to %u frames, %u requested", nMaxFramesPerChunk, nFramesPerChunk);
+        nFramesPerChunk = nMaxFramesPerChunk;
+    }
+
+    MutexLock lock(ProfileMutex());
+
+    pRecorder->mDesc = *pDesc;
+    pRecorder->mDesc.mFramesPerChunk = nFramesPerChunk;
+    snprintf(pRecorder->Name, sizeof(pRecorder->Name), "%s", pDesc->pName);
+    pRecorder->mDesc.pName = pRecorder->Name;
+
+    time_t t = time(0);
+    char   time[PROFILE_FLIGHT_TIME_LEN];
+    size_t timeLen = strftime(time, sizeof(time), R"(Pinned-%Y-%m-%d-%H.%M.%S)", localtime(&t));
+    ASSERT(timeLen < sizeof(time));
+    int pinnedLen = snprintf(pRecorder->PinnedName, sizeof(pRecorder->PinnedName), "%s-%s", pRecorder->Name, time);
+    ASSERT(pinnedLen > 0 && pinnedLen < (int)sizeof(pRecorder->PinnedName));
+    UNREF_PARAM(pinnedLen);
+
+    arrsetlen(pRecorder->pSlotSize, pDesc->mChunkCount);
+    memset(pRecorder->pSlotSize, 0, pDesc->mChunkCount * sizeof(uint64_t));
+    pRecorder->nDiskSize = 0;
+    pRecorder->nPinned = 0;
+    pRecorder->nFrames = 0;
+    pRecorder->nChunkBytes = 0;
+    pRecorder->nRecorderTicks = 0;
+    pRecorder->nSequence = 0;
+    pRecorder->nPinAfter = 0;
+    pRecorder->bTrigger = false;
+    pRecorder->bExit = false;
+
+    initMutex(&pRecorder->mMutex);
+    initConditionVariable(&pRecorder->mCondition);
+
+    ThreadDesc desc = {};
+    desc.pFunc = ProfileFlightThreadFunc;
+    desc.pData = pRecorder;
+    strncpy(desc.mThreadName, "ProfilerFlightRecorder", sizeof(desc.mThreadName));
+    pRecorder->bActive = initThread(&desc, &pRecorder->mThread);
+    if (!pRecorder->bActive)
+    {
+        LOGF(LogLevel::eERROR, "Failed to start the flight recorder thread");
+        exitConditionVariable(&pRecorder->mCondition);
+        exitMutex(&pRecorder->mMutex);
+    }
+}
+
+void stopProfileFlightRecorder()
+{
+    ProfileFlightRecorder* pRecorder = &gFlightRecorder;
+    {
+        MutexLock lock(ProfileMutex());
+        if (!pRecorder->bActive)
+            return;
+        pRecorder->bActive = false;
+    }
+
+    // The writer drains the queue before exiting
+    acquireMutex(&pRecorder->mMutex);
+    pRecorder->bExit = true;
+    wakeOneConditionVariable(&pRecorder->mCondition);
+    releaseMutex(&pRecorder->mMutex);
+    joinThread(pRecorder->mThread);
+
+    exitConditionVariable(&pRecorder->mCondition);
+    exitMutex(&pRecorder->mMutex);
+    arrfree(pRecorder->pQueue);
+    arrfree(pRecorder->pRaw);
+    arrfree(pRecorder->pBlob);
+    arrfree(pRecorder->pPrevious);
+    arrfree(pRecorder->pSlotSize);
+}
+
+void triggerProfileFlightRecorder(const char* pReason)
+{
+    MutexLock              lock(ProfileMutex());
+    ProfileFlightRecorder* pRecorder = &gFlightRecorder;
+    if (!pRecorder->bActive || pRecorder->bTrigger)
+        return;
+    pRecorder->bTrigger = true;
+    strncpy(pRecorder->Reason, pReason ? pReason : "", sizeof(pRecorder->Reason) - 1);
+}
+
+// Benchmark statistics. Every measured flip appends the Cpu frame time and the frame time of every Cpu timer that ran,
+// Gpu timers are appended by the gpu profiler as their queries resolve. Statistics are only computed when dumping.
+#define PROFILE_BENCHMARK_GPU_MEMORY_INTERVAL 32
+#define PROFILE_BENCHMARK_MAX_MEASURED_FRAMES 16384
+
+#if defined(_WINDOWS) && !defined(XBOX)
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#elif defined(__APPLE__) || defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+struct ProfileBenchmark
+{
+    ProfileBenchmarkDesc mDesc;
+    bool                 bActive;
+    uint32_t             nWarmupFrames;
+    uint32_t             nMeasuredFrames;
+    // stb_ds arrays of per frame ticks
+    uint64_t*            pFrameTicks;
+    uint64_t*            pTimerTicks[PROFILE_MAX_TIMERS];
+    uint64_t             nPeakGpuUsedBytes;
+    uint64_t             nPeakGpuAllocatedBytes;
+};
+
+static ProfileBenchmark gProfileBenchmark = {};
+
+static bool ProfileBenchmarkMeasuring(const ProfileBenchmark* pBenchmark)
+{
+    return pBenchmark->bActive && pBenchmark->nWarmupFrames >= pBenchmark->mDesc.mWarmupFrames &&
+           pBenchmark->nMeasuredFrames < pBenchmark->mDesc.mMeasuredFrames;
+}
+
+static void ProfileBenchmarkSampleGpuMemory(ProfileBenchmark* pBenchmark)
+{
+    if (!pRendererRef)
+        return;
+
+    uint64_t nUsedBytes = 0;
+    uint64_t nAllocatedBytes = 0;
+    calculateMemoryUse(pRendererRef, &nUsedBytes, &nAllocatedBytes);
+    pBenchmark->nPeakGpuUsedBytes = ProfileMax(pBenchmark->nPeakGpuUsedBytes, nUsedBytes);
+    pBenchmark->nPeakGpuAllocatedBytes = ProfileMax(pBenchmark->nPeakGpuAllocatedBytes, nAllocatedBytes);
+}
+
+// Process peak resident set size, the os keeps the high-water mark so it only needs to be queried once
+static uint64_t ProfileBenchmarkPeakProcessMemory()
+{
+#if defined(_WINDOWS) && !defined(XBOX)
+    PROCESS_MEMORY_COUNTERS Counters = {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &Counters, sizeof(Counters)))
+        return (uint64_t)Counters.PeakWorkingSetSize;
+#elif defined(__APPLE__) || defined(__linux__)
+    struct rusage Usage = {};
+    if (getrusage(RUSAGE_SELF, &Usage) == 0)
+    {
+#if defined(__APPLE__)
+        return (uint64_t)Usage.ru_maxrss;
+#else
+        return (uint64_t)Usage.ru_maxrss * 1024;
+#endif
+    }
+#endif
+    return 0;
+}
+
+// Called from ProfileFlipCpu with the profile mutex held, after the Cpu timers of the completed frame were accumulated
+static void ProfileBenchmarkFlip(uint64_t nFrameTicks)
+{
+    ProfileBenchmark* pBenchmark = &gProfileBenchmark;
+    if (!pBenchmark->bActive)
+        return;
+
+    if (pBenchmark->nWarmupFrames < pBenchmark->mDesc.mWarmupFrames)
+    {
+        ++pBenchmark->nWarmupFrames;
+        return;
+    }
+    if (pBenchmark->nMeasuredFrames >= pBenchmark->mDesc.mMeasuredFrames)
+        return;
+
+    Profile& S = g_Profile;
+    arrpush(pBenchmark->pFrameTicks, nFrameTicks);
+    for (uint32_t i = 0; i < S.nTotalTimers; ++i)
+    {
+        if (S.GroupInfo[S.TimerInfo[i].nGroupIndex].Type == ProfileTokenTypeGpu || !S.Frame[i].nCount)
+            continue;
+        arrpush(pBenchmark->pTimerTicks[i], S.Frame[i].nTicks);
+    }
+
+    if (pBenchmark->nMeasuredFrames % PROFILE_BENCHMARK_GPU_MEMORY_INTERVAL == 0)
+        ProfileBenchmarkSampleGpuMemory(pBenchmark);
+    ++pBenchmark->nMeasuredFrames;
+}
+
+void ProfileBenchmarkGpuSample(uint32_t nTimerIndex, uint64_t nTicks)
+{
+    ProfileBenchmark* pBenchmark = &gProfileBenchmark;
+    if (ProfileBenchmarkMeasuring(pBenchmark))
+        arrpush(pBenchmark->pTimerTicks[nTimerIndex], nTicks);
+}
+
+static void ProfileBenchmarkReset(ProfileBenchmark* pBenchmark)
+{
+    arrfree(pBenchmark->pFrameTicks);
+    for (uint32_t i = 0; i < PROFILE_MAX_TIMERS; ++i)
+    {
+        arrfree(pBenchmark->pTimerTicks[i]);
+    }
+    *pBenchmark = {};
+}
+
+// Linear interpolation between the closest ranks
+static double ProfileBenchmarkPercentile(const uint64_t* pSorted, uint32_t nCount, double fPercentile)
+{
+    const double   fRank = fPercentile * (double)(nCount - 1);
+    const uint32_t nLow = (uint32_t)fRank;
+    const uint32_t nHigh = ProfileMin(nLow + 1, nCount - 1);
+    return (double)pSorted[nLow] + ((double)pSorted[nHigh] - (double)pSorted[nLow]) * (fRank - (double)nLow);
+}
+
+static void ProfileBenchmarkWriteTimer(ProfileWriteFileData* pData, bool* pFirst, const char* pGroup, const char* pName,
+                                       const char* pType, const uint64_t* pTicks, double fTickToMs)
+{
+    const uint32_t nCount = (uint32_t)arrlenu(pTicks);
+    if (!nCount)
+        return;
+
+    uint64_t* pSorted = NULL;
+    arrsetlen(pSorted, nCount);
+    memcpy(pSorted, pTicks, nCount * sizeof(uint64_t));
+    sortUInt64(pSorted, nCount);
+
+    double fMean = 0.0;
+    for (uint32_t i = 0; i < nCount; ++i)
+    {
+        fMean += (double)pSorted[i];
+    }
+    fMean /= (double)nCount;
+    double fVariance = 0.0;
+    for (uint32_t i = 0; i < nCount; ++i)
+    {
+        const double fDelta = (double)pSorted[i] - fMean;
+        fVariance += fDelta * fDelta;
+    }
+    // Sample standard deviation, the compare tool runs Welch's t-test on it
+    const double fStdDev = nCount > 1 ? sqrt(fVariance / (double)(nCount - 1)) : 0.0;
+
+    ProfilePrintString(ProfileWriteFile, pData, *pFirst ? "\n" : ",\n");
+    *pFirst = false;
+    ProfilePrintString(ProfileWriteFile, pData, "{ \"Group\": ");
+    ProfileTraceJsonString(ProfileWriteFile, pData, pGroup);
+    ProfilePrintString(ProfileWriteFile, pData, ", \"Name\": ");
+    ProfileTraceJsonString(ProfileWriteFile, pData, pName);
+    ProfilePrintf(ProfileWriteFile, pData,
+                  ", \"Type\": \"%s\", \"Samples\": %u, \"Mean\": %0.6f, \"StdDev\": %0.6f, \"Min\": %0.6f, \"Max\": %0.6f, "
+                  "\"P50\": %0.6f, \"P95\": %0.6f, \"P99\": %0.6f }",
+                  pType, nCount, fTickToMs * fMean, fTickToMs * fStdDev, fTickToMs * (double)pSorted[0],
+                  fTickToMs * (double)pSorted[nCount - 1], fTickToMs * ProfileBenchmarkPercentile(pSorted, nCount, 0.5),
+                  fTickToMs * ProfileBenchmarkPercentile(pSorted, nCount, 0.95),
+                  fTickToMs * ProfileBenchmarkPercentile(pSorted, nCount, 0.99));
+
+    arrfree(pSorted);
+}
+
+void beginProfileBenchmark(const ProfileBenchmarkDesc* pDesc)
+{
+    ASSERT(pDesc && pDesc->mMeasuredFrames);
+
+    MutexLock         lock(ProfileMutex());
+    ProfileBenchmark* pBenchmark = &gProfileBenchmark;
+    ProfileBenchmarkReset(pBenchmark);
+    pBenchmark->mDesc = *pDesc;
+    pBenchmark->mDesc.mMeasuredFrames = ProfileMin(pDesc->mMeasuredFrames, (uint32_t)PROFILE_BENCHMARK_MAX_MEASURED_FRAMES);
+    arrsetcap(pBenchmark->pFrameTicks, pBenchmark->mDesc.mMeasuredFrames);
+    pBenchmark->bActive = true;
+}
+
+bool isProfileBenchmarkFinished()
+{
+    MutexLock lock(ProfileMutex());
+    return !ProfileBenchmarkMeasuring(&gProfileBenchmark);
+}
+
+void dumpProfileBenchmark(IApp::Settings* pSettings, const char* outFilename, const char* appName)
+{
+    MutexLock         lock(ProfileMutex());
+    ProfileBenchmark* pBenchmark = &gProfileBenchmark;
+    if (!pBenchmark->bActive)
+        return;
+
+    if (pBenchmark->nMeasuredFrames < pBenchmark->mDesc.mMeasuredFrames)
+    {
+        LOGF(LogLevel::eWARNING, "Benchmark ended after %u of %u measured frames (%u of %u warm-up frames)", pBenchmark->nMeasuredFrames,
+             pBenchmark->mDesc.mMeasuredFrames, pBenchmark->nWarmupFrames, pBenchmark->mDesc.mWarmupFrames);
+    }
+    ProfileBenchmarkSampleGpuMemory(pBenchmark);
+
+    time_t t = time(0);
+    char   Name[1024];
+    char   time[64];
+    size_t timeLen = strftime(time, sizeof(time), R"(BenchmarkStats-%Y-%m-%d-%H.%M.%S.json)", localtime(&t));
+    ASSERT(timeLen < 64);
+    snprintf(Name, sizeof(Name), "%s%s", outFilename, time);
+
+    ProfileWriteFileData Data = {};
+    Data.mBuffer = bempty();
+    if (!fsOpenStreamFromPath(RD_LOG, Name, FM_WRITE, &Data.mStream))
+    {
+        LOGF(LogLevel::eERROR, "Failed to open benchmark file '%s'", Name);
+        bdestroy(&Data.mBuffer);
+        ProfileBenchmarkReset(pBenchmark);
+        return;
+    }
+
+    const Profile& S = g_Profile;
+    ProfilePrintString(ProfileWriteFile, &Data, "{\n\"Application\": ");
+    ProfileTraceJsonString(ProfileWriteFile, &Data, appName);
+    ProfilePrintf(ProfileWriteFile, &Data, ",\n\"Width\": %d,\n\"Height\": %d,\n", pSettings->mWidth, pSettings->mHeight);
+    ProfilePrintString(ProfileWriteFile, &Data, "\"GpuName\": ");
+    ProfileTraceJsonString(ProfileWriteFile, &Data, S.pGpuDesc ? S.pGpuDesc->mGpuVendorPreset.mGpuName : "");
+    ProfilePrintf(ProfileWriteFile, &Data, ",\n\"WarmupFrames\": %u,\n\"MeasuredFrames\": %u,\n", pBenchmark->nWarmupFrames,
+                  pBenchmark->nMeasuredFrames);
+
+    // High-water marks in bytes, 0 when unavailable on the platform
+    uint64_t nPeakTrackedBytes = 0;
+#ifdef ENABLE_MEMORY_TRACKING
+    nPeakTrackedBytes = memGetStatistics().peakReportedMemory;
+#endif
+    ProfilePrintf(ProfileWriteFile, &Data,
+                  "\"Memory\": { \"PeakProcessBytes\": %" PRIu64 ", \"PeakTrackedBytes\": %" PRIu64 ", \"PeakGpuUsedBytes\": %" PRIu64
+                  ", \"PeakGpuAllocatedBytes\": %" PRIu64 " },\n",
+                  ProfileBenchmarkPeakProcessMemory(), nPeakTrackedBytes, pBenchmark->nPeakGpuUsedBytes, pBenchmark->nPeakGpuAllocatedBytes);
+
+    ProfilePrintString(ProfileWriteFile, &Data, "\"Timers\": [");
+    bool         bFirst = true;
+    const double fCpuTickToMs = ProfileTickToMsMultiplier(ProfileTicksPerSecondCpu());
+    ProfileBenchmarkWriteTimer(&Data, &bFirst, "Cpu", "Frame", "Cpu", pBenchmark->pFrameTicks, fCpuTickToMs);
+    for (uint32_t i = 0; i < S.nTotalTimers; ++i)
+    {
+        const ProfileGroupInfo& Group = S.GroupInfo[S.TimerInfo[i].nGroupIndex];
+        const bool              bGpu = Group.Type == ProfileTokenTypeGpu;
+        const double            fTickToMs =
+            bGpu ? ProfileTickToMsMultiplier(getGpuProfileTicksPerSecond(Group.nGpuProfileToken)) : fCpuTickToMs;
+        ProfileBenchmarkWriteTimer(&Data, &bFirst, Group.pName, S.TimerInfo[i].pName, bGpu ? "Gpu" : "Cpu", pBenchmark->pTimerTicks[i],
+                                   fTickToMs);
+    }
+    ProfilePrintString(ProfileWriteFile, &Data, "\n]\n}\n");
+
+    ProfileWriteFileFlush(&Data);
+    fsCloseStream(&Data.mStream);
+    bdestroy(&Data.mBuffer);
+    LOGF(LogLevel::eINFO, "Benchmark statistics of %u frames written to '%s'", pBenchmark->nMeasuredFrames, Name);
+
+    ProfileBenchmarkReset(pBenchmark);
+}
+
 #ifdef ENABLE_PROFILER_WEBSERVER
 uint32_t ProfileWebServerPort()
 {
@@ -5207,6 +6524,14 @@ void  exitProfiler() {}
 void  flipProfiler() {}
 void  dumpProfileData(const char* /*appName*/, uint32_t /*nMaxFrames*/) {}
 void  dumpBenchmarkData(IApp::Settings* /*pSettings*/, const char* /*outFilename*/, const char* /*appName*/) {}
+void  dumpProfileTrace(const char* /*appName*/, uint32_t /*nMaxFrames*/, uint32_t /*formats*/) {}
+void  waitProfileTrace() {}
+void  beginProfileBenchmark(const ProfileBenchmarkDesc* /*pDesc*/) {}
+bool  isProfileBenchmarkFinished() { return true; }
+void  dumpProfileBenchmark(IApp::Settings* /*pSettings*/, const char* /*outFilename*/, const char* /*appName*/) {}
+void  startProfileFlightRecorder(const ProfileFlightRecorderDesc* /*pDesc*/) {}
+void  stopProfileFlightRecorder() {}
+void  triggerProfileFlightRecorder(const char* /*pReason*/) {}
 void  setAggregateFrames(uint32_t /*nFrames*/) {}
 float getCpuProfileTime(const char* /*pGroup*/, const char* /*pName*/, ThreadID* /*pThreadID*/) { return -1.0f; }
 float getCpuProfileAvgTime(const char* /*pGroup*/, const char* /*pName*/, ThreadID* /*pThreadID*/) { return -1.0f; }
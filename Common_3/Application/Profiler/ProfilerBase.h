@@ -580,6 +580,8 @@ PROFILE_API uint32_t ProfileWebServerPort();
 
 PROFILE_API uint64_t ProfileEnterGpu(ProfileToken nToken, uint64_t nTick, ProfileThreadLog* pLog);
 PROFILE_API void     ProfileLeaveGpu(ProfileToken nToken, uint64_t nTick, ProfileThreadLog* pLog);
+// Gpu timers resolve frames after the Cpu flip, the gpu profiler feeds their per frame time to a running benchmark
+PROFILE_API void     ProfileBenchmarkGpuSample(uint32_t nTimerIndex, uint64_t nTicks);
 
 PROFILE_API const char* ProfileGetThreadName();
 
@@ -667,6 +667,7 @@ int AndroidMain(void* param, IApp* app)
 #ifdef AUTOMATED_TESTING
     uint32_t testingFrameCount = 0;
     uint32_t targetFrameCount = DEFAULT_AUTOMATION_FRAME_COUNT;
+    uint32_t warmupFrameCount = DEFAULT_BENCHMARK_WARMUP_FRAMES;
 #endif
 
     initCpuInfo(&gCpu, pMainJavaEnv);
@@ -754,6 +755,12 @@ int AndroidMain(void* param, IApp* app)
     if (pSettings->mBenchmarking)
     {
         setAggregateFrames(targetFrameCount / 2);
+
+        // The frame count of -b includes the warm-up, at least half of the frames are measured
+        ProfileBenchmarkDesc benchmarkDesc = {};
+        benchmarkDesc.mWarmupFrames = min(warmupFrameCount, targetFrameCount / 2);
+        benchmarkDesc.mMeasuredFrames = targetFrameCount - benchmarkDesc.mWarmupFrames;
+        beginProfileBenchmark(&benchmarkDesc);
     }
 #endif
 
@@ -966,7 +973,9 @@ int AndroidMain(void* param, IApp* app)
     if (pSettings->mBenchmarking)
     {
         dumpBenchmarkData(pSettings, benchmarkOutput, pApp->GetName());
+        dumpProfileBenchmark(pSettings, benchmarkOutput, pApp->GetName());
         dumpProfileData(benchmarkOutput, targetFrameCount);
+        dumpProfileTrace(benchmarkOutput, targetFrameCount);
     }
 #endif
 
@@ -177,6 +177,7 @@ static IFileSystem gBundledFileIO = {
     NULL,
     NULL,
     NULL,
+    NULL,
 };
 
 IFileSystem* pSystemFileIO = &gBundledFileIO;
@@ -394,6 +394,7 @@ int WindowsMain(int argc, char** argv, IApp* app)
 #if defined(AUTOMATED_TESTING)
     uint32_t frameCounter = 0;
     uint32_t targetFrameCount = DEFAULT_AUTOMATION_FRAME_COUNT;
+    uint32_t warmupFrameCount = DEFAULT_BENCHMARK_WARMUP_FRAMES;
 #endif
 
     initCpuInfo(&gCpu);
@@ -458,6 +459,11 @@ int WindowsMain(int argc, char** argv, IApp* app)
             if (i + 1 < argc && isdigit(*argv[i + 1]))
                 targetFrameCount = min(max(atoi(argv[i + 1]), 32), 512);
         }
+        // Frames run before benchmark sampling starts, -w is taken by unit tests which read the window width
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc && isdigit(*argv[i + 1]))
+        {
+            warmupFrameCount = min(atoi(argv[i + 1]), 1024);
+        }
         // Run forever, this is useful when the app will control when the automated tests are over
         else if (strcmp(argv[i], "--no-auto-exit") == 0)
         {
@@ -527,7 +533,15 @@ int WindowsMain(int argc, char** argv, IApp* app)
 
 #ifdef AUTOMATED_TESTING
     if (pSettings->mBenchmarking)
+    {
         setAggregateFrames(targetFrameCount / 2);
+
+        // The frame count of -b includes the warm-up, at least half of the frames are measured
+        ProfileBenchmarkDesc benchmarkDesc = {};
+        benchmarkDesc.mWarmupFrames = min(warmupFrameCount, targetFrameCount / 2);
+        benchmarkDesc.mMeasuredFrames = targetFrameCount - benchmarkDesc.mWarmupFrames;
+        beginProfileBenchmark(&benchmarkDesc);
+    }
 #endif
 
     bool    baseSubsystemAppDrawn = false;
@@ -673,7 +687,9 @@ int WindowsMain(int argc, char** argv, IApp* app)
     if (pSettings->mBenchmarking)
     {
         dumpBenchmarkData(pSettings, benchmarkOutput, pApp->GetName());
+        dumpProfileBenchmark(pSettings, benchmarkOutput, pApp->GetName());
         dumpProfileData(benchmarkOutput, targetFrameCount);
+        dumpProfileTrace(benchmarkOutput, targetFrameCount);
     }
 #endif
 
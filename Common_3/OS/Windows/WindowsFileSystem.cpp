@@ -442,6 +442,7 @@ static IFileSystem gWindowsFileIO = {
     ioWindowsFsMemoryMap,
     ioWindowsGetSystemHandle,
     NULL,
+    NULL,
 };
 
 IFileSystem* pSystemFileIO = &gWindowsFileIO;
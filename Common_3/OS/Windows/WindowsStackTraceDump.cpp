@@ -265,6 +265,10 @@ LONG WindowsStackTrace::Dump(EXCEPTION_POINTERS* pExceptionInfo)
 
     SymCleanup(process);
 
+    // The process terminates after we return, write out messages still queued for the asynchronous log thread
+    if (mInit)
+        flushLog();
+
     return EXCEPTION_EXECUTE_HANDLER;
 }
 #else
@@ -67,6 +67,17 @@ typedef enum RegisterMaterialResult
 
 // MARK: - Resource Loading
 
+typedef enum ResourceLoadPriority
+{
+    /// Requests of the same priority are processed in the order they were added
+    RESOURCE_LOAD_PRIORITY_NORMAL = 0,
+    /// Processed before all pending normal and low priority requests, e.g. resources needed by the current view
+    RESOURCE_LOAD_PRIORITY_HIGH,
+    /// Processed once no high or normal priority requests are pending, e.g. prefetching
+    RESOURCE_LOAD_PRIORITY_LOW,
+    RESOURCE_LOAD_PRIORITY_COUNT,
+} ResourceLoadPriority;
+
 typedef struct BufferLoadDesc
 {
     Buffer**    ppBuffer;
@@ -80,6 +91,8 @@ typedef struct BufferLoadDesc
     // Optional (if user provides staging buffer memory)
     Buffer*  pSrcBuffer;
     uint64_t mSrcOffset;
+
+    ResourceLoadPriority mPriority;
 } BufferLoadDesc;
 
 typedef struct TextureLoadDesc
@@ -105,6 +118,7 @@ typedef struct TextureLoadDesc
     TextureCreationFlags mCreationFlag;
     /// The texture file format (dds/ktx/...)
     TextureContainerType mContainer;
+    ResourceLoadPriority mPriority;
 } TextureLoadDesc;
 
 typedef struct BufferChunk
@@ -113,16 +127,58 @@ typedef struct BufferChunk
     uint32_t mSize;
 } BufferChunk;
 
+// Red-black tree links of a BufferChunkNode, one set per tree it belongs to
+typedef struct BufferChunkTreeLink
+{
+    uint32_t mParent;
+    uint32_t mChild[2];
+    uint32_t mRed;
+} BufferChunkTreeLink;
+
+// Unused chunk of a BufferChunkAllocator.
+// Nodes are referenced by their index in BufferChunkAllocator::pUnusedChunkNodes, index 0 is the tree sentinel and means 'none'.
+typedef struct BufferChunkNode
+{
+    BufferChunk         mChunk;
+    // Unused chunks sorted by offset
+    uint32_t            mPrev;
+    uint32_t            mNext;
+    // [0]: tree sorted by offset, [1]: tree sorted by size (then offset)
+    BufferChunkTreeLink mLink[2];
+} BufferChunkNode;
+
 // Structure used to sub-allocate chunks on a buffer, keeps track of free memory to handle new requests.
+// Unused chunks are indexed by offset and by size so that best-fit allocation, requested chunk allocation and coalescing of released
+// chunks are O(log n) in the number of unused chunks.
 // Interface to add/remove this allocator is currently private, could be made public if needed.
 typedef struct BufferChunkAllocator
 {
-    Buffer*      pBuffer;
-    uint32_t     mUsedChunkCount;
-    uint32_t     mSize;
-    BufferChunk* mUnusedChunks;
+    Buffer*          pBuffer;
+    uint32_t         mUsedChunkCount;
+    uint32_t         mSize;
+    // stb_ds array
+    BufferChunkNode* pUnusedChunkNodes;
+    uint32_t         mUnusedChunkRoot[2];
+    // First unused chunk in offset order, follow BufferChunkNode::mNext to iterate all of them
+    uint32_t         mFirstUnusedChunk;
+    // Released nodes of pUnusedChunkNodes, linked through BufferChunkNode::mNext
+    uint32_t         mFreeNode;
+    uint32_t         mUnusedChunkCount;
+    uint32_t         mUnusedSize;
 } BufferChunkAllocator;
 
+typedef struct BufferChunkAllocatorStats
+{
+    uint32_t mUsedChunkCount;
+    uint32_t mUnusedChunkCount;
+    // Total amount of unused memory, in bytes
+    uint32_t mUnusedSize;
+    // Biggest allocation that can succeed when no alignment is required
+    uint32_t mLargestUnusedChunk;
+    // 0 when all unused memory is contiguous, approaches 1 as it gets split in many small chunks
+    float    mFragmentation;
+} BufferChunkAllocatorStats;
+
 // Stores huge buffers that are then used to sub-allocate memory for each of the loaded meshes.
 // GeometryBuffer can be provided to GeometryLoadDesc::pGeometryBuffer when loading a mesh, sub-chunks will be allocated
 // by mIndex and mVertex allocators and return the BufferChunk(s) that where used in Geometry::mIndexBufferChunk and
@@ -336,6 +392,8 @@ typedef struct GeometryLoadDesc
 
     /// Used to convert data to desired state inside GeometryBuffer.
     GeometryBufferLayoutDesc* pGeometryBufferLayoutDesc;
+
+    ResourceLoadPriority mPriority;
 } GeometryLoadDesc;
 
 typedef struct BufferUpdateDesc
@@ -489,6 +547,10 @@ typedef struct ResourceLoaderDesc
     uint64_t mBufferSize;
     uint32_t mBufferCount;
     bool     mSingleThreaded;
+    // Number of ThreadSystem workers reading texture and geometry files ahead of the streamer thread.
+    // The streamer only parses the in-memory file and records copies. 0 reads files on the streamer thread.
+    // Ignored in single threaded mode.
+    uint32_t mIoThreadCount;
 #ifdef ENABLE_FORGE_MATERIALS
     bool mUseMaterials;
 #endif
@@ -557,6 +619,78 @@ FORGE_RENDERER_API void addGeometryBufferPart(BufferChunkAllocator* buffer, uint
 /// Buffer must be the one passed to claimGeometryBufferPart for this chunk.
 FORGE_RENDERER_API void removeGeometryBufferPart(BufferChunkAllocator* buffer, BufferChunk* chunk);
 
+/// Fragmentation stats of a geometry buffer allocator (GeometryBuffer::mIndex or GeometryBuffer::mVertex[i]).
+FORGE_RENDERER_API void getBufferChunkAllocatorStats(const BufferChunkAllocator* buffer, BufferChunkAllocatorStats* pOutStats);
+
+typedef struct GeometryBufferMove
+{
+    /// Index of the moved part in GeometryBufferMovePlanDesc::pParts
+    uint32_t    mPartIndex;
+    BufferChunk mSrc;
+    BufferChunk mDst;
+} GeometryBufferMove;
+
+typedef struct GeometryBufferMovePlanDesc
+{
+    /// Unused chunks of the allocator, sorted by offset
+    const BufferChunk* pUnusedChunks;
+    uint32_t           mUnusedChunkCount;
+    /// Parts that can be moved, in any order
+    const BufferChunk* pParts;
+    /// Optional, required alignment of each part (0 or 1 when there is none)
+    const uint32_t*    pAlignments;
+    uint32_t           mPartCount;
+    /// Maximum sum of the sizes of the planned moves, 0 means no limit
+    uint32_t           mMaxBytes;
+} GeometryBufferMovePlanDesc;
+
+/// Plans moves of parts into unused chunks closer to the start of the buffer, starting with the parts at the highest offsets, so that
+/// unused memory gathers at the end of the buffer. Destinations don't overlap any part nor each other, all moves can be copied at once.
+/// Only works on the given chunks, doesn't need a device. Returns the number of moves written to pOutMoves.
+FORGE_RENDERER_API uint32_t planGeometryBufferMoves(const GeometryBufferMovePlanDesc* pDesc, GeometryBufferMove* pOutMoves,
+                                                    uint32_t maxMoves);
+
+typedef struct GeometryBufferCompactionDesc
+{
+    GeometryBuffer* pGeometryBuffer;
+    /// Geometries loaded in pGeometryBuffer that can be moved
+    Geometry**      ppGeometries;
+    uint32_t        mGeometryCount;
+    /// Maximum amount of bytes copied by this compaction step across the index and vertex buffers, 0 means no limit
+    uint32_t        mMaxBytes;
+    /// Current state of the index and vertex buffers of pGeometryBuffer
+    ResourceState   mBufferState;
+} GeometryBufferCompactionDesc;
+
+typedef struct GeometryBufferCompactionMove
+{
+    Geometry*   pGeometry;
+    /// Vertex binding of the moved chunk, MAX_VERTEX_BINDINGS for the index buffer
+    uint32_t    mBinding;
+    BufferChunk mSrc;
+    BufferChunk mDst;
+} GeometryBufferCompactionMove;
+
+typedef struct GeometryBufferCompaction
+{
+    GeometryBuffer*               pGeometryBuffer;
+    /// stb_ds array
+    GeometryBufferCompactionMove* pMoves;
+    uint32_t                      mMovedBytes;
+} GeometryBufferCompaction;
+
+/// Incremental GeometryBuffer defragmentation step, meant to be called with a small mMaxBytes budget once per frame.
+/// Plans moves with planGeometryBufferMoves, claims their destinations and queues the GPU copies, token completes once they are done.
+/// Geometries keep their current chunks until endGeometryBufferCompaction, so they can still be drawn in the meantime.
+/// No geometry load into pGeometryBuffer may be in flight, and the moved geometries can't be removed before endGeometryBufferCompaction.
+FORGE_RENDERER_API void beginGeometryBufferCompaction(const GeometryBufferCompactionDesc* pDesc, GeometryBufferCompaction* pOut,
+                                                      SyncToken* token);
+
+/// Points the moved geometries to their new chunks and releases the old ones, call it once the token completed.
+/// Releasing follows the same rules as removeResource(Geometry*): no GPU work using the old chunks can still be in flight.
+/// Apps that cache chunk offsets (e.g. in draw arguments) must read the new ones from pMoves before this call.
+FORGE_RENDERER_API void endGeometryBufferCompaction(GeometryBufferCompaction* pCompaction);
+
 typedef struct FlushResourceUpdateDesc
 {
     uint32_t    mNodeIndex;
@@ -602,10 +736,18 @@ FORGE_RENDERER_API bool isResourceLoaderSingleThreaded();
 /// A SyncToken is an array of monotonically increasing integers.
 /// getLastTokenCompleted() returns the last value for which
 /// isTokenCompleted(token) is guaranteed to return true.
+/// A token returned by a single request (*token was 0 when passed to addResource) completes as soon as that request completed,
+/// even if older lower priority requests are still pending. A token combining several requests completes once every older
+/// request completed.
 FORGE_RENDERER_API SyncToken getLastTokenCompleted();
 FORGE_RENDERER_API bool      isTokenCompleted(const SyncToken* token);
 FORGE_RENDERER_API void      waitForToken(const SyncToken* token);
 
+/// Drops the request which returned this token if the resource loader did not start processing it yet.
+/// The token still completes. Texture and geometry loads which were dropped leave their output pointer NULL,
+/// buffers keep undefined contents. Resources which already exist are still transitioned to the state the load would leave them in.
+FORGE_RENDERER_API void cancelResourceLoad(const SyncToken* token);
+
 /// Allows clients to synchronize with the submission of copy commands (as opposed to their completion).
 /// This can reduce the wait time for clients but requires using the Semaphore from getLastSemaphoreCompleted() in a wait
 /// operation in a submit that uses the textures just updated.
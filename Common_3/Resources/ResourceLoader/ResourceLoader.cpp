@@ -41,6 +41,8 @@
 #include "../../Utilities/Interfaces/IFileSystem.h"
 #include "../../Utilities/Interfaces/ILog.h"
 #include "../../Utilities/Interfaces/IThread.h"
+#include "../../Utilities/Math/Algorithms.h"
+#include "../../Utilities/Threading/ThreadSystem.h"
 #include "Interfaces/IResourceLoader.h"
 
 #include "../../Utilities/Math/ShaderUtilities.h" // Packing functions
@@ -75,6 +77,18 @@
 
 #define MAX_FRAMES 3U
 
+// Capacity of the request queue shared by all threads calling addResource / copyResource. Must be a power of two.
+// Producers yield when the queue is full until the streamer thread drains it.
+#ifndef RESOURCE_LOADER_REQUEST_QUEUE_SIZE
+#define RESOURCE_LOADER_REQUEST_QUEUE_SIZE 4096U
+#endif
+COMPILE_ASSERT((RESOURCE_LOADER_REQUEST_QUEUE_SIZE & (RESOURCE_LOADER_REQUEST_QUEUE_SIZE - 1)) == 0);
+
+#define RESOURCE_LOADER_CACHE_LINE_SIZE 64
+
+// How many requests ahead of the one being recorded the streamer keeps file reads in flight, per IO thread
+#define RESOURCE_LOADER_READ_AHEAD_PER_THREAD 4
+
 struct SubresourceDataDesc
 {
     uint64_t mSrcOffset;
@@ -462,7 +476,7 @@ static inline bool IssueExplicitInitialStateBarrier()
 #endif
 }
 
-ResourceLoaderDesc          gDefaultResourceLoaderDesc = { 8ull * TF_MB, 2, false };
+ResourceLoaderDesc          gDefaultResourceLoaderDesc = { 8ull * TF_MB, 2, false, 4 };
 /************************************************************************/
 // Surface Utils
 /************************************************************************/
@@ -533,6 +547,16 @@ typedef struct BufferLoadDescInternal
     bool          mForceReset;
 } BufferLoadDescInternal;
 
+// GPU copy between two non overlapping ranges of the same buffer
+typedef struct BufferMoveDesc
+{
+    Buffer*       pBuffer;
+    uint64_t      mSrcOffset;
+    uint64_t      mDstOffset;
+    uint64_t      mSize;
+    ResourceState mCurrentState;
+} BufferMoveDesc;
+
 struct TextureLoadDescInternal
 {
     Texture** ppTexture;
@@ -554,6 +578,25 @@ struct TextureLoadDescInternal
     bool mForceReset;
 };
 
+typedef enum FileReadAheadState
+{
+    FILE_READ_AHEAD_PENDING = 0,
+    FILE_READ_AHEAD_DONE,
+    FILE_READ_AHEAD_FAILED,
+} FileReadAheadState;
+
+// File contents read into memory by an IO thread before the streamer thread processes the request
+typedef struct FileReadAhead
+{
+    ResourceDirectory mResourceDir;
+    const char*       pFileName;
+    /// Memory stream owning the file contents, valid once mState is FILE_READ_AHEAD_DONE
+    FileStream        mStream;
+    tfrg_atomic32_t   mState;
+    /// Set when the loader took ownership of mStream
+    bool              mStreamTaken;
+} FileReadAhead;
+
 typedef struct TextureUpdateDescInternal
 {
     Texture*          pTexture;
@@ -631,6 +674,7 @@ typedef enum UpdateRequestType
     UPDATE_REQUEST_LOAD_TEXTURE,
     UPDATE_REQUEST_LOAD_GEOMETRY,
     UPDATE_REQUEST_COPY_TEXTURE,
+    UPDATE_REQUEST_MOVE_BUFFER,
     UPDATE_REQUEST_INVALID,
 } UpdateRequestType;
 
@@ -643,14 +687,22 @@ typedef enum UploadFunctionResult
 
 struct UpdateRequest
 {
+    UpdateRequest() {}
     UpdateRequest(const BufferLoadDescInternal& buffer): mType(UPDATE_REQUEST_LOAD_BUFFER), bufLoadDesc(buffer) {}
     UpdateRequest(const TextureLoadDescInternal& texture): mType(UPDATE_REQUEST_LOAD_TEXTURE), texLoadDesc(texture) {}
     UpdateRequest(const GeometryLoadDesc& geom): mType(UPDATE_REQUEST_LOAD_GEOMETRY), geomLoadDesc(geom) {}
     UpdateRequest(const TextureBarrier& barrier): mType(UPDATE_REQUEST_TEXTURE_BARRIER), textureBarrier(barrier) {}
     UpdateRequest(const TextureCopyDesc& texture): mType(UPDATE_REQUEST_COPY_TEXTURE), texCopyDesc(texture) {}
-
-    UpdateRequestType mType = UPDATE_REQUEST_INVALID;
-    uint64_t          mWaitIndex = 0;
+    UpdateRequest(const BufferMoveDesc& buffer): mType(UPDATE_REQUEST_MOVE_BUFFER), bufMoveDesc(buffer) {}
+
+    UpdateRequestType    mType = UPDATE_REQUEST_INVALID;
+    ResourceLoadPriority mPriority = RESOURCE_LOAD_PRIORITY_NORMAL;
+    uint64_t             mWaitIndex = 0;
+    /// mWaitIndex was not combined with other tokens so it can complete before older lower priority requests
+    bool                 mExactToken = false;
+    /// Cancelled with cancelResourceLoad, only the state transitions of the request are recorded
+    bool                 mCancelled = false;
+    FileReadAhead*       pFileReadAhead = NULL;
     union
     {
         BufferLoadDescInternal  bufLoadDesc;
@@ -658,9 +710,24 @@ struct UpdateRequest
         GeometryLoadDesc        geomLoadDesc;
         TextureBarrier          textureBarrier;
         TextureCopyDesc         texCopyDesc;
+        BufferMoveDesc          bufMoveDesc;
     };
 };
 
+struct RequestQueueCell
+{
+    tfrg_atomic64_t mSequence;
+    uint32_t        mNodeIndex;
+    UpdateRequest   mRequest;
+};
+
+// Request waiting in its priority lane for the streamer thread
+struct PendingRequest
+{
+    uint32_t      mNodeIndex;
+    UpdateRequest mRequest;
+};
+
 struct ResourceLoader
 {
     Renderer* ppRenderers[MAX_MULTIPLE_GPUS];
@@ -671,25 +738,56 @@ struct ResourceLoader
     volatile int mRun;
     ThreadHandle mThread;
 
+    // Only used to put the streamer thread to sleep when there is no work, the request queue itself is lock-free
     Mutex             mQueueMutex;
     ConditionVariable mQueueCond;
     Mutex             mTokenMutex;
     ConditionVariable mTokenCond;
-    // array of stb_ds arrays
-    UpdateRequest*    mRequestQueue[MAX_MULTIPLE_GPUS];
+
+    // Bounded multi-producer queue (D. Vyukov). A request enqueued at position N gets SyncToken N + 1,
+    // so mTokenCounter doubles as the enqueue position.
+    uint8_t           mPadTokenCounterBegin[RESOURCE_LOADER_CACHE_LINE_SIZE];
+    tfrg_atomic64_t   mTokenCounter;
+    uint8_t           mPadTokenCounterEnd[RESOURCE_LOADER_CACHE_LINE_SIZE - sizeof(tfrg_atomic64_t)];
+    tfrg_atomic64_t   mDequeuePos;
+    tfrg_atomic32_t   mStreamerSleeping;
+    uint8_t           mPadDequeueEnd[RESOURCE_LOADER_CACHE_LINE_SIZE - sizeof(tfrg_atomic64_t) - sizeof(tfrg_atomic32_t)];
+    RequestQueueCell* pRequestQueue;
+
+    // Only accessed by the streamer thread. One stb_ds array per ResourceLoadPriority, sorted by token.
+    // Requests before mPendingHead were already processed.
+    PendingRequest* mPendingRequests[RESOURCE_LOAD_PRIORITY_COUNT];
+    ptrdiff_t       mPendingHead[RESOURCE_LOAD_PRIORITY_COUNT];
+    // Incremented when a copy engine runs out of staging memory, limits how much is recorded per streamer iteration
+    uint32_t        mOverflowFlushCount;
+
+    // stb_ds array of tokens passed to cancelResourceLoad, guarded by mCancelMutex
+    Mutex      mCancelMutex;
+    SyncToken* mCancelledTokens;
 
     tfrg_atomic64_t mTokenCompleted;
     tfrg_atomic64_t mTokenSubmitted;
-    tfrg_atomic64_t mTokenCounter;
 
     Mutex mSemaphoreMutex;
 
     SyncToken mCurrentTokenState[MAX_FRAMES];
     SyncToken mMaxToken;
+    // Exact tokens recorded ahead of mMaxToken (stb_ds arrays), they complete together with mCurrentTokenState
+    SyncToken* mExactTokenState[MAX_FRAMES];
+    SyncToken* mRecordedExactTokens;
+    // Exact tokens completed ahead of mTokenCompleted (stb_ds array), guarded by mTokenMutex
+    SyncToken*      mCompletedExactTokens;
+    tfrg_atomic32_t mCompletedExactTokenCount;
 
     CopyEngine pCopyEngines[MAX_MULTIPLE_GPUS];
     CopyEngine pUploadEngines[MAX_MULTIPLE_GPUS];
     Mutex      mUploadEngineMutex;
+
+    // Reads files ahead of the streamer thread, NULL when disabled
+    ThreadSystem      mIoThreadSystem;
+    Mutex             mIoMutex;
+    ConditionVariable mIoCond;
+    uint32_t          mReadAheadCount;
 };
 
 static ResourceLoader* pResourceLoader = NULL;
@@ -1029,6 +1127,143 @@ static MappedMemoryRange allocateStagingMemory(CopyEngine* pCopyEngine, uint64_t
     }
 }
 
+/************************************************************************/
+// File Read-Ahead
+/************************************************************************/
+static bool getFileReadAheadSource(const UpdateRequest& request, ResourceDirectory* pOutResourceDir, const char** ppOutFileName)
+{
+    switch (request.mType)
+    {
+    case UPDATE_REQUEST_LOAD_TEXTURE:
+        if (request.texLoadDesc.mForceReset || !request.texLoadDesc.pFileName)
+            return false;
+        *pOutResourceDir = RD_TEXTURES;
+        *ppOutFileName = request.texLoadDesc.pFileName;
+        return true;
+    case UPDATE_REQUEST_LOAD_GEOMETRY:
+        if (!request.geomLoadDesc.pFileName)
+            return false;
+        *pOutResourceDir = RD_MESHES;
+        *ppOutFileName = request.geomLoadDesc.pFileName;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void fileReadAheadTask(void* pUserData, uint64_t)
+{
+    FileReadAhead* pReadAhead = (FileReadAhead*)pUserData;
+    uint32_t       state = FILE_READ_AHEAD_FAILED;
+
+    // Errors are not reported here, the streamer thread opens the file again on failure and reports the error
+    FileStream file = {};
+    if (fsOpenStreamFromPath(pReadAhead->mResourceDir, pReadAhead->pFileName, FM_READ, &file))
+    {
+        ssize_t fileSize = fsGetStreamFileSize(&file);
+        void*   pFileData = fileSize > 0 ? tf_malloc((size_t)fileSize) : NULL;
+        if (pFileData && fsReadFromStream(&file, pFileData, (size_t)fileSize) == (size_t)fileSize &&
+            fsOpenStreamFromMemory(pFileData, (size_t)fileSize, FM_READ, true, &pReadAhead->mStream))
+        {
+            state = FILE_READ_AHEAD_DONE;
+        }
+        else
+        {
+            tf_free(pFileData);
+        }
+        fsCloseStream(&file);
+    }
+
+    acquireMutex(&pResourceLoader->mIoMutex);
+    tfrg_atomic32_store_release(&pReadAhead->mState, state);
+    releaseMutex(&pResourceLoader->mIoMutex);
+    wakeAllConditionVariable(&pResourceLoader->mIoCond);
+}
+
+static void beginFileReadAhead(ResourceLoader* pLoader, UpdateRequest* pRequest)
+{
+    ResourceDirectory resourceDir = RD_TEXTURES;
+    const char*       pFileName = NULL;
+    if (!getFileReadAheadSource(*pRequest, &resourceDir, &pFileName))
+    {
+        return;
+    }
+
+    FileReadAhead* pReadAhead = (FileReadAhead*)tf_calloc(1, sizeof(FileReadAhead));
+    pReadAhead->mResourceDir = resourceDir;
+    pReadAhead->pFileName = pFileName;
+    pRequest->pFileReadAhead = pReadAhead;
+    threadSystemAddTask(pLoader->mIoThreadSystem, fileReadAheadTask, pReadAhead);
+}
+
+static void waitFileReadAhead(ResourceLoader* pLoader, FileReadAhead* pReadAhead)
+{
+    while (tfrg_atomic32_load_acquire(&pReadAhead->mState) == FILE_READ_AHEAD_PENDING)
+    {
+        // The read might still be queued behind other reads, help out instead of idling
+        if (threadSystemAssist(pLoader->mIoThreadSystem))
+        {
+            continue;
+        }
+
+        acquireMutex(&pLoader->mIoMutex);
+        while (tfrg_atomic32_load_acquire(&pReadAhead->mState) == FILE_READ_AHEAD_PENDING)
+        {
+            waitConditionVariable(&pLoader->mIoCond, &pLoader->mIoMutex, TIMEOUT_INFINITE);
+        }
+        releaseMutex(&pLoader->mIoMutex);
+    }
+}
+
+/// Opens the file of a texture or geometry request, using the contents read by the IO threads if available
+static bool openRequestFileStream(FileReadAhead* pReadAhead, ResourceDirectory resourceDir, const char* pFileName, FileStream* pOut)
+{
+    if (pReadAhead)
+    {
+        waitFileReadAhead(pResourceLoader, pReadAhead);
+        if (tfrg_atomic32_load_relaxed(&pReadAhead->mState) == FILE_READ_AHEAD_DONE && !pReadAhead->mStreamTaken)
+        {
+            pReadAhead->mStreamTaken = true;
+            *pOut = pReadAhead->mStream;
+            return true;
+        }
+    }
+
+    return fsOpenStreamFromPath(resourceDir, pFileName, FM_READ, pOut);
+}
+
+// Memory streams (e.g. file read-ahead) and RAW files of archives opened with mmap expose their data directly,
+// so it is copied to staging memory without going through an intermediate stream read.
+// System files are not mapped, mapping a file just to copy it once doesn't save anything over reading it.
+static const uint8_t* getResidentStreamData(FileStream* pStream, size_t* pOutSize)
+{
+    const void* pData = NULL;
+    *pOutSize = 0;
+    if (pStream->pIO == pSystemFileIO || !fsStreamMemoryMap(pStream, pOutSize, &pData))
+    {
+        *pOutSize = 0;
+        return NULL;
+    }
+    return (const uint8_t*)pData;
+}
+
+static void endFileReadAhead(ResourceLoader* pLoader, UpdateRequest* pRequest)
+{
+    FileReadAhead* pReadAhead = pRequest->pFileReadAhead;
+    if (!pReadAhead)
+    {
+        return;
+    }
+
+    waitFileReadAhead(pLoader, pReadAhead);
+    if (tfrg_atomic32_load_relaxed(&pReadAhead->mState) == FILE_READ_AHEAD_DONE && !pReadAhead->mStreamTaken)
+    {
+        fsCloseStream(&pReadAhead->mStream);
+    }
+    tf_free(pReadAhead);
+    pRequest->pFileReadAhead = NULL;
+}
+
 static UploadFunctionResult updateBuffer(Renderer* pRenderer, CopyEngine* pCopyEngine, const BufferUpdateDesc& bufUpdateDesc)
 {
     UNREF_PARAM(pRenderer);
@@ -1183,6 +1418,9 @@ static UploadFunctionResult updateTexture(Renderer* pRenderer, CopyEngine* pCopy
         return UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL;
     }
 
+    size_t         residentSize = 0;
+    const uint8_t* pResidentData = dataAlreadyFilled ? NULL : getResidentStreamData(&stream, &residentSize);
+
     uint32_t firstStart = texUpdateDesc.mMipsAfterSlice ? texUpdateDesc.mBaseMipLevel : texUpdateDesc.mBaseArrayLayer;
     uint32_t firstEnd = texUpdateDesc.mMipsAfterSlice ? (texUpdateDesc.mBaseMipLevel + texUpdateDesc.mMipLevels)
                                                       : (texUpdateDesc.mBaseArrayLayer + texUpdateDesc.mLayerCount);
@@ -1229,7 +1467,28 @@ static UploadFunctionResult updateTexture(Renderer* pRenderer, CopyEngine* pCopy
                 uint32_t subDepth = d;
                 uint8_t* data = upload.pData + offset;
 
-                if (!dataAlreadyFilled)
+                if (pResidentData)
+                {
+                    // Copy rows straight from the stream memory, the stream only has to skip them
+                    const uint64_t position = (uint64_t)fsGetStreamSeekPosition(&stream);
+                    const uint64_t subresourceSize = (uint64_t)subDepth * subNumRows * rowBytes;
+                    if (position + subresourceSize > residentSize)
+                    {
+                        return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+                    }
+
+                    const uint8_t* srcData = pResidentData + position;
+                    for (uint32_t z = 0; z < subDepth; ++z)
+                    {
+                        uint8_t* dstData = data + subSlicePitch * z;
+                        for (uint32_t r = 0; r < subNumRows; ++r, srcData += rowBytes)
+                        {
+                            memcpy(dstData + r * subRowPitch, srcData, rowBytes);
+                        }
+                    }
+                    fsSeekStream(&stream, SBO_CURRENT_POSITION, (ssize_t)subresourceSize);
+                }
+                else if (!dataAlreadyFilled)
                 {
                     for (uint32_t z = 0; z < subDepth; ++z)
                     {
@@ -1353,7 +1612,7 @@ static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEn
         case TEXTURE_CONTAINER_DDS:
         {
 #if defined(XBOX)
-            success = fsOpenStreamFromPath(RD_TEXTURES, pTextureDesc->pFileName, FM_READ, &stream);
+            success = openRequestFileStream(pTextureUpdate.pFileReadAhead, RD_TEXTURES, pTextureDesc->pFileName, &stream);
             uint32_t res = 1;
             if (success)
             {
@@ -1375,7 +1634,7 @@ static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEn
 
             LOGF(eINFO, "XDDS: Could not find XDDS texture %s. Trying to load Desktop version", pTextureDesc->pFileName);
 #else
-            success = fsOpenStreamFromPath(RD_TEXTURES, pTextureDesc->pFileName, FM_READ, &stream);
+            success = openRequestFileStream(pTextureUpdate.pFileReadAhead, RD_TEXTURES, pTextureDesc->pFileName, &stream);
             if (success)
             {
                 success = loadDDSTextureDesc(&stream, &textureDesc);
@@ -1390,7 +1649,7 @@ static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEn
         }
         case TEXTURE_CONTAINER_KTX:
         {
-            success = fsOpenStreamFromPath(RD_TEXTURES, pTextureDesc->pFileName, FM_READ, &stream);
+            success = openRequestFileStream(pTextureUpdate.pFileReadAhead, RD_TEXTURES, pTextureDesc->pFileName, &stream);
             if (success)
             {
                 success = loadKTXTextureDesc(&stream, &textureDesc);
@@ -1413,7 +1672,7 @@ static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEn
         case TEXTURE_CONTAINER_GNF:
         {
 #if defined(ORBIS) || defined(PROSPERO)
-            success = fsOpenStreamFromPath(RD_TEXTURES, pTextureDesc->pFileName, FM_READ, &stream);
+            success = openRequestFileStream(pTextureUpdate.pFileReadAhead, RD_TEXTURES, pTextureDesc->pFileName, &stream);
             uint32_t res = 1;
             if (success)
             {
@@ -1596,11 +1855,12 @@ static void fillGeometryUpdateDesc(Renderer* pRenderer, CopyEngine* pCopyEngine,
 }
 
 static UploadFunctionResult loadGeometryCustomMeshFormat(Renderer* pRenderer, CopyEngine* pCopyEngine, GeometryLoadDesc* pDesc,
+                                                         FileReadAhead* pFileReadAhead,
                                                          BufferUpdateDesc vertexUpdateDesc[MAX_VERTEX_BINDINGS],
                                                          BufferUpdateDesc indexUpdateDesc[1])
 {
     FileStream file = {};
-    if (!fsOpenStreamFromPath(RD_MESHES, pDesc->pFileName, FM_READ, &file))
+    if (!openRequestFileStream(pFileReadAhead, RD_MESHES, pDesc->pFileName, &file))
     {
         LOGF(eERROR, "Failed to open bin file %s. Function %s failed with error: %s", pDesc->pFileName, FS_ERR_CTX.func,
              getFSErrCodeString(FS_ERR_CTX.code));
@@ -1659,14 +1919,34 @@ static UploadFunctionResult loadGeometryCustomMeshFormat(Renderer* pRenderer, Co
         return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
     }
 
-    geomData->pShadow = (GeometryData::ShadowData*)tf_malloc(shadowSize);
+    // Without GEOMETRY_LOAD_FLAG_SHADOWED the shadow is only a source of the copy to staging memory,
+    // so indices and attributes can be copied straight from the stream memory if it is resident
+    const bool     keepShadow = (pDesc->mFlags & GEOMETRY_LOAD_FLAG_SHADOWED) == GEOMETRY_LOAD_FLAG_SHADOWED;
+    size_t         residentSize = 0;
+    const uint8_t* pResidentData = keepShadow ? NULL : getResidentStreamData(&file, &residentSize);
+    const uint8_t* pResidentShadow = NULL;
+    if (pResidentData)
+    {
+        const uint64_t position = (uint64_t)fsGetStreamSeekPosition(&file);
+        if (position + shadowSize <= residentSize)
+        {
+            pResidentShadow = pResidentData + position;
+        }
+    }
+
+    geomData->pShadow = (GeometryData::ShadowData*)tf_malloc(pResidentShadow ? sizeof(*geomData->pShadow) : shadowSize);
     if (!geomData->pShadow)
     {
         return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
     }
 
-    if (!VERIFYMSG(fsReadFromStream(&file, geomData->pShadow, shadowSize) == shadowSize,
-                   "File '%s': Failed to read Geometry object's shadow.", pDesc->pFileName))
+    if (pResidentShadow)
+    {
+        memcpy(geomData->pShadow, pResidentShadow, sizeof(*geomData->pShadow));
+        fsSeekStream(&file, SBO_CURRENT_POSITION, (ssize_t)shadowSize);
+    }
+    else if (!VERIFYMSG(fsReadFromStream(&file, geomData->pShadow, shadowSize) == shadowSize,
+                        "File '%s': Failed to read Geometry object's shadow.", pDesc->pFileName))
     {
         return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
     }
@@ -1694,7 +1974,11 @@ static UploadFunctionResult loadGeometryCustomMeshFormat(Renderer* pRenderer, Co
         }
     }
 
-    fsCloseStream(&file);
+    // resident shadow data stays valid until the file is closed
+    if (!pResidentShadow)
+    {
+        fsCloseStream(&file);
+    }
 
     geom->pDrawArgs = (IndirectDrawIndexArguments*)(geom + 1); //-V1027
 
@@ -1716,7 +2000,7 @@ static UploadFunctionResult loadGeometryCustomMeshFormat(Renderer* pRenderer, Co
     // Determine index stride
     const uint32_t indexStride = geom->mVertexCount > UINT16_MAX ? sizeof(uint32_t) : sizeof(uint16_t);
 
-    geomData->pShadow->pIndices = geomData->pShadow + 1;
+    geomData->pShadow->pIndices = pResidentShadow ? (void*)(pResidentShadow + sizeof(*geomData->pShadow)) : (void*)(geomData->pShadow + 1);
 
     geomData->pShadow->pAttributes[SEMANTIC_POSITION] = (uint8_t*)geomData->pShadow->pIndices + (geom->mIndexCount * indexStride);
 
@@ -1823,8 +2107,13 @@ static UploadFunctionResult loadGeometryCustomMeshFormat(Renderer* pRenderer, Co
         }
     }
 
+    if (pResidentShadow)
+    {
+        fsCloseStream(&file);
+    }
+
     // If the user doesn't want the shadowed data we don't need it any more
-    if ((pDesc->mFlags & GEOMETRY_LOAD_FLAG_SHADOWED) != GEOMETRY_LOAD_FLAG_SHADOWED)
+    if (!keepShadow)
     {
         tf_free(geomData->pShadow);
         geomData->pShadow = nullptr;
@@ -1858,7 +2147,8 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
     BufferUpdateDesc indexUpdateDesc = {};
     BufferUpdateDesc vertexUpdateDesc[MAX_VERTEX_BINDINGS] = {};
 
-    UploadFunctionResult res = loadGeometryCustomMeshFormat(pRenderer, pCopyEngine, pDesc, vertexUpdateDesc, &indexUpdateDesc);
+    UploadFunctionResult res =
+        loadGeometryCustomMeshFormat(pRenderer, pCopyEngine, pDesc, pGeometryLoad.pFileReadAhead, vertexUpdateDesc, &indexUpdateDesc);
     if (res != UPLOAD_FUNCTION_RESULT_COMPLETED)
         return res;
 
@@ -1972,20 +2262,274 @@ static UploadFunctionResult copyTexture(Renderer* pRenderer, CopyEngine* pCopyEn
 
     return UPLOAD_FUNCTION_RESULT_COMPLETED;
 }
+
+static UploadFunctionResult moveBuffer(Renderer* pRenderer, CopyEngine* pCopyEngine, const BufferMoveDesc& bufMoveDesc)
+{
+    UNREF_PARAM(pRenderer);
+    Buffer* pBuffer = bufMoveDesc.pBuffer;
+    ASSERT(pCopyEngine->pQueue->mNodeIndex == pBuffer->mNodeIndex);
+    ASSERT(bufMoveDesc.mSrcOffset + bufMoveDesc.mSize <= bufMoveDesc.mDstOffset ||
+           bufMoveDesc.mDstOffset + bufMoveDesc.mSize <= bufMoveDesc.mSrcOffset);
+
+    Cmd* pCmd = acquireCmd(pCopyEngine);
+
+    // Source and destination are the same resource, which can't be in the copy source and copy dest states at once
+    if (IssueBufferCopyBarriers() && bufMoveDesc.mCurrentState != RESOURCE_STATE_COPY_DEST)
+    {
+        BufferBarrier barrier = { pBuffer, bufMoveDesc.mCurrentState, RESOURCE_STATE_COPY_DEST };
+        cmdResourceBarrier(pCmd, 1, &barrier, 0, NULL, 0, NULL);
+    }
+
+    cmdUpdateBuffer(pCmd, pBuffer, bufMoveDesc.mDstOffset, pBuffer, bufMoveDesc.mSrcOffset, bufMoveDesc.mSize);
+
+    if (IssueBufferCopyBarriers() && bufMoveDesc.mCurrentState != RESOURCE_STATE_COPY_DEST)
+    {
+        BufferBarrier barrier = { pBuffer, RESOURCE_STATE_COPY_DEST, bufMoveDesc.mCurrentState };
+        cmdResourceBarrier(pCmd, 1, &barrier, 0, NULL, 0, NULL);
+    }
+
+    return UPLOAD_FUNCTION_RESULT_COMPLETED;
+}
 /************************************************************************/
 // Internal Resource Loader Implementation
 /************************************************************************/
 static bool areTasksAvailable(ResourceLoader* pLoader)
 {
-    for (size_t i = 0; i < MAX_MULTIPLE_GPUS; ++i)
+    uint64_t          pos = tfrg_atomic64_load_relaxed(&pLoader->mDequeuePos);
+    RequestQueueCell* pCell = &pLoader->pRequestQueue[pos & (RESOURCE_LOADER_REQUEST_QUEUE_SIZE - 1)];
+    return tfrg_atomic64_load_acquire(&pCell->mSequence) == pos + 1;
+}
+
+static bool areAllTokensSignaled(ResourceLoader* pLoader)
+{
+    return tfrg_atomic64_load_acquire(&pLoader->mTokenCompleted) == tfrg_atomic64_load_relaxed(&pLoader->mTokenCounter);
+}
+
+static bool dequeueRequest(ResourceLoader* pLoader, uint32_t* pNodeIndex, UpdateRequest* pRequest)
+{
+    RequestQueueCell* pCell = NULL;
+    uint64_t          pos = tfrg_atomic64_load_relaxed(&pLoader->mDequeuePos);
+    for (;;)
     {
-        if (arrlen(pLoader->mRequestQueue[i]))
+        pCell = &pLoader->pRequestQueue[pos & (RESOURCE_LOADER_REQUEST_QUEUE_SIZE - 1)];
+        int64_t diff = (int64_t)tfrg_atomic64_load_acquire(&pCell->mSequence) - (int64_t)(pos + 1);
+        if (diff == 0)
         {
-            return true;
+            // Only the streamer dequeues, CAS protects against concurrent streamerThreadFunc calls in single threaded mode
+            uint64_t prev = tfrg_atomic64_cas_relaxed(&pLoader->mDequeuePos, pos, pos + 1);
+            if (prev == pos)
+                break;
+            pos = prev;
+        }
+        else if (diff < 0)
+        {
+            // Empty, or the producer which reserved this position has not published the request yet
+            return false;
+        }
+        else
+        {
+            pos = tfrg_atomic64_load_relaxed(&pLoader->mDequeuePos);
         }
     }
 
-    return false;
+    *pNodeIndex = pCell->mNodeIndex;
+    *pRequest = pCell->mRequest;
+    tfrg_atomic64_store_release(&pCell->mSequence, pos + RESOURCE_LOADER_REQUEST_QUEUE_SIZE);
+    return true;
+}
+
+static const ResourceLoadPriority gPriorityProcessingOrder[RESOURCE_LOAD_PRIORITY_COUNT] = {
+    RESOURCE_LOAD_PRIORITY_HIGH,
+    RESOURCE_LOAD_PRIORITY_NORMAL,
+    RESOURCE_LOAD_PRIORITY_LOW,
+};
+
+/// Cancelled loads skip the upload, but resources which already exist still have to end up in the state the load would leave them in
+static void recordCancelledRequest(CopyEngine* pCopyEngine, const UpdateRequest& request)
+{
+    switch (request.mType)
+    {
+    case UPDATE_REQUEST_TEXTURE_BARRIER:
+    {
+        TextureBarrier barrier = request.textureBarrier;
+        cmdResourceBarrier(acquireCmd(pCopyEngine), 0, NULL, 1, &barrier, 0, NULL);
+        break;
+    }
+    case UPDATE_REQUEST_LOAD_BUFFER:
+    {
+        // Buffers are only created in COPY_DEST when the load copies from a staging or source buffer, see loadBuffer
+        const BufferLoadDescInternal& loadDesc = request.bufLoadDesc;
+        if (IssueBufferCopyBarriers() && loadDesc.pSrcBuffer != loadDesc.pBuffer && loadDesc.mStartState != RESOURCE_STATE_COPY_DEST)
+        {
+            BufferBarrier barrier = { loadDesc.pBuffer, RESOURCE_STATE_COPY_DEST, loadDesc.mStartState };
+            cmdResourceBarrier(acquirePostCopyBarrierCmd(pCopyEngine), 1, &barrier, 0, NULL, 0, NULL);
+        }
+        break;
+    }
+    case UPDATE_REQUEST_LOAD_TEXTURE:
+    {
+        // Textures loaded from files are created by the load itself, only mForceReset textures exist already
+        const TextureLoadDescInternal& loadDesc = request.texLoadDesc;
+        if (!loadDesc.mForceReset)
+        {
+            break;
+        }
+        Texture* texture = *loadDesc.ppTexture;
+        if (IssueExplicitInitialStateBarrier())
+        {
+            TextureBarrier barrier = { texture, RESOURCE_STATE_UNDEFINED,
+                                       IssueTextureCopyBarriers() ? loadDesc.mStartState : RESOURCE_STATE_COPY_DEST };
+            cmdResourceBarrier(acquireCmd(pCopyEngine), 0, NULL, 1, &barrier, 0, NULL);
+        }
+        else if (IssueTextureCopyBarriers() && loadDesc.mStartState != RESOURCE_STATE_COPY_DEST)
+        {
+            TextureBarrier barrier = { texture, RESOURCE_STATE_COPY_DEST, loadDesc.mStartState };
+            cmdResourceBarrier(acquirePostCopyBarrierCmd(pCopyEngine), 0, NULL, 1, &barrier, 0, NULL);
+        }
+        break;
+    }
+    default:
+        // Geometry outputs are only created by the load, copies and moves leave the resource states unchanged
+        break;
+    }
+}
+
+static bool processRequest(ResourceLoader* pLoader, uint32_t nodeIndex, UpdateRequest& updateState)
+{
+    Renderer*   pRenderer = pLoader->ppRenderers[nodeIndex];
+    CopyEngine* pCopyEngine = &pLoader->pCopyEngines[nodeIndex];
+    // #NOTE: acquireCmd also resets copy engine on first use
+    Cmd*        cmd = acquireCmd(pCopyEngine);
+
+    if (updateState.mCancelled)
+    {
+        recordCancelledRequest(pCopyEngine, updateState);
+        return true;
+    }
+
+    UploadFunctionResult result = UPLOAD_FUNCTION_RESULT_COMPLETED;
+    switch (updateState.mType)
+    {
+    case UPDATE_REQUEST_TEXTURE_BARRIER:
+        cmdResourceBarrier(cmd, 0, NULL, 1, &updateState.textureBarrier, 0, NULL);
+        result = UPLOAD_FUNCTION_RESULT_COMPLETED;
+        break;
+    case UPDATE_REQUEST_LOAD_BUFFER:
+        result = loadBuffer(pRenderer, pCopyEngine, updateState);
+        break;
+    case UPDATE_REQUEST_LOAD_TEXTURE:
+        result = loadTexture(pRenderer, pCopyEngine, updateState);
+        break;
+    case UPDATE_REQUEST_LOAD_GEOMETRY:
+        result = loadGeometry(pRenderer, pCopyEngine, updateState);
+        break;
+    case UPDATE_REQUEST_COPY_TEXTURE:
+        result = copyTexture(pRenderer, pCopyEngine, updateState.texCopyDesc);
+        break;
+    case UPDATE_REQUEST_MOVE_BUFFER:
+        result = moveBuffer(pRenderer, pCopyEngine, updateState.bufMoveDesc);
+        break;
+    case UPDATE_REQUEST_INVALID:
+        break;
+    }
+
+    endFileReadAhead(pLoader, &updateState);
+
+    ASSERT(result != UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL);
+    return result == UPLOAD_FUNCTION_RESULT_COMPLETED || result == UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+}
+
+/// Releases what the loader owns for a request that will not be processed
+static void dropRequest(ResourceLoader* pLoader, UpdateRequest* pRequest)
+{
+    endFileReadAhead(pLoader, pRequest);
+    if (UPDATE_REQUEST_LOAD_GEOMETRY == pRequest->mType)
+    {
+        tf_free((void*)pRequest->geomLoadDesc.pVertexLayout);
+    }
+    pRequest->mType = UPDATE_REQUEST_INVALID;
+}
+
+/// Releases what the loader owns for a cancelled request, the request stays pending to record its state transitions
+static void cancelRequest(ResourceLoader* pLoader, UpdateRequest* pRequest)
+{
+    endFileReadAhead(pLoader, pRequest);
+    if (UPDATE_REQUEST_LOAD_GEOMETRY == pRequest->mType)
+    {
+        tf_free((void*)pRequest->geomLoadDesc.pVertexLayout);
+        pRequest->geomLoadDesc.pVertexLayout = NULL;
+    }
+    pRequest->mCancelled = true;
+}
+
+static void compactPendingRequests(ResourceLoader* pLoader, uint32_t priority)
+{
+    PendingRequest* pPending = pLoader->mPendingRequests[priority];
+    ptrdiff_t       head = pLoader->mPendingHead[priority];
+    ptrdiff_t       count = arrlen(pPending);
+    if (head == count)
+    {
+        // Keep the allocation around for the next batch
+        arrsetlen(pLoader->mPendingRequests[priority], 0);
+        pLoader->mPendingHead[priority] = 0;
+    }
+    else if (head > count / 2)
+    {
+        memmove(pPending, pPending + head, (count - head) * sizeof(PendingRequest));
+        arrsetlen(pLoader->mPendingRequests[priority], count - head);
+        pLoader->mPendingHead[priority] = 0;
+    }
+}
+
+static PendingRequest* findPendingRequest(ResourceLoader* pLoader, SyncToken token)
+{
+    for (uint32_t p = 0; p < RESOURCE_LOAD_PRIORITY_COUNT; ++p)
+    {
+        // Lanes are sorted by token
+        PendingRequest* pPending = pLoader->mPendingRequests[p];
+        ptrdiff_t       first = pLoader->mPendingHead[p];
+        ptrdiff_t       last = arrlen(pPending);
+        while (first < last)
+        {
+            ptrdiff_t mid = first + (last - first) / 2;
+            if (pPending[mid].mRequest.mWaitIndex < token)
+                first = mid + 1;
+            else
+                last = mid;
+        }
+        if (first < arrlen(pPending) && pPending[first].mRequest.mWaitIndex == token)
+        {
+            return &pPending[first];
+        }
+    }
+    return NULL;
+}
+
+static void applyCancelledTokens(ResourceLoader* pLoader)
+{
+    acquireMutex(&pLoader->mCancelMutex);
+    const SyncToken dequeuedToken = tfrg_atomic64_load_relaxed(&pLoader->mDequeuePos);
+    ptrdiff_t       remaining = 0;
+    for (ptrdiff_t i = 0; i < arrlen(pLoader->mCancelledTokens); ++i)
+    {
+        SyncToken token = pLoader->mCancelledTokens[i];
+        if (token > dequeuedToken)
+        {
+            // Producer has not published the request yet, try again next iteration
+            pLoader->mCancelledTokens[remaining++] = token;
+            continue;
+        }
+
+        // Requests which are not pending anymore were already processed
+        PendingRequest* pPending = findPendingRequest(pLoader, token);
+        if (pPending && !pPending->mRequest.mCancelled)
+        {
+            LOADER_LOGF(eINFO, "Cancelled resource load %llu", (unsigned long long)token);
+            cancelRequest(pLoader, &pPending->mRequest);
+        }
+    }
+    arrsetlen(pLoader->mCancelledTokens, remaining);
+    releaseMutex(&pLoader->mCancelMutex);
 }
 
 static void streamerThreadFunc(void* pThreadData)
@@ -1995,25 +2539,27 @@ static void streamerThreadFunc(void* pThreadData)
 
     while (pLoader->mRun)
     {
-        acquireMutex(&pLoader->mQueueMutex);
-
-        // Check for pending tokens
-        // Safe to use mTokenCounter as we are inside critical section
-        bool allTokensSignaled = (pLoader->mTokenCompleted == tfrg_atomic64_load_relaxed(&pLoader->mTokenCounter));
-
-        while (!areTasksAvailable(pLoader) && allTokensSignaled && pLoader->mRun)
+        if (!areTasksAvailable(pLoader) && areAllTokensSignaled(pLoader))
         {
             // No waiting if not running dedicated resource loader thread.
             if (pLoader->mDesc.mSingleThreaded)
             {
-                releaseMutex(&pLoader->mQueueMutex);
                 return;
             }
-            // Sleep until someone adds an update request to the queue
-            waitConditionVariable(&pLoader->mQueueCond, &pLoader->mQueueMutex, TIMEOUT_INFINITE);
-        }
 
-        releaseMutex(&pLoader->mQueueMutex);
+            acquireMutex(&pLoader->mQueueMutex);
+            // Producers check this flag after publishing their request, the full barrier orders the flag store before
+            // the queue checks below so either we see the new request or the producer sees us sleeping and wakes us up
+            tfrg_atomic32_store_relaxed(&pLoader->mStreamerSleeping, 1);
+            tfrg_memorybarrier_full();
+            while (!areTasksAvailable(pLoader) && areAllTokensSignaled(pLoader) && pLoader->mRun)
+            {
+                // Sleep until someone adds an update request to the queue
+                waitConditionVariable(&pLoader->mQueueCond, &pLoader->mQueueMutex, TIMEOUT_INFINITE);
+            }
+            tfrg_atomic32_store_relaxed(&pLoader->mStreamerSleeping, 0);
+            releaseMutex(&pLoader->mQueueMutex);
+        }
 
         for (uint32_t nodeIndex = 0; nodeIndex < pLoader->mGpuCount; ++nodeIndex)
         {
@@ -2025,87 +2571,119 @@ static void streamerThreadFunc(void* pThreadData)
 
         // Signal pending tokens from previous frames
         acquireMutex(&pLoader->mTokenMutex);
-        tfrg_atomic64_store_release(&pLoader->mTokenCompleted, pLoader->mCurrentTokenState[pLoader->pCopyEngines[0].activeSet]);
+        const uint32_t  completedSet = pLoader->pCopyEngines[0].activeSet;
+        const SyncToken completedToken = pLoader->mCurrentTokenState[completedSet];
+        tfrg_atomic64_store_release(&pLoader->mTokenCompleted, completedToken);
+        ptrdiff_t completedExactCount = 0;
+        for (ptrdiff_t i = 0; i < arrlen(pLoader->mCompletedExactTokens); ++i)
+        {
+            if (pLoader->mCompletedExactTokens[i] > completedToken)
+            {
+                pLoader->mCompletedExactTokens[completedExactCount++] = pLoader->mCompletedExactTokens[i];
+            }
+        }
+        arrsetlen(pLoader->mCompletedExactTokens, completedExactCount);
+        for (ptrdiff_t i = 0; i < arrlen(pLoader->mExactTokenState[completedSet]); ++i)
+        {
+            if (pLoader->mExactTokenState[completedSet][i] > completedToken)
+            {
+                arrpush(pLoader->mCompletedExactTokens, pLoader->mExactTokenState[completedSet][i]);
+            }
+        }
+        arrsetlen(pLoader->mExactTokenState[completedSet], 0);
+        tfrg_atomic32_store_release(&pLoader->mCompletedExactTokenCount, (uint32_t)arrlen(pLoader->mCompletedExactTokens));
         releaseMutex(&pLoader->mTokenMutex);
         wakeAllConditionVariable(&pLoader->mTokenCond);
 
-        uint64_t completionMask = 0;
-
-        for (uint32_t nodeIndex = 0; nodeIndex < pLoader->mGpuCount; ++nodeIndex)
+        // Drain everything published so far into the priority lanes. Requests come out in token order so every lane stays sorted.
+        uint32_t      requestNodeIndex = 0;
+        UpdateRequest request;
+        while (dequeueRequest(pLoader, &requestNodeIndex, &request))
         {
-            acquireMutex(&pLoader->mQueueMutex);
-
-            UpdateRequest** pRequestQueue = &pLoader->mRequestQueue[nodeIndex];
-            CopyEngine*     pCopyEngine = &pLoader->pCopyEngines[nodeIndex];
-
-            if (!arrlen(*pRequestQueue))
-            {
-                releaseMutex(&pLoader->mQueueMutex);
-                continue;
-            }
+            ASSERT(requestNodeIndex < pLoader->mGpuCount);
+            ASSERT(request.mPriority < RESOURCE_LOAD_PRIORITY_COUNT);
+            PendingRequest pending = { requestNodeIndex, request };
+            arrpush(pLoader->mPendingRequests[request.mPriority], pending);
+        }
 
-            UpdateRequest* activeQueue = *pRequestQueue;
-            *pRequestQueue = NULL;
-            releaseMutex(&pLoader->mQueueMutex);
+        applyCancelledTokens(pLoader);
 
-            Renderer* pRenderer = pLoader->ppRenderers[nodeIndex];
-            SyncToken maxNodeToken = {};
+        // High priority first, FIFO within a priority. Once a staging buffer worth of uploads has been recorded we stop so
+        // that requests added in the meantime can overtake the remaining lower priority ones.
+        const bool     limitRecording = !pLoader->mDesc.mSingleThreaded;
+        const uint32_t overflowFlushCount = pLoader->mOverflowFlushCount;
+        uint64_t       completionMask = 0;
+        arrsetlen(pLoader->mRecordedExactTokens, 0);
 
-            ASSERT(arrlen(activeQueue));
+        for (uint32_t p = 0; p < RESOURCE_LOAD_PRIORITY_COUNT; ++p)
+        {
+            const ResourceLoadPriority priority = gPriorityProcessingOrder[p];
+            PendingRequest*            pPending = pLoader->mPendingRequests[priority];
 
-            for (ptrdiff_t j = 0; j < arrlen(activeQueue); ++j)
+            while (pLoader->mPendingHead[priority] < arrlen(pPending))
             {
-                UpdateRequest updateState = activeQueue[j];
-                // #NOTE: acquireCmd also resets copy engine on first use
-                Cmd*          cmd = acquireCmd(pCopyEngine);
-
-                UploadFunctionResult result = UPLOAD_FUNCTION_RESULT_COMPLETED;
-                switch (updateState.mType)
+                if (limitRecording && overflowFlushCount != pLoader->mOverflowFlushCount)
                 {
-                case UPDATE_REQUEST_TEXTURE_BARRIER:
-                    cmdResourceBarrier(cmd, 0, NULL, 1, &updateState.textureBarrier, 0, NULL);
-                    result = UPLOAD_FUNCTION_RESULT_COMPLETED;
-                    break;
-                case UPDATE_REQUEST_LOAD_BUFFER:
-                    result = loadBuffer(pRenderer, pCopyEngine, updateState);
-                    break;
-                case UPDATE_REQUEST_LOAD_TEXTURE:
-                    result = loadTexture(pRenderer, pCopyEngine, updateState);
-                    break;
-                case UPDATE_REQUEST_LOAD_GEOMETRY:
-                    result = loadGeometry(pRenderer, pCopyEngine, updateState);
-                    break;
-                case UPDATE_REQUEST_COPY_TEXTURE:
-                    result = copyTexture(pRenderer, pCopyEngine, updateState.texCopyDesc);
-                    break;
-                case UPDATE_REQUEST_INVALID:
                     break;
                 }
 
-                bool completed = result == UPLOAD_FUNCTION_RESULT_COMPLETED || result == UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+                const ptrdiff_t head = pLoader->mPendingHead[priority]++;
+
+                // Keep the IO threads busy reading the files of the next requests while this one is recorded
+                if (pLoader->mIoThreadSystem)
+                {
+                    ptrdiff_t readAheadEnd = min(arrlen(pPending), head + 1 + (ptrdiff_t)pLoader->mReadAheadCount);
+                    for (ptrdiff_t r = head; r < readAheadEnd; ++r)
+                    {
+                        if (!pPending[r].mRequest.pFileReadAhead && !pPending[r].mRequest.mCancelled)
+                        {
+                            beginFileReadAhead(pLoader, &pPending[r].mRequest);
+                        }
+                    }
+                }
 
+                const uint32_t nodeIndex = pPending[head].mNodeIndex;
+                UpdateRequest  updateState = pPending[head].mRequest;
+                const bool     completed = processRequest(pLoader, nodeIndex, updateState);
                 completionMask |= (uint64_t)completed << nodeIndex;
 
-                if (updateState.mWaitIndex && completed)
+                if (updateState.mWaitIndex && updateState.mExactToken && completed)
                 {
-                    ASSERT(maxNodeToken < updateState.mWaitIndex);
-                    maxNodeToken = updateState.mWaitIndex;
+                    arrpush(pLoader->mRecordedExactTokens, updateState.mWaitIndex);
                 }
-
-                ASSERT(result != UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL);
             }
 
-            arrfree(activeQueue);
-            pLoader->mMaxToken = max(pLoader->mMaxToken, maxNodeToken);
+            compactPendingRequests(pLoader, priority);
         }
 
-        if (completionMask != 0)
+        // Every token up to the oldest request still pending was processed
+        SyncToken processedToken = tfrg_atomic64_load_relaxed(&pLoader->mDequeuePos);
+        for (uint32_t p = 0; p < RESOURCE_LOAD_PRIORITY_COUNT; ++p)
         {
-            for (uint32_t nodeIndex = 0; nodeIndex < pLoader->mGpuCount; ++nodeIndex)
+            if (pLoader->mPendingHead[p] < arrlen(pLoader->mPendingRequests[p]))
             {
-                if (completionMask & ((uint64_t)1 << nodeIndex))
-                {
-                    CopyEngine* copyEngine = &pLoader->pCopyEngines[nodeIndex];
+                processedToken = min(processedToken, pLoader->mPendingRequests[p][pLoader->mPendingHead[p]].mRequest.mWaitIndex - 1);
+            }
+        }
+        pLoader->mMaxToken = max(pLoader->mMaxToken, processedToken);
+
+        // Exact tokens covered by the watermark don't need to be tracked. Overflow flushes may have switched the active set,
+        // the tokens complete with the last set which is conservative.
+        for (ptrdiff_t i = 0; i < arrlen(pLoader->mRecordedExactTokens); ++i)
+        {
+            if (pLoader->mRecordedExactTokens[i] > pLoader->mMaxToken)
+            {
+                arrpush(pLoader->mExactTokenState[pLoader->pCopyEngines[0].activeSet], pLoader->mRecordedExactTokens[i]);
+            }
+        }
+
+        if (completionMask != 0)
+        {
+            for (uint32_t nodeIndex = 0; nodeIndex < pLoader->mGpuCount; ++nodeIndex)
+            {
+                if (completionMask & ((uint64_t)1 << nodeIndex))
+                {
+                    CopyEngine* copyEngine = &pLoader->pCopyEngines[nodeIndex];
                     streamerFlush(copyEngine);
                     acquireMutex(&pLoader->mSemaphoreMutex);
                     copyEngine->pLastSubmittedSemaphore = copyEngine->resourceSets[copyEngine->activeSet].pSemaphore;
@@ -2144,6 +2722,7 @@ static void streamerThreadFunc(void* pThreadData)
 
 static void CopyEngineFlush(CopyEngine* pCopyEngine)
 {
+    ++pResourceLoader->mOverflowFlushCount;
     streamerFlush(pCopyEngine);
     acquireMutex(&pResourceLoader->mSemaphoreMutex);
     pCopyEngine->pLastSubmittedSemaphore = pCopyEngine->resourceSets[pCopyEngine->activeSet].pSemaphore;
@@ -2199,11 +2778,40 @@ static void initResourceLoader(Renderer** ppRenderers, uint32_t rendererCount, R
     initConditionVariable(&pLoader->mTokenCond);
     initMutex(&pLoader->mSemaphoreMutex);
     initMutex(&pLoader->mUploadEngineMutex);
+    initMutex(&pLoader->mIoMutex);
+    initConditionVariable(&pLoader->mIoCond);
+    initMutex(&pLoader->mCancelMutex);
+
+    pLoader->mIoThreadSystem = NULL;
+    pLoader->mReadAheadCount = 0;
+    if (!pLoader->mDesc.mSingleThreaded && pLoader->mDesc.mIoThreadCount)
+    {
+        ThreadSystemInitDesc ioThreadDesc = gThreadSystemInitDescDefault;
+        ioThreadDesc.threadCount = pLoader->mDesc.mIoThreadCount;
+        ioThreadDesc.threadName = "ResourceLoaderIO";
+        bool ioThreadsInitialized = threadSystemInit(&pLoader->mIoThreadSystem, &ioThreadDesc);
+        ASSERT(ioThreadsInitialized);
+        UNREF_PARAM(ioThreadsInitialized);
+
+        ThreadSystemInfo ioThreadInfo = {};
+        threadSystemGetInfo(pLoader->mIoThreadSystem, &ioThreadInfo);
+        pLoader->mReadAheadCount = (uint32_t)ioThreadInfo.threadCount * RESOURCE_LOADER_READ_AHEAD_PER_THREAD;
+    }
 
     pLoader->mTokenCounter = 0;
     pLoader->mTokenCompleted = 0;
     pLoader->mTokenSubmitted = 0;
 
+    pLoader->mDequeuePos = 0;
+    pLoader->mStreamerSleeping = 0;
+    pLoader->pRequestQueue = (RequestQueueCell*)tf_calloc_memalign(RESOURCE_LOADER_REQUEST_QUEUE_SIZE, RESOURCE_LOADER_CACHE_LINE_SIZE,
+                                                                   sizeof(RequestQueueCell));
+    ASSERT(pLoader->pRequestQueue);
+    for (uint64_t i = 0; i < RESOURCE_LOADER_REQUEST_QUEUE_SIZE; ++i)
+    {
+        pLoader->pRequestQueue[i].mSequence = i;
+    }
+
     for (uint32_t i = 0; i < gpuCount; ++i)
     {
         CopyEngineDesc desc = {};
@@ -2278,10 +2886,16 @@ static void exitResourceLoader(ResourceLoader* pLoader)
     }
     else
     {
+        // Make sure the streamer is either waiting or will see mRun == false before it goes to sleep
+        acquireMutex(&pLoader->mQueueMutex);
+        releaseMutex(&pLoader->mQueueMutex);
         wakeOneConditionVariable(&pLoader->mQueueCond);
         joinThread(pLoader->mThread);
     }
 
+    // All read-ahead requests were consumed by the streamer thread
+    threadSystemExit(&pLoader->mIoThreadSystem, &gThreadSystemExitDescDefault);
+
     for (uint32_t nodeIndex = 0; nodeIndex < pLoader->mGpuCount; ++nodeIndex)
     {
         const bool wait = true;
@@ -2300,124 +2914,139 @@ static void exitResourceLoader(ResourceLoader* pLoader)
     exitMutex(&pLoader->mTokenMutex);
     exitMutex(&pLoader->mSemaphoreMutex);
     exitMutex(&pLoader->mUploadEngineMutex);
+    exitConditionVariable(&pLoader->mIoCond);
+    exitMutex(&pLoader->mIoMutex);
 
-    tf_delete(pLoader);
-}
-
-static void queueBufferLoad(ResourceLoader* pLoader, BufferLoadDescInternal* pBufferLoad, SyncToken* token)
-{
-    uint32_t nodeIndex = pBufferLoad->pBuffer->mNodeIndex;
-    acquireMutex(&pLoader->mQueueMutex);
-
-    SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
-
-    arrpush(pLoader->mRequestQueue[nodeIndex], UpdateRequest(*pBufferLoad));
-    UpdateRequest* pLastRequest = arrback(pLoader->mRequestQueue[nodeIndex]);
-    if (pLastRequest)
-        pLastRequest->mWaitIndex = t;
-
-    releaseMutex(&pLoader->mQueueMutex);
-    wakeOneConditionVariable(&pLoader->mQueueCond);
-    if (token)
-        *token = max(t, *token);
+    exitMutex(&pLoader->mCancelMutex);
 
-    if (pResourceLoader->mDesc.mSingleThreaded)
+    // Requests still queued at exit are dropped
+    uint32_t      requestNodeIndex = 0;
+    UpdateRequest request;
+    while (dequeueRequest(pLoader, &requestNodeIndex, &request))
     {
-        streamerThreadFunc(pResourceLoader);
+        dropRequest(pLoader, &request);
     }
+    for (uint32_t p = 0; p < RESOURCE_LOAD_PRIORITY_COUNT; ++p)
+    {
+        for (ptrdiff_t i = pLoader->mPendingHead[p]; i < arrlen(pLoader->mPendingRequests[p]); ++i)
+        {
+            dropRequest(pLoader, &pLoader->mPendingRequests[p][i].mRequest);
+        }
+        arrfree(pLoader->mPendingRequests[p]);
+    }
+    for (uint32_t i = 0; i < MAX_FRAMES; ++i)
+    {
+        arrfree(pLoader->mExactTokenState[i]);
+    }
+    arrfree(pLoader->mRecordedExactTokens);
+    arrfree(pLoader->mCompletedExactTokens);
+    arrfree(pLoader->mCancelledTokens);
+    tf_free(pLoader->pRequestQueue);
+
+    tf_delete(pLoader);
 }
 
-static void queueTextureLoad(ResourceLoader* pLoader, TextureLoadDescInternal* pTextureLoad, SyncToken* token)
+static void wakeStreamer(ResourceLoader* pLoader)
 {
-    uint32_t nodeIndex = pTextureLoad->mNodeIndex;
-    acquireMutex(&pLoader->mQueueMutex);
-
-    SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
-
-    arrpush(pLoader->mRequestQueue[nodeIndex], UpdateRequest(*pTextureLoad));
-    UpdateRequest* pLastRequest = arrback(pLoader->mRequestQueue[nodeIndex]);
-    if (pLastRequest)
-        pLastRequest->mWaitIndex = t;
-
-    releaseMutex(&pLoader->mQueueMutex);
-    wakeOneConditionVariable(&pLoader->mQueueCond);
-    if (token)
-        *token = max(t, *token);
-
-    if (pResourceLoader->mDesc.mSingleThreaded)
+    // Pairs with the barrier in streamerThreadFunc, see the comment there
+    tfrg_memorybarrier_full();
+    if (tfrg_atomic32_load_relaxed(&pLoader->mStreamerSleeping))
     {
-        streamerThreadFunc(pResourceLoader);
+        // Taking the mutex guarantees the streamer is inside waitConditionVariable and will not miss the wake up
+        acquireMutex(&pLoader->mQueueMutex);
+        releaseMutex(&pLoader->mQueueMutex);
+        wakeOneConditionVariable(&pLoader->mQueueCond);
     }
 }
 
-static void queueGeometryLoad(ResourceLoader* pLoader, GeometryLoadDesc* pGeometryLoad, SyncToken* token)
+static void queueRequest(ResourceLoader* pLoader, uint32_t nodeIndex, ResourceLoadPriority priority, const UpdateRequest& request,
+                         SyncToken* token)
 {
-    uint32_t nodeIndex = pGeometryLoad->mNodeIndex;
-    acquireMutex(&pLoader->mQueueMutex);
+    RequestQueueCell* pCell = NULL;
+    uint64_t          pos = tfrg_atomic64_load_relaxed(&pLoader->mTokenCounter);
+    for (;;)
+    {
+        pCell = &pLoader->pRequestQueue[pos & (RESOURCE_LOADER_REQUEST_QUEUE_SIZE - 1)];
+        int64_t diff = (int64_t)tfrg_atomic64_load_acquire(&pCell->mSequence) - (int64_t)pos;
+        if (diff == 0)
+        {
+            uint64_t prev = tfrg_atomic64_cas_relaxed(&pLoader->mTokenCounter, pos, pos + 1);
+            if (prev == pos)
+                break;
+            pos = prev;
+        }
+        else if (diff < 0)
+        {
+            // Queue is full, let the streamer drain it
+            if (pLoader->mDesc.mSingleThreaded)
+            {
+                streamerThreadFunc(pLoader);
+            }
+            else
+            {
+                wakeStreamer(pLoader);
+                threadSleep(0);
+            }
+            pos = tfrg_atomic64_load_relaxed(&pLoader->mTokenCounter);
+        }
+        else
+        {
+            pos = tfrg_atomic64_load_relaxed(&pLoader->mTokenCounter);
+        }
+    }
 
-    SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+    SyncToken t = pos + 1;
 
-    arrpush(pLoader->mRequestQueue[nodeIndex], UpdateRequest(*pGeometryLoad));
-    UpdateRequest* pLastRequest = arrback(pLoader->mRequestQueue[nodeIndex]);
-    if (pLastRequest)
-        pLastRequest->mWaitIndex = t;
+    pCell->mNodeIndex = nodeIndex;
+    pCell->mRequest = request;
+    pCell->mRequest.mPriority = priority;
+    pCell->mRequest.mWaitIndex = t;
+    // A token combining several requests (max of their tokens) only completes once all older requests completed
+    pCell->mRequest.mExactToken = !token || !*token;
+    tfrg_atomic64_store_release(&pCell->mSequence, pos + 1);
 
-    releaseMutex(&pLoader->mQueueMutex);
-    wakeOneConditionVariable(&pLoader->mQueueCond);
+    wakeStreamer(pLoader);
     if (token)
         *token = max(t, *token);
 
-    if (pResourceLoader->mDesc.mSingleThreaded)
+    if (pLoader->mDesc.mSingleThreaded)
     {
-        streamerThreadFunc(pResourceLoader);
+        streamerThreadFunc(pLoader);
     }
 }
 
-static void queueTextureBarrier(ResourceLoader* pLoader, Texture* pTexture, ResourceState state, SyncToken* token)
+static void queueBufferLoad(ResourceLoader* pLoader, BufferLoadDescInternal* pBufferLoad, ResourceLoadPriority priority, SyncToken* token)
 {
-    uint32_t nodeIndex = pTexture->mNodeIndex;
-    acquireMutex(&pLoader->mQueueMutex);
-
-    SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+    queueRequest(pLoader, pBufferLoad->pBuffer->mNodeIndex, priority, UpdateRequest(*pBufferLoad), token);
+}
 
-    arrpush(pLoader->mRequestQueue[nodeIndex], UpdateRequest(TextureBarrier{ pTexture, RESOURCE_STATE_UNDEFINED, state }));
-    UpdateRequest* pLastRequest = arrback(pLoader->mRequestQueue[nodeIndex]);
-    if (pLastRequest)
-        pLastRequest->mWaitIndex = t;
+static void queueTextureLoad(ResourceLoader* pLoader, TextureLoadDescInternal* pTextureLoad, ResourceLoadPriority priority,
+                             SyncToken* token)
+{
+    queueRequest(pLoader, pTextureLoad->mNodeIndex, priority, UpdateRequest(*pTextureLoad), token);
+}
 
-    releaseMutex(&pLoader->mQueueMutex);
-    wakeOneConditionVariable(&pLoader->mQueueCond);
-    if (token)
-        *token = max(t, *token);
+static void queueGeometryLoad(ResourceLoader* pLoader, GeometryLoadDesc* pGeometryLoad, SyncToken* token)
+{
+    queueRequest(pLoader, pGeometryLoad->mNodeIndex, pGeometryLoad->mPriority, UpdateRequest(*pGeometryLoad), token);
+}
 
-    if (pResourceLoader->mDesc.mSingleThreaded)
-    {
-        streamerThreadFunc(pResourceLoader);
-    }
+static void queueTextureBarrier(ResourceLoader* pLoader, Texture* pTexture, ResourceState state, ResourceLoadPriority priority,
+                                SyncToken* token)
+{
+    queueRequest(pLoader, pTexture->mNodeIndex, priority, UpdateRequest(TextureBarrier{ pTexture, RESOURCE_STATE_UNDEFINED, state }),
+                 token);
 }
 
 static void queueTextureCopy(ResourceLoader* pLoader, TextureCopyDesc* pTextureCopy, SyncToken* token)
 {
     ASSERT(pTextureCopy->pTexture->mNodeIndex == pTextureCopy->pBuffer->mNodeIndex);
-    uint32_t nodeIndex = pTextureCopy->pTexture->mNodeIndex;
-    acquireMutex(&pLoader->mQueueMutex);
-
-    SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
-
-    arrpush(pLoader->mRequestQueue[nodeIndex], UpdateRequest(*pTextureCopy));
-    UpdateRequest* pLastRequest = arrback(pLoader->mRequestQueue[nodeIndex]);
-    if (pLastRequest)
-        pLastRequest->mWaitIndex = t;
-
-    releaseMutex(&pLoader->mQueueMutex);
-    wakeOneConditionVariable(&pLoader->mQueueCond);
-    if (token)
-        *token = max(t, *token);
+    queueRequest(pLoader, pTextureCopy->pTexture->mNodeIndex, RESOURCE_LOAD_PRIORITY_NORMAL, UpdateRequest(*pTextureCopy), token);
+}
 
-    if (pResourceLoader->mDesc.mSingleThreaded)
-    {
-        streamerThreadFunc(pResourceLoader);
-    }
+static void queueBufferMove(ResourceLoader* pLoader, BufferMoveDesc* pBufferMove, SyncToken* token)
+{
+    queueRequest(pLoader, pBufferMove->pBuffer->mNodeIndex, RESOURCE_LOAD_PRIORITY_LOW, UpdateRequest(*pBufferMove), token);
 }
 
 static void waitForToken(ResourceLoader* pLoader, const SyncToken* token)
@@ -3187,7 +3816,7 @@ void addResource(BufferLoadDesc* pBufferDesc, SyncToken* token)
             loadDesc.pSrcBuffer = loadDesc.pBuffer;
             loadDesc.mSrcOffset = 0;
         }
-        queueBufferLoad(pResourceLoader, &loadDesc, token);
+        queueBufferLoad(pResourceLoader, &loadDesc, pBufferDesc->mPriority, token);
     }
 }
 
@@ -3241,7 +3870,7 @@ void addResource(TextureLoadDesc* pTextureDesc, SyncToken* token)
             loadDesc.ppTexture = pTextureDesc->ppTexture;
             loadDesc.mForceReset = true;
             loadDesc.mStartState = pTextureDesc->pDesc->mStartState;
-            queueTextureLoad(pResourceLoader, &loadDesc, token);
+            queueTextureLoad(pResourceLoader, &loadDesc, pTextureDesc->mPriority, token);
 #endif
             return;
         }
@@ -3254,7 +3883,7 @@ void addResource(TextureLoadDesc* pTextureDesc, SyncToken* token)
             {
                 startState = ResourceStartState(pTextureDesc->pDesc->mDescriptors & DESCRIPTOR_TYPE_RW_TEXTURE);
             }
-            queueTextureBarrier(pResourceLoader, *pTextureDesc->ppTexture, startState, token);
+            queueTextureBarrier(pResourceLoader, *pTextureDesc->ppTexture, startState, pTextureDesc->mPriority, token);
         }
     }
     else
@@ -3266,7 +3895,7 @@ void addResource(TextureLoadDesc* pTextureDesc, SyncToken* token)
         loadDesc.mNodeIndex = pTextureDesc->mNodeIndex;
         loadDesc.pFileName = pTextureDesc->pFileName;
         loadDesc.pYcbcrSampler = pTextureDesc->pYcbcrSampler;
-        queueTextureLoad(pResourceLoader, &loadDesc, token);
+        queueTextureLoad(pResourceLoader, &loadDesc, pTextureDesc->mPriority, token);
     }
 }
 
@@ -3335,6 +3964,387 @@ void removeGeometryShadowData(GeometryData* pGeom)
 }
 
 // Interface to add/remove BufferChunkAllocators is currently private but we could expose it in the IResourceLoader interface if needed
+/************************************************************************/
+// Buffer Chunk Allocator
+/************************************************************************/
+// Unused chunks live in two intrusive red-black trees sharing the same nodes: one sorted by offset (coalescing and requested chunks) and
+// one sorted by size then offset (best-fit). Nodes are addressed by index since pUnusedChunkNodes can be reallocated while growing.
+#define BUFFER_CHUNK_NIL         0u
+#define BUFFER_CHUNK_OFFSET_TREE 0u
+#define BUFFER_CHUNK_SIZE_TREE   1u
+// How many chunks bigger than the requested size we test before looking for one that fits with any alignment
+#define BUFFER_CHUNK_ALIGNMENT_PROBE_COUNT 8u
+
+static inline bool bufferChunkNodeLess(const BufferChunkNode* pNodes, uint32_t tree, uint32_t a, uint32_t b)
+{
+    const BufferChunk* chunkA = &pNodes[a].mChunk;
+    const BufferChunk* chunkB = &pNodes[b].mChunk;
+    if (tree == BUFFER_CHUNK_SIZE_TREE && chunkA->mSize != chunkB->mSize)
+        return chunkA->mSize < chunkB->mSize;
+    return chunkA->mOffset < chunkB->mOffset;
+}
+
+// dir 0 rotates node down to the left, dir 1 down to the right
+static void bufferChunkTreeRotate(BufferChunkAllocator* pAllocator, uint32_t tree, uint32_t node, uint32_t dir)
+{
+    BufferChunkNode*     pNodes = pAllocator->pUnusedChunkNodes;
+    BufferChunkTreeLink* link = &pNodes[node].mLink[tree];
+    const uint32_t       pivot = link->mChild[!dir];
+    BufferChunkTreeLink* pivotLink = &pNodes[pivot].mLink[tree];
+
+    link->mChild[!dir] = pivotLink->mChild[dir];
+    if (pivotLink->mChild[dir] != BUFFER_CHUNK_NIL)
+        pNodes[pivotLink->mChild[dir]].mLink[tree].mParent = node;
+
+    const uint32_t parent = link->mParent;
+    pivotLink->mParent = parent;
+    if (parent == BUFFER_CHUNK_NIL)
+        pAllocator->mUnusedChunkRoot[tree] = pivot;
+    else
+        pNodes[parent].mLink[tree].mChild[pNodes[parent].mLink[tree].mChild[0] == node ? 0 : 1] = pivot;
+
+    pivotLink->mChild[dir] = node;
+    link->mParent = pivot;
+}
+
+static void bufferChunkTreeInsert(BufferChunkAllocator* pAllocator, uint32_t tree, uint32_t node)
+{
+    BufferChunkNode* pNodes = pAllocator->pUnusedChunkNodes;
+
+    uint32_t parent = BUFFER_CHUNK_NIL;
+    uint32_t dir = 0;
+    for (uint32_t it = pAllocator->mUnusedChunkRoot[tree]; it != BUFFER_CHUNK_NIL; it = pNodes[it].mLink[tree].mChild[dir])
+    {
+        parent = it;
+        dir = bufferChunkNodeLess(pNodes, tree, it, node) ? 1 : 0;
+    }
+
+    BufferChunkTreeLink* link = &pNodes[node].mLink[tree];
+    link->mParent = parent;
+    link->mChild[0] = BUFFER_CHUNK_NIL;
+    link->mChild[1] = BUFFER_CHUNK_NIL;
+    link->mRed = 1;
+    if (parent == BUFFER_CHUNK_NIL)
+        pAllocator->mUnusedChunkRoot[tree] = node;
+    else
+        pNodes[parent].mLink[tree].mChild[dir] = node;
+
+    // Sentinel is always black, so this stops at the root
+    while (pNodes[pNodes[node].mLink[tree].mParent].mLink[tree].mRed)
+    {
+        parent = pNodes[node].mLink[tree].mParent;
+        const uint32_t grandParent = pNodes[parent].mLink[tree].mParent;
+        const uint32_t side = pNodes[grandParent].mLink[tree].mChild[0] == parent ? 0 : 1;
+        const uint32_t uncle = pNodes[grandParent].mLink[tree].mChild[!side];
+
+        if (pNodes[uncle].mLink[tree].mRed)
+        {
+            pNodes[parent].mLink[tree].mRed = 0;
+            pNodes[uncle].mLink[tree].mRed = 0;
+            pNodes[grandParent].mLink[tree].mRed = 1;
+            node = grandParent;
+            continue;
+        }
+
+        if (pNodes[parent].mLink[tree].mChild[!side] == node)
+        {
+            node = parent;
+            bufferChunkTreeRotate(pAllocator, tree, node, side);
+            parent = pNodes[node].mLink[tree].mParent;
+        }
+
+        pNodes[parent].mLink[tree].mRed = 0;
+        pNodes[grandParent].mLink[tree].mRed = 1;
+        bufferChunkTreeRotate(pAllocator, tree, grandParent, !side);
+    }
+
+    pNodes[pAllocator->mUnusedChunkRoot[tree]].mLink[tree].mRed = 0;
+}
+
+static void bufferChunkTreeTransplant(BufferChunkAllocator* pAllocator, uint32_t tree, uint32_t node, uint32_t replacement)
+{
+    BufferChunkNode* pNodes = pAllocator->pUnusedChunkNodes;
+    const uint32_t   parent = pNodes[node].mLink[tree].mParent;
+    if (parent == BUFFER_CHUNK_NIL)
+        pAllocator->mUnusedChunkRoot[tree] = replacement;
+    else
+        pNodes[parent].mLink[tree].mChild[pNodes[parent].mLink[tree].mChild[0] == node ? 0 : 1] = replacement;
+    // Also written on the sentinel, the fixup below relies on it
+    pNodes[replacement].mLink[tree].mParent = parent;
+}
+
+static inline uint32_t bufferChunkTreeMinimum(const BufferChunkNode* pNodes, uint32_t tree, uint32_t node)
+{
+    while (pNodes[node].mLink[tree].mChild[0] != BUFFER_CHUNK_NIL)
+        node = pNodes[node].mLink[tree].mChild[0];
+    return node;
+}
+
+static void bufferChunkTreeErase(BufferChunkAllocator* pAllocator, uint32_t tree, uint32_t node)
+{
+    BufferChunkNode* pNodes = pAllocator->pUnusedChunkNodes;
+    BufferChunkTreeLink* link = &pNodes[node].mLink[tree];
+
+    uint32_t removedRed = link->mRed;
+    uint32_t fixup = BUFFER_CHUNK_NIL;
+    if (link->mChild[0] == BUFFER_CHUNK_NIL || link->mChild[1] == BUFFER_CHUNK_NIL)
+    {
+        fixup = link->mChild[link->mChild[0] == BUFFER_CHUNK_NIL ? 1 : 0];
+        bufferChunkTreeTransplant(pAllocator, tree, node, fixup);
+    }
+    else
+    {
+        const uint32_t       successor = bufferChunkTreeMinimum(pNodes, tree, link->mChild[1]);
+        BufferChunkTreeLink* successorLink = &pNodes[successor].mLink[tree];
+        removedRed = successorLink->mRed;
+        fixup = successorLink->mChild[1];
+        if (successorLink->mParent == node)
+        {
+            pNodes[fixup].mLink[tree].mParent = successor;
+        }
+        else
+        {
+            bufferChunkTreeTransplant(pAllocator, tree, successor, fixup);
+            successorLink->mChild[1] = link->mChild[1];
+            pNodes[successorLink->mChild[1]].mLink[tree].mParent = successor;
+        }
+        bufferChunkTreeTransplant(pAllocator, tree, node, successor);
+        successorLink->mChild[0] = link->mChild[0];
+        pNodes[successorLink->mChild[0]].mLink[tree].mParent = successor;
+        successorLink->mRed = link->mRed;
+    }
+
+    if (removedRed)
+        return;
+
+    while (fixup != pAllocator->mUnusedChunkRoot[tree] && !pNodes[fixup].mLink[tree].mRed)
+    {
+        const uint32_t parent = pNodes[fixup].mLink[tree].mParent;
+        // The sibling of a removed black node can't be the sentinel, so this is unambiguous even when fixup is the sentinel
+        const uint32_t side = pNodes[parent].mLink[tree].mChild[0] == fixup ? 0 : 1;
+        uint32_t       sibling = pNodes[parent].mLink[tree].mChild[!side];
+
+        if (pNodes[sibling].mLink[tree].mRed)
+        {
+            pNodes[sibling].mLink[tree].mRed = 0;
+            pNodes[parent].mLink[tree].mRed = 1;
+            bufferChunkTreeRotate(pAllocator, tree, parent, side);
+            sibling = pNodes[parent].mLink[tree].mChild[!side];
+        }
+
+        BufferChunkTreeLink* siblingLink = &pNodes[sibling].mLink[tree];
+        if (!pNodes[siblingLink->mChild[0]].mLink[tree].mRed && !pNodes[siblingLink->mChild[1]].mLink[tree].mRed)
+        {
+            siblingLink->mRed = 1;
+            fixup = parent;
+            continue;
+        }
+
+        if (!pNodes[siblingLink->mChild[!side]].mLink[tree].mRed)
+        {
+            pNodes[siblingLink->mChild[side]].mLink[tree].mRed = 0;
+            siblingLink->mRed = 1;
+            bufferChunkTreeRotate(pAllocator, tree, sibling, !side);
+            sibling = pNodes[parent].mLink[tree].mChild[!side];
+            siblingLink = &pNodes[sibling].mLink[tree];
+        }
+
+        siblingLink->mRed = pNodes[parent].mLink[tree].mRed;
+        pNodes[parent].mLink[tree].mRed = 0;
+        pNodes[siblingLink->mChild[!side]].mLink[tree].mRed = 0;
+        bufferChunkTreeRotate(pAllocator, tree, parent, side);
+        fixup = pAllocator->mUnusedChunkRoot[tree];
+    }
+    pNodes[fixup].mLink[tree].mRed = 0;
+}
+
+static uint32_t bufferChunkTreeNext(const BufferChunkNode* pNodes, uint32_t tree, uint32_t node)
+{
+    if (pNodes[node].mLink[tree].mChild[1] != BUFFER_CHUNK_NIL)
+        return bufferChunkTreeMinimum(pNodes, tree, pNodes[node].mLink[tree].mChild[1]);
+
+    uint32_t parent = pNodes[node].mLink[tree].mParent;
+    while (parent != BUFFER_CHUNK_NIL && pNodes[parent].mLink[tree].mChild[1] == node)
+    {
+        node = parent;
+        parent = pNodes[node].mLink[tree].mParent;
+    }
+    return parent;
+}
+
+// Last unused chunk starting at or before offset
+static uint32_t findUnusedChunkByOffset(const BufferChunkAllocator* pAllocator, uint32_t offset)
+{
+    const BufferChunkNode* pNodes = pAllocator->pUnusedChunkNodes;
+    uint32_t               result = BUFFER_CHUNK_NIL;
+    for (uint32_t it = pAllocator->mUnusedChunkRoot[BUFFER_CHUNK_OFFSET_TREE]; it != BUFFER_CHUNK_NIL;)
+    {
+        const bool before = pNodes[it].mChunk.mOffset <= offset;
+        if (before)
+            result = it;
+        it = pNodes[it].mLink[BUFFER_CHUNK_OFFSET_TREE].mChild[before ? 1 : 0];
+    }
+    return result;
+}
+
+// Smallest unused chunk of at least size bytes
+static uint32_t findUnusedChunkBySize(const BufferChunkAllocator* pAllocator, uint64_t size)
+{
+    const BufferChunkNode* pNodes = pAllocator->pUnusedChunkNodes;
+    uint32_t               result = BUFFER_CHUNK_NIL;
+    for (uint32_t it = pAllocator->mUnusedChunkRoot[BUFFER_CHUNK_SIZE_TREE]; it != BUFFER_CHUNK_NIL;)
+    {
+        const bool fits = pNodes[it].mChunk.mSize >= size;
+        if (fits)
+            result = it;
+        it = pNodes[it].mLink[BUFFER_CHUNK_SIZE_TREE].mChild[fits ? 0 : 1];
+    }
+    return result;
+}
+
+static inline uint32_t getBufferChunkPadding(const BufferChunk* pChunk, uint32_t alignment)
+{
+    if (alignment <= 1)
+        return 0;
+    const uint32_t padding = pChunk->mOffset % alignment;
+    return padding ? alignment - padding : 0;
+}
+
+static inline bool bufferChunkFits(const BufferChunk* pChunk, uint32_t size, uint32_t alignment)
+{
+    return (uint64_t)pChunk->mSize >= (uint64_t)size + getBufferChunkPadding(pChunk, alignment);
+}
+
+static uint32_t findBestFitUnusedChunk(const BufferChunkAllocator* pAllocator, uint32_t size, uint32_t alignment)
+{
+    const BufferChunkNode* pNodes = pAllocator->pUnusedChunkNodes;
+
+    uint32_t node = findUnusedChunkBySize(pAllocator, size);
+    for (uint32_t i = 0; node != BUFFER_CHUNK_NIL && i < BUFFER_CHUNK_ALIGNMENT_PROBE_COUNT; ++i)
+    {
+        if (bufferChunkFits(&pNodes[node].mChunk, size, alignment))
+            return node;
+        node = bufferChunkTreeNext(pNodes, BUFFER_CHUNK_SIZE_TREE, node);
+    }
+    if (node == BUFFER_CHUNK_NIL)
+        return BUFFER_CHUNK_NIL;
+
+    // Any chunk of size + alignment - 1 bytes fits whatever its offset is
+    const uint32_t alignedNode = findUnusedChunkBySize(pAllocator, (uint64_t)size + alignment - 1);
+    if (alignedNode != BUFFER_CHUNK_NIL)
+        return alignedNode;
+
+    // Buffer is almost full, only lucky offsets can fit now
+    for (; node != BUFFER_CHUNK_NIL; node = bufferChunkTreeNext(pNodes, BUFFER_CHUNK_SIZE_TREE, node))
+    {
+        if (bufferChunkFits(&pNodes[node].mChunk, size, alignment))
+            return node;
+    }
+    return BUFFER_CHUNK_NIL;
+}
+
+static uint32_t addUnusedChunk(BufferChunkAllocator* pAllocator, uint32_t prev, uint32_t offset, uint32_t size)
+{
+    ASSERT(size > 0);
+
+    uint32_t node = pAllocator->mFreeNode;
+    if (node != BUFFER_CHUNK_NIL)
+    {
+        pAllocator->mFreeNode = pAllocator->pUnusedChunkNodes[node].mNext;
+    }
+    else
+    {
+        node = (uint32_t)arrlenu(pAllocator->pUnusedChunkNodes);
+        BufferChunkNode newNode = {};
+        arrpush(pAllocator->pUnusedChunkNodes, newNode);
+    }
+
+    BufferChunkNode* pNodes = pAllocator->pUnusedChunkNodes;
+    pNodes[node].mChunk = { offset, size };
+
+    // Unused chunks are sorted by offset, insert it after prev
+    const uint32_t next = prev != BUFFER_CHUNK_NIL ? pNodes[prev].mNext : pAllocator->mFirstUnusedChunk;
+    pNodes[node].mPrev = prev;
+    pNodes[node].mNext = next;
+    if (prev != BUFFER_CHUNK_NIL)
+        pNodes[prev].mNext = node;
+    else
+        pAllocator->mFirstUnusedChunk = node;
+    if (next != BUFFER_CHUNK_NIL)
+        pNodes[next].mPrev = node;
+
+    bufferChunkTreeInsert(pAllocator, BUFFER_CHUNK_OFFSET_TREE, node);
+    bufferChunkTreeInsert(pAllocator, BUFFER_CHUNK_SIZE_TREE, node);
+    ++pAllocator->mUnusedChunkCount;
+    return node;
+}
+
+static void removeUnusedChunk(BufferChunkAllocator* pAllocator, uint32_t node)
+{
+    bufferChunkTreeErase(pAllocator, BUFFER_CHUNK_OFFSET_TREE, node);
+    bufferChunkTreeErase(pAllocator, BUFFER_CHUNK_SIZE_TREE, node);
+
+    BufferChunkNode* pNodes = pAllocator->pUnusedChunkNodes;
+    const uint32_t   prev = pNodes[node].mPrev;
+    const uint32_t   next = pNodes[node].mNext;
+    if (prev != BUFFER_CHUNK_NIL)
+        pNodes[prev].mNext = next;
+    else
+        pAllocator->mFirstUnusedChunk = next;
+    if (next != BUFFER_CHUNK_NIL)
+        pNodes[next].mPrev = prev;
+
+    pNodes[node] = {};
+    pNodes[node].mNext = pAllocator->mFreeNode;
+    pAllocator->mFreeNode = node;
+    --pAllocator->mUnusedChunkCount;
+}
+
+// Chunks only ever shrink or grow into adjacent memory, so they keep their place in the offset tree and list, only the size tree changes
+static void resizeUnusedChunk(BufferChunkAllocator* pAllocator, uint32_t node, uint32_t offset, uint32_t size)
+{
+    ASSERT(size > 0);
+    BufferChunkNode* pNodes = pAllocator->pUnusedChunkNodes;
+    ASSERT(pNodes[node].mPrev == BUFFER_CHUNK_NIL ||
+           pNodes[pNodes[node].mPrev].mChunk.mOffset + pNodes[pNodes[node].mPrev].mChunk.mSize <= offset);
+    ASSERT(pNodes[node].mNext == BUFFER_CHUNK_NIL || offset + size <= pNodes[pNodes[node].mNext].mChunk.mOffset);
+
+    bufferChunkTreeErase(pAllocator, BUFFER_CHUNK_SIZE_TREE, node);
+    pNodes[node].mChunk = { offset, size };
+    bufferChunkTreeInsert(pAllocator, BUFFER_CHUNK_SIZE_TREE, node);
+}
+
+// Removes [offset, offset + size) from the unused chunk node, keeping whatever is left before and after it
+static void claimUnusedChunk(BufferChunkAllocator* pAllocator, uint32_t node, uint32_t offset, uint32_t size)
+{
+    const BufferChunk chunk = pAllocator->pUnusedChunkNodes[node].mChunk;
+    const uint32_t    chunkEnd = chunk.mOffset + chunk.mSize;
+    const uint32_t    claimEnd = offset + size;
+    ASSERT(chunk.mOffset <= offset && claimEnd <= chunkEnd);
+
+    if (chunk.mOffset < offset)
+    {
+        // There's unnused memory before the claimed chunk
+        resizeUnusedChunk(pAllocator, node, chunk.mOffset, offset - chunk.mOffset);
+        // And maybe after it
+        if (claimEnd < chunkEnd)
+            addUnusedChunk(pAllocator, node, claimEnd, chunkEnd - claimEnd);
+    }
+    else if (claimEnd < chunkEnd)
+    {
+        // There's unnused memory after the claimed chunk
+        resizeUnusedChunk(pAllocator, node, claimEnd, chunkEnd - claimEnd);
+    }
+    else
+    {
+        // Exact chunk
+        removeUnusedChunk(pAllocator, node);
+    }
+
+    pAllocator->mUnusedSize -= size;
+    ++pAllocator->mUsedChunkCount;
+}
+
 typedef struct BufferChunkAllocatorDesc
 {
     Buffer* pBuffer;
@@ -3348,8 +4358,11 @@ static void addBufferChunkAllocator(BufferChunkAllocatorDesc* pDesc, BufferChunk
     pOut->pBuffer = pDesc->pBuffer;
     pOut->mSize = (uint32_t)pDesc->pBuffer->mSize;
 
-    BufferChunk firstUnusedChunk{ 0, (uint32_t)pDesc->pBuffer->mSize };
-    arrpush(pOut->mUnusedChunks, firstUnusedChunk);
+    // Node 0 is the tree sentinel
+    BufferChunkNode sentinel = {};
+    arrpush(pOut->pUnusedChunkNodes, sentinel);
+    addUnusedChunk(pOut, BUFFER_CHUNK_NIL, 0, pOut->mSize);
+    pOut->mUnusedSize = pOut->mSize;
 }
 
 static void removeBufferChunkAllocator(BufferChunkAllocator* pBuffer)
@@ -3359,7 +4372,7 @@ static void removeBufferChunkAllocator(BufferChunkAllocator* pBuffer)
 
     if (pBuffer->pBuffer)
     {
-        ASSERT(arrlen(pBuffer->mUnusedChunks) == 1 && "Expecting just one chunk since the buffer is completely empty");
+        ASSERT(pBuffer->mUnusedChunkCount == 1 && "Expecting just one chunk since the buffer is completely empty");
 
         // We are checking that the unnused chunk offset is 0 because we currently assume that a BufferChunkAllocator covers the entire
         // buffer, but we could change this to allow to have several BufferChunkAllocators over the same buffer, each working on a fixed
@@ -3377,10 +4390,11 @@ static void removeBufferChunkAllocator(BufferChunkAllocator* pBuffer)
         //       if mSize is 0 we would use the size of the buffer.
         //       We would also need to consider if we want to expose the add/removeBufferChunkAllocator interface to the user and let him
         //       allocate the BufferChunkAllocator or we want to include this splitting logic in addGeometryBuffer.
-        ASSERT(pBuffer->mUnusedChunks && (pBuffer->mUnusedChunks[0].mOffset == 0) && (pBuffer->mUnusedChunks[0].mSize == pBuffer->mSize) &&
+        ASSERT(pBuffer->pUnusedChunkNodes && (pBuffer->pUnusedChunkNodes[pBuffer->mFirstUnusedChunk].mChunk.mOffset == 0) &&
+               (pBuffer->pUnusedChunkNodes[pBuffer->mFirstUnusedChunk].mChunk.mSize == pBuffer->mSize) &&
                "Expecting just one chunk since the buffer is completely empty");
 
-        arrfree(pBuffer->mUnusedChunks);
+        arrfree(pBuffer->pUnusedChunkNodes);
     }
 }
 
@@ -3480,48 +4494,15 @@ void addGeometryBufferPart(BufferChunkAllocator* pBuffer, uint32_t size, uint32_
     {
         ASSERT(pRequestedChunk->mOffset + pRequestedChunk->mSize <= pBuffer->mSize);
 
-        // Try to allocate the requested slot
-        for (uint32_t i = 0; i < arrlenu(pBuffer->mUnusedChunks); ++i)
+        // Try to allocate the requested slot, only the last unused chunk starting before it can contain it
+        const uint32_t node = findUnusedChunkByOffset(pBuffer, pRequestedChunk->mOffset);
+        if (node != BUFFER_CHUNK_NIL)
         {
-            BufferChunk* chunk = &pBuffer->mUnusedChunks[i];
-
-            const uint32_t chunkEnd = chunk->mOffset + chunk->mSize;
-            const uint32_t requestedEnd = pRequestedChunk->mOffset + pRequestedChunk->mSize;
-            if (chunk->mOffset <= pRequestedChunk->mOffset && chunkEnd >= requestedEnd)
+            const BufferChunk* chunk = &pBuffer->pUnusedChunkNodes[node].mChunk;
+            if ((uint64_t)chunk->mOffset + chunk->mSize >= (uint64_t)pRequestedChunk->mOffset + pRequestedChunk->mSize)
             {
-                ++pBuffer->mUsedChunkCount;
-
                 *pOut = *pRequestedChunk;
-
-                if (chunk->mOffset == pRequestedChunk->mOffset && chunkEnd == requestedEnd)
-                {
-                    // Exact chunk
-                    arrdel(pBuffer->mUnusedChunks, i);
-                    return;
-                }
-
-                // There's unnused memory before the requested chunk
-                if (chunk->mOffset < pRequestedChunk->mOffset)
-                {
-                    BufferChunk prevChunk = { chunk->mOffset, pRequestedChunk->mOffset - chunk->mOffset };
-                    arrins(pBuffer->mUnusedChunks, i, prevChunk);
-                    i++;
-                    chunk = &pBuffer->mUnusedChunks[i];
-                }
-
-                if (chunkEnd == requestedEnd)
-                {
-                    // We consummed the full chunk
-                    arrdel(pBuffer->mUnusedChunks, i);
-                }
-                else
-                {
-                    // There's unnused memory after the requested chunk
-                    chunk->mSize = chunkEnd - requestedEnd;
-                    chunk->mOffset = pRequestedChunk->mOffset + pRequestedChunk->mSize;
-                    ASSERT(chunk->mSize > 0);
-                }
-
+                claimUnusedChunk(pBuffer, node, pRequestedChunk->mOffset, pRequestedChunk->mSize);
                 return;
             }
         }
@@ -3530,102 +4511,309 @@ void addGeometryBufferPart(BufferChunkAllocator* pBuffer, uint32_t size, uint32_
         return;
     }
 
-    // TODO binary search. (unused chunk array is sorted already)
-    for (uint32_t i = 0; i < arrlenu(pBuffer->mUnusedChunks); ++i)
+    const uint32_t node = findBestFitUnusedChunk(pBuffer, size, alignment);
+    if (node == BUFFER_CHUNK_NIL)
     {
-        BufferChunk* chunk = &pBuffer->mUnusedChunks[i];
+        *pOut = {};
+        ASSERT(false);
+        return;
+    }
 
-        if (chunk->mSize < size)
-            continue;
+    const BufferChunk* chunk = &pBuffer->pUnusedChunkNodes[node].mChunk;
+    pOut->mOffset = chunk->mOffset + getBufferChunkPadding(chunk, alignment);
+    pOut->mSize = size;
+    claimUnusedChunk(pBuffer, node, pOut->mOffset, size);
+}
 
-        if (alignment > 0)
-        {
-            uint32_t padding = chunk->mOffset % alignment;
-            if (padding > 0)
-                padding = alignment - padding;
+void removeGeometryBufferPart(BufferChunkAllocator* pBuffer, BufferChunk* pChunk)
+{
+    ASSERT(pChunk->mSize ? pBuffer != NULL : true);
+    if (!pBuffer || pChunk->mSize == 0)
+        return;
 
-            if (chunk->mSize - padding < size)
-                continue;
+    ASSERT(pBuffer->mUsedChunkCount);
 
-            if (padding > 0)
-            {
-                BufferChunk paddingChunk = {
-                    chunk->mOffset,
-                    padding,
-                };
+    --pBuffer->mUsedChunkCount;
+    pBuffer->mUnusedSize += pChunk->mSize;
 
-                arrins(pBuffer->mUnusedChunks, i, paddingChunk);
-                i++;
+    const uint32_t partEnd = pChunk->mOffset + pChunk->mSize;
 
-                chunk = &pBuffer->mUnusedChunks[i];
-                chunk->mOffset += padding;
-                chunk->mSize -= padding;
-            }
-        }
+    BufferChunkNode* pNodes = pBuffer->pUnusedChunkNodes;
+    const uint32_t   prev = findUnusedChunkByOffset(pBuffer, pChunk->mOffset);
+    const uint32_t   next = prev != BUFFER_CHUNK_NIL ? pNodes[prev].mNext : pBuffer->mFirstUnusedChunk;
+    ASSERT((prev == BUFFER_CHUNK_NIL || pNodes[prev].mChunk.mOffset + pNodes[prev].mChunk.mSize <= pChunk->mOffset) &&
+           "Chunk released twice");
+    ASSERT((next == BUFFER_CHUNK_NIL || partEnd <= pNodes[next].mChunk.mOffset) && "Chunk released twice");
 
-        pOut->mOffset = chunk->mOffset;
-        pOut->mSize = size;
+    const bool mergePrev = prev != BUFFER_CHUNK_NIL && pNodes[prev].mChunk.mOffset + pNodes[prev].mChunk.mSize == pChunk->mOffset;
+    const bool mergeNext = next != BUFFER_CHUNK_NIL && partEnd == pNodes[next].mChunk.mOffset;
+
+    if (mergePrev && mergeNext)
+    {
+        // pChunk fills the gap between two unused chunks, merge all of them in prev
+        const uint32_t nextEnd = pNodes[next].mChunk.mOffset + pNodes[next].mChunk.mSize;
+        const uint32_t prevOffset = pNodes[prev].mChunk.mOffset;
+        removeUnusedChunk(pBuffer, next);
+        resizeUnusedChunk(pBuffer, prev, prevOffset, nextEnd - prevOffset);
+    }
+    else if (mergePrev) // If pChunk goes after prev, merge both
+    {
+        resizeUnusedChunk(pBuffer, prev, pNodes[prev].mChunk.mOffset, pNodes[prev].mChunk.mSize + pChunk->mSize);
+    }
+    else if (mergeNext) // If pChunk goes before next, merge both
+    {
+        resizeUnusedChunk(pBuffer, next, pChunk->mOffset, pNodes[next].mChunk.mSize + pChunk->mSize);
+    }
+    else
+    {
+        addUnusedChunk(pBuffer, prev, pChunk->mOffset, pChunk->mSize);
+    }
+}
 
-        chunk->mOffset += size;
-        chunk->mSize -= size;
+void getBufferChunkAllocatorStats(const BufferChunkAllocator* pBuffer, BufferChunkAllocatorStats* pOutStats)
+{
+    ASSERT(pBuffer);
+    ASSERT(pOutStats);
 
-        if (chunk->mSize == 0)
-        {
-            arrdel(pBuffer->mUnusedChunks, i);
-        }
+    *pOutStats = {};
+    pOutStats->mUsedChunkCount = pBuffer->mUsedChunkCount;
+    pOutStats->mUnusedChunkCount = pBuffer->mUnusedChunkCount;
+    pOutStats->mUnusedSize = pBuffer->mUnusedSize;
 
-        ++pBuffer->mUsedChunkCount;
+    uint32_t largest = pBuffer->mUnusedChunkRoot[BUFFER_CHUNK_SIZE_TREE];
+    if (largest == BUFFER_CHUNK_NIL)
         return;
-    }
+    while (pBuffer->pUnusedChunkNodes[largest].mLink[BUFFER_CHUNK_SIZE_TREE].mChild[1] != BUFFER_CHUNK_NIL)
+        largest = pBuffer->pUnusedChunkNodes[largest].mLink[BUFFER_CHUNK_SIZE_TREE].mChild[1];
 
-    *pOut = {};
-    ASSERT(false);
+    pOutStats->mLargestUnusedChunk = pBuffer->pUnusedChunkNodes[largest].mChunk.mSize;
+    pOutStats->mFragmentation = 1.0f - (float)pOutStats->mLargestUnusedChunk / (float)pOutStats->mUnusedSize;
 }
 
-void removeGeometryBufferPart(BufferChunkAllocator* pBuffer, BufferChunk* pChunk)
+uint32_t planGeometryBufferMoves(const GeometryBufferMovePlanDesc* pDesc, GeometryBufferMove* pOutMoves, uint32_t maxMoves)
 {
-    ASSERT(pChunk->mSize ? pBuffer != NULL : true);
-    if (!pBuffer || pChunk->mSize == 0)
-        return;
+    ASSERT(pDesc);
+    ASSERT(pOutMoves || !maxMoves);
+    if (!pDesc->mPartCount || !pDesc->mUnusedChunkCount || !maxMoves)
+        return 0;
 
-    ASSERT(pBuffer->mUsedChunkCount);
+    // Destinations are carved out of the gaps as moves get planned, gaps stay sorted by offset
+    BufferChunk* pGaps = NULL;
+    arrsetlen(pGaps, pDesc->mUnusedChunkCount);
+    memcpy(pGaps, pDesc->pUnusedChunks, pDesc->mUnusedChunkCount * sizeof(BufferChunk));
 
-    --pBuffer->mUsedChunkCount;
+    uint32_t largestGap = 0;
+    for (uint32_t i = 0; i < pDesc->mUnusedChunkCount; ++i)
+    {
+        ASSERT(i == 0 || pGaps[i - 1].mOffset + pGaps[i - 1].mSize <= pGaps[i].mOffset);
+        largestGap = max(largestGap, pGaps[i].mSize);
+    }
 
-    const uint64_t partEnd = pChunk->mOffset + pChunk->mSize;
+    uint32_t* pOffsets = (uint32_t*)tf_malloc(pDesc->mPartCount * sizeof(uint32_t));
+    uint32_t* pIndices = (uint32_t*)tf_malloc(pDesc->mPartCount * sizeof(uint32_t));
+    for (uint32_t i = 0; i < pDesc->mPartCount; ++i)
+    {
+        pOffsets[i] = pDesc->pParts[i].mOffset;
+        pIndices[i] = i;
+    }
+    sortUInt32KeyIndex(pOffsets, pIndices, pDesc->mPartCount);
 
-    // TODO binary search. (unused chunk array is sorted already)
-    uint64_t i = 0;
-    for (; i < arrlenu(pBuffer->mUnusedChunks); ++i)
+    uint32_t moveCount = 0;
+    uint64_t movedBytes = 0;
+    // Moving the last parts first frees the end of the buffer. Their old location is never reused here since it's above all remaining
+    // parts, so no destination can overlap a source.
+    for (uint32_t i = pDesc->mPartCount; i-- > 0 && moveCount < maxMoves;)
     {
-        BufferChunk* chunk = &pBuffer->mUnusedChunks[i];
-        if (partEnd < chunk->mOffset)
+        const uint32_t     partIndex = pIndices[i];
+        const BufferChunk* pPart = &pDesc->pParts[partIndex];
+
+        // Everything below the first gap is already packed
+        if (!arrlenu(pGaps) || pPart->mOffset < pGaps[0].mOffset)
             break;
+        if (!pPart->mSize || pPart->mSize > largestGap)
+            continue;
+        if (pDesc->mMaxBytes && movedBytes + pPart->mSize > pDesc->mMaxBytes)
+            continue;
 
-        auto chunkEnd = chunk->mOffset + chunk->mSize;
-        if (chunkEnd == pChunk->mOffset) // if pChunk goes after chunk, merge both
+        const uint32_t alignment = pDesc->pAlignments ? pDesc->pAlignments[partIndex] : 0;
+        for (uint32_t g = 0; g < arrlenu(pGaps) && pGaps[g].mOffset < pPart->mOffset; ++g)
         {
-            chunk->mSize += pChunk->mSize;
-            if (i + 1 < arrlenu(pBuffer->mUnusedChunks)) // If there's another empty chunk after pChunk, merge that one too
+            const BufferChunk gap = pGaps[g];
+            const uint32_t    padding = getBufferChunkPadding(&gap, alignment);
+            if ((uint64_t)gap.mSize < (uint64_t)pPart->mSize + padding)
+                continue;
+
+            GeometryBufferMove* pMove = &pOutMoves[moveCount++];
+            pMove->mPartIndex = partIndex;
+            pMove->mSrc = *pPart;
+            pMove->mDst = { gap.mOffset + padding, pPart->mSize };
+            movedBytes += pPart->mSize;
+
+            const uint32_t dstEnd = pMove->mDst.mOffset + pMove->mDst.mSize;
+            const uint32_t tail = gap.mOffset + gap.mSize - dstEnd;
+            if (padding && tail)
             {
-                if (partEnd == pBuffer->mUnusedChunks[i + 1].mOffset)
-                {
-                    chunk->mSize += pBuffer->mUnusedChunks[i + 1].mSize;
-                    arrdel(pBuffer->mUnusedChunks, i + 1);
-                }
+                pGaps[g].mSize = padding;
+                BufferChunk tailGap = { dstEnd, tail };
+                arrins(pGaps, g + 1, tailGap);
             }
-            return;
+            else if (padding)
+            {
+                pGaps[g].mSize = padding;
+            }
+            else if (tail)
+            {
+                pGaps[g] = { dstEnd, tail };
+            }
+            else
+            {
+                arrdel(pGaps, g);
+            }
+
+            if (gap.mSize == largestGap)
+            {
+                largestGap = 0;
+                for (uint32_t j = 0; j < arrlenu(pGaps); ++j)
+                    largestGap = max(largestGap, pGaps[j].mSize);
+            }
+            break;
         }
+    }
 
-        if (partEnd == chunk->mOffset) // If pChunk goes after chunk, merge both
+    tf_free(pIndices);
+    tf_free(pOffsets);
+    arrfree(pGaps);
+    return moveCount;
+}
+
+static void planGeometryBufferCompaction(const GeometryBufferCompactionDesc* pDesc, uint32_t binding, GeometryBufferCompaction* pOut)
+{
+    BufferChunkAllocator* pAllocator = binding < MAX_VERTEX_BINDINGS ? &pDesc->pGeometryBuffer->mVertex[binding]
+                                                                     : &pDesc->pGeometryBuffer->mIndex;
+    if (!pAllocator->pBuffer || !pAllocator->mUnusedChunkCount)
+        return;
+    if (pDesc->mMaxBytes && pOut->mMovedBytes >= pDesc->mMaxBytes)
+        return;
+
+    BufferChunk* pUnusedChunks = NULL;
+    for (uint32_t node = pAllocator->mFirstUnusedChunk; node != BUFFER_CHUNK_NIL; node = pAllocator->pUnusedChunkNodes[node].mNext)
+        arrpush(pUnusedChunks, pAllocator->pUnusedChunkNodes[node].mChunk);
+
+    BufferChunk* pParts = NULL;
+    uint32_t*    pAlignments = NULL;
+    Geometry**   ppPartGeometries = NULL;
+    for (uint32_t i = 0; i < pDesc->mGeometryCount; ++i)
+    {
+        Geometry* pGeom = pDesc->ppGeometries[i];
+        ASSERT(pGeom->pGeometryBuffer == pDesc->pGeometryBuffer);
+        if (binding < MAX_VERTEX_BINDINGS)
         {
-            chunk->mOffset = pChunk->mOffset;
-            chunk->mSize += pChunk->mSize;
-            return;
+            if (binding >= pGeom->mVertexBufferCount || !pGeom->mVertexBufferChunks[binding].mSize)
+                continue;
+            arrpush(pParts, pGeom->mVertexBufferChunks[binding]);
+            arrpush(pAlignments, pGeom->mVertexStrides[binding]);
         }
+        else
+        {
+            if (!pGeom->mIndexBufferChunk.mSize)
+                continue;
+            arrpush(pParts, pGeom->mIndexBufferChunk);
+            arrpush(pAlignments, pGeom->mIndexType == INDEX_TYPE_UINT16 ? (uint32_t)sizeof(uint16_t) : (uint32_t)sizeof(uint32_t));
+        }
+        arrpush(ppPartGeometries, pGeom);
+    }
+
+    const uint32_t      partCount = (uint32_t)arrlenu(pParts);
+    GeometryBufferMove* pMoves = partCount ? (GeometryBufferMove*)tf_malloc(partCount * sizeof(GeometryBufferMove)) : NULL;
+
+    GeometryBufferMovePlanDesc planDesc = {};
+    planDesc.pUnusedChunks = pUnusedChunks;
+    planDesc.mUnusedChunkCount = (uint32_t)arrlenu(pUnusedChunks);
+    planDesc.pParts = pParts;
+    planDesc.pAlignments = pAlignments;
+    planDesc.mPartCount = partCount;
+    planDesc.mMaxBytes = pDesc->mMaxBytes ? pDesc->mMaxBytes - pOut->mMovedBytes : 0;
+    const uint32_t moveCount = planGeometryBufferMoves(&planDesc, pMoves, partCount);
+
+    for (uint32_t i = 0; i < moveCount; ++i)
+    {
+        // Claim the destination right away so that new parts can't be allocated there
+        BufferChunk dst = {};
+        addGeometryBufferPart(pAllocator, pMoves[i].mDst.mSize, 0, &dst, &pMoves[i].mDst);
+        ASSERT(dst.mOffset == pMoves[i].mDst.mOffset && dst.mSize == pMoves[i].mDst.mSize);
+
+        GeometryBufferCompactionMove move = {};
+        move.pGeometry = ppPartGeometries[pMoves[i].mPartIndex];
+        move.mBinding = binding;
+        move.mSrc = pMoves[i].mSrc;
+        move.mDst = pMoves[i].mDst;
+        arrpush(pOut->pMoves, move);
+        pOut->mMovedBytes += move.mSrc.mSize;
+    }
+
+    tf_free(pMoves);
+    arrfree(ppPartGeometries);
+    arrfree(pAlignments);
+    arrfree(pParts);
+    arrfree(pUnusedChunks);
+}
+
+void beginGeometryBufferCompaction(const GeometryBufferCompactionDesc* pDesc, GeometryBufferCompaction* pOut, SyncToken* token)
+{
+    ASSERT(pDesc);
+    ASSERT(pDesc->pGeometryBuffer);
+    ASSERT(pOut);
+
+    *pOut = {};
+    pOut->pGeometryBuffer = pDesc->pGeometryBuffer;
+
+    planGeometryBufferCompaction(pDesc, MAX_VERTEX_BINDINGS, pOut);
+    for (uint32_t binding = 0; binding < MAX_VERTEX_BINDINGS; ++binding)
+        planGeometryBufferCompaction(pDesc, binding, pOut);
+
+    SyncToken lastToken = {};
+    for (ptrdiff_t i = 0; i < arrlen(pOut->pMoves); ++i)
+    {
+        const GeometryBufferCompactionMove* pMove = &pOut->pMoves[i];
+        BufferMoveDesc moveDesc = {};
+        moveDesc.pBuffer = pMove->mBinding < MAX_VERTEX_BINDINGS ? pDesc->pGeometryBuffer->mVertex[pMove->mBinding].pBuffer
+                                                                 : pDesc->pGeometryBuffer->mIndex.pBuffer;
+        moveDesc.mSrcOffset = pMove->mSrc.mOffset;
+        moveDesc.mDstOffset = pMove->mDst.mOffset;
+        moveDesc.mSize = pMove->mSrc.mSize;
+        moveDesc.mCurrentState = pDesc->mBufferState;
+        queueBufferMove(pResourceLoader, &moveDesc, &lastToken);
     }
 
-    arrins(pBuffer->mUnusedChunks, i, *pChunk);
+    if (token)
+        *token = max(*token, lastToken);
+}
+
+void endGeometryBufferCompaction(GeometryBufferCompaction* pCompaction)
+{
+    ASSERT(pCompaction);
+
+    GeometryBuffer* pGeometryBuffer = pCompaction->pGeometryBuffer;
+    for (ptrdiff_t i = 0; i < arrlen(pCompaction->pMoves); ++i)
+    {
+        GeometryBufferCompactionMove* pMove = &pCompaction->pMoves[i];
+        Geometry*                     pGeom = pMove->pGeometry;
+        if (pMove->mBinding < MAX_VERTEX_BINDINGS)
+        {
+            ASSERT(pGeom->mVertexBufferChunks[pMove->mBinding].mOffset == pMove->mSrc.mOffset);
+            pGeom->mVertexBufferChunks[pMove->mBinding] = pMove->mDst;
+            removeGeometryBufferPart(&pGeometryBuffer->mVertex[pMove->mBinding], &pMove->mSrc);
+        }
+        else
+        {
+            ASSERT(pGeom->mIndexBufferChunk.mOffset == pMove->mSrc.mOffset);
+            pGeom->mIndexBufferChunk = pMove->mDst;
+            removeGeometryBufferPart(&pGeometryBuffer->mIndex, &pMove->mSrc);
+        }
+    }
+
+    arrfree(pCompaction->pMoves);
+    *pCompaction = {};
 }
 
 void beginUpdateResource(BufferUpdateDesc* pBufferUpdate)
@@ -3841,7 +5029,40 @@ void flushResourceUpdates(FlushResourceUpdateDesc* pDesc)
 
 SyncToken getLastTokenCompleted() { return tfrg_atomic64_load_acquire(&pResourceLoader->mTokenCompleted); }
 
-bool isTokenCompleted(const SyncToken* token) { return *token <= tfrg_atomic64_load_acquire(&pResourceLoader->mTokenCompleted); }
+bool isTokenCompleted(const SyncToken* token)
+{
+    if (*token <= tfrg_atomic64_load_acquire(&pResourceLoader->mTokenCompleted))
+    {
+        return true;
+    }
+
+    // Token of a single request which completed before older lower priority requests
+    if (!tfrg_atomic32_load_acquire(&pResourceLoader->mCompletedExactTokenCount))
+    {
+        return false;
+    }
+
+    bool completed = false;
+    acquireMutex(&pResourceLoader->mTokenMutex);
+    for (ptrdiff_t i = 0; i < arrlen(pResourceLoader->mCompletedExactTokens) && !completed; ++i)
+    {
+        completed = pResourceLoader->mCompletedExactTokens[i] == *token;
+    }
+    releaseMutex(&pResourceLoader->mTokenMutex);
+    return completed;
+}
+
+void cancelResourceLoad(const SyncToken* token)
+{
+    if (!*token || isTokenCompleted(token))
+    {
+        return;
+    }
+
+    acquireMutex(&pResourceLoader->mCancelMutex);
+    arrpush(pResourceLoader->mCancelledTokens, *token);
+    releaseMutex(&pResourceLoader->mCancelMutex);
+}
 
 void waitForToken(const SyncToken* token) { waitForToken(pResourceLoader, token); }
 
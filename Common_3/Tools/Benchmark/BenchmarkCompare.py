@@ -0,0 +1,203 @@
+# Copyright (c) 2017-2025 The Forge Interactive Inc.
+#
+# This file is part of The-Forge
+# (see https://github.com/ConfettiFX/The-Forge).
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# Compares "BenchmarkStats-*.json" files written by dumpProfileBenchmark (run a unit test with -b <frames> --warmup <warmup>).
+# A timer regresses when its mean got slower with statistical significance (one sided Welch's t-test, Bonferroni corrected
+# over all compared timers) and by more than both the relative and the absolute threshold.
+# Exits with 1 when any timer or memory high-water mark regressed, so it can gate merges.
+#
+#   python3 BenchmarkCompare.py baseline.json candidate.json
+#   python3 BenchmarkCompare.py baselineDir candidateDir      (newest file of every application in both directories)
+
+import argparse
+import glob
+import json
+import math
+import os
+import sys
+
+MEMORY_KEYS = ["PeakProcessBytes", "PeakTrackedBytes", "PeakGpuUsedBytes", "PeakGpuAllocatedBytes"]
+
+
+def betacf(a, b, x):
+    # Continued fraction of the regularized incomplete beta function (modified Lentz)
+    tiny = 1e-300
+    qab = a + b
+    qap = a + 1.0
+    qam = a - 1.0
+    c = 1.0
+    d = 1.0 - qab * x / qap
+    d = tiny if abs(d) < tiny else d
+    d = 1.0 / d
+    h = d
+    for m in range(1, 300):
+        m2 = 2 * m
+        aa = m * (b - m) * x / ((qam + m2) * (a + m2))
+        d = 1.0 + aa * d
+        d = tiny if abs(d) < tiny else d
+        c = 1.0 + aa / c
+        c = tiny if abs(c) < tiny else c
+        d = 1.0 / d
+        h *= d * c
+        aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2))
+        d = 1.0 + aa * d
+        d = tiny if abs(d) < tiny else d
+        c = 1.0 + aa / c
+        c = tiny if abs(c) < tiny else c
+        d = 1.0 / d
+        delta = d * c
+        h *= delta
+        if abs(delta - 1.0) < 1e-12:
+            break
+    return h
+
+
+def betainc(a, b, x):
+    if x <= 0.0:
+        return 0.0
+    if x >= 1.0:
+        return 1.0
+    front = math.exp(math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b) + a * math.log(x) + b * math.log(1.0 - x))
+    if x < (a + 1.0) / (a + b + 2.0):
+        return front * betacf(a, b, x) / a
+    return 1.0 - front * betacf(b, a, 1.0 - x) / b
+
+
+def student_t_sf(t, df):
+    # P(T > t) of Student's t distribution
+    p = 0.5 * betainc(0.5 * df, 0.5, df / (df + t * t))
+    return p if t > 0.0 else 1.0 - p
+
+
+def welch_slower_p(base, cand):
+    # One sided p-value of "candidate mean > baseline mean"
+    if base["Samples"] < 2 or cand["Samples"] < 2:
+        return 1.0
+    vb = base["StdDev"] ** 2 / base["Samples"]
+    vc = cand["StdDev"] ** 2 / cand["Samples"]
+    delta = cand["Mean"] - base["Mean"]
+    if vb + vc == 0.0:
+        return 0.0 if delta > 0.0 else 1.0
+    t = delta / math.sqrt(vb + vc)
+    df = (vb + vc) ** 2 / ((vb * vb) / (base["Samples"] - 1) + (vc * vc) / (cand["Samples"] - 1))
+    return student_t_sf(t, df)
+
+
+def load(path):
+    with open(path, "r") as f:
+        return json.load(f)
+
+
+def newest_per_application(directory):
+    results = {}
+    for path in sorted(glob.glob(os.path.join(directory, "**", "*BenchmarkStats-*.json"), recursive=True), key=os.path.getmtime):
+        data = load(path)
+        results[data.get("Application", path)] = (path, data)
+    return results
+
+
+def timer_key(timer):
+    return "{}/{}/{}".format(timer["Type"], timer["Group"], timer["Name"])
+
+
+def compare(base, cand, args, out):
+    base_timers = {timer_key(t): t for t in base["Timers"]}
+    cand_timers = {timer_key(t): t for t in cand["Timers"]}
+    keys = [k for k in base_timers if k in cand_timers and base_timers[k]["Samples"] >= args.min_samples and
+            cand_timers[k]["Samples"] >= args.min_samples]
+    alpha = args.alpha / max(len(keys), 1)
+
+    regressions = 0
+    rows = []
+    for key in keys:
+        b = base_timers[key]
+        c = cand_timers[key]
+        delta = c["Mean"] - b["Mean"]
+        relative = delta / b["Mean"] if b["Mean"] > 0.0 else 0.0
+        p = welch_slower_p(b, c)
+        regressed = p < alpha and relative > args.threshold and delta > args.min_ms
+        regressions += regressed
+        if regressed or args.verbose:
+            rows.append((relative, key, b, c, p, regressed))
+
+    rows.sort(key=lambda row: -row[0])
+    for relative, key, b, c, p, regressed in rows:
+        out.write("  {:<10} {:<60} mean {:9.4f} -> {:9.4f} ms ({:+7.2f}%)  p95 {:9.4f} -> {:9.4f} ms  p={:.2e}\n".format(
+            "REGRESSED" if regressed else "", key, b["Mean"], c["Mean"], relative * 100.0, b["P95"], c["P95"], p))
+    for key in sorted(set(base_timers) - set(cand_timers)):
+        if args.verbose:
+            out.write("  {:<10} {}\n".format("missing", key))
+
+    base_memory = base.get("Memory", {})
+    cand_memory = cand.get("Memory", {})
+    for key in MEMORY_KEYS:
+        b = base_memory.get(key, 0)
+        c = cand_memory.get(key, 0)
+        if not b or not c:
+            continue
+        relative = (c - b) / b
+        regressed = relative > args.memory_threshold
+        regressions += regressed
+        if regressed or args.verbose:
+            out.write("  {:<10} {:<60} {:12d} -> {:12d} bytes ({:+7.2f}%)\n".format(
+                "REGRESSED" if regressed else "", "Memory/" + key, b, c, relative * 100.0))
+    return regressions, len(keys)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flag statistically significant regressions between two benchmark runs")
+    parser.add_argument("baseline", help="BenchmarkStats json file or directory")
+    parser.add_argument("candidate", help="BenchmarkStats json file or directory")
+    parser.add_argument("--alpha", type=float, default=0.01, help="family-wise significance level per application")
+    parser.add_argument("--threshold", type=float, default=0.05, help="minimum relative slowdown of the mean")
+    parser.add_argument("--min-ms", type=float, default=0.05, help="minimum absolute slowdown of the mean in ms")
+    parser.add_argument("--min-samples", type=int, default=8, help="timers with fewer samples are not compared")
+    parser.add_argument("--memory-threshold", type=float, default=0.10, help="maximum relative growth of a memory high-water mark")
+    parser.add_argument("-v", "--verbose", action="store_true", help="print every compared timer")
+    args = parser.parse_args()
+
+    if os.path.isdir(args.baseline) != os.path.isdir(args.candidate):
+        parser.error("baseline and candidate must both be files or both be directories")
+
+    if os.path.isdir(args.baseline):
+        base_runs = newest_per_application(args.baseline)
+        cand_runs = newest_per_application(args.candidate)
+    else:
+        base_runs = {"": (args.baseline, load(args.baseline))}
+        cand_runs = {"": (args.candidate, load(args.candidate))}
+
+    total = 0
+    for app in sorted(base_runs):
+        if app not in cand_runs:
+            print("{}: no candidate run".format(app))
+            continue
+        base_path, base = base_runs[app]
+        cand_path, cand = cand_runs[app]
+        print("{} -> {}".format(base_path, cand_path))
+        regressions, compared = compare(base, cand, args, sys.stdout)
+        print("{}: {} regression(s) in {} timers".format(base.get("Application", app), regressions, compared))
+        total += regressions
+    return 1 if total else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
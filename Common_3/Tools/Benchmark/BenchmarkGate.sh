@@ -0,0 +1,57 @@
+#!/bin/sh
+# Runs unit tests built with AUTOMATED_TESTING in benchmark mode, collects their BenchmarkStats json files into an output
+# directory and, when a baseline directory is given, fails if BenchmarkCompare.py finds a regression.
+# Without a DISPLAY the tests run under xvfb-run when it is installed.
+#
+# frames is the total frame count of the run (-b of the unit test, 32 to 512), the warm-up frames are part of it.
+#
+#   Common_3/Tools/Benchmark/BenchmarkGate.sh [-f frames] [-w warmup] [-b baselineDir] outputDir unitTestBinary...
+
+frames=256
+warmup=32
+baseline=""
+while getopts "f:w:b:" opt; do
+    case $opt in
+        f) frames=$OPTARG ;;
+        w) warmup=$OPTARG ;;
+        b) baseline=$OPTARG ;;
+        *) echo "usage: $0 [-f frames] [-w warmup] [-b baselineDir] outputDir unitTestBinary..."; exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+if [ $# -lt 2 ]; then
+    echo "usage: $0 [-f frames] [-w warmup] [-b baselineDir] outputDir unitTestBinary..."
+    exit 2
+fi
+
+scriptDir=$(cd "$(dirname "$0")" && pwd)
+outputDir=$1
+shift
+mkdir -p "$outputDir"
+outputDir=$(cd "$outputDir" && pwd)
+
+runner=""
+if [ -z "$DISPLAY" ] && command -v xvfb-run > /dev/null 2>&1; then
+    runner="xvfb-run -a"
+fi
+
+status=0
+for binary in "$@"; do
+    name=$(basename "$binary")
+    binaryDir=$(cd "$(dirname "$binary")" && pwd)
+    marker="$outputDir/.$name.started"
+    touch "$marker"
+    echo "Benchmarking $name ($frames frames, $warmup of them warm-up)"
+    # Unit tests resolve their resources relative to the working directory
+    if ! (cd "$binaryDir" && $runner "./$name" -b "$frames" --warmup "$warmup" -o "$name"); then
+        echo "$name failed"
+        status=1
+    fi
+    find "$binaryDir" -name "${name}BenchmarkStats-*.json" -newer "$marker" -exec cp {} "$outputDir" \;
+    rm -f "$marker"
+done
+
+if [ -n "$baseline" ]; then
+    python3 "$scriptDir/BenchmarkCompare.py" "$baseline" "$outputDir" || status=1
+fi
+exit $status
@@ -0,0 +1,287 @@
+# Copyright (c) 2017-2025 The Forge Interactive Inc.
+#
+# This file is part of The-Forge
+# (see https://github.com/ConfettiFX/The-Forge).
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+# Formats binary logs written by addBinaryLogFile / BLOGF into the text log format of addLogFile.
+# The record layout is documented above LOG_BINARY_MAGIC in Common_3/Utilities/Log/Log.c.
+#
+#   python3 BinaryLogDecoder.py App.blog                  (writes to stdout)
+#   python3 BinaryLogDecoder.py App.blog -o App.log --precise --level WARN,ERR
+
+import argparse
+import math
+import os
+import re
+import struct
+import sys
+import time
+
+MAGIC = b"TFBINLOG"
+VERSION = 1
+
+RECORD_STRING = 1
+RECORD_THREAD = 2
+RECORD_MESSAGE = 3
+
+FILENAME_NAME_LENGTH_LOG = 23
+
+# Same order and prefixes as writeLogVaList
+LEVEL_PREFIXES = [(8, "WARN| "), (4, "INFO| "), (2, " DBG| "), (16, " ERR| ")]
+LEVEL_NAMES = {"WARN": 8, "INFO": 4, "DBG": 2, "DEBUG": 2, "ERR": 16, "ERROR": 16}
+
+CONVERSION = re.compile(rb"%([-+ #0']*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|j|z|t|L|q|I64|I32|I)?([diouxXeEfFgGaAcspn%])")
+ARGUMENT = struct.Struct("<Q")
+MESSAGE = struct.Struct("<IqQQIQI")
+
+
+class Missing(object):
+    pass
+
+
+MISSING = Missing()
+
+
+def read_args(data):
+    args = []
+    pos = 0
+    while pos < len(data):
+        tag = data[pos:pos + 1]
+        pos += 1
+        if tag == b"s":
+            (size,) = struct.unpack_from("<I", data, pos)
+            pos += 4
+            args.append(data[pos:pos + size])
+            pos += size
+        elif tag == b"i":
+            args.append(struct.unpack_from("<q", data, pos)[0])
+            pos += 8
+        elif tag == b"u" or tag == b"p":
+            value = ARGUMENT.unpack_from(data, pos)[0]
+            args.append(("p", value) if tag == b"p" else value)
+            pos += 8
+        elif tag == b"f":
+            args.append(struct.unpack_from("<d", data, pos)[0])
+            pos += 8
+        else:
+            break
+    return args
+
+
+def truncate_integer(value, length, signed):
+    # Arguments of %hd and %hhd are converted to short and signed char like printf does
+    bits = {b"h": 16, b"hh": 8}.get(length)
+    if bits is None:
+        return value
+    value &= (1 << bits) - 1
+    return value - (1 << bits) if signed and value >> (bits - 1) else value
+
+
+def pad_number(sign, prefix, digits, flags, width, zero_pad):
+    padding = max(width - len(sign) - len(prefix) - len(digits), 0)
+    if b"-" in flags:
+        return sign + prefix + digits + " " * padding
+    if b"0" in flags and zero_pad:
+        return sign + prefix + "0" * padding + digits
+    return " " * padding + sign + prefix + digits
+
+
+def format_integer(value, flags, width, precision, conversion):
+    # C rules Python's % operator lacks: "017" for %#o, no 0x for a zero %#x, + and space only for signed conversions,
+    # the 0 flag is ignored with a precision and a zero precision prints nothing for 0
+    digits = {b"o": "{:o}", b"x": "{:x}", b"X": "{:X}"}.get(conversion, "{:d}").format(abs(value))
+    if precision is not None:
+        digits = "" if precision == 0 and value == 0 else digits.rjust(precision, "0")
+    sign = ""
+    if conversion in b"di":
+        sign = "-" if value < 0 else "+" if b"+" in flags else " " if b" " in flags else ""
+    prefix = ""
+    if b"#" in flags and conversion == b"o" and not digits.startswith("0"):
+        digits = "0" + digits
+    elif b"#" in flags and conversion in b"xX" and value:
+        prefix = "0" + conversion.decode()
+    return pad_number(sign, prefix, digits, flags, width, precision is None).encode()
+
+
+def format_hex_float(value, flags, width, precision, upper):
+    # C style %a: "0x1.8p+0" instead of the "0x1.8000000000000p+0" of float.hex, rounded to precision hex digits
+    if math.isinf(value) or math.isnan(value):
+        body = "inf" if math.isinf(value) else "nan"
+        digits = None
+    else:
+        mantissa, exponent = float.hex(abs(value)).split("p")
+        lead, fraction = mantissa[2:].split(".")
+        lead = int(lead)
+        if precision is not None and precision < len(fraction):
+            # Round half to even, the leading digit takes the carry
+            shift = 4 * (len(fraction) - precision)
+            bits, remainder = divmod((lead << (4 * len(fraction))) | int(fraction, 16), 1 << shift)
+            half = 1 << (shift - 1)
+            if remainder > half or (remainder == half and bits & 1):
+                bits += 1
+            lead = bits >> (4 * precision)
+            fraction = "{:0{}x}".format(bits & ((1 << (4 * precision)) - 1), precision) if precision else ""
+        elif precision is not None:
+            fraction = fraction.ljust(precision, "0")
+        else:
+            fraction = fraction.rstrip("0")
+        digits = str(lead) + ("." + fraction if fraction or b"#" in flags else "")
+        body = "0x" + digits + "p" + ("+" if int(exponent) >= 0 else "-") + str(abs(int(exponent)))
+    sign = "-" if math.copysign(1.0, value) < 0 else "+" if b"+" in flags else " " if b" " in flags else ""
+    prefix = "0x" if digits is not None else ""
+    text = pad_number(sign, prefix, body[len(prefix):], flags, width, digits is not None)
+    return (text.upper() if upper else text).encode()
+
+
+def format_message(fmt, args):
+    # Formats every C conversion on its own, strings and floating point with the Python % operator, integers and %a by hand
+    args = list(args)
+
+    def take():
+        return args.pop(0) if args else MISSING
+
+    def replace(match):
+        flags, width, precision, length, conversion = match.groups()
+        if conversion == b"%":
+            return b"%"
+        flags = flags.replace(b"'", b"")
+        if width == b"*":
+            value = take()
+            width = b"" if value is MISSING else str(abs(value)).encode()
+            # A negative width argument means left aligned
+            flags += b"-" if value is not MISSING and value < 0 else b""
+        if precision == b"*":
+            value = take()
+            # A negative precision argument is taken as if the precision was omitted
+            precision = None if value is MISSING or value < 0 else str(value).encode()
+        spec = b"%" + flags + (width or b"") + (b"." + precision if precision is not None else b"")
+        if conversion == b"n":
+            return b""
+        value = take()
+        if value is MISSING:
+            return b"?"
+        try:
+            if conversion == b"s":
+                text = value if isinstance(value, bytes) else str(value).encode()
+                return (spec + b"s") % text
+            if conversion == b"p":
+                value = value[1] if isinstance(value, tuple) else value
+                return (spec + b"s") % ("0x%x" % value).encode()
+            if conversion == b"c":
+                return (spec + b"c") % (value & 0xff)
+            if conversion in b"eEfFgG":
+                if math.isinf(value) or math.isnan(value):
+                    # Infinity and NaN are padded with spaces
+                    spec = b"%" + flags.replace(b"0", b"") + (width or b"") + (b"." + precision if precision is not None else b"")
+                return (spec + conversion) % float(value)
+            width = int(width or 0)
+            precision = int(precision or 0) if precision is not None else None
+            if conversion in b"aA":
+                return format_hex_float(float(value), flags, width, precision, conversion == b"A")
+            value = truncate_integer(int(value), length, conversion in b"di")
+            return format_integer(value, flags, width, precision, conversion)
+        except (TypeError, ValueError):
+            return b"?"
+
+    return CONVERSION.sub(replace, fmt)
+
+
+def file_name(path):
+    return re.split(rb"[/\\]", path)[-1]
+
+
+def decode(data, out, args):
+    if data[:8] != MAGIC:
+        raise ValueError("not a binary log file")
+    version, header_size, start_time, start_usec = struct.unpack_from("<IIqq", data, 8)
+    if version != VERSION:
+        raise ValueError("unsupported binary log version {}".format(version))
+
+    strings = {}
+    threads = {}
+    pos = header_size
+    count = 0
+    while pos < len(data):
+        record_type = data[pos]
+        pos += 1
+        if record_type == RECORD_STRING or record_type == RECORD_THREAD:
+            key, size = struct.unpack_from("<QI", data, pos)
+            pos += 12
+            (strings if record_type == RECORD_STRING else threads)[key] = data[pos:pos + size]
+            pos += size
+        elif record_type == RECORD_MESSAGE:
+            if pos + MESSAGE.size > len(data):
+                break
+            level, usec, thread_id, file_ptr, line, format_ptr, args_size = MESSAGE.unpack_from(data, pos)
+            pos += MESSAGE.size
+            arguments = read_args(data[pos:pos + args_size])
+            pos += args_size
+            if not level & args.level:
+                continue
+
+            timestamp = start_time + (usec - start_usec) / 1000000.0
+            stamp = time.strftime("%Y-%m-%d %H:%M:%S", time.localtime(timestamp))
+            if args.precise:
+                stamp += ".{:06d}".format(int((timestamp - int(timestamp)) * 1000000))
+            thread = threads.get(thread_id, b"NoName")
+            source = file_name(strings.get(file_ptr, b"?"))[:FILENAME_NAME_LENGTH_LOG]
+            preamble = "{} [{:<15}] {:>23}:{:<5} ".format(stamp, thread.decode("utf-8", "replace"), source.decode("utf-8", "replace"),
+                                                          line).encode()
+            message = format_message(strings.get(format_ptr, b"<unknown format>"), arguments)
+            for bit, prefix in LEVEL_PREFIXES:
+                if level & bit:
+                    out.write(preamble + prefix.encode() + message + b"\n")
+                    count += 1
+        else:
+            sys.stderr.write("corrupted record at offset {}, stopping\n".format(pos - 1))
+            break
+    return count
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Format a binary log written by addBinaryLogFile")
+    parser.add_argument("input", help="binary log file")
+    parser.add_argument("-o", "--output", help="text log file, stdout when omitted")
+    parser.add_argument("--precise", action="store_true", help="print microseconds in the timestamps")
+    parser.add_argument("--level", default="", help="comma separated levels to print: WARN,INFO,DBG,ERR (default all)")
+    args = parser.parse_args()
+
+    level = 0
+    for name in filter(None, args.level.upper().split(",")):
+        if name not in LEVEL_NAMES:
+            parser.error("unknown level " + name)
+        level |= LEVEL_NAMES[name]
+    args.level = level or 0xffffffff
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+    if args.output:
+        with open(args.output, "wb") as out:
+            count = decode(data, out, args)
+    else:
+        count = decode(data, sys.stdout.buffer, args)
+        sys.stdout.flush()
+    sys.stderr.write("{}: {} messages\n".format(os.path.basename(args.input), count))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -409,16 +409,51 @@ static void bunyArLibCreatePostprocessDesc(struct BunyArLibCreateDesc* desc, cha
 /// Prepare archive metadata                                                 ///
 ////////////////////////////////////////////////////////////////////////////////
 
-struct BunyArLibCreateMetadata
+struct BunyArLibDictionary
+{
+    uint8_t* data;
+    uint64_t size;
+};
+
+// Metadata of an existing archive, used by update and compaction
+struct BunyArLibArchiveBase
 {
+    struct BunyArHeader     header;
+    uint64_t                fileSize;
     uint64_t                nodeCount;
     struct BunyArNode*      nodes;
-    struct BunyArHashTable* hashTable;
-    uint64_t                maxBlockSize;
     char*                   names;
-    uint32_t                namesSize;
-    bool                    lz4Used;
-    bool                    zstdUsed;
+    uint64_t                dictionaryCount;
+    struct BunyArPointer64* dictionaries;
+    uint32_t*               nodeDictionaries; // NULL if archive has no dictionaries
+
+    // update only
+    bool* replaced; // node is replaced by a new entry
+    bool  buildHashTable;
+};
+
+struct BunyArLibCreateMetadata
+{
+    uint64_t           nodeCount;
+    struct BunyArNode* nodes;
+    uint64_t           maxBlockSize;
+    char*              names;
+    uint32_t           namesSize;
+    bool               lz4Used;
+    bool               zstdUsed;
+
+    // BunyArPerfectHashTable if perfectHashTable is set, BunyArHashTable otherwise
+    void*    hashTable;
+    uint64_t hashTableSize;
+    bool     perfectHashTable;
+
+    // stb_ds array of ZSTD raw content dictionaries
+    struct BunyArLibDictionary* dictionaries;
+    // dictionary index + 1 for every node, NULL if there are no dictionaries
+    uint32_t*                   nodeDictionaries;
+
+    // bunyArLibUpdate appends files to this archive, NULL when archive is created
+    struct BunyArLibArchiveBase* base;
 };
 
 // TODO experiment with this
@@ -438,6 +473,10 @@ static uint32_t convertBlockSize(enum BunyArFileFormat format, uint32_t blockSiz
 
 static void bunyArLibCreateMetadataDestroy(struct BunyArLibCreateMetadata* md)
 {
+    for (ptrdiff_t i = 0; i < arrlen(md->dictionaries); ++i)
+        tf_free(md->dictionaries[i].data);
+    arrfree(md->dictionaries);
+    tf_free(md->nodeDictionaries);
     tf_free(md->nodes);
     tf_free(md->names);
     tf_free(md->hashTable);
@@ -447,6 +486,7 @@ static void bunyArLibCreateMetadataDestroy(struct BunyArLibCreateMetadata* md)
 static bool bunyArLibCreateMetadataDetail(const struct BunyArLibCreateDesc* desc, struct BunyArLibCreateMetadata* md)
 {
     md->nodeCount = desc->entryCount;
+    md->perfectHashTable = desc->perfectHashTable;
 
     md->nodes = (struct BunyArNode*)tf_calloc(1, (sizeof(*md->nodes)) * md->nodeCount);
     if (!md->nodes)
@@ -525,11 +565,141 @@ static bool bunyArLibCreateMetadata(const struct BunyArLibCreateDesc* desc, stru
     return false;
 }
 
+// The bundled ZSTD has no dictionary builder (zdict), so dictionaries are raw content:
+// files spread evenly over the group are concatenated up to the dictionary size.
+// Small files of one type mostly share their layout and key names, which is what a dictionary helps with the most.
+#define BUNYAR_LIB_DICTIONARY_MAX_SAMPLE_SIZE 4096
+
+typedef struct BunyArLibDictionaryGroup
+{
+    char*     key;   // file extension
+    uint64_t* value; // stb_ds array of entry indices
+} BunyArLibDictionaryGroup;
+
+static bool bunyArLibCreateDictionaries(const struct BunyArLibCreateDesc* desc, struct BunyArLibCreateMetadata* md)
+{
+    if (!desc->dictionarySizeKb || !md->zstdUsed)
+        return true;
+
+    const uint64_t dictionaryCapacity = (uint64_t)desc->dictionarySizeKb * 1024;
+
+    BunyArLibDictionaryGroup* groups = NULL;
+    uint64_t*                 fileSizes = (uint64_t*)tf_calloc(desc->entryCount ? desc->entryCount : 1, sizeof(uint64_t));
+    for (uint64_t ei = 0; ei < desc->entryCount; ++ei)
+    {
+        const struct BunyArLibEntryCreateDesc* entry = desc->entries + ei;
+        if (entry->format != BUNYAR_FILE_FORMAT_ZSTD_BLOCKS)
+            continue;
+
+        FileStream fs;
+        if (!fsOpenStreamFromPath(entry->inputRd, entry->inputPath, FM_READ, &fs))
+            continue;
+        ssize_t fileSize = fsGetStreamFileSize(&fs);
+        fsCloseStream(&fs);
+
+        // larger files compress well enough on their own
+        if (fileSize <= 0 || (uint64_t)fileSize > convertBlockSize(entry->format, entry->blockSizeKb))
+            continue;
+
+        fileSizes[ei] = (uint64_t)fileSize;
+
+        const char* name = strrchr(entry->outputName, '/');
+        const char* extension = strrchr(name ? name : entry->outputName, '.');
+
+        ptrdiff_t gi = shgeti(groups, extension ? extension : "");
+        if (gi < 0)
+        {
+            shput(groups, (char*)(extension ? extension : ""), NULL);
+            gi = shgeti(groups, extension ? extension : "");
+        }
+        arrpush(groups[gi].value, ei);
+    }
+
+    for (ptrdiff_t gi = 0; gi < shlen(groups); ++gi)
+    {
+        const uint64_t* entries = groups[gi].value;
+        const uint64_t  entryCount = (uint64_t)arrlenu(entries);
+        if (entryCount < BUNYAR_LIB_DICTIONARY_MIN_FILES)
+            continue;
+
+        uint64_t groupSize = 0;
+        for (uint64_t i = 0; i < entryCount; ++i)
+            groupSize += fileSizes[entries[i]];
+
+        // enough samples of average size to fill the dictionary, spread over the whole group
+        const uint64_t averageSampleSize = groupSize / entryCount < BUNYAR_LIB_DICTIONARY_MAX_SAMPLE_SIZE
+                                               ? groupSize / entryCount + 1
+                                               : BUNYAR_LIB_DICTIONARY_MAX_SAMPLE_SIZE;
+        uint64_t       sampleCount = (dictionaryCapacity + averageSampleSize - 1) / averageSampleSize;
+        if (sampleCount > entryCount)
+            sampleCount = entryCount;
+
+        struct BunyArLibDictionary dictionary = { 0 };
+        dictionary.data = (uint8_t*)tf_malloc(dictionaryCapacity);
+        for (uint64_t si = 0; si < sampleCount && dictionary.size < dictionaryCapacity; ++si)
+        {
+            const struct BunyArLibEntryCreateDesc* entry = desc->entries + entries[si * entryCount / sampleCount];
+
+            FileStream fs;
+            if (!fsOpenStreamFromPath(entry->inputRd, entry->inputPath, FM_READ, &fs))
+                continue;
+
+            uint64_t size = dictionaryCapacity - dictionary.size;
+            if (size > BUNYAR_LIB_DICTIONARY_MAX_SAMPLE_SIZE)
+                size = BUNYAR_LIB_DICTIONARY_MAX_SAMPLE_SIZE;
+            dictionary.size += fsReadFromStream(&fs, dictionary.data + dictionary.size, (size_t)size);
+            fsCloseStream(&fs);
+        }
+
+        // tiny dictionaries only cost time
+        if (dictionary.size < 256)
+        {
+            tf_free(dictionary.data);
+            continue;
+        }
+
+        if (!md->nodeDictionaries)
+            md->nodeDictionaries = (uint32_t*)tf_calloc(md->nodeCount ? md->nodeCount : 1, sizeof(uint32_t));
+
+        arrpush(md->dictionaries, dictionary);
+        for (uint64_t i = 0; i < entryCount; ++i)
+            md->nodeDictionaries[entries[i]] = (uint32_t)arrlenu(md->dictionaries);
+
+        if (desc->verbose > 1)
+        {
+            fprintf(stdout, "ZSTD dictionary for '*%s' files: %llu files, %s\n", groups[gi].key, (unsigned long long)entryCount,
+                    humanReadableSize(dictionary.size).str);
+        }
+    }
+
+    for (ptrdiff_t gi = 0; gi < shlen(groups); ++gi)
+        arrfree(groups[gi].value);
+    shfree(groups);
+    tf_free(fileSizes);
+    return true;
+}
+
+// Returns NULL if construction failed
+static void* bunyArLibHashTableConstruct(bool perfect, uint64_t nodeCount, const struct BunyArNode* nodes, const char* names,
+                                         uint64_t* outSize)
+{
+    if (perfect)
+    {
+        struct BunyArPerfectHashTable* ht = bunyArPerfectHashTableConstruct(nodeCount, nodes, names);
+        *outSize = bunyArPerfectHashTableSize(ht);
+        return ht;
+    }
+
+    struct BunyArHashTable* ht = bunyArHashTableConstruct(nodeCount, nodes, names);
+    *outSize = bunyArHashTableSize(ht);
+    return ht;
+}
+
 static void hashTableTask(void* pUser)
 {
     struct BunyArLibCreateMetadata* md = (struct BunyArLibCreateMetadata*)pUser;
 
-    md->hashTable = bunyArHashTableConstruct(md->nodeCount, md->nodes, md->names);
+    md->hashTable = bunyArLibHashTableConstruct(md->perfectHashTable, md->nodeCount, md->nodes, md->names, &md->hashTableSize);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -609,6 +779,9 @@ struct FileAssemblyLine
 
     tfrg_atomic32_t readStatusId_Atomic32;
 
+    // entry index + 1 of the earlier file with identical contents, 0 if none
+    uint64_t duplicateOf;
+
     bool error;
 
     bool writeComplete;
@@ -630,8 +803,32 @@ struct ArchiveWriterThreadInfo
     bool*                             error;
 };
 
+// Files can share data only if they are encoded the same way
+struct BunyArLibContentKey
+{
+    uint64_t hash;
+    uint64_t size;
+    uint32_t format;
+    uint32_t blockSize;
+    uint32_t dictionary;
+    uint32_t padding;
+};
+
+struct BunyArLibContentEntry
+{
+    struct BunyArLibContentKey key;
+    uint64_t                   value; // lowest entry index with these contents
+};
+
 struct ThreadsSharedMemory
 {
+    const struct BunyArLibCreateMetadata* md;
+
+    // content-addressed deduplication, stb_ds hash map
+    bool                          dedup;
+    struct BunyArLibContentEntry* contents;
+    Mutex                         contentsMutex;
+
     bool         singlethreadRun;
     uint64_t     nThreadItems;
     ThreadSystem threadSystem;
@@ -820,8 +1017,9 @@ static void compressionContextDestroy(struct CompressionContext* ctx)
     memset(ctx, 0, sizeof *ctx);
 }
 
-static bool bunyArLibTaskCompress(struct CompressionContext* ctx, enum BunyArFileFormat format, int compressionLevel, const void* src,
-                                  uint64_t size, void* dst,
+static bool bunyArLibTaskCompress(struct CompressionContext* ctx, enum BunyArFileFormat format, int compressionLevel,
+                                  const struct BunyArLibDictionary* dictionary, // ZSTD only, can be NULL
+                                  const void* src, uint64_t size, void* dst,
                                   uint64_t* dstLimitAndOutSize) // UINT64_MAX if not fit
 {
     if (size == 0)
@@ -852,7 +1050,24 @@ static bool bunyArLibTaskCompress(struct CompressionContext* ctx, enum BunyArFil
     }
     case BUNYAR_FILE_FORMAT_ZSTD_BLOCKS:
     {
-        size_t compressedSize = ZSTD_compressCCtx(ctx->zstdCtx, dst, *dstLimitAndOutSize, src, size, compressionLevel);
+        size_t compressedSize;
+        if (dictionary)
+        {
+            // Reader creates ZSTD_DDict from the same raw content
+            compressedSize = ZSTD_CCtx_setParameter(ctx->zstdCtx, ZSTD_c_compressionLevel, compressionLevel);
+            if (!ZSTD_isError(compressedSize))
+                compressedSize = ZSTD_CCtx_loadDictionary_advanced(ctx->zstdCtx, dictionary->data, dictionary->size, ZSTD_dlm_byRef,
+                                                                   ZSTD_dct_rawContent);
+            if (!ZSTD_isError(compressedSize))
+                compressedSize = ZSTD_compress2(ctx->zstdCtx, dst, *dstLimitAndOutSize, src, size);
+
+            // next blocks may be compressed without a dictionary
+            ZSTD_CCtx_reset(ctx->zstdCtx, ZSTD_reset_session_and_parameters);
+        }
+        else
+        {
+            compressedSize = ZSTD_compressCCtx(ctx->zstdCtx, dst, *dstLimitAndOutSize, src, size, compressionLevel);
+        }
 
         ZSTD_ErrorCode error = ZSTD_getErrorCode(compressedSize);
 
@@ -934,6 +1149,172 @@ static bool initializeEntryBlockStream(enum BunyArFileFormat format, uint32_t bl
     return true;
 }
 
+// Older readers can't decompress blocks compressed with dictionaries or read the perfect hash table
+static void bunyArLibSetHeaderVersion(struct BunyArHeader* header, bool dictionaries, bool perfectHashTable)
+{
+    header->version.actual = BUNYAR_VERSION;
+    header->version.compatible = perfectHashTable ? 2 : dictionaries ? 1 : 0;
+
+    header->flags &= ~BUNYAR_FLAG_PERFECT_HASH_TABLE;
+    if (perfectHashTable)
+        header->flags |= BUNYAR_FLAG_PERFECT_HASH_TABLE;
+}
+
+// Writes dictionary contents at the current stream position 'offset'
+static bool bunyArLibWriteDictionaries(FileStream* fs, uint64_t* offset, const struct BunyArLibDictionary* dictionaries, uint64_t count,
+                                       struct BunyArPointer64* outPointers)
+{
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        outPointers[i].offset = *offset;
+        outPointers[i].size = dictionaries[i].size;
+        if (!tf_write(fs, dictionaries[i].size, dictionaries[i].data))
+            return false;
+        *offset += dictionaries[i].size;
+    }
+    return true;
+}
+
+static bool bunyArLibWriteDictionaryTable(FileStream* fs, uint64_t* offset, const struct BunyArPointer64* dictionaries,
+                                          uint64_t dictionaryCount, const uint32_t* nodeDictionaries, uint64_t nodeCount,
+                                          struct BunyArPointer64* outTablePointer)
+{
+    struct BunyArDictionaryTable table = { 0 };
+    table.dictionaryCount = dictionaryCount;
+
+    outTablePointer->offset = *offset;
+    outTablePointer->size = sizeof(table) + dictionaryCount * sizeof(*dictionaries) + nodeCount * sizeof(*nodeDictionaries);
+
+    if (!tf_write(fs, sizeof(table), &table) || !tf_write(fs, dictionaryCount * sizeof(*dictionaries), (void*)dictionaries) ||
+        !tf_write(fs, nodeCount * sizeof(*nodeDictionaries), (void*)nodeDictionaries))
+        return false;
+
+    *offset += outTablePointer->size;
+    return true;
+}
+
+struct BunyArLibMergedNode
+{
+    const struct BunyArNode* node;
+    const char*              name;
+    uint32_t                 dictionary;
+};
+
+static int bunyArLibMergedNodeCmp(const void* v0, const void* v1)
+{
+    const struct BunyArLibMergedNode* n0 = (const struct BunyArLibMergedNode*)v0;
+    const struct BunyArLibMergedNode* n1 = (const struct BunyArLibMergedNode*)v1;
+    return strcmp(n0->name, n1->name);
+}
+
+// Update mode. Merges nodes of the base archive with the appended files
+// and writes node table, names, dictionary table and hash table after the files.
+// Header is written last, so the base archive stays valid if anything fails before.
+static bool bunyArLibUpdateWriteMetadata(FileStream* fs, uint64_t offset, const struct BunyArLibCreateDesc* desc,
+                                         const struct BunyArLibCreateMetadata* md, uint64_t* outArchiveSize)
+{
+    const struct BunyArLibArchiveBase* base = md->base;
+
+    const uint64_t newDictionaryCount = (uint64_t)arrlenu(md->dictionaries);
+    const uint64_t dictionaryCount = base->dictionaryCount + newDictionaryCount;
+
+    struct BunyArLibMergedNode* merged =
+        (struct BunyArLibMergedNode*)tf_malloc(sizeof(*merged) * (base->nodeCount + md->nodeCount + 1));
+
+    uint64_t nodeCount = 0;
+    uint64_t namesSize = 0;
+    for (uint64_t i = 0; i < base->nodeCount; ++i)
+    {
+        if (base->replaced[i])
+            continue;
+
+        struct BunyArLibMergedNode* m = merged + nodeCount++;
+        m->node = base->nodes + i;
+        m->name = base->names + m->node->namePointer.offset;
+        m->dictionary = base->nodeDictionaries ? base->nodeDictionaries[i] : 0;
+        namesSize += m->node->namePointer.size + 1;
+    }
+    for (uint64_t i = 0; i < md->nodeCount; ++i)
+    {
+        struct BunyArLibMergedNode* m = merged + nodeCount++;
+        m->node = md->nodes + i;
+        m->name = md->names + m->node->namePointer.offset;
+        m->dictionary = md->nodeDictionaries && md->nodeDictionaries[i] ? md->nodeDictionaries[i] + (uint32_t)base->dictionaryCount : 0;
+        namesSize += m->node->namePointer.size + 1;
+    }
+
+    if (namesSize > UINT32_MAX)
+    {
+        LOGF(eERROR, "Archive names don't fit into 4GB");
+        tf_free(merged);
+        return false;
+    }
+
+    // lookup without hash table requires sorted names
+    qsort(merged, nodeCount, sizeof(*merged), bunyArLibMergedNodeCmp);
+
+    struct BunyArNode*      nodes = (struct BunyArNode*)tf_calloc(nodeCount + 1, sizeof(*nodes));
+    char*                   names = (char*)tf_malloc(namesSize + 1);
+    uint32_t*               nodeDictionaries = dictionaryCount ? (uint32_t*)tf_calloc(nodeCount + 1, sizeof(uint32_t)) : NULL;
+    struct BunyArPointer64* dictionaries = (struct BunyArPointer64*)tf_calloc(dictionaryCount + 1, sizeof(*dictionaries));
+
+    uint32_t namesOffset = 0;
+    for (uint64_t i = 0; i < nodeCount; ++i)
+    {
+        nodes[i] = *merged[i].node;
+        nodes[i].namePointer.offset = namesOffset;
+        memcpy(names + namesOffset, merged[i].name, nodes[i].namePointer.size + 1);
+        namesOffset += nodes[i].namePointer.size + 1;
+
+        if (nodeDictionaries)
+            nodeDictionaries[i] = merged[i].dictionary;
+    }
+    memcpy(dictionaries, base->dictionaries, sizeof(*dictionaries) * base->dictionaryCount);
+    tf_free(merged);
+
+    uint64_t hashTableSize = 0;
+    void*    hashTable =
+        base->buildHashTable ? bunyArLibHashTableConstruct(desc->perfectHashTable, nodeCount, nodes, names, &hashTableSize) : NULL;
+
+    struct BunyArHeader header = base->header;
+    bunyArLibSetHeaderVersion(&header, dictionaryCount != 0, hashTable && desc->perfectHashTable);
+    memset(&header.dictionaryTablePointer, 0, sizeof(header.dictionaryTablePointer));
+
+    bool success = tf_seek(fs, offset) &&
+                   bunyArLibWriteDictionaries(fs, &offset, md->dictionaries, newDictionaryCount, dictionaries + base->dictionaryCount);
+    if (success && dictionaryCount)
+    {
+        success = bunyArLibWriteDictionaryTable(fs, &offset, dictionaries, dictionaryCount, nodeDictionaries, nodeCount,
+                                                &header.dictionaryTablePointer);
+    }
+
+    header.nodesPointer.offset = offset;
+    header.nodesPointer.size = sizeof(*nodes) * nodeCount;
+    header.namesPointer.offset = header.nodesPointer.offset + header.nodesPointer.size;
+    header.namesPointer.size = namesSize;
+    header.hashTablePointer.offset = header.namesPointer.offset + header.namesPointer.size;
+    header.hashTablePointer.size = hashTableSize;
+
+    success = success && tf_write(fs, header.nodesPointer.size, nodes) && tf_write(fs, header.namesPointer.size, names) &&
+              (!hashTable || tf_write(fs, header.hashTablePointer.size, hashTable)) && tf_seek(fs, 0) &&
+              tf_write(fs, sizeof(header), &header);
+
+    if (success && desc->verbose > 1)
+    {
+        fprintf(stdout, "|- %llu files in archive, metadata %s\n\n", (unsigned long long)nodeCount,
+                humanReadableSize(header.nodesPointer.size + header.namesPointer.size + header.hashTablePointer.size).str);
+    }
+
+    *outArchiveSize = header.hashTablePointer.offset + header.hashTablePointer.size;
+
+    tf_free(hashTable);
+    tf_free(dictionaries);
+    tf_free(nodeDictionaries);
+    tf_free(names);
+    tf_free(nodes);
+    return success;
+}
+
 // Writes archive file. Gets compressed file data through 'packetIo'.
 // It just writes data given by 'packetIo' for each node one by one.
 static bool bunyArLibArchiveWrite(ResourceDirectory rd, const char* dstPath, struct bunyArLibPacketIo packetIo,
@@ -948,8 +1329,9 @@ static bool bunyArLibArchiveWrite(ResourceDirectory rd, const char* dstPath, str
         BUNYAR_LIB_RESULT_MEMORY_ERROR,
     };
 
+    // update appends files to the existing archive
     FileStream archiveFs = { 0 };
-    if (!fsOpenStreamFromPath(rd, dstPath, FM_WRITE, &archiveFs))
+    if (!fsOpenStreamFromPath(rd, dstPath, md->base ? FM_READ_WRITE : FM_WRITE, &archiveFs))
     {
         LOGF(eERROR, "Failed to create/open archive file '%s'", dstPath);
         return false;
@@ -958,6 +1340,8 @@ static bool bunyArLibArchiveWrite(ResourceDirectory rd, const char* dstPath, str
     enum BunyArLibWriteResult result = BUNYAR_LIB_RESULT_SUCCESS;
 
     uint64_t offset = sizeof(struct BunyArHeader) + desc->entryCount * sizeof(struct BunyArNode) + md->namesSize;
+    if (md->base)
+        offset = md->base->fileSize;
 
     uint64_t           filesDone = 0;
     struct BunyArNode* refNode = NULL;
@@ -969,6 +1353,9 @@ static bool bunyArLibArchiveWrite(ResourceDirectory rd, const char* dstPath, str
 
     size_t totalFilesSize = 0;
 
+    uint64_t duplicateCount = 0;
+    uint64_t duplicatesSize = 0;
+
     int counterWidth = 0;
 
     if (desc->verbose)
@@ -997,6 +1384,38 @@ static bool bunyArLibArchiveWrite(ResourceDirectory rd, const char* dstPath, str
         }
 
         struct BunyArNode* node = md->nodes + file->entryIndex;
+
+        // original is written already, file points to its data
+        if (!block && file->duplicateOf)
+        {
+            if (refNode)
+            {
+                LOGF(eERROR, "Received unexpected file block");
+                result = BUNYAR_LIB_RESULT_INPUT_ERROR;
+                break;
+            }
+
+            const struct BunyArNode* original = md->nodes + file->duplicateOf - 1;
+
+            node->format = original->format;
+            node->filePointer = original->filePointer;
+            node->originalFileSize = file->fsize;
+
+            totalFilesSize += file->fsize;
+            duplicatesSize += original->filePointer.size;
+            ++duplicateCount;
+            ++filesDone;
+
+            blockIndex = UINT64_MAX;
+
+            if (desc->verbose)
+            {
+                fprintf(stdout, "%*llu/%*llu '%s' = '%s'\n", counterWidth, (unsigned long long)file->entryIndex + 1, counterWidth,
+                        (unsigned long long)md->nodeCount, md->names + node->namePointer.offset, md->names + original->namePointer.offset);
+            }
+            continue;
+        }
+
         if (refNode != node)
         {
             if (refNode || (block && blockIndex != block->blockIndex))
@@ -1191,13 +1610,20 @@ static bool bunyArLibArchiveWrite(ResourceDirectory rd, const char* dstPath, str
         LOGF(eERROR, "%s", "Archive write can not continue, aborting.");
         result = BUNYAR_LIB_RESULT_INPUT_ERROR;
     }
+    else if (result == BUNYAR_LIB_RESULT_SUCCESS && md->base)
+    {
+        uint64_t updatedArchiveSize = 0;
+        if (!bunyArLibUpdateWriteMetadata(&archiveFs, offset, desc, md, &updatedArchiveSize))
+            result = BUNYAR_LIB_RESULT_OUTPUT_ERROR;
+        archiveSize = (size_t)updatedArchiveSize;
+    }
     else if (result == BUNYAR_LIB_RESULT_SUCCESS)
     {
-        size_t hashTableSize = bunyArHashTableSize(md->hashTable);
+        size_t hashTableSize = (size_t)md->hashTableSize;
 
         if (desc->verbose > 1 && hashTableSize)
         {
-            fprintf(stdout, "Hash Table %s\n\n", humanReadableSize(hashTableSize).str);
+            fprintf(stdout, "%s %s\n\n", md->perfectHashTable ? "Perfect Hash Table" : "Hash Table", humanReadableSize(hashTableSize).str);
         }
 
         if (desc->verbose)
@@ -1208,6 +1634,29 @@ static bool bunyArLibArchiveWrite(ResourceDirectory rd, const char* dstPath, str
         struct BunyArHeader header = { 0 };
         memcpy(&header.magic, BUNYAR_MAGIC, sizeof(header.magic));
 
+        bunyArLibSetHeaderVersion(&header, md->dictionaries != NULL, md->hashTable && md->perfectHashTable);
+
+        // dictionaries are located after the files
+        if (md->dictionaries)
+        {
+            const uint64_t          dictionaryCount = (uint64_t)arrlenu(md->dictionaries);
+            struct BunyArPointer64* pointers = (struct BunyArPointer64*)tf_calloc(dictionaryCount, sizeof(*pointers));
+
+            const uint64_t dictionariesOffset = offset;
+
+            bool written = tf_seek(&archiveFs, offset) &&
+                           bunyArLibWriteDictionaries(&archiveFs, &offset, md->dictionaries, dictionaryCount, pointers) &&
+                           bunyArLibWriteDictionaryTable(&archiveFs, &offset, pointers, dictionaryCount, md->nodeDictionaries,
+                                                         md->nodeCount, &header.dictionaryTablePointer);
+            tf_free(pointers);
+            if (!written)
+                result = BUNYAR_LIB_RESULT_OUTPUT_ERROR;
+            else if (desc->verbose > 1)
+            {
+                fprintf(stdout, "ZSTD dictionaries %s\n\n", humanReadableSize(offset - dictionariesOffset).str);
+            }
+        }
+
         header.nodesPointer.offset = sizeof(struct BunyArHeader);
         header.nodesPointer.size = sizeof(struct BunyArNode) * desc->entryCount;
 
@@ -1217,13 +1666,14 @@ static bool bunyArLibArchiveWrite(ResourceDirectory rd, const char* dstPath, str
         header.hashTablePointer.offset = offset;
         header.hashTablePointer.size = hashTableSize;
 
-        if (!tf_seek(&archiveFs, 0) || !tf_write(&archiveFs, sizeof(header), &header) ||
-            !tf_write(&archiveFs, header.nodesPointer.size, md->nodes) || !tf_write(&archiveFs, header.namesPointer.size, md->names) ||
-            (md->hashTable &&
-             (!tf_seek(&archiveFs, header.hashTablePointer.offset) || !tf_write(&archiveFs, header.hashTablePointer.size, md->hashTable))))
-            return BUNYAR_LIB_RESULT_OUTPUT_ERROR;
+        if (result == BUNYAR_LIB_RESULT_SUCCESS &&
+            (!tf_seek(&archiveFs, 0) || !tf_write(&archiveFs, sizeof(header), &header) ||
+             !tf_write(&archiveFs, header.nodesPointer.size, md->nodes) || !tf_write(&archiveFs, header.namesPointer.size, md->names) ||
+             (md->hashTable && (!tf_seek(&archiveFs, header.hashTablePointer.offset) ||
+                                !tf_write(&archiveFs, header.hashTablePointer.size, md->hashTable)))))
+            result = BUNYAR_LIB_RESULT_OUTPUT_ERROR;
 
-        if (desc->verbose > 1)
+        if (result == BUNYAR_LIB_RESULT_SUCCESS && desc->verbose > 1)
         {
             size_t metadataSize = sizeof(header) + header.nodesPointer.size + header.namesPointer.size + header.hashTablePointer.size;
 
@@ -1263,8 +1713,13 @@ static bool bunyArLibArchiveWrite(ResourceDirectory rd, const char* dstPath, str
 
     if (desc->verbose && result == BUNYAR_LIB_RESULT_SUCCESS)
     {
-        fprintf(stdout, "Archive '%s' completed.\n|- %llu files\n|- %s -> %s (x%.2f)\n\n", dstPath, (unsigned long long)desc->entryCount,
-                humanReadableSize(totalFilesSize).str, humanReadableSize(archiveSize).str, (double)totalFilesSize / (double)archiveSize);
+        fprintf(stdout, "Archive '%s' completed.\n|- %llu files\n", dstPath, (unsigned long long)desc->entryCount);
+        if (duplicateCount)
+        {
+            fprintf(stdout, "|- %llu duplicates, %s saved\n", (unsigned long long)duplicateCount, humanReadableSize(duplicatesSize).str);
+        }
+        fprintf(stdout, "|- %s -> %s (x%.2f)\n\n", humanReadableSize(totalFilesSize).str, humanReadableSize(archiveSize).str,
+                (double)totalFilesSize / (double)archiveSize);
     }
 
     return result == BUNYAR_LIB_RESULT_SUCCESS;
@@ -1294,9 +1749,12 @@ static void fileAssemblyCompressTask(void* data, uint64_t thid)
 
     struct CompressionContext* ctx = tsm->compressionContexts + thid;
 
+    const uint32_t                    dictionaryIndex = tsm->md->nodeDictionaries ? tsm->md->nodeDictionaries[file->entryIndex] : 0;
+    const struct BunyArLibDictionary* dictionary = dictionaryIndex ? tsm->md->dictionaries + dictionaryIndex - 1 : NULL;
+
     block->compressedSize = block->bufferSize;
-    if (!bunyArLibTaskCompress(ctx, file->entry->format, file->entry->compressionLevel, block->bufferUncompressed, block->rawSize,
-                               block->bufferCompressed, &block->compressedSize))
+    if (!bunyArLibTaskCompress(ctx, file->entry->format, file->entry->compressionLevel, dictionary, block->bufferUncompressed,
+                               block->rawSize, block->bufferCompressed, &block->compressedSize))
     {
         tfrg_atomic32_store_relaxed(&block->compressStatusId_Atomic32, BLOCK_TASK_STATUS_ERROR);
         file->error = true;
@@ -1310,6 +1768,81 @@ static void fileAssemblyCompressTask(void* data, uint64_t thid)
     reportActivity(tsm);
 }
 
+#define BUNYAR_LIB_COMPARE_CHUNK_SIZE (64 * 1024)
+
+static bool compareFileStreams(FileStream* a, FileStream* b, uint8_t* bufferA, uint8_t* bufferB)
+{
+    for (;;)
+    {
+        size_t sizeA = fsReadFromStream(a, bufferA, BUNYAR_LIB_COMPARE_CHUNK_SIZE);
+        size_t sizeB = fsReadFromStream(b, bufferB, BUNYAR_LIB_COMPARE_CHUNK_SIZE);
+        if (sizeA != sizeB || memcmp(bufferA, bufferB, sizeA) != 0)
+            return false;
+        if (sizeA == 0)
+            return true;
+    }
+}
+
+// Hashes file contents and looks for an earlier entry with the same contents.
+// Candidates are compared byte by byte, so a hash collision only costs a redundant read.
+// The only way for a duplicate to point to data already written is to have an original with a lower entry index,
+// because the archive is written in entry order.
+static bool fileAssemblyFindDuplicate(struct FileAssemblyLine* file, uint64_t* outDuplicateOf)
+{
+    struct ThreadsSharedMemory* tsm = file->tsm;
+    *outDuplicateOf = 0;
+
+    uint8_t* buffer = (uint8_t*)tf_malloc(BUNYAR_LIB_COMPARE_CHUNK_SIZE * 2);
+    if (!buffer)
+        return false;
+
+    size_t   hash = 0;
+    uint64_t hashedSize = 0;
+    for (size_t size; (size = fsReadFromStream(&file->fileStream, buffer, BUNYAR_LIB_COMPARE_CHUNK_SIZE)) > 0; hashedSize += size)
+        hash = stbds_hash_bytes(buffer, size, hash);
+
+    struct BunyArLibContentKey key;
+    memset(&key, 0, sizeof key);
+    key.hash = (uint64_t)hash;
+    key.size = file->fsize;
+    key.format = (uint32_t)file->entry->format;
+    key.blockSize = file->entry->format == BUNYAR_FILE_FORMAT_RAW ? 0 : (uint32_t)file->blockSize;
+    key.dictionary = tsm->md->nodeDictionaries ? tsm->md->nodeDictionaries[file->entryIndex] : 0;
+
+    uint64_t candidate = UINT64_MAX;
+
+    acquireMutex(&tsm->contentsMutex);
+    ptrdiff_t ci = hmgeti(tsm->contents, key);
+    if (ci < 0)
+        hmput(tsm->contents, key, file->entryIndex);
+    else if (tsm->contents[ci].value < file->entryIndex)
+        candidate = tsm->contents[ci].value;
+    else
+        tsm->contents[ci].value = file->entryIndex;
+    releaseMutex(&tsm->contentsMutex);
+
+    bool success = hashedSize == file->fsize && fsSeekStream(&file->fileStream, SBO_START_OF_FILE, 0);
+
+    if (success && candidate != UINT64_MAX)
+    {
+        // entries are an array, candidate < file->entryIndex
+        const struct BunyArLibEntryCreateDesc* original = file->entry - (file->entryIndex - candidate);
+
+        FileStream originalStream;
+        if (fsOpenStreamFromPath(original->inputRd, original->inputPath, FM_READ | FM_ALLOW_READ, &originalStream))
+        {
+            if (compareFileStreams(&file->fileStream, &originalStream, buffer, buffer + BUNYAR_LIB_COMPARE_CHUNK_SIZE))
+                *outDuplicateOf = candidate + 1;
+            fsCloseStream(&originalStream);
+        }
+
+        success = fsSeekStream(&file->fileStream, SBO_START_OF_FILE, 0);
+    }
+
+    tf_free(buffer);
+    return success;
+}
+
 // this task loops file blocks because file reading is done in a single thread
 static void fileAssemblyReadTask(void* data, uint64_t thid)
 {
@@ -1344,6 +1877,19 @@ static void fileAssemblyReadTask(void* data, uint64_t thid)
             file->blockSize = convertBlockSize(file->entry->format, file->entry->blockSizeKb);
         }
 
+        if (file->tsm->dedup && file->fsize)
+        {
+            if (!fileAssemblyFindDuplicate(file, &file->duplicateOf))
+            {
+                LOGF(eERROR, "Failed to hash file %s%s", fsGetResourceDirectory(file->entry->inputRd), file->entry->inputPath);
+                goto ERROR_RETURN;
+            }
+
+            // writer reuses data of the original
+            if (file->duplicateOf)
+                goto COMPLETE;
+        }
+
         file->blockCount = file->fsize / file->blockSize + ((file->fsize % file->blockSize) > 0);
 
         if (!file->blockCount)
@@ -1552,7 +2098,7 @@ static void bunyArLibCreateTaskManager(struct ThreadsSharedMemory* tsm, const st
             if (file->entryIndex != entryId)
                 continue;
 
-            if (readStatus == BLOCK_TASK_STATUS_COMPLETED && file->fsize == 0)
+            if (readStatus == BLOCK_TASK_STATUS_COMPLETED && (file->fsize == 0 || file->duplicateOf))
             {
                 packetSend(&tsm->packetIo, file, NULL);
             NEXT_ENTRY:
@@ -1622,6 +2168,9 @@ static void destroyThreadSharedMemory(struct ThreadsSharedMemory* tsm)
     exitMutex(&tsm->mutexBlocks);
     exitConditionVariable(&tsm->conditionBlocks);
 
+    hmfree(tsm->contents);
+    exitMutex(&tsm->contentsMutex);
+
     arrfree(tsm->packetIo.packetsQueue);
     arrfree(tsm->packetIo.packets);
     exitMutex(&tsm->packetIo.mutex);
@@ -1637,6 +2186,7 @@ static bool initThreadSharedMemory(struct ThreadsSharedMemory* tsm, ResourceDire
                                    const struct BunyArLibCreateDesc* desc, struct BunyArLibCreateMetadata* md)
 {
     memset(tsm, 0, sizeof(*tsm));
+    tsm->md = md;
 
     // waiter + scheduler + thread pool
     uint64_t threadPoolSize = (uint64_t)desc->threadPoolSize;
@@ -1692,6 +2242,10 @@ static bool initThreadSharedMemory(struct ThreadsSharedMemory* tsm, ResourceDire
     if (!initConditionVariable(&tsm->conditionBlocks))
         goto ERROR_RETURN;
 
+    tsm->dedup = desc->dedup;
+    if (!initMutex(&tsm->contentsMutex))
+        goto ERROR_RETURN;
+
     uint64_t threadMemorySize = desc->memorySizePerThread;
     if (threadMemorySize == 0)
         threadMemorySize = 1024 * 1024 * 4;
@@ -1980,6 +2534,9 @@ bool bunyArLibCreate(ResourceDirectory rd, const char* dstPath, const struct Bun
         LOGF(eERROR, "Failed to initialize metadata for archive '%s'", dstPath);
     }
 
+    if (success)
+        success = bunyArLibCreateDictionaries(&desc, &md);
+
     if (success)
         success = bunyArLibCreateArchive(rd, dstPath, &desc, &md);
 
@@ -1989,53 +2546,752 @@ bool bunyArLibCreate(ResourceDirectory rd, const char* dstPath, const struct Bun
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// Function bunyArLibExtract                                               ///
+/// Functions bunyArLibUpdate, bunyArLibCompact                             ///
+/// Update appends new and changed files to the end of an existing archive  ///
+/// and rewrites metadata after them. Compaction drops unreferenced data.   ///
 ////////////////////////////////////////////////////////////////////////////////
 
-bool bunyArLibExtract(struct IFileSystem* archive, ResourceDirectory rd, const char* dstDir, const struct BunyArLibExtractDesc* desc)
+static void bunyArLibArchiveBaseDestroy(struct BunyArLibArchiveBase* base)
 {
-    struct BunyArDescription archiveInfo;
-    fsArchiveGetDescription(archive, &archiveInfo);
+    tf_free(base->nodes);
+    tf_free(base->names);
+    tf_free(base->dictionaries);
+    tf_free(base->nodeDictionaries);
+    tf_free(base->replaced);
+    memset(base, 0, sizeof(*base));
+}
 
-    FileStream fsOut = { 0 };
-    FileStream fsIn = { 0 };
+static bool bunyArLibReadPointer(FileStream* fs, uint64_t fileSize, struct BunyArPointer64 pointer, void* dst)
+{
+    if (pointer.offset > fileSize || pointer.size > fileSize - pointer.offset)
+        return false;
+    return tf_seek(fs, pointer.offset) && fsReadFromStream(fs, dst, pointer.size) == pointer.size;
+}
 
-    bool loopFileNames = desc->fileNameCount > 0;
+static bool bunyArLibArchiveBaseReadDetail(FileStream* fs, struct BunyArLibArchiveBase* base)
+{
+    struct BunyArHeader* header = &base->header;
 
-    uint64_t loopLimit = loopFileNames ? desc->fileNameCount : archiveInfo.nodeCount;
+    // header of version 0 is shorter
+    const size_t headerSizeV0 = offsetof(struct BunyArHeader, dictionaryTablePointer);
+    if (fsReadFromStream(fs, header, sizeof(*header)) < headerSizeV0 || memcmp(&header->magic, &BUNYAR_MAGIC, sizeof(header->magic)) != 0)
+        return false;
 
-    int counterWidth = 0;
-    int printedLength = 0;
-    if (desc->verbose)
+    if (header->version.compatible > BUNYAR_VERSION)
     {
-        char buffer[32];
-        counterWidth = snprintf(buffer, sizeof buffer, "%llu", (unsigned long long)loopLimit);
+        LOGF(eERROR, "Archive version %u not supported, expected %u or older", header->version.compatible, BUNYAR_VERSION);
+        return false;
     }
 
-    uint64_t failureCount = 0;
+    if (header->version.actual < 1)
+        memset((uint8_t*)header + headerSizeV0, 0, sizeof(*header) - headerSizeV0);
 
-    for (uint64_t i = 0; i < loopLimit; ++i)
-    {
-        const char* error = NULL;
+    if (header->nodesPointer.size % sizeof(struct BunyArNode) != 0 || header->namesPointer.size > UINT32_MAX)
+        return false;
 
-        uint64_t uid = i;
+    base->nodeCount = header->nodesPointer.size / sizeof(struct BunyArNode);
+    base->nodes = (struct BunyArNode*)tf_calloc(base->nodeCount + 1, sizeof(struct BunyArNode));
+    base->names = (char*)tf_calloc(header->namesPointer.size + 1, 1);
+    base->replaced = (bool*)tf_calloc(base->nodeCount + 1, sizeof(bool));
 
-        uint64_t totalSize = 0;
-        char     buffer[64 * 1024];
-        ASSERT(sizeof buffer >= FS_MAX_PATH);
+    if (!bunyArLibReadPointer(fs, base->fileSize, header->nodesPointer, base->nodes) ||
+        !bunyArLibReadPointer(fs, base->fileSize, header->namesPointer, base->names))
+        return false;
 
-        struct BunyArNodeDescription node;
+    for (uint64_t i = 0; i < base->nodeCount; ++i)
+    {
+        const struct BunyArNode* node = base->nodes + i;
+        if ((uint64_t)node->namePointer.offset + node->namePointer.size >= header->namesPointer.size ||
+            base->names[node->namePointer.offset + node->namePointer.size] != 0 || node->filePointer.offset > base->fileSize ||
+            node->filePointer.size > base->fileSize - node->filePointer.offset)
+            return false;
+    }
 
-        if (loopFileNames && !fsArchiveGetNodeId(archive, desc->fileNames[i], &uid))
-        {
-            node.name = desc->fileNames[i];
-            error = "no such file";
-            goto FILE_DONE;
-        }
+    if (header->dictionaryTablePointer.size < sizeof(struct BunyArDictionaryTable))
+        return true;
 
-        fsArchiveGetNodeDescription(archive, uid, &node);
+    struct BunyArDictionaryTable table;
+    struct BunyArPointer64       tablePointer = { header->dictionaryTablePointer.offset, sizeof(table) };
+    if (!bunyArLibReadPointer(fs, base->fileSize, tablePointer, &table) ||
+        header->dictionaryTablePointer.size !=
+            sizeof(table) + table.dictionaryCount * sizeof(struct BunyArPointer64) + base->nodeCount * sizeof(uint32_t))
+        return false;
 
-        if (desc->verbose)
+    base->dictionaryCount = table.dictionaryCount;
+    base->dictionaries = (struct BunyArPointer64*)tf_calloc(base->dictionaryCount + 1, sizeof(struct BunyArPointer64));
+    base->nodeDictionaries = (uint32_t*)tf_calloc(base->nodeCount + 1, sizeof(uint32_t));
+
+    struct BunyArPointer64 dictionariesPointer = { tablePointer.offset + sizeof(table),
+                                                   base->dictionaryCount * sizeof(struct BunyArPointer64) };
+    struct BunyArPointer64 nodeDictionariesPointer = { dictionariesPointer.offset + dictionariesPointer.size,
+                                                       base->nodeCount * sizeof(uint32_t) };
+    return bunyArLibReadPointer(fs, base->fileSize, dictionariesPointer, base->dictionaries) &&
+           bunyArLibReadPointer(fs, base->fileSize, nodeDictionariesPointer, base->nodeDictionaries);
+}
+
+static bool bunyArLibArchiveBaseRead(ResourceDirectory rd, const char* path, struct BunyArLibArchiveBase* base)
+{
+    memset(base, 0, sizeof(*base));
+
+    FileStream fs;
+    if (!fsOpenStreamFromPath(rd, path, FM_READ, &fs))
+    {
+        LOGF(eERROR, "Failed to open archive '%s'", path);
+        return false;
+    }
+
+    ssize_t fileSize = fsGetStreamFileSize(&fs);
+    base->fileSize = fileSize > 0 ? (uint64_t)fileSize : 0;
+
+    bool success = bunyArLibArchiveBaseReadDetail(&fs, base);
+    fsCloseStream(&fs);
+
+    if (!success)
+    {
+        LOGF(eERROR, "Archive '%s' is damaged or not supported", path);
+        bunyArLibArchiveBaseDestroy(base);
+    }
+    return success;
+}
+
+static uint64_t bunyArLibBaseFindNode(const struct BunyArLibArchiveBase* base, const char* name)
+{
+    uint64_t beg = 0;
+    uint64_t end = base->nodeCount;
+    while (beg < end)
+    {
+        uint64_t mid = beg + (end - beg) / 2;
+        int      cmp = strcmp(name, base->names + base->nodes[mid].namePointer.offset);
+        if (cmp == 0)
+            return mid;
+        if (cmp < 0)
+            end = mid;
+        else
+            beg = mid + 1;
+    }
+    return UINT64_MAX;
+}
+
+// Entry is unchanged if format and decompressed contents match the archive file.
+// Reading is much cheaper than compressing and writing the file again.
+static bool bunyArLibEntryUnchanged(IFileSystem* archive, uint64_t nodeIndex, const struct BunyArNode* node,
+                                    const struct BunyArLibEntryCreateDesc* entry, uint8_t* buffer)
+{
+    if (node->format != (uint64_t)entry->format)
+        return false;
+
+    FileStream input;
+    if (!fsOpenStreamFromPath(entry->inputRd, entry->inputPath, FM_READ, &input))
+        return false;
+
+    bool unchanged = false;
+
+    FileStream archived;
+    if (fsGetStreamFileSize(&input) == (ssize_t)node->originalFileSize && fsIoOpenByUid(archive, nodeIndex, FM_READ, &archived))
+    {
+        unchanged = compareFileStreams(&input, &archived, buffer, buffer + BUNYAR_LIB_COMPARE_CHUNK_SIZE);
+        fsCloseStream(&archived);
+    }
+
+    fsCloseStream(&input);
+    return unchanged;
+}
+
+bool bunyArLibUpdate(ResourceDirectory rd, const char* archivePath, const struct BunyArLibCreateDesc* inDesc)
+{
+    struct BunyArLibArchiveBase base;
+    if (!bunyArLibArchiveBaseRead(rd, archivePath, &base))
+        return false;
+
+    char** strings = NULL;
+
+    struct BunyArLibCreateDesc desc;
+    if (!bunyArLibCreatePreprocessDesc(inDesc, &desc, &strings))
+    {
+        LOGF(eERROR, "Failed to preprocess file entries to update archive '%s'", archivePath);
+        bunyArLibCreatePostprocessDesc(&desc, &strings);
+        bunyArLibArchiveBaseDestroy(&base);
+        return false;
+    }
+
+    FileStream  archiveStream = { 0 };
+    IFileSystem archive = { 0 };
+
+    struct ArchiveOpenDesc openDesc = { 0 };
+
+    bool success = fsOpenStreamFromPath(rd, archivePath, FM_READ, &archiveStream) &&
+                   fsArchiveOpenFromStream(&archiveStream, &openDesc, &archive);
+    if (!success)
+        LOGF(eERROR, "Failed to open archive '%s'", archivePath);
+
+    // entries to write, preprocessed entries stay sorted
+    struct BunyArLibEntryCreateDesc* entries = NULL;
+    uint64_t                         unchangedCount = 0;
+
+    uint8_t* buffer = success ? (uint8_t*)tf_malloc(BUNYAR_LIB_COMPARE_CHUNK_SIZE * 2) : NULL;
+    for (uint64_t i = 0; i < desc.entryCount && success; ++i)
+    {
+        const struct BunyArLibEntryCreateDesc* entry = desc.entries + i;
+
+        uint64_t nodeIndex = bunyArLibBaseFindNode(&base, entry->outputName);
+        if (nodeIndex != UINT64_MAX)
+        {
+            if (bunyArLibEntryUnchanged(&archive, nodeIndex, base.nodes + nodeIndex, entry, buffer))
+            {
+                ++unchangedCount;
+                continue;
+            }
+            base.replaced[nodeIndex] = true;
+        }
+
+        arrpush(entries, *entry);
+    }
+    tf_free(buffer);
+
+    if (archive.pUser)
+        fsArchiveClose(&archive);
+    fsCloseStream(&archiveStream);
+
+    if (success && desc.verbose)
+    {
+        fprintf(stdout, "Archive '%s': %llu unchanged, %llu new or changed files\n\n", archivePath, (unsigned long long)unchangedCount,
+                (unsigned long long)arrlenu(entries));
+    }
+
+    if (success && entries)
+    {
+        struct BunyArLibCreateDesc updateDesc = desc;
+        updateDesc.entries = entries;
+        updateDesc.entryCount = (uint64_t)arrlenu(entries);
+        // hash table is built for all archive nodes after the files are written
+        updateDesc.skipHashTable = true;
+        base.buildHashTable = !desc.skipHashTable;
+
+        struct BunyArLibCreateMetadata md;
+        success = bunyArLibCreateMetadata(&updateDesc, &md);
+        if (success)
+        {
+            md.base = &base;
+            success = bunyArLibCreateDictionaries(&updateDesc, &md) && bunyArLibCreateArchive(rd, archivePath, &updateDesc, &md);
+            bunyArLibCreateMetadataDestroy(&md);
+        }
+    }
+
+    arrfree(entries);
+    bunyArLibCreatePostprocessDesc(&desc, &strings);
+    bunyArLibArchiveBaseDestroy(&base);
+    return success;
+}
+
+#define BUNYAR_LIB_COPY_CHUNK_SIZE (1024 * 1024)
+
+static bool bunyArLibCopyStreamRange(FileStream* src, FileStream* dst, struct BunyArPointer64 range, uint8_t* buffer)
+{
+    if (!tf_seek(src, range.offset))
+        return false;
+
+    for (uint64_t left = range.size; left > 0;)
+    {
+        size_t size = left < BUNYAR_LIB_COPY_CHUNK_SIZE ? (size_t)left : BUNYAR_LIB_COPY_CHUNK_SIZE;
+        if (fsReadFromStream(src, buffer, size) != size || !tf_write(dst, size, buffer))
+            return false;
+        left -= size;
+    }
+    return true;
+}
+
+typedef struct BunyArLibOffsetRemap
+{
+    uint64_t key;   // offset in source archive
+    uint64_t value; // offset in compacted archive
+} BunyArLibOffsetRemap;
+
+bool bunyArLibCompact(ResourceDirectory rd, const char* srcPath, const char* dstPath, unsigned verbose)
+{
+    struct BunyArLibArchiveBase base;
+    if (!bunyArLibArchiveBaseRead(rd, srcPath, &base))
+        return false;
+
+    FileStream src = { 0 };
+    FileStream dst = { 0 };
+    if (!fsOpenStreamFromPath(rd, srcPath, FM_READ, &src))
+    {
+        LOGF(eERROR, "Failed to open archive '%s'", srcPath);
+        bunyArLibArchiveBaseDestroy(&base);
+        return false;
+    }
+    if (!fsOpenStreamFromPath(rd, dstPath, FM_WRITE, &dst))
+    {
+        LOGF(eERROR, "Failed to create/open archive file '%s'", dstPath);
+        fsCloseStream(&src);
+        bunyArLibArchiveBaseDestroy(&base);
+        return false;
+    }
+
+    struct BunyArHeader header = base.header;
+    header.nodesPointer.offset = sizeof(header);
+    header.namesPointer.offset = header.nodesPointer.offset + header.nodesPointer.size;
+
+    uint64_t offset = header.namesPointer.offset + header.namesPointer.size;
+
+    uint8_t*              buffer = (uint8_t*)tf_malloc(BUNYAR_LIB_COPY_CHUNK_SIZE);
+    BunyArLibOffsetRemap* remap = NULL;
+
+    bool success = tf_seek(&dst, offset);
+
+    // Files in node order, deduplicated files keep sharing their data
+    for (uint64_t i = 0; i < base.nodeCount && success; ++i)
+    {
+        struct BunyArNode* node = base.nodes + i;
+
+        ptrdiff_t ri = node->filePointer.size ? hmgeti(remap, node->filePointer.offset) : -1;
+        if (ri >= 0)
+        {
+            node->filePointer.offset = remap[ri].value;
+            continue;
+        }
+
+        success = bunyArLibCopyStreamRange(&src, &dst, node->filePointer, buffer);
+        if (node->filePointer.size)
+            hmput(remap, node->filePointer.offset, offset);
+
+        node->filePointer.offset = offset;
+        offset += node->filePointer.size;
+    }
+
+    for (uint64_t i = 0; i < base.dictionaryCount && success; ++i)
+    {
+        success = bunyArLibCopyStreamRange(&src, &dst, base.dictionaries[i], buffer);
+        base.dictionaries[i].offset = offset;
+        offset += base.dictionaries[i].size;
+    }
+
+    if (success && base.dictionaryCount)
+    {
+        success = bunyArLibWriteDictionaryTable(&dst, &offset, base.dictionaries, base.dictionaryCount, base.nodeDictionaries,
+                                                base.nodeCount, &header.dictionaryTablePointer);
+    }
+
+    // node order is the same, so hash table is still valid
+    if (success && header.hashTablePointer.size)
+    {
+        success = bunyArLibCopyStreamRange(&src, &dst, header.hashTablePointer, buffer);
+        header.hashTablePointer.offset = offset;
+        offset += header.hashTablePointer.size;
+    }
+
+    success = success && tf_seek(&dst, 0) && tf_write(&dst, sizeof(header), &header) &&
+              tf_write(&dst, header.nodesPointer.size, base.nodes) && tf_write(&dst, header.namesPointer.size, base.names);
+
+    if (!fsCloseStream(&dst))
+        success = false;
+    fsCloseStream(&src);
+
+    if (!success)
+        LOGF(eERROR, "Failed to compact archive '%s' to '%s'", srcPath, dstPath);
+    else if (verbose)
+    {
+        fprintf(stdout, "Archive '%s' compacted.\n|- %llu files\n|- %s -> %s\n\n", dstPath, (unsigned long long)base.nodeCount,
+                humanReadableSize(base.fileSize).str, humanReadableSize(offset).str);
+    }
+
+    hmfree(remap);
+    tf_free(buffer);
+    bunyArLibArchiveBaseDestroy(&base);
+    return success;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Function bunyArLibExtract                                               ///
+///                                                                          ///
+/// Multithreaded path:                                                      ///
+/// Thread pool reads and decompresses files, one file per task,            ///
+/// into chunks from a bounded pool                                          ///
+/// + thread to write chunks to output files in queue order                 ///
+////////////////////////////////////////////////////////////////////////////////
+
+#define BUNYAR_LIB_EXTRACT_CHUNK_SIZE (256 * 1024)
+
+struct BunyArLibExtractFile
+{
+    struct BunyArNodeDescription node;
+    FileStream                   out;
+    const char*                  error;
+    bool                         skipped;
+};
+
+struct BunyArLibExtractChunk
+{
+    struct BunyArLibExtractChunk* next;
+    struct BunyArLibExtractFile*  file;
+    uint8_t*                      data;
+    size_t                        size;
+    bool                          last;
+};
+
+struct BunyArLibExtractContext
+{
+    IFileSystem*                       archive;
+    ResourceDirectory                  rd;
+    const char*                        dstDir;
+    const struct BunyArLibExtractDesc* desc;
+
+    uint64_t                     fileCount;
+    struct BunyArLibExtractFile* files;
+
+    struct BunyArLibExtractChunk* chunks;
+    void*                         chunkMemory;
+
+    // protects everything below
+    Mutex                         mutex;
+    // notify when a chunk is released by the writer
+    ConditionVariable             freeCondition;
+    // notify when a chunk is queued or workers are done
+    ConditionVariable             queueCondition;
+    struct BunyArLibExtractChunk* freeChunks;
+    struct BunyArLibExtractChunk* queueHead;
+    struct BunyArLibExtractChunk* queueTail;
+    bool                          workersDone;
+    bool                          abort;
+
+    // writer thread only
+    uint64_t failureCount;
+    uint64_t doneCount;
+    int      counterWidth;
+};
+
+// blocks until the writer releases a chunk, NULL if extraction is aborted
+static struct BunyArLibExtractChunk* bunyArLibExtractAcquireChunk(struct BunyArLibExtractContext* ctx)
+{
+    acquireMutex(&ctx->mutex);
+    while (!ctx->freeChunks && !ctx->abort)
+        waitConditionVariable(&ctx->freeCondition, &ctx->mutex, TIMEOUT_INFINITE);
+
+    struct BunyArLibExtractChunk* chunk = ctx->abort ? NULL : ctx->freeChunks;
+    if (chunk)
+        ctx->freeChunks = chunk->next;
+    releaseMutex(&ctx->mutex);
+    return chunk;
+}
+
+static void bunyArLibExtractQueueChunk(struct BunyArLibExtractContext* ctx, struct BunyArLibExtractChunk* chunk)
+{
+    chunk->next = NULL;
+
+    acquireMutex(&ctx->mutex);
+    if (ctx->queueTail)
+        ctx->queueTail->next = chunk;
+    else
+        ctx->queueHead = chunk;
+    ctx->queueTail = chunk;
+    wakeOneConditionVariable(&ctx->queueCondition);
+    releaseMutex(&ctx->mutex);
+}
+
+static void bunyArLibExtractFileTask(struct BunyArLibExtractContext* ctx, uint64_t index)
+{
+    const struct BunyArLibExtractDesc* desc = ctx->desc;
+    struct BunyArLibExtractFile*       file = ctx->files + index;
+
+    uint64_t uid = index;
+    if (desc->fileNameCount && !fsArchiveGetNodeId(ctx->archive, desc->fileNames[index], &uid))
+    {
+        file->node.name = desc->fileNames[index];
+        file->error = "no such file";
+    }
+    else
+    {
+        fsArchiveGetNodeDescription(ctx->archive, uid, &file->node);
+    }
+
+    if (!file->error && strncmp(file->node.name, "../", 3) == 0)
+        file->skipped = true;
+
+    FileStream fsIn = { 0 };
+    if (!file->error && !file->skipped && !fsIoOpenByUid(ctx->archive, uid, FM_READ, &fsIn))
+        file->error = "file is corrupted or archive stream failure";
+
+    // Every file sends at least one chunk, the last one completes the file
+    uint64_t totalSize = 0;
+    for (;;)
+    {
+        struct BunyArLibExtractChunk* chunk = bunyArLibExtractAcquireChunk(ctx);
+        if (!chunk)
+            break;
+
+        chunk->file = file;
+        chunk->size = 0;
+        if (!file->error && !file->skipped)
+            chunk->size = fsReadFromStream(&fsIn, chunk->data, BUNYAR_LIB_EXTRACT_CHUNK_SIZE);
+        totalSize += chunk->size;
+
+        // chunk belongs to the writer once queued
+        bool last = chunk->size == 0 || totalSize >= file->node.fileSize;
+        if (last && !file->error && !file->skipped && totalSize != file->node.fileSize)
+            file->error = "File size mismatch";
+
+        chunk->last = last;
+        bunyArLibExtractQueueChunk(ctx, chunk);
+        if (last)
+            break;
+    }
+
+    fsCloseStream(&fsIn);
+}
+
+static void bunyArLibExtractFilesTask(void* user, uint64_t begin, uint64_t end, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    for (uint64_t i = begin; i < end; ++i)
+        bunyArLibExtractFileTask((struct BunyArLibExtractContext*)user, i);
+}
+
+static void bunyArLibExtractWriteChunk(struct BunyArLibExtractContext* ctx, struct BunyArLibExtractChunk* chunk)
+{
+    struct BunyArLibExtractFile* file = chunk->file;
+
+    if (!file->error && !file->skipped && !file->out.pIO)
+    {
+        char path[FS_MAX_PATH];
+        char subDir[FS_MAX_PATH];
+        fsGetParentPath(file->node.name, subDir);
+        fsAppendPathComponent(ctx->dstDir, subDir, path);
+        if (!fsCreateDirectory(ctx->rd, path, true))
+            file->error = "failed to create directory";
+
+        fsAppendPathComponent(ctx->dstDir, file->node.name, path);
+        if (!file->error && !fsOpenStreamFromPath(ctx->rd, path, FM_WRITE, &file->out))
+            file->error = "failed to create output file";
+    }
+
+    if (!file->error && chunk->size)
+    {
+        if (fsWriteToStream(&file->out, chunk->data, chunk->size) != chunk->size)
+            file->error = "failed to write data to output file";
+    }
+
+    if (!chunk->last)
+        return;
+
+    fsCloseStream(&file->out);
+
+    const struct BunyArLibExtractDesc* desc = ctx->desc;
+    ++ctx->doneCount;
+
+    if (file->skipped)
+    {
+        LOGF(eERROR, "Archive file '%s' contains backlinks, so it is skipped.", file->node.name);
+    }
+    else if (file->error)
+    {
+        ++ctx->failureCount;
+        LOGF(eERROR, "Failed to extract file '%s': %s", file->node.name, file->error);
+
+        if (!desc->continueOnError)
+        {
+            acquireMutex(&ctx->mutex);
+            ctx->abort = true;
+            wakeAllConditionVariable(&ctx->freeCondition);
+            releaseMutex(&ctx->mutex);
+        }
+    }
+    else if (desc->verbose > 1)
+    {
+        fprintf(stdout, "%*llu/%*llu '%s' %s %s -> %s (x%.2f)\n", ctx->counterWidth, (unsigned long long)ctx->doneCount,
+                ctx->counterWidth, (unsigned long long)ctx->fileCount, file->node.name,
+                bunyArFormatName((enum BunyArFileFormat)file->node.format), humanReadableSize(file->node.compressedSize).str,
+                humanReadableSize(file->node.fileSize).str, (double)file->node.fileSize / (double)file->node.compressedSize);
+    }
+    else if (desc->verbose)
+    {
+        fprintf(stdout, "%*llu/%*llu '%s'\n", ctx->counterWidth, (unsigned long long)ctx->doneCount, ctx->counterWidth,
+                (unsigned long long)ctx->fileCount, file->node.name);
+    }
+}
+
+static void bunyArLibExtractWriterThreadFunc(void* pUser)
+{
+    struct BunyArLibExtractContext* ctx = (struct BunyArLibExtractContext*)pUser;
+
+    for (;;)
+    {
+        acquireMutex(&ctx->mutex);
+        while (!ctx->queueHead && !ctx->workersDone)
+            waitConditionVariable(&ctx->queueCondition, &ctx->mutex, TIMEOUT_INFINITE);
+
+        struct BunyArLibExtractChunk* chunk = ctx->queueHead;
+        if (chunk)
+        {
+            ctx->queueHead = chunk->next;
+            if (!ctx->queueHead)
+                ctx->queueTail = NULL;
+        }
+        releaseMutex(&ctx->mutex);
+
+        if (!chunk)
+            break;
+
+        bunyArLibExtractWriteChunk(ctx, chunk);
+
+        acquireMutex(&ctx->mutex);
+        chunk->next = ctx->freeChunks;
+        ctx->freeChunks = chunk;
+        wakeOneConditionVariable(&ctx->freeCondition);
+        releaseMutex(&ctx->mutex);
+    }
+}
+
+static bool bunyArLibExtractMultiThreaded(IFileSystem* archive, ResourceDirectory rd, const char* dstDir,
+                                          const struct BunyArLibExtractDesc* desc)
+{
+    struct BunyArDescription archiveInfo;
+    fsArchiveGetDescription(archive, &archiveInfo);
+
+    struct BunyArLibExtractContext ctx;
+    memset(&ctx, 0, sizeof ctx);
+    ctx.archive = archive;
+    ctx.rd = rd;
+    ctx.dstDir = dstDir;
+    ctx.desc = desc;
+    ctx.fileCount = desc->fileNameCount ? desc->fileNameCount : archiveInfo.nodeCount;
+
+    if (desc->verbose)
+    {
+        char buffer[32];
+        ctx.counterWidth = snprintf(buffer, sizeof buffer, "%llu", (unsigned long long)ctx.fileCount);
+    }
+
+    uint64_t threadPoolSize = desc->threadPoolSize < 0 ? getNumCPUCores() : (uint64_t)desc->threadPoolSize;
+
+    // Writer queue is bounded by memory, at least one chunk per thread to keep them busy
+    uint64_t threadMemorySize = desc->memorySizePerThread ? desc->memorySizePerThread : 1024 * 1024 * 4;
+    uint64_t chunkCount = (threadPoolSize + 1) * threadMemorySize / BUNYAR_LIB_EXTRACT_CHUNK_SIZE;
+    if (chunkCount < threadPoolSize + 1)
+        chunkCount = threadPoolSize + 1;
+
+    ctx.files = (struct BunyArLibExtractFile*)tf_calloc(ctx.fileCount + 1, sizeof(*ctx.files));
+    ctx.chunks = (struct BunyArLibExtractChunk*)tf_calloc(chunkCount, sizeof(*ctx.chunks));
+    ctx.chunkMemory = tf_malloc(chunkCount * BUNYAR_LIB_EXTRACT_CHUNK_SIZE);
+
+    for (uint64_t i = 0; i < chunkCount; ++i)
+    {
+        ctx.chunks[i].data = (uint8_t*)ctx.chunkMemory + i * BUNYAR_LIB_EXTRACT_CHUNK_SIZE;
+        ctx.chunks[i].next = ctx.freeChunks;
+        ctx.freeChunks = ctx.chunks + i;
+    }
+
+    initMutex(&ctx.mutex);
+    initConditionVariable(&ctx.freeCondition);
+    initConditionVariable(&ctx.queueCondition);
+
+    struct ThreadSystemInitDesc tsInfo = gThreadSystemInitDescDefault;
+    tsInfo.threadCount = threadPoolSize;
+
+    ThreadSystem threadSystem = NULL;
+    ThreadHandle writerThread = { 0 };
+
+    bool success = threadSystemInit(&threadSystem, &tsInfo);
+    if (success)
+    {
+        ThreadDesc threadInfo = { 0 };
+        threadInfo.pFunc = bunyArLibExtractWriterThreadFunc;
+        threadInfo.pData = &ctx;
+        snprintf(threadInfo.mThreadName, sizeof threadInfo.mThreadName, "ExtractWriter");
+        success = initThread(&threadInfo, &writerThread);
+    }
+
+    if (success)
+    {
+        // calling thread takes part in decompression
+        threadSystemParallelFor(threadSystem, ctx.fileCount, 1, bunyArLibExtractFilesTask, &ctx);
+
+        acquireMutex(&ctx.mutex);
+        ctx.workersDone = true;
+        wakeAllConditionVariable(&ctx.queueCondition);
+        releaseMutex(&ctx.mutex);
+
+        joinThread(writerThread);
+    }
+    else
+    {
+        LOGF(eERROR, "Failed to start extraction threads");
+    }
+
+    if (threadSystem)
+        threadSystemExit(&threadSystem, &gThreadSystemExitDescDefault);
+
+    // files interrupted by abort
+    for (uint64_t i = 0; i < ctx.fileCount; ++i)
+        fsCloseStream(&ctx.files[i].out);
+
+    if (success && desc->verbose && (ctx.failureCount || ctx.abort))
+    {
+        fprintf(stdout, "\nSome files are not extracted (%llu/%llu)\n", (unsigned long long)(ctx.doneCount - ctx.failureCount),
+                (unsigned long long)ctx.fileCount);
+    }
+    else if (success && desc->verbose)
+    {
+        fprintf(stdout, "\nAll files are extracted (%llu)\n", (unsigned long long)ctx.fileCount);
+    }
+
+    success = success && ctx.failureCount == 0 && !ctx.abort;
+
+    exitConditionVariable(&ctx.queueCondition);
+    exitConditionVariable(&ctx.freeCondition);
+    exitMutex(&ctx.mutex);
+    tf_free(ctx.chunkMemory);
+    tf_free(ctx.chunks);
+    tf_free(ctx.files);
+    return success;
+}
+
+bool bunyArLibExtract(struct IFileSystem* archive, ResourceDirectory rd, const char* dstDir, const struct BunyArLibExtractDesc* desc)
+{
+    if (desc->threadPoolSize != 0)
+        return bunyArLibExtractMultiThreaded(archive, rd, dstDir, desc);
+
+    struct BunyArDescription archiveInfo;
+    fsArchiveGetDescription(archive, &archiveInfo);
+
+    FileStream fsOut = { 0 };
+    FileStream fsIn = { 0 };
+
+    bool loopFileNames = desc->fileNameCount > 0;
+
+    uint64_t loopLimit = loopFileNames ? desc->fileNameCount : archiveInfo.nodeCount;
+
+    int counterWidth = 0;
+    int printedLength = 0;
+    if (desc->verbose)
+    {
+        char buffer[32];
+        counterWidth = snprintf(buffer, sizeof buffer, "%llu", (unsigned long long)loopLimit);
+    }
+
+    uint64_t failureCount = 0;
+
+    for (uint64_t i = 0; i < loopLimit; ++i)
+    {
+        const char* error = NULL;
+
+        uint64_t uid = i;
+
+        uint64_t totalSize = 0;
+        char     buffer[64 * 1024];
+        ASSERT(sizeof buffer >= FS_MAX_PATH);
+
+        struct BunyArNodeDescription node;
+
+        if (loopFileNames && !fsArchiveGetNodeId(archive, desc->fileNames[i], &uid))
+        {
+            node.name = desc->fileNames[i];
+            error = "no such file";
+            goto FILE_DONE;
+        }
+
+        fsArchiveGetNodeDescription(archive, uid, &node);
+
+        if (desc->verbose)
         {
             printedLength =
                 fprintf(stdout, "%*llu/%*llu ", counterWidth, (unsigned long long)i + 1, counterWidth, (unsigned long long)loopLimit);
@@ -2283,61 +3539,68 @@ bool bunyArLibHashTableBenchmarks(size_t keyCount, size_t keySize)
     LOGF(eINFO, "%llu unique %llu-bit keys generated in %s", (unsigned long long)keyCount, (unsigned long long)keySize * 8,
          humanReadableTime(endTime - startTime).str);
 
-    ///////////////////
-    // Contruction test
-
-    startTime = getUSec(true);
+    // Both table types are tested on the same keys
+    for (int perfect = 0; perfect < 2 && success; ++perfect)
+    {
+        const char* tableName = perfect ? "Archive perfect hash table" : "Archive hash table";
 
-    struct BunyArHashTable* hashTable = bunyArHashTableConstruct(keyCount, nodes, names);
+        ///////////////////
+        // Contruction test
 
-    endTime = getUSec(true);
+        startTime = getUSec(true);
 
-    size_t htsize = bunyArHashTableSize(hashTable);
+        uint64_t htsize = 0;
+        void*    hashTable = bunyArLibHashTableConstruct(perfect, keyCount, nodes, names, &htsize);
 
-    LOGF(eINFO, "Archive hash table %s for %llu keys in %s. %s (%f bits/key).", hashTable ? "construction" : "construction failure",
-         (unsigned long long)keyCount, humanReadableTime(endTime - startTime).str, humanReadableSize(htsize).str,
-         (double)(8 * htsize) / (double)keyCount);
+        endTime = getUSec(true);
 
-    if (!hashTable)
-    {
-        success = false;
-        goto CLEANUP;
-    }
+        LOGF(eINFO, "%s %s for %llu keys in %s. %s (%f bits/key).", tableName, hashTable ? "construction" : "construction failure",
+             (unsigned long long)keyCount, humanReadableTime(endTime - startTime).str, humanReadableSize(htsize).str,
+             (double)(8 * htsize) / (double)keyCount);
 
-    //////////////
-    // Lookup test
+        if (!hashTable)
+        {
+            success = false;
+            break;
+        }
 
-    startTime = getUSec(true);
+        //////////////
+        // Lookup test
 
-    for (size_t i = 0; i < keyCount; ++i)
-    {
-        uint64_t value = bunyArHashTableLookup(hashTable, names + nodes[i].namePointer.offset, keyCount, nodes, names);
+        startTime = getUSec(true);
 
-        if (value >= keyCount)
+        for (size_t i = 0; i < keyCount && success; ++i)
         {
-            LOGF(eERROR, "Archive hash table lookup test failed: key wasn't found.");
-            success = false;
-            goto CLEANUP;
+            const char* name = names + nodes[i].namePointer.offset;
+            uint64_t    value = perfect ? bunyArPerfectHashTableLookup(hashTable, name, keyCount, nodes, names)
+                                        : bunyArHashTableLookup(hashTable, name, keyCount, nodes, names);
+
+            if (value >= keyCount)
+            {
+                LOGF(eERROR, "%s lookup test failed: key wasn't found.", tableName);
+                success = false;
+            }
+            else if (value != i)
+            {
+                LOGF(eERROR, "%s lookup test failed: got the wrong key.", tableName);
+                success = false;
+            }
         }
 
-        if (value != i)
+        endTime = getUSec(true);
+
+        if (success)
         {
-            LOGF(eERROR, "Archive hash table lookup test failed: got the wrong key.");
-            success = false;
-            goto CLEANUP;
+            LOGF(eINFO, "%s lookup for %llu keys in %s. %s/key", tableName, (unsigned long long)keyCount,
+                 humanReadableTime(endTime - startTime).str, humanReadableTimeD((double)(endTime - startTime) / (double)keyCount).str);
         }
-    }
-
-    endTime = getUSec(true);
 
-    LOGF(eINFO, "Archive hash table lookup for %llu keys in %s. %s/key", (unsigned long long)keyCount,
-         humanReadableTime(endTime - startTime).str, humanReadableTimeD((double)(endTime - startTime) / (double)keyCount).str);
+        tf_free(hashTable);
+    }
 
     ///////////////////////
     // Cleanup
 
-CLEANUP:
-    tf_free(hashTable);
     tf_free(nodes);
 
     return success;
@@ -32,6 +32,7 @@ extern "C"
 #define BUNYAR_LIB_COMPRESSION_LEVEL_DEFAULT INT_MIN
 #define BUNYAR_LIB_BLOCK_SIZE_KB_DEFAULT     UINT32_MAX
 #define BUNYAR_LIB_FORMAT_DEFAULT            BUNYAR_FILE_FORMAT_LZ4_BLOCKS
+#define BUNYAR_LIB_DICTIONARY_MIN_FILES      8
 
     struct BunyArLibEntryCreateDesc
     {
@@ -71,6 +72,9 @@ extern "C"
         struct BunyArLibEntryCreateDesc* entries;
 
         bool     skipHashTable;
+        // Store BunyArPerfectHashTable instead of BunyArHashTable, it is ~3.5 times smaller.
+        // Such archives require reader of version 2.
+        bool     perfectHashTable;
         // larger value, more details
         unsigned verbose;
 
@@ -88,6 +92,15 @@ extern "C"
         // Minimum is 4KB
         // If 0, it sets to default 4MB
         size_t memorySizePerThread;
+
+        // Size of ZSTD dictionaries in KB. If 0, dictionaries are not used.
+        // ZSTD files fitting into a single block are grouped by extension,
+        // every group of at least BUNYAR_LIB_DICTIONARY_MIN_FILES files gets a dictionary sampled from its files.
+        uint32_t dictionarySizeKb;
+
+        // Files with identical contents, format, block size and dictionary are stored once and share the data.
+        // Candidates found by content hash are compared byte by byte.
+        bool dedup;
     };
 
     static const struct BunyArLibEntryCreateDesc BUNYAR_LIB_FUNC_CREATE_DEFAULT_ENTRY_DESC = {
@@ -105,6 +118,16 @@ extern "C"
 
     bool bunyArLibCreate(ResourceDirectory rd, const char* dstPath, const struct BunyArLibCreateDesc* desc);
 
+    // Appends new and changed entries to the end of an existing archive and rewrites node table, names and hash table after them.
+    // Entry replaces the archive file with the same name, entry with the same format and contents is skipped.
+    // Archive files missing in 'desc' are kept in place. Replaced data and old metadata become dead space.
+    // Archive header is written last, so the archive stays valid if the update fails.
+    bool bunyArLibUpdate(ResourceDirectory rd, const char* archivePath, const struct BunyArLibCreateDesc* desc);
+
+    // Writes a copy of 'srcPath' archive without dead space left by bunyArLibUpdate.
+    // Compressed data is copied as is.
+    bool bunyArLibCompact(ResourceDirectory rd, const char* srcPath, const char* dstPath, unsigned verbose);
+
     struct BunyArLibExtractDesc
     {
         // if fileNameCount is 0, all files are extracted
@@ -119,6 +142,17 @@ extern "C"
         // Try all files even after failing extracting anyone,
         // e.g. if one from "fileNames" is missing, extract others anyway
         bool continueOnError;
+
+        // if < 0, uses getNumCPUCores()
+        // if = 0, uses single-threaded code path
+        // if > 0, threadPoolSize decompress files + writer thread
+        // Archive must allow reading several files at once, see ArchiveOpenDesc::protectStreamCriticalSection
+        int threadPoolSize;
+
+        // Size of decompressed data queued for the writer per thread.
+        // Workers wait for the writer when the queue is full.
+        // If 0, it sets to default 4MB
+        size_t memorySizePerThread;
     };
 
     bool bunyArLibExtract(struct IFileSystem* archiveFs, ResourceDirectory rd, const char* dstPath,
@@ -25,6 +25,7 @@
 #include <locale.h>
 
 #include "../../Utilities/Interfaces/ILog.h"
+#include "../../Utilities/Interfaces/ITime.h"
 
 #include "Buny.h"
 
@@ -56,6 +57,9 @@ enum ArgType
     AT_PARALLEL_READS,
     AT_MEMORY_SIZE,
     AT_THREADS,
+    AT_DICTIONARY,
+    AT_DEDUP,
+    AT_TIMING,
 };
 
 struct ArgTracker
@@ -71,6 +75,8 @@ struct BunyArToolCtx
 {
     // archive create flags
     bool hashMap;
+    bool perfectHashMap;
+    bool dedup;
 
     // archive create entry args
     size_t                outputNameCutLength; // only set by drag&drop
@@ -83,12 +89,14 @@ struct BunyArToolCtx
     int                   threadCount;
     size_t                parallelFileReads;
     size_t                MBPerThread;
+    uint32_t              dictionarySizeKb;
 
     // inspect
     bool inspectBlocks;
 
     // extract
     bool keepGoing;
+    bool timing;
 
     // benchmark
     size_t keyCount;
@@ -128,8 +136,11 @@ static struct ArgTracker ARG_TRACKER_CREATE[] = {
 	{ "--bsize",          AT_BLOCK_SIZE,        1, (BUNYAR_BLOCK_MAX_SIZE_MINUS_ONE + 1) / 1024, "size of compressed data block in KB" },
 	{ "--hashmap",        AT_HASHMAP,           0, 0, "precompute hash table (enabled by default)" },
 	{ "--no-hashmap",     AT_HASHMAP,           0, 0, "disable hash table precomputing" },
+	{ "--perfect-hash",   AT_HASHMAP,           0, 0, "precompute compact perfect hash table, requires archive reader version 2" },
 	{ "--optional",       AT_OPTIONAL,          0, 0, "keep going if next entries are missing" },
 	{ "--required",       AT_OPTIONAL,          0, 0, "undo --optional" },
+	{ "--dictionary",     AT_DICTIONARY,        0, 1024, "KB of ZSTD dictionary per extension of small files. 0 disables" },
+	{ "--dedup",          AT_DEDUP,             0, 0, "store files with identical contents once" },
 	{ "--help",           AT_HELP,              0, 0, "be provided with something that is useful or necessary in achieving" },
 	{ NULL,               AT_UNRECOGNIZED,      0, 0, NULL },
 };
@@ -139,10 +150,19 @@ static struct ArgTracker ARG_TRACKER_INSPECT[] = {
 	{ NULL,           AT_UNRECOGNIZED,      0, 0, NULL },
 };
 static struct ArgTracker ARG_TRACKER_EXTRACT[] = {
-	{ "--keep-going", AT_CONTINUE_ON_ERROR, 0, 0, "continue on error" },
+	{ "--keep-going",    AT_CONTINUE_ON_ERROR, 0, 0, "continue on error" },
+	{ "--quiet",         AT_VERBOSITY,         0, 0, "disable stdout output (log not affected)" },
+	{ "--verbose",       AT_VERBOSITY,         0, 0, "display statistics" },
+	{ "--threads",       AT_THREADS,          -1, 99, "thread pool size. 0 singlethreaded. -1 auto" },
+	{ "--thread-memory", AT_MEMORY_SIZE,       1, 64, "MB of decompressed data queued per thread" },
+	{ "--timing",        AT_TIMING,            0, 0, "print extraction time and throughput" },
+	{ "--help",          AT_HELP,              0, 0, "gain assistance or support to achieve goals" },
+	{ NULL,           AT_UNRECOGNIZED,      0, 0, NULL },
+};
+static struct ArgTracker ARG_TRACKER_COMPACT[] = {
 	{ "--quiet",      AT_VERBOSITY,         0, 0, "disable stdout output (log not affected)" },
 	{ "--verbose",    AT_VERBOSITY,         0, 0, "display statistics" },
-	{ "--help",       AT_HELP,              0, 0, "gain assistance or support to achieve goals" },
+	{ "--help",       AT_HELP,              0, 0, "offer a helping hand" },
 	{ NULL,           AT_UNRECOGNIZED,      0, 0, NULL },
 };
 static struct ArgTracker ARG_TRACKER_BENCHMARK[] = {
@@ -257,6 +277,7 @@ static bool nextArg(struct BunyArToolCtx* ctx, char** out)
             break;
         case AT_HASHMAP:
             ctx->hashMap = resolver != 'n';
+            ctx->perfectHashMap = resolver == 'p';
             break;
         case AT_VERBOSITY:
             ctx->verbose = resolver == 'q' ? 0 : 2;
@@ -291,6 +312,15 @@ static bool nextArg(struct BunyArToolCtx* ctx, char** out)
         case AT_MEMORY_SIZE:
             ctx->MBPerThread = (size_t)value;
             break;
+        case AT_DICTIONARY:
+            ctx->dictionarySizeKb = (uint32_t)value;
+            break;
+        case AT_DEDUP:
+            ctx->dedup = true;
+            break;
+        case AT_TIMING:
+            ctx->timing = true;
+            break;
         case AT_UNRECOGNIZED:
         default:
             fprintf(stderr, "Unrecognized argument '%s'\n", a);
@@ -335,7 +365,7 @@ static void displayArgsHelp(struct ArgTracker* args)
     putc('\n', stdout);
 }
 
-static int bunyArToolCreate(struct BunyArToolCtx* ctx)
+static int bunyArToolCreate(struct BunyArToolCtx* ctx, bool update)
 {
     {
         int min;
@@ -353,7 +383,11 @@ static int bunyArToolCreate(struct BunyArToolCtx* ctx)
     ctx->argTrackers = ARG_TRACKER_CREATE;
 
     // clang-format off
-	ctx->helpStr =
+	ctx->helpStr = update ?
+	  "Update archive with the list of entries. Options are the same as for create.\n"
+	  "\nUsage:\n\tupdate archive_file --zstd Art\n\n"
+	  "New and changed files are appended to the archive, files with unchanged contents are skipped, other archive files are kept.\n"
+	  "Replaced data stays in the archive as dead space until \"compact\" command.\n" :
 	  "Create archive from the list of entries. Entries are directory or file paths.\n"
 	  "\nUsage:\n\tcreate output_file --zstd Art --lz4 readme.txt --name backup /home/Downloads\n\n"
 	  "Each entry has its own set of options, e.g. Art directory is compressed using ZSTD, while \"readme.txt\" and \"/home/Downloads\" entries are compressed using LZ4.\n\n"
@@ -415,13 +449,19 @@ static int bunyArToolCreate(struct BunyArToolCtx* ctx)
     if (success)
     {
         info.skipHashTable = !ctx->hashMap;
+        info.perfectHashTable = ctx->perfectHashMap;
         info.verbose = ctx->verbose;
 
         info.maxParallelFileReads = ctx->parallelFileReads;
         info.threadPoolSize = ctx->threadCount;
         info.memorySizePerThread = ctx->MBPerThread * 1024 * 1024;
+        info.dictionarySizeKb = ctx->dictionarySizeKb;
+        info.dedup = ctx->dedup;
 
-        success = bunyArLibCreate(TF_RD, ctx->archivePath, &info);
+        if (update)
+            success = bunyArLibUpdate(TF_RD, ctx->archivePath, &info);
+        else
+            success = bunyArLibCreate(TF_RD, ctx->archivePath, &info);
     }
 
     tf_free(info.entries);
@@ -429,6 +469,56 @@ static int bunyArToolCreate(struct BunyArToolCtx* ctx)
     return success ? 0 : -1;
 }
 
+static int bunyArToolCompact(struct BunyArToolCtx* ctx)
+{
+    ctx->argTrackers = ARG_TRACKER_COMPACT;
+
+    // clang-format off
+	ctx->helpStr =
+	  "Remove dead space left by archive updates. Compressed data is copied as is.\n"
+	  "\nUsage:\n\tcompact archive_file\n\tcompact archive_file output_file\n";
+    // clang-format on
+
+    const char* output = NULL;
+    for (;;)
+    {
+        char* arg;
+        if (!nextArg(ctx, &arg))
+            return -1;
+
+        if (arg == NULL)
+            break;
+
+        if (output)
+        {
+            fprintf(stderr, "Unexpected argument '%s'\n", arg);
+            return -1;
+        }
+        output = arg;
+    }
+
+    if (output)
+        return bunyArLibCompact(TF_RD, ctx->archivePath, output, ctx->verbose) ? 0 : -1;
+
+    // compact in place through a temporary file
+    char tmpPath[FS_MAX_PATH];
+    snprintf(tmpPath, sizeof tmpPath, "%s.compact", ctx->archivePath);
+
+    if (!bunyArLibCompact(TF_RD, ctx->archivePath, tmpPath, ctx->verbose))
+    {
+        fsRemoveFile(TF_RD, tmpPath);
+        return -1;
+    }
+
+    if (!fsRemoveFile(TF_RD, ctx->archivePath) || !fsRenameFile(TF_RD, tmpPath, ctx->archivePath))
+    {
+        fprintf(stderr, "Failed to replace '%s' by '%s'\n", ctx->archivePath, tmpPath);
+        return -1;
+    }
+
+    return 0;
+}
+
 static int bunyArToolInspect(struct BunyArToolCtx* ctx)
 {
     ctx->argTrackers = ARG_TRACKER_INSPECT;
@@ -546,11 +636,14 @@ static int bunyArToolExtract(struct BunyArToolCtx* ctx)
 
     desc.verbose = ctx->verbose;
     desc.continueOnError = ctx->keepGoing;
+    desc.threadPoolSize = ctx->threadCount;
+    desc.memorySizePerThread = ctx->MBPerThread * 1024 * 1024;
 
     struct ArchiveOpenDesc adesc = { 0 };
 
     adesc.disableHashTable = desc.fileNameCount == 0;
     adesc.validation = true;
+    adesc.protectStreamCriticalSection = desc.threadPoolSize != 0;
 
     IFileSystem archiveFs = { 0 };
     if (success && !fsArchiveOpen(TF_RD, ctx->archivePath, &adesc, &archiveFs))
@@ -559,9 +652,35 @@ static int bunyArToolExtract(struct BunyArToolCtx* ctx)
         success = false;
     }
 
+    int64_t startTime = getUSec(true);
+
     if (success)
         success = bunyArLibExtract(&archiveFs, TF_RD, output, &desc);
 
+    if (success && ctx->timing)
+    {
+        double seconds = (double)(getUSec(true) - startTime) / 1e6;
+
+        struct BunyArDescription archiveInfo;
+        fsArchiveGetDescription(&archiveFs, &archiveInfo);
+
+        uint64_t fileCount = desc.fileNameCount ? desc.fileNameCount : archiveInfo.nodeCount;
+        uint64_t totalSize = 0;
+        for (uint64_t i = 0; i < fileCount; ++i)
+        {
+            uint64_t uid = i;
+            if (desc.fileNameCount && !fsArchiveGetNodeId(&archiveFs, desc.fileNames[i], &uid))
+                continue;
+
+            struct BunyArNodeDescription node;
+            fsArchiveGetNodeDescription(&archiveFs, uid, &node);
+            totalSize += node.fileSize;
+        }
+
+        fprintf(stdout, "Extracted %llu files, %s in %.3f seconds (%.2f MB/s)\n", (unsigned long long)fileCount,
+                humanReadableSize(totalSize).str, seconds, (double)totalSize / (1024.0 * 1024.0) / (seconds > 0 ? seconds : 1e-6));
+    }
+
     fsArchiveClose(&archiveFs);
 
     tf_free(desc.fileNames);
@@ -785,7 +904,7 @@ static bool tryDragNdrop(struct BunyArToolCtx* ctx, int* res, char** freeMe)
     ctx->verbose = 0;
 #endif
 
-    *res = bunyArToolCreate(ctx);
+    *res = bunyArToolCreate(ctx, false);
 
     if (*res == 0)
     {
@@ -825,6 +944,8 @@ static int bunyArTool(int argCount, char** args)
         fprintf(stdout, "\nUsage:\n\t%s command --help\n\n", BUNYAR_TOOL_NAME);
         fprintf(stdout, "Commands:\n");
         fprintf(stdout, "\tcreate      Create archive\n");
+        fprintf(stdout, "\tupdate      Append new and changed files to archive\n");
+        fprintf(stdout, "\tcompact     Remove dead space from archive\n");
         fprintf(stdout, "\tinspect     Lookup archive content\n");
         fprintf(stdout, "\textract     Extract archive\n");
         fprintf(stdout, "\tbenchmark   Run benchmarks\n");
@@ -859,7 +980,11 @@ static int bunyArTool(int argCount, char** args)
 
     int res = -1;
     if (strcmp(cmd, "create") == 0)
-        res = bunyArToolCreate(&ctx);
+        res = bunyArToolCreate(&ctx, false);
+    else if (strcmp(cmd, "update") == 0)
+        res = bunyArToolCreate(&ctx, true);
+    else if (strcmp(cmd, "compact") == 0)
+        res = bunyArToolCompact(&ctx);
     else if (strcmp(cmd, "inspect") == 0)
         res = bunyArToolInspect(&ctx);
     else if (strcmp(cmd, "extract") == 0)
@@ -0,0 +1,307 @@
+# Copyright (c) 2017-2025 The Forge Interactive Inc.
+#
+# This file is part of The-Forge
+# (see https://github.com/ConfettiFX/The-Forge).
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+# Converts chunk files written by startProfileFlightRecorder into a Chrome JSON trace (chrome://tracing, ui.perfetto.dev), the
+# same events dumpProfileTrace writes. The chunk format is documented above PROFILE_FLIGHT_MAGIC in
+# Common_3/Application/Profiler/ProfilerBase.cpp. Chunks are ordered by their sequence number and placed on one timeline.
+#
+#   python3 FlightRecorderDecoder.py FlightRecorder-*.pfr -o FlightRecorder.json
+#   python3 FlightRecorderDecoder.py LogDir/FlightRecorder-Pinned-*.pfr --name MyApp
+
+import argparse
+import glob
+import json
+import os
+import struct
+import sys
+
+MAGIC = 0x30524650  # "PFR0"
+VERSION = 1
+
+CHUNK_PINNED = 0x1
+CHUNK_TRIGGERED = 0x2
+
+HEADER = struct.Struct("<IIQIIII64s")
+PAYLOAD = struct.Struct("<dIIIII")
+THREAD = struct.Struct("<64sIqdI")
+
+# ProfileLogEntry layout, see P_LOG_TICK_MASK in ProfilerBase.h
+LOG_TICK_MASK = 0x0000ffffffffffff
+LOG_LEAVE = 0
+LOG_ENTER = 1
+LOG_LABEL = 3
+LOG_LABEL_LITERAL = 5
+
+
+def lz4_block_decompress(src, size):
+    dst = bytearray()
+    pos = 0
+    while pos < len(src):
+        token = src[pos]
+        pos += 1
+        length = token >> 4
+        if length == 15:
+            while True:
+                extra = src[pos]
+                pos += 1
+                length += extra
+                if extra != 255:
+                    break
+        dst += src[pos:pos + length]
+        pos += length
+        # The last sequence only has literals
+        if pos >= len(src):
+            break
+        offset = src[pos] | (src[pos + 1] << 8)
+        pos += 2
+        if offset == 0 or offset > len(dst):
+            raise ValueError("corrupted LZ4 block")
+        length = token & 15
+        if length == 15:
+            while True:
+                extra = src[pos]
+                pos += 1
+                length += extra
+                if extra != 255:
+                    break
+        length += 4
+        start = len(dst) - offset
+        if length <= offset:
+            dst += dst[start:start + length]
+        else:
+            # Overlapping match repeats the last offset bytes
+            for i in range(length):
+                dst.append(dst[start + i])
+    if len(dst) != size:
+        raise ValueError("LZ4 block decompressed to {} bytes, expected {}".format(len(dst), size))
+    return bytes(dst)
+
+
+def read_string(data, pos):
+    end = data.index(b"\0", pos)
+    return data[pos:end].decode("utf-8", "replace"), end + 1
+
+
+def tick_difference(start, entry):
+    # ProfileLogTickDifference: signed difference of the 48 bit ticks
+    diff = (entry - start) & LOG_TICK_MASK
+    return diff - (1 << 48) if diff & (1 << 47) else diff
+
+
+class Chunk(object):
+    pass
+
+
+def read_chunk(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < HEADER.size:
+        raise ValueError("truncated chunk header")
+    magic, version, sequence, flags, frames, compressed_size, uncompressed_size, reason = HEADER.unpack_from(data, 0)
+    if magic != MAGIC:
+        raise ValueError("not a flight recorder chunk")
+    if version != VERSION:
+        raise ValueError("unsupported chunk version {}".format(version))
+    if HEADER.size + compressed_size > len(data):
+        raise ValueError("truncated chunk")
+    payload = lz4_block_decompress(data[HEADER.size:HEADER.size + compressed_size], uncompressed_size)
+
+    chunk = Chunk()
+    chunk.path = path
+    chunk.sequence = sequence
+    chunk.flags = flags
+    chunk.reason = reason.split(b"\0", 1)[0].decode("utf-8", "replace")
+
+    tick_to_ns, frames, timers, threads, label_bytes, counters = PAYLOAD.unpack_from(payload, 0)
+    pos = PAYLOAD.size
+    chunk.tick_to_ns = tick_to_ns
+    chunk.frame_start = list(struct.unpack_from("<{}q".format(frames + 1), payload, pos))
+    pos += (frames + 1) * 8
+
+    chunk.timers = []
+    for _ in range(timers):
+        group, pos = read_string(payload, pos)
+        name, pos = read_string(payload, pos)
+        chunk.timers.append((group, name))
+
+    chunk.logs = []
+    for _ in range(threads):
+        name, gpu, tick_start, log_tick_to_ns, entries = THREAD.unpack_from(payload, pos)
+        pos += THREAD.size
+        log = Chunk()
+        log.name = name.split(b"\0", 1)[0].decode("utf-8", "replace")
+        log.gpu = gpu
+        log.tick_start = tick_start
+        log.tick_to_ns = log_tick_to_ns
+        log.entries = struct.unpack_from("<{}Q".format(entries), payload, pos)
+        pos += entries * 8
+        chunk.logs.append(log)
+
+    chunk.labels = payload[pos:pos + label_bytes]
+    pos += label_bytes
+
+    chunk.counters = []
+    for _ in range(counters):
+        name, pos = read_string(payload, pos)
+        chunk.counters.append((name, struct.unpack_from("<q", payload, pos)[0]))
+        pos += 8
+    return chunk
+
+
+# Track keys of events without a thread, resolved to track indices once every thread is known
+FRAME_TRACK = "Frames"
+COUNTER_TRACK = "Counters"
+
+
+class Writer(object):
+    def __init__(self):
+        self.events = []
+        self.tracks = {}
+
+    def event(self, phase, key, ns, **fields):
+        self.events.append((key, dict(ph=phase, pid=1, ts=round(ns / 1000.0, 3), **fields)))
+
+    def thread(self, name, gpu):
+        # Threads keep one track across chunks
+        key = (name, gpu)
+        if key not in self.tracks:
+            self.tracks[key] = len(self.tracks)
+        return key
+
+
+def emit_chunk(writer, chunk, base_ns, frame_index):
+    # Mirrors ProfileTraceEmit
+    tick_start = chunk.frame_start[0]
+    frames = len(chunk.frame_start) - 1
+    end_ns = base_ns + (chunk.frame_start[frames] - tick_start) * chunk.tick_to_ns
+
+    for i in range(frames):
+        writer.event("B", FRAME_TRACK, base_ns + (chunk.frame_start[i] - tick_start) * chunk.tick_to_ns, name="Frame {}".format(
+            frame_index + i), cat="Frame")
+        writer.event("E", FRAME_TRACK, base_ns + (chunk.frame_start[i + 1] - tick_start) * chunk.tick_to_ns)
+    if chunk.flags & CHUNK_TRIGGERED:
+        writer.event("i", FRAME_TRACK, base_ns, s="g", name="Flight recorder trigger: " + chunk.reason)
+
+    for log in chunk.logs:
+        track = writer.thread(log.name, log.gpu)
+        last_ns = base_ns
+        stack = []
+        for entry in log.entries:
+            log_type = (entry >> 61) & 7
+            timer = (entry >> 48) & 0x1fff
+            if log_type == LOG_ENTER or log_type == LOG_LEAVE:
+                if timer >= len(chunk.timers):
+                    continue
+                last_ns = base_ns + tick_difference(log.tick_start, entry) * log.tick_to_ns
+                if log_type == LOG_ENTER:
+                    stack.append(timer)
+                    writer.event("B", track, last_ns, name=chunk.timers[timer][1], cat=chunk.timers[timer][0])
+                # Scopes entered before the first frame have no begin, skip their leave
+                elif stack and stack[-1] == timer:
+                    stack.pop()
+                    writer.event("E", track, last_ns)
+            elif log_type == LOG_LABEL or log_type == LOG_LABEL_LITERAL:
+                offset = entry & LOG_TICK_MASK
+                if offset and offset <= len(chunk.labels):
+                    name = chunk.labels[offset - 1:].split(b"\0", 1)[0].decode("utf-8", "replace")
+                    writer.event("i", track, last_ns, s="t", name=name)
+
+        # Close scopes still open at the end of the last frame
+        for _ in stack:
+            writer.event("E", track, max(last_ns, end_ns))
+
+    for name, value in chunk.counters:
+        writer.event("C", COUNTER_TRACK, end_ns, name=name, args={"value": value})
+    return frames
+
+
+def convert(chunks, out, process_name):
+    writer = Writer()
+    first_tick = chunks[0].frame_start[0]
+    frame_index = 0
+    previous = None
+    for chunk in chunks:
+        if previous is not None and chunk.sequence != previous + 1:
+            sys.stderr.write("chunks {} to {} are missing, overwritten in the ring or dropped\n".format(previous + 1, chunk.sequence - 1))
+        previous = chunk.sequence
+        # Cpu ticks are absolute, Gpu logs start at the Gpu timestamp of the first frame like in dumpProfileTrace
+        base_ns = (chunk.frame_start[0] - first_tick) * chunk.tick_to_ns
+        frame_index += emit_chunk(writer, chunk, base_ns, frame_index)
+
+    # Same track layout as dumpProfileTrace: thread logs, then the frame track, counters on the first track
+    tracks = dict(writer.tracks)
+    tracks[FRAME_TRACK] = len(writer.tracks)
+    tracks[COUNTER_TRACK] = 0
+    names = [(index, key[0]) for key, index in writer.tracks.items()] + [(tracks[FRAME_TRACK], FRAME_TRACK)]
+
+    events = [dict(ph="M", pid=1, tid=1, ts=0.0, name="process_name", args={"name": process_name})]
+    for index, name in sorted(names):
+        events.append(dict(ph="M", pid=1, tid=index + 1, ts=0.0, name="thread_name", args={"name": name}))
+        events.append(dict(ph="M", pid=1, tid=index + 1, ts=0.0, name="thread_sort_index", args={"sort_index": index}))
+    for key, event in writer.events:
+        event["tid"] = tracks[key] + 1
+        events.append(event)
+
+    out.write('{"displayTimeUnit":"ms","traceEvents":[\n')
+    out.write(",\n".join(json.dumps(event, separators=(",", ":")) for event in events))
+    out.write("\n]}\n")
+    return len(events)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert flight recorder chunks written by startProfileFlightRecorder to a Chrome trace")
+    parser.add_argument("input", nargs="+", help="chunk files or directories containing *.pfr files")
+    parser.add_argument("-o", "--output", help="Chrome JSON trace, stdout when omitted")
+    parser.add_argument("--name", default="FlightRecorder", help="process name shown in the trace")
+    args = parser.parse_args()
+
+    paths = []
+    for path in args.input:
+        paths += sorted(glob.glob(os.path.join(path, "*.pfr"))) if os.path.isdir(path) else [path]
+
+    chunks = {}
+    for path in paths:
+        try:
+            chunk = read_chunk(path)
+        except (IOError, ValueError, struct.error) as error:
+            sys.stderr.write("{}: {}\n".format(path, error))
+            continue
+        # Pinned chunks are copies of ring chunks, keep one of them
+        chunks.setdefault(chunk.sequence, chunk)
+    if not chunks:
+        sys.stderr.write("no chunk to convert\n")
+        return 1
+    chunks = [chunks[sequence] for sequence in sorted(chunks)]
+
+    if args.output:
+        with open(args.output, "w") as out:
+            count = convert(chunks, out, args.name)
+    else:
+        count = convert(chunks, sys.stdout, args.name)
+        sys.stdout.flush()
+    sys.stderr.write("{} chunks, {} frames, {} events\n".format(len(chunks), sum(len(c.frame_start) - 1 for c in chunks), count))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -265,7 +265,7 @@ static void uiSetWidgetAllocatorPlotBufferChunkAllocatorData(UIWidget* pWidget,
     uint32_t nValues = (uint32_t)pPlotWidget->mSize[0];
     int64_t* values = pPlotWidget->pValues;
 
-    uint32_t unusedChunkCount = (uint32_t)arrlenu(data->mUnusedChunks);
+    uint32_t unusedChunkCount = data->mUnusedChunkCount;
 
     values[0] = (int64_t)data->mSize;
     ++values;
@@ -278,9 +278,10 @@ static void uiSetWidgetAllocatorPlotBufferChunkAllocatorData(UIWidget* pWidget,
 
     int64_t floatingOccupiedChunks = unusedChunkCount + 1;
 
-    for (uint32_t ci = 0; ci < unusedChunkCount; ++ci)
+    uint32_t ci = 0;
+    for (uint32_t node = data->mFirstUnusedChunk; node; node = data->pUnusedChunkNodes[node].mNext, ++ci)
     {
-        BufferChunk* freeChunk = data->mUnusedChunks + ci;
+        BufferChunk* freeChunk = &data->pUnusedChunkNodes[node].mChunk;
 
         if (ci == 0 && freeChunk->mOffset == 0)
             floatingOccupiedChunks -= 1;
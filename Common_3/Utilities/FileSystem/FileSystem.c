@@ -24,6 +24,7 @@
 
 #include <errno.h>
 
+#include "../ThirdParty/OpenSource/Nothings/stb_ds.h"
 #include "../ThirdParty/OpenSource/bstrlib/bstrlib.h"
 
 #include "../../Utilities/Interfaces/IFileSystem.h"
@@ -31,6 +32,9 @@
 #include "../../Utilities/Interfaces/IThread.h"
 #include "../../Utilities/Interfaces/ITime.h"
 
+#include "../../Utilities/Threading/Atomics.h"
+#include "../../Utilities/Threading/ThreadSystem.h"
+
 #include "../../Utilities/Interfaces/IMemory.h"
 
 // This macro enables custom ZSTD allocator features
@@ -261,6 +265,26 @@ static size_t ioMemoryStreamRead(FileStream* fs, void* dst, size_t size)
     return bytesToRead;
 }
 
+static size_t ioMemoryStreamReadAt(FileStream* fs, void* dst, size_t size, uint64_t offset)
+{
+    __FS_NO_ERR;
+    if (!(fs->mMode & FM_READ))
+    {
+        __FS_SET_ERR(FS_NOT_PERMITTED_ERR);
+        return 0;
+    }
+
+    MEMSD(stream, fs);
+
+    // Same as pread, reading past the end is not an error
+    if (offset >= (uint64_t)stream->mSize)
+        return 0;
+
+    size_t bytesToRead = (uint64_t)stream->mSize - offset < size ? (size_t)((uint64_t)stream->mSize - offset) : size;
+    memcpy(dst, stream->pBuffer + offset, bytesToRead);
+    return bytesToRead;
+}
+
 static size_t ioMemoryStreamWrite(FileStream* fs, const void* src, size_t size)
 {
     __FS_NO_ERR;
@@ -391,19 +415,16 @@ static bool ioMemoryStreamMemoryMap(FileStream* fs, size_t* outSize, void const*
 }
 
 static IFileSystem gMemoryFileIO = {
-    NULL,
-    ioMemoryStreamClose,
-    ioMemoryStreamRead,
-    ioMemoryStreamWrite,
-    ioMemoryStreamSeek,
-    ioMemoryStreamGetPosition,
-    ioMemoryStreamGetSize,
-    ioMemoryStreamFlush,
-    ioMemoryStreamIsAtEnd,
-    NULL,
-    NULL,
-    ioMemoryStreamMemoryMap,
-    NULL,
+    .Close = ioMemoryStreamClose,
+    .Read = ioMemoryStreamRead,
+    .Write = ioMemoryStreamWrite,
+    .Seek = ioMemoryStreamSeek,
+    .GetSeekPosition = ioMemoryStreamGetPosition,
+    .GetFileSize = ioMemoryStreamGetSize,
+    .Flush = ioMemoryStreamFlush,
+    .IsAtEnd = ioMemoryStreamIsAtEnd,
+    .MemoryMap = ioMemoryStreamMemoryMap,
+    .ReadAt = ioMemoryStreamReadAt,
 };
 
 /************************************************************************/
@@ -658,6 +679,333 @@ FORGE_API void* fsGetSystemHandle(FileStream* fs)
     return fs->pIO->GetSystemHandle(fs);
 }
 
+/************************************************************************/
+// MARK: - Asynchronous file IO
+/************************************************************************/
+
+#if defined(__linux__) && !defined(ANDROID)
+#define FS_ASYNC_READ_NATIVE_BACKEND
+// io_uring backend in UnixFileSystem.c, all functions except Wait are called with gAsyncReads.mMutex held
+bool        unixAsyncReadInit(uint32_t queueDepth);
+void        unixAsyncReadExit(void);
+const char* unixAsyncReadBackendName(void);
+// returns false if the read has to go through the thread pool
+bool        unixAsyncReadSubmit(FsAsyncRead* pRead);
+void        unixAsyncReadFlush(void);
+// prepends completed reads to 'ppCompleted', returns their count
+uint32_t    unixAsyncReadReap(FsAsyncRead** ppCompleted);
+// blocks until at least one completion is available
+void        unixAsyncReadWait(void);
+#endif
+
+static struct
+{
+    // guards the lists and counters below
+    Mutex             mMutex;
+    // held by the thread which collects completions
+    Mutex             mPollMutex;
+    // serializes reads of streams without positional reads
+    Mutex             mStreamMutex;
+    ConditionVariable mPoolCompleted;
+    ThreadSystem      mThreadSystem;
+
+    FsAsyncRead* pQueuedHead;
+    FsAsyncRead* pQueuedTail;
+    FsAsyncRead* pCompleted;
+
+    uint32_t mQueueDepth;
+    uint32_t mInFlight;
+    uint32_t mPoolInFlight;
+    uint32_t mNativeInFlight;
+    bool     mNativeBackend;
+    bool     mInitialized;
+} gAsyncReads;
+
+static uint64_t asyncReadAt(FsAsyncRead* pRead)
+{
+    __FS_NO_ERR;
+    size_t bytesRead = 0;
+    if (fsStreamSupportsReadAt(pRead->pStream))
+    {
+        bytesRead = fsReadFromStreamAt(pRead->pStream, pRead->pDst, (size_t)pRead->mSize, pRead->mOffset);
+        pRead->mError = FS_ERR_CTX.code;
+        return bytesRead;
+    }
+
+    // Other streams share the seek position between reads, so they go one at a time
+    // and the position is restored afterwards.
+    acquireMutex(&gAsyncReads.mStreamMutex);
+    FileStream* pStream = pRead->pStream;
+    ssize_t     position = fsGetStreamSeekPosition(pStream);
+    if (position >= 0 && fsSeekStream(pStream, SBO_START_OF_FILE, (ssize_t)pRead->mOffset))
+    {
+        bytesRead = fsReadFromStream(pStream, pRead->pDst, (size_t)pRead->mSize);
+    }
+    pRead->mError = FS_ERR_CTX.code;
+    if (position >= 0)
+    {
+        fsSeekStream(pStream, SBO_START_OF_FILE, position);
+    }
+    releaseMutex(&gAsyncReads.mStreamMutex);
+    return bytesRead;
+}
+
+static void asyncReadTask(void* user, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    FsAsyncRead* pRead = (FsAsyncRead*)user;
+    pRead->mBytesRead = asyncReadAt(pRead);
+
+    acquireMutex(&gAsyncReads.mMutex);
+    pRead->pNext = gAsyncReads.pCompleted;
+    gAsyncReads.pCompleted = pRead;
+    --gAsyncReads.mPoolInFlight;
+    --gAsyncReads.mInFlight;
+    wakeAllConditionVariable(&gAsyncReads.mPoolCompleted);
+    releaseMutex(&gAsyncReads.mMutex);
+}
+
+// gAsyncReads.mMutex has to be held
+static uint32_t asyncReadSubmitQueued(void)
+{
+    uint32_t submitted = 0;
+    while (gAsyncReads.pQueuedHead && gAsyncReads.mInFlight < gAsyncReads.mQueueDepth)
+    {
+        FsAsyncRead* pRead = gAsyncReads.pQueuedHead;
+        gAsyncReads.pQueuedHead = pRead->pNext;
+        if (!gAsyncReads.pQueuedHead)
+        {
+            gAsyncReads.pQueuedTail = NULL;
+        }
+        pRead->pNext = NULL;
+        ++gAsyncReads.mInFlight;
+        ++submitted;
+
+#if defined(FS_ASYNC_READ_NATIVE_BACKEND)
+        if (gAsyncReads.mNativeBackend && unixAsyncReadSubmit(pRead))
+        {
+            ++gAsyncReads.mNativeInFlight;
+            continue;
+        }
+#endif
+        ++gAsyncReads.mPoolInFlight;
+        threadSystemAddTask(gAsyncReads.mThreadSystem, asyncReadTask, pRead);
+    }
+
+#if defined(FS_ASYNC_READ_NATIVE_BACKEND)
+    if (gAsyncReads.mNativeBackend)
+    {
+        unixAsyncReadFlush();
+    }
+#endif
+    return submitted;
+}
+
+// gAsyncReads.mPollMutex has to be held
+static uint32_t asyncReadCollect(void)
+{
+    acquireMutex(&gAsyncReads.mMutex);
+    FsAsyncRead* pCompleted = gAsyncReads.pCompleted;
+    gAsyncReads.pCompleted = NULL;
+#if defined(FS_ASYNC_READ_NATIVE_BACKEND)
+    if (gAsyncReads.mNativeInFlight)
+    {
+        uint32_t count = unixAsyncReadReap(&pCompleted);
+        gAsyncReads.mNativeInFlight -= count;
+        gAsyncReads.mInFlight -= count;
+    }
+#endif
+    asyncReadSubmitQueued();
+    releaseMutex(&gAsyncReads.mMutex);
+
+    uint32_t completed = 0;
+    while (pCompleted)
+    {
+        // The callback is allowed to free or reuse the read
+        FsAsyncRead*        pRead = pCompleted;
+        FsAsyncReadCallback pCompletion = pRead->pCompletion;
+        pCompleted = pRead->pNext;
+        pRead->pNext = NULL;
+        tfrg_atomic32_store_release(&pRead->mDone, 1);
+        if (pCompletion)
+        {
+            pCompletion(pRead);
+        }
+        ++completed;
+    }
+    return completed;
+}
+
+bool fsInitAsyncReads(const FsAsyncReadDesc* pDesc)
+{
+    if (gAsyncReads.mInitialized)
+    {
+        LOGF(eWARNING, "Asynchronous reads are already initialized.");
+        return true;
+    }
+
+    FsAsyncReadDesc desc = { 0 };
+    if (pDesc)
+    {
+        desc = *pDesc;
+    }
+
+    memset(&gAsyncReads, 0, sizeof gAsyncReads);
+    gAsyncReads.mQueueDepth = desc.mQueueDepth ? desc.mQueueDepth : FS_ASYNC_READ_DEFAULT_QUEUE_DEPTH;
+    if (gAsyncReads.mQueueDepth > FS_ASYNC_READ_MAX_QUEUE_DEPTH)
+    {
+        gAsyncReads.mQueueDepth = FS_ASYNC_READ_MAX_QUEUE_DEPTH;
+    }
+
+    struct ThreadSystemInitDesc threadDesc = gThreadSystemInitDescDefault;
+    threadDesc.threadCount = desc.mThreadCount ? desc.mThreadCount : UINT64_MAX;
+    threadDesc.threadName = "AsyncRead";
+    if (!threadSystemInit(&gAsyncReads.mThreadSystem, &threadDesc))
+    {
+        LOGF(eERROR, "Failed to start asynchronous read threads.");
+        return false;
+    }
+
+    initMutex(&gAsyncReads.mMutex);
+    initMutex(&gAsyncReads.mPollMutex);
+    initMutex(&gAsyncReads.mStreamMutex);
+    initConditionVariable(&gAsyncReads.mPoolCompleted);
+
+#if defined(FS_ASYNC_READ_NATIVE_BACKEND)
+    gAsyncReads.mNativeBackend = !desc.mDisableNativeBackend && unixAsyncReadInit(gAsyncReads.mQueueDepth);
+#endif
+
+    gAsyncReads.mInitialized = true;
+    LOGF(eINFO, "Asynchronous reads: backend %s, queue depth %u", fsGetAsyncReadBackendName(), gAsyncReads.mQueueDepth);
+    return true;
+}
+
+void fsExitAsyncReads(void)
+{
+    if (!gAsyncReads.mInitialized)
+        return;
+
+    fsWaitAsyncReads(UINT32_MAX);
+
+    threadSystemExit(&gAsyncReads.mThreadSystem, &gThreadSystemExitDescDefault);
+#if defined(FS_ASYNC_READ_NATIVE_BACKEND)
+    if (gAsyncReads.mNativeBackend)
+    {
+        unixAsyncReadExit();
+    }
+#endif
+
+    exitConditionVariable(&gAsyncReads.mPoolCompleted);
+    exitMutex(&gAsyncReads.mStreamMutex);
+    exitMutex(&gAsyncReads.mPollMutex);
+    exitMutex(&gAsyncReads.mMutex);
+    gAsyncReads.mInitialized = false;
+}
+
+const char* fsGetAsyncReadBackendName(void)
+{
+#if defined(FS_ASYNC_READ_NATIVE_BACKEND)
+    if (gAsyncReads.mNativeBackend)
+        return unixAsyncReadBackendName();
+#endif
+    return "thread pool";
+}
+
+bool fsReadAsync(FileStream* pStream, uint64_t offset, uint64_t size, void* pDst, FsAsyncRead* pRead)
+{
+    ASSERT(gAsyncReads.mInitialized);
+    ASSERT(pStream && pStream->pIO && pRead);
+    ASSERT(pDst || !size);
+    if (!(pStream->mMode & FM_READ))
+    {
+        LOGF(eERROR, "Asynchronous read of a stream which is not opened for reading.");
+        return false;
+    }
+
+    pRead->pStream = pStream;
+    pRead->mOffset = offset;
+    pRead->mSize = size;
+    pRead->pDst = pDst;
+    pRead->mBytesRead = 0;
+    pRead->mError = FS_SUCCESS;
+    pRead->pNext = NULL;
+    pRead->mDone = 0;
+
+    acquireMutex(&gAsyncReads.mMutex);
+    if (gAsyncReads.pQueuedTail)
+    {
+        gAsyncReads.pQueuedTail->pNext = pRead;
+    }
+    else
+    {
+        gAsyncReads.pQueuedHead = pRead;
+    }
+    gAsyncReads.pQueuedTail = pRead;
+    releaseMutex(&gAsyncReads.mMutex);
+    return true;
+}
+
+uint32_t fsSubmitAsyncReads(void)
+{
+    ASSERT(gAsyncReads.mInitialized);
+    acquireMutex(&gAsyncReads.mMutex);
+    uint32_t submitted = asyncReadSubmitQueued();
+    releaseMutex(&gAsyncReads.mMutex);
+    return submitted;
+}
+
+uint32_t fsPollAsyncReads(void)
+{
+    ASSERT(gAsyncReads.mInitialized);
+    acquireMutex(&gAsyncReads.mPollMutex);
+    uint32_t completed = asyncReadCollect();
+    releaseMutex(&gAsyncReads.mPollMutex);
+    return completed;
+}
+
+uint32_t fsWaitAsyncReads(uint32_t minCompletions)
+{
+    ASSERT(gAsyncReads.mInitialized);
+    acquireMutex(&gAsyncReads.mPollMutex);
+    uint32_t completed = asyncReadCollect();
+    while (completed < minCompletions)
+    {
+        acquireMutex(&gAsyncReads.mMutex);
+        // completion callbacks could have queued more reads
+        asyncReadSubmitQueued();
+        if (!gAsyncReads.pCompleted && !gAsyncReads.mInFlight)
+        {
+            releaseMutex(&gAsyncReads.mMutex);
+            break;
+        }
+        if (!gAsyncReads.pCompleted && gAsyncReads.mPoolInFlight)
+        {
+            // poll the native backend every millisecond while waiting for the pool
+            waitConditionVariable(&gAsyncReads.mPoolCompleted, &gAsyncReads.mMutex, gAsyncReads.mNativeInFlight ? 1 : TIMEOUT_INFINITE);
+            releaseMutex(&gAsyncReads.mMutex);
+        }
+        else
+        {
+            bool waitNative = !gAsyncReads.pCompleted && gAsyncReads.mNativeInFlight;
+            releaseMutex(&gAsyncReads.mMutex);
+#if defined(FS_ASYNC_READ_NATIVE_BACKEND)
+            // Only the holder of mPollMutex reaps completions, so the wait can't miss the last one
+            if (waitNative)
+            {
+                unixAsyncReadWait();
+            }
+#else
+            UNREF_PARAM(waitNative);
+#endif
+        }
+        completed += asyncReadCollect();
+    }
+    releaseMutex(&gAsyncReads.mPollMutex);
+    return completed;
+}
+
+bool fsIsAsyncReadDone(FsAsyncRead* pRead) { return tfrg_atomic32_load_acquire(&pRead->mDone) != 0; }
+
 /************************************************************************/
 // Platform independent directory queries
 /************************************************************************/
@@ -927,6 +1275,179 @@ uint64_t bunyArHashTableLookup(const struct BunyArHashTable* ht, const char* nam
     return index;
 }
 
+// Average number of keys per bucket, every bucket costs 2 bytes
+#define BUNYAR_PERFECT_HASH_BUCKET_SIZE 4
+// Seeds to try before giving up, construction rarely needs a second one
+#define BUNYAR_PERFECT_HASH_SEED_LIMIT  64
+
+// Skewed distribution, 60% of keys go to the first 30% of buckets.
+// Dense buckets are placed first while most slots are free, the rest are mostly single keys.
+static inline uint64_t archivePerfectHashBucket(uint64_t hash, uint64_t bucketCount)
+{
+    uint64_t const denseCount = bucketCount * 3 / 10 + 1;
+    if ((hash & 0xffffffff) < (uint64_t)0x99999999)
+        return (hash >> 32) % denseCount;
+    return denseCount + (hash >> 32) % (bucketCount - denseCount);
+}
+
+static inline uint64_t archivePilotHash(uint64_t pilot)
+{
+    // splitmix64 finalizer
+    uint64_t h = (pilot + 1) * 0x9E3779B97F4A7C15ull;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+    return h ^ (h >> 31);
+}
+
+struct BunyArPerfectHashTable* bunyArPerfectHashTableConstruct(uint64_t nodeCount, const struct BunyArNode* nodes, const char* nodeNames)
+{
+    // node indices are stored as uint32_t, UINT32_MAX marks empty slot
+    if (nodeCount >= UINT32_MAX)
+        return NULL;
+
+    uint64_t const bucketCount = nodeCount / BUNYAR_PERFECT_HASH_BUCKET_SIZE + 2;
+    uint64_t const slotCount = nodeCount + nodeCount / 100 + 1;
+
+    struct BunyArPerfectHashTable* ht = tf_calloc(1, sizeof(*ht) + slotCount * sizeof(uint32_t) + bucketCount * sizeof(uint16_t));
+    ht->bucketCount = bucketCount;
+    ht->slotCount = slotCount;
+
+    uint32_t* const slots = (uint32_t*)(ht + 1);
+    uint16_t* const pilots = (uint16_t*)(slots + slotCount);
+
+    uint64_t* const hashes = tf_malloc(sizeof(uint64_t) * (nodeCount + 1));
+    // node indices grouped by bucket, bucket b owns keys[bucketOffsets[b]..bucketOffsets[b + 1]]
+    uint32_t* const keys = tf_malloc(sizeof(uint32_t) * (nodeCount + 1));
+    uint32_t* const bucketOffsets = tf_calloc(bucketCount + 1, sizeof(uint32_t));
+    // buckets sorted from largest to smallest
+    uint32_t* const bucketOrder = tf_malloc(sizeof(uint32_t) * bucketCount);
+    // claimed slots, small enough to stay in cache unlike slots table
+    uint64_t* const slotBits = tf_malloc(sizeof(uint64_t) * (slotCount / 64 + 1));
+    uint64_t        keySlots[256];
+
+    bool success = false;
+    for (uint64_t seed = 0; seed < BUNYAR_PERFECT_HASH_SEED_LIMIT && !success; ++seed)
+    {
+        ht->seed = seed;
+        memset(bucketOffsets, 0, sizeof(uint32_t) * (bucketCount + 1));
+        memset(slots, 0xff, sizeof(uint32_t) * slotCount);
+        memset(slotBits, 0, sizeof(uint64_t) * (slotCount / 64 + 1));
+        memset(pilots, 0, sizeof(uint16_t) * bucketCount);
+
+        uint32_t maxBucketSize = 0;
+        for (uint64_t ni = 0; ni < nodeCount; ++ni)
+        {
+            const struct BunyArNode* node = nodes + ni;
+
+            hashes[ni] = archiveHashMurmur2_64(nodeNames + node->namePointer.offset, node->namePointer.size, ht->seed);
+
+            uint32_t size = ++bucketOffsets[archivePerfectHashBucket(hashes[ni], bucketCount) + 1];
+            if (maxBucketSize < size)
+                maxBucketSize = size;
+        }
+
+        // bad seed
+        if (maxBucketSize > TF_ARRAY_COUNT(keySlots))
+            continue;
+
+        // counting sort of keys by bucket, then buckets by size
+        {
+            uint32_t* sizeOffsets = tf_calloc(maxBucketSize + 2, sizeof(uint32_t));
+
+            for (uint64_t bi = 0; bi < bucketCount; ++bi)
+                ++sizeOffsets[maxBucketSize - bucketOffsets[bi + 1] + 1];
+            for (uint32_t si = 0; si <= maxBucketSize; ++si)
+                sizeOffsets[si + 1] += sizeOffsets[si];
+            for (uint64_t bi = 0; bi < bucketCount; ++bi)
+                bucketOrder[sizeOffsets[maxBucketSize - bucketOffsets[bi + 1]]++] = (uint32_t)bi;
+
+            tf_free(sizeOffsets);
+
+            for (uint64_t bi = 0; bi < bucketCount; ++bi)
+                bucketOffsets[bi + 1] += bucketOffsets[bi];
+            for (uint64_t ni = 0; ni < nodeCount; ++ni)
+                keys[bucketOffsets[archivePerfectHashBucket(hashes[ni], bucketCount)]++] = (uint32_t)ni;
+            // offsets were moved to the bucket ends while placing keys
+            memmove(bucketOffsets + 1, bucketOffsets, sizeof(uint32_t) * bucketCount);
+            bucketOffsets[0] = 0;
+        }
+
+        success = true;
+        for (uint64_t oi = 0; oi < bucketCount && success; ++oi)
+        {
+            uint32_t const  bucket = bucketOrder[oi];
+            const uint32_t* bucketKeys = keys + bucketOffsets[bucket];
+            uint32_t const  bucketSize = bucketOffsets[bucket + 1] - bucketOffsets[bucket];
+
+            // the rest of buckets are empty
+            if (bucketSize == 0)
+                break;
+
+            success = false;
+            for (uint32_t pilot = 0; pilot <= UINT16_MAX && !success; ++pilot)
+            {
+                uint64_t const pilotHash = archivePilotHash(pilot);
+
+                uint32_t ki = 0;
+                for (; ki < bucketSize; ++ki)
+                {
+                    uint64_t slot = (hashes[bucketKeys[ki]] ^ pilotHash) % slotCount;
+                    if (slotBits[slot / 64] & ((uint64_t)1 << (slot % 64)))
+                        break;
+
+                    uint32_t kj = 0;
+                    while (kj < ki && keySlots[kj] != slot)
+                        ++kj;
+                    if (kj < ki)
+                        break;
+
+                    keySlots[ki] = slot;
+                }
+
+                if (ki < bucketSize)
+                    continue;
+
+                for (ki = 0; ki < bucketSize; ++ki)
+                {
+                    slots[keySlots[ki]] = bucketKeys[ki];
+                    slotBits[keySlots[ki] / 64] |= (uint64_t)1 << (keySlots[ki] % 64);
+                }
+                pilots[bucket] = (uint16_t)pilot;
+                success = true;
+            }
+        }
+    }
+
+    tf_free(slotBits);
+    tf_free(bucketOrder);
+    tf_free(bucketOffsets);
+    tf_free(keys);
+    tf_free(hashes);
+
+    if (!success)
+    {
+        tf_free(ht);
+        return NULL;
+    }
+
+    return ht;
+}
+
+uint64_t bunyArPerfectHashTableLookup(const struct BunyArPerfectHashTable* ht, const char* name, uint64_t nodeCount,
+                                      const struct BunyArNode* nodes, const char* nodeNames)
+{
+    const uint32_t* slots = (const uint32_t*)(ht + 1);
+    const uint16_t* pilots = (const uint16_t*)(slots + ht->slotCount);
+
+    uint64_t hash = archiveHashMurmur2_64(name, strlen(name), ht->seed);
+    uint64_t slot = (hash ^ archivePilotHash(pilots[archivePerfectHashBucket(hash, ht->bucketCount)])) % ht->slotCount;
+    uint64_t index = slots[slot];
+
+    if (index >= nodeCount || strcmp(nodeNames + nodes[index].namePointer.offset, name) != 0)
+        return UINT64_MAX;
+    return index;
+}
+
 const char* bunyArFormatName(enum BunyArFileFormat format)
 {
     switch (format)
@@ -958,19 +1479,102 @@ struct BunyArFileStream
     struct BunyArNode*             node;
     size_t                         position;
     ZSTD_DCtx*                     zstd_ctx;
+    // NULL if the node doesn't use a dictionary
+    const ZSTD_DDict*              zstd_ddict;
     struct BunyArBlockBuffer       compressed;
     struct BunyArBlockBuffer       decompressed;
     BunyArBlockPointer*            currentBlock;
     struct BunyArBlockFormatHeader blocksHeader;
     BunyArBlockPointer*            blocks;
+
+    // Block cache only. 'decompressed' points to the memory of 'cachedBlock' which is referenced by the stream.
+    struct BunyArCachedBlock* cachedBlock;
+    // block expected by a sequential read and the end of blocks already sent to read-ahead
+    uint64_t                  nextSequentialBlock;
+    uint64_t                  readAheadEnd;
+};
+
+enum BunyArCachedBlockState
+{
+    BUNYAR_CACHED_BLOCK_LOADING = 0,
+    BUNYAR_CACHED_BLOCK_READY,
+    BUNYAR_CACHED_BLOCK_FAILED,
+};
+
+// Decompressed block shared by all streams of an archive, memory of the block follows the struct
+struct BunyArCachedBlock
+{
+    uint64_t                  key;
+    struct BunyArCachedBlock* lruPrev;
+    struct BunyArCachedBlock* lruNext;
+    struct BunyArMetadata*    archive;
+    // streams reading the block and pending read-ahead task, referenced blocks are not evicted
+    uint32_t                  refCount;
+    uint32_t                  state;
+    // decompressed by read-ahead and not read yet
+    bool                      readAhead;
+    // source of the block for read-ahead
+    enum BunyArFileFormat     format;
+    const ZSTD_DDict*         ddict;
+    struct BunyArPointer64    location;
+    struct BunyArBlockBuffer  buffer;
+};
+
+typedef struct BunyArCachedBlockNode
+{
+    uint64_t                  key;
+    struct BunyArCachedBlock* value;
+} BunyArCachedBlockNode;
+
+struct BunyArBlockCache
+{
+    Mutex             mutex;
+    // signaled when a block leaves the loading state
+    ConditionVariable blockLoaded;
+
+    // stb_ds hash map, key is (node index << 32) | block index
+    BunyArCachedBlockNode*    blocks;
+    // most recently used first
+    struct BunyArCachedBlock* lruHead;
+    struct BunyArCachedBlock* lruTail;
+
+    uint32_t     readAheadBlockCount;
+    ThreadSystem readAheadThreads;
+    uint32_t     readAheadThreadCount;
+    // per read-ahead thread
+    ZSTD_DCtx**               zstdCtxs;
+    struct BunyArBlockBuffer* compressed;
+
+    struct BunyArBlockCacheStats stats;
+};
+
+// Reads covering fewer blocks are decompressed on the reading thread
+#define BUNYAR_PARALLEL_READ_MIN_BLOCKS 4
+
+struct BunyArDecompressionContext
+{
+    ZSTD_DCtx*                         zstdCtx;
+    struct BunyArBlockBuffer           compressed;
+    struct BunyArDecompressionContext* next;
+};
+
+struct BunyArParallelDecompression
+{
+    ThreadSystem threads;
+    Mutex        mutex;
+    // Contexts are taken by every processed chunk instead of using thread indices,
+    // because the reading thread and threadSystemJoin run chunks outside of the thread system.
+    struct BunyArDecompressionContext* freeContexts;
 };
 
 struct BunyArMetadata
 {
-    uint64_t                nodeCount;
-    struct BunyArNode*      nodes;
-    char*                   nodeNames;
-    struct BunyArHashTable* hashTable;
+    uint64_t                       nodeCount;
+    struct BunyArNode*             nodes;
+    char*                          nodeNames;
+    struct BunyArHashTable*        hashTable;
+    // BUNYAR_FLAG_PERFECT_HASH_TABLE archives, hashTable is NULL then
+    struct BunyArPerfectHashTable* perfectHashTable;
 
     const uint8_t* memoryBeg;
     const uint8_t* memoryEnd;
@@ -981,6 +1585,18 @@ struct BunyArMetadata
 
     bool  archiveStreamLocking;
     Mutex mutex;
+
+    // NULL if ArchiveOpenDesc::blockCacheSize is 0
+    struct BunyArBlockCache* blockCache;
+    // NULL if ArchiveOpenDesc::decompressionThreadCount is 0
+    struct BunyArParallelDecompression* parallelDecompression;
+
+    // ZSTD dictionaries, NULL if the archive has no BunyArDictionaryTable
+    uint64_t        dictionaryCount;
+    ZSTD_DDict**    dictionaries;
+    // dictionary index + 1 for every node, points into dictionaryTable
+    const uint32_t* nodeDictionaries;
+    void*           dictionaryTable;
 };
 
 struct BunyArNodeSearchCtx
@@ -1013,6 +1629,11 @@ static int bunyArNameNodeCmp(const void* v1, const void* v2)
 }
 
 static void initBunyArFsInterface(IFileSystem*, struct BunyArMetadata*);
+static bool bunyArCacheInit(struct BunyArMetadata*, const struct ArchiveOpenDesc*);
+static void bunyArCacheExit(struct BunyArMetadata*);
+static void bunyArCacheReleaseStreamBlock(struct BunyArBlockCache*, struct BunyArFileStream*);
+static bool bunyArParallelDecompressionInit(struct BunyArMetadata*, const struct ArchiveOpenDesc*);
+static void bunyArParallelDecompressionExit(struct BunyArMetadata*);
 
 static inline struct BunyArMetadata* getFsArchive(IFileSystem* fs) { return (struct BunyArMetadata*)fs->pUser; }
 
@@ -1039,6 +1660,10 @@ static inline size_t bunyArStreamRead(struct BunyArMetadata* a, uint64_t positio
         return read;
     }
 
+    // Positional reads don't touch the seek position, so concurrent reads need no lock
+    if (fsStreamSupportsReadAt(a->archiveStream))
+        return fsReadFromStreamAt(a->archiveStream, dst, size, position);
+
     if (a->archiveStreamLocking)
         acquireMutex(&a->mutex);
 
@@ -1066,6 +1691,86 @@ static inline bool bunyArReadLocation(struct BunyArMetadata* a,
     return bunyArStreamRead(a, ptr.offset, ptr.size, dst) == ptr.size;
 }
 
+// archive must have one of hash tables
+static inline uint64_t bunyArLookupNode(const struct BunyArMetadata* archive, const char* name)
+{
+    if (archive->perfectHashTable)
+        return bunyArPerfectHashTableLookup(archive->perfectHashTable, name, archive->nodeCount, archive->nodes, archive->nodeNames);
+    return bunyArHashTableLookup(archive->hashTable, name, archive->nodeCount, archive->nodes, archive->nodeNames);
+}
+
+static void bunyArFreeDictionaries(struct BunyArMetadata* archive)
+{
+    for (uint64_t i = 0; archive->dictionaries && i < archive->dictionaryCount; ++i)
+        ZSTD_freeDDict(archive->dictionaries[i]);
+    tf_free(archive->dictionaries);
+    tf_free(archive->dictionaryTable);
+    archive->dictionaryCount = 0;
+    archive->dictionaries = NULL;
+    archive->nodeDictionaries = NULL;
+    archive->dictionaryTable = NULL;
+}
+
+static bool bunyArLoadDictionaries(struct BunyArMetadata* archive, struct BunyArPointer64 tablePointer)
+{
+    struct BunyArDictionaryTable table;
+    if (tablePointer.size < sizeof table)
+        return false;
+
+    archive->dictionaryTable = tf_malloc(tablePointer.size);
+    if (!bunyArReadLocation(archive, tablePointer, archive->dictionaryTable))
+    {
+        bunyArFreeDictionaries(archive);
+        return false;
+    }
+    memcpy(&table, archive->dictionaryTable, sizeof table);
+
+    const uint64_t pointersSize = tablePointer.size - sizeof table - archive->nodeCount * sizeof(uint32_t);
+    if (tablePointer.size < sizeof table + archive->nodeCount * sizeof(uint32_t) ||
+        pointersSize != table.dictionaryCount * sizeof(struct BunyArPointer64))
+    {
+        bunyArFreeDictionaries(archive);
+        return false;
+    }
+
+    const struct BunyArPointer64* pointers = (const struct BunyArPointer64*)((uint8_t*)archive->dictionaryTable + sizeof table);
+    archive->nodeDictionaries = (const uint32_t*)(pointers + table.dictionaryCount);
+    archive->dictionaryCount = table.dictionaryCount;
+    archive->dictionaries = (ZSTD_DDict**)tf_calloc(table.dictionaryCount ? table.dictionaryCount : 1, sizeof(ZSTD_DDict*));
+
+    bool success = true;
+    for (uint64_t i = 0; i < table.dictionaryCount && success; ++i)
+    {
+        if (archive->memoryBeg)
+        {
+            // dictionary is referenced, archive memory outlives it
+            const uint8_t* src;
+            uint64_t       size;
+            bunyArMemoryReadPrepare(archive, pointers[i], &src, &size);
+            success = size == pointers[i].size;
+            archive->dictionaries[i] =
+                success ? ZSTD_createDDict_advanced(src, size, ZSTD_dlm_byRef, ZSTD_dct_rawContent, ZSTD_MEMORY_ALLOCATOR) : NULL;
+        }
+        else
+        {
+            void* content = tf_malloc(pointers[i].size);
+            success = bunyArReadLocation(archive, pointers[i], content);
+            archive->dictionaries[i] =
+                success ? ZSTD_createDDict_advanced(content, pointers[i].size, ZSTD_dlm_byCopy, ZSTD_dct_rawContent, ZSTD_MEMORY_ALLOCATOR)
+                        : NULL;
+            tf_free(content);
+        }
+        success = success && archive->dictionaries[i];
+    }
+
+    for (uint64_t i = 0; i < archive->nodeCount && success; ++i)
+        success = archive->nodeDictionaries[i] <= table.dictionaryCount;
+
+    if (!success)
+        bunyArFreeDictionaries(archive);
+    return success;
+}
+
 static const struct ArchiveOpenDesc BUNYAR_OPEN_DESC_DEFAULT = { 0 };
 
 static bool bunyArchiveOpen(FileStream* stream, uint64_t memorySize, const void* memory, const struct ArchiveOpenDesc* desc,
@@ -1084,16 +1789,20 @@ static bool bunyArchiveOpen(FileStream* stream, uint64_t memorySize, const void*
     // Read and check header
 
     struct BunyArHeader header;
+    memset(&header, 0, sizeof header);
+
+    // header of version 0 is shorter
+    const size_t headerSizeV0 = offsetof(struct BunyArHeader, dictionaryTablePointer);
 
     bool headerReaded = false;
 
     if (streamMode)
     {
-        headerReaded = fsSeekStream(stream, SBO_START_OF_FILE, 0) && fsReadFromStream(stream, &header, sizeof header) == sizeof header;
+        headerReaded = fsSeekStream(stream, SBO_START_OF_FILE, 0) && fsReadFromStream(stream, &header, sizeof header) >= headerSizeV0;
     }
-    else if (memorySize >= sizeof header)
+    else if (memorySize >= headerSizeV0)
     {
-        memcpy(&header, memory, sizeof header);
+        memcpy(&header, memory, memorySize < sizeof header ? memorySize : sizeof header);
         headerReaded = true;
     }
 
@@ -1114,12 +1823,18 @@ static bool bunyArchiveOpen(FileStream* stream, uint64_t memorySize, const void*
         return false;
     }
 
-    if (header.version.compatible != 0)
+    if (header.version.compatible > BUNYAR_VERSION)
     {
-        LOGF(eERROR, "Failed to open archive: version %llu not supported, expected 0", (unsigned long long)header.version.actual);
+        LOGF(eERROR, "Failed to open archive: version %u not supported, expected %u or older", header.version.compatible, BUNYAR_VERSION);
         return false;
     }
 
+    // bytes after the version 0 header belong to the nodes
+    if (header.version.actual < 1)
+    {
+        memset((uint8_t*)&header + headerSizeV0, 0, sizeof header - headerSizeV0);
+    }
+
     ///////////////////////////////////////
     // Allocate memory for archive metadata
     // includes Archive struct, file nodes, file names
@@ -1195,14 +1910,29 @@ static bool bunyArchiveOpen(FileStream* stream, uint64_t memorySize, const void*
 
     if (!desc->disableHashTable && header.hashTablePointer.size)
     {
-        archive->hashTable = tf_malloc(header.hashTablePointer.size);
+        void*                                hashTable = tf_malloc(header.hashTablePointer.size);
+        const struct BunyArPerfectHashTable* perfectHashTable = (const struct BunyArPerfectHashTable*)hashTable;
 
-        if (!bunyArReadLocation(archive, header.hashTablePointer, archive->hashTable))
+        if (!bunyArReadLocation(archive, header.hashTablePointer, hashTable))
         {
             // not fatal, we can recreate it
             LOGF(eWARNING, "Failed to read archive hash table");
-            tf_free(archive->hashTable);
-            archive->hashTable = NULL;
+            tf_free(hashTable);
+        }
+        else if (!(header.flags & BUNYAR_FLAG_PERFECT_HASH_TABLE))
+        {
+            archive->hashTable = (struct BunyArHashTable*)hashTable;
+        }
+        else if (header.hashTablePointer.size < sizeof(*perfectHashTable) ||
+                 bunyArPerfectHashTableSize(perfectHashTable) != header.hashTablePointer.size || perfectHashTable->bucketCount < 2 ||
+                 perfectHashTable->slotCount == 0)
+        {
+            LOGF(eWARNING, "Archive perfect hash table is corrupted");
+            tf_free(hashTable);
+        }
+        else
+        {
+            archive->perfectHashTable = (struct BunyArPerfectHashTable*)hashTable;
         }
     }
 
@@ -1257,17 +1987,18 @@ static bool bunyArchiveOpen(FileStream* stream, uint64_t memorySize, const void*
             LOGF(eWARNING, "Baked archive hash table is abandoned because node names was "
                            "modified");
             tf_free(archive->hashTable);
+            tf_free(archive->perfectHashTable);
             archive->hashTable = NULL;
+            archive->perfectHashTable = NULL;
         }
     }
 
-    if (validation && archive->hashTable)
+    if (validation && (archive->hashTable || archive->perfectHashTable))
     {
         bool success = true;
         for (size_t i = 0; i < archive->nodeCount; ++i)
         {
-            uint64_t value = bunyArHashTableLookup(archive->hashTable, archive->nodeNames + archive->nodes[i].namePointer.offset,
-                                                   archive->nodeCount, archive->nodes, archive->nodeNames);
+            uint64_t value = bunyArLookupNode(archive, archive->nodeNames + archive->nodes[i].namePointer.offset);
 
             if (value >= archive->nodeCount)
             {
@@ -1288,7 +2019,9 @@ static bool bunyArchiveOpen(FileStream* stream, uint64_t memorySize, const void*
         {
             LOGF(eWARNING, "Baked archive hash table is abandoned because it was faulty");
             tf_free(archive->hashTable);
+            tf_free(archive->perfectHashTable);
             archive->hashTable = NULL;
+            archive->perfectHashTable = NULL;
         }
     }
 
@@ -1296,7 +2029,7 @@ static bool bunyArchiveOpen(FileStream* stream, uint64_t memorySize, const void*
     // Initialize hash table if required
     // binary search is used in case hash table is not initialized
 
-    if (!desc->disableHashTable && !archive->hashTable)
+    if (!desc->disableHashTable && !archive->hashTable && !archive->perfectHashTable)
     {
         Timer timer;
         initTimer(&timer);
@@ -1312,12 +2045,37 @@ static bool bunyArchiveOpen(FileStream* stream, uint64_t memorySize, const void*
         }
     }
 
+    //////////////////////////
+    // Load ZSTD dictionaries
+
+    if (header.dictionaryTablePointer.size && !bunyArLoadDictionaries(archive, header.dictionaryTablePointer))
+    {
+        LOGF(eERROR, "Failed to open archive: ZSTD dictionaries are corrupted");
+        tf_free(archive->hashTable);
+        tf_free(archive->perfectHashTable);
+        goto CANCEL;
+    }
+
     /////////////////////////////////////////////
     // Archive preparations are done, fill output
 
     initBunyArFsInterface(out, archive);
 
-    if (streamMode && desc->protectStreamCriticalSection)
+    if (desc->blockCacheSize && !bunyArCacheInit(archive, desc))
+    {
+        fsArchiveClose(out);
+        return false;
+    }
+
+    if (desc->decompressionThreadCount && !bunyArParallelDecompressionInit(archive, desc))
+    {
+        fsArchiveClose(out);
+        return false;
+    }
+
+    // read-ahead and decompression threads read the archive stream as well
+    const bool readAhead = archive->blockCache && archive->blockCache->readAheadBlockCount;
+    if (streamMode && (desc->protectStreamCriticalSection || readAhead || archive->parallelDecompression))
     {
         if (!initMutex(&archive->mutex))
         {
@@ -1380,6 +2138,10 @@ FORGE_API bool fsArchiveClose(IFileSystem* fs)
         LOGF(eWARNING, "Archive closed while some files are still opened");
     }
 
+    // read-ahead has to be finished before the stream is closed
+    bunyArCacheExit(archive);
+    bunyArParallelDecompressionExit(archive);
+
     if (archive->ownedStream.pIO)
     {
         fsCloseStream(&archive->ownedStream);
@@ -1390,7 +2152,9 @@ FORGE_API bool fsArchiveClose(IFileSystem* fs)
         exitMutex(&archive->mutex);
     }
 
+    bunyArFreeDictionaries(archive);
     tf_free(archive->hashTable);
+    tf_free(archive->perfectHashTable);
     tf_free(archive);
     return true;
 }
@@ -1399,9 +2163,9 @@ bool fsArchiveGetNodeId(IFileSystem* fs, const char* fileName, uint64_t* outUid)
 {
     struct BunyArMetadata* archive = getFsArchive(fs);
 
-    if (archive->hashTable)
+    if (archive->hashTable || archive->perfectHashTable)
     {
-        *outUid = bunyArHashTableLookup(archive->hashTable, fileName, archive->nodeCount, archive->nodes, archive->nodeNames);
+        *outUid = bunyArLookupNode(archive, fileName);
     }
     else
     {
@@ -1432,7 +2196,7 @@ static bool ioArchiveOpenByUid(IFileSystem* inFs, uint64_t index, FileMode mode,
 
     struct BunyArMetadata* archive = getFsArchive(inFs);
 
-    if (index > archive->nodeCount)
+    if (index >= archive->nodeCount)
     {
         __FS_SET_ERR(FS_NOT_FOUND_ERR);
         return false;
@@ -1482,7 +2246,8 @@ static bool ioArchiveOpenByUid(IFileSystem* inFs, uint64_t index, FileMode mode,
             return false;
         }
 
-        decompressedBufferSize = blocksHeader.blockSize;
+        // block cache owns decompressed blocks
+        decompressedBufferSize = archive->blockCache ? 0 : blocksHeader.blockSize;
         compressedBufferSize = archive->memoryBeg ? 0 : blocksHeader.blockSize;
     }
     break;
@@ -1526,6 +2291,10 @@ static bool ioArchiveOpenByUid(IFileSystem* inFs, uint64_t index, FileMode mode,
         {
             goto CANCEL;
         }
+        if (archive->nodeDictionaries && archive->nodeDictionaries[index])
+        {
+            fs->zstd_ddict = archive->dictionaries[archive->nodeDictionaries[index] - 1];
+        }
     }
     }
 
@@ -1559,6 +2328,10 @@ static bool ioArchiveFsClose(FileStream* fs)
     --archive->virtualStreamCount;
 
     struct BunyArFileStream* stream = getFsBunyArStream(fs);
+    if (archive->blockCache)
+    {
+        bunyArCacheReleaseStreamBlock(archive->blockCache, stream);
+    }
     ZSTD_freeDCtx(stream->zstd_ctx);
     tf_free(stream);
 
@@ -1575,68 +2348,75 @@ static inline struct BunyArPointer64 bunyArDecodeBlockPointerInfo(struct BunyArN
     };
 }
 
-static bool bunyArReadBlockToBuffer(struct BunyArMetadata* archive, struct BunyArFileStream* fs, BunyArBlockPointer* blockToRead,
-                                    struct BunyArBlockBuffer* dst)
+// 'compressed' is a staging buffer for archives which are not in memory, it grows if needed
+static const char* bunyArDecompressBlock(struct BunyArMetadata* archive, enum BunyArFileFormat format, struct BunyArPointer64 loc,
+                                         ZSTD_DCtx* zstdCtx, const ZSTD_DDict* zstdDDict, struct BunyArBlockBuffer* compressed,
+                                         struct BunyArBlockBuffer* dst)
 {
     uint64_t       srcSize;
     const uint8_t* srcMemory;
 
+    if (archive->memoryBeg)
     {
-        struct BunyArBlockInfo blockInfo = bunyArDecodeBlockPointer(*blockToRead);
-
-        ASSERT(blockInfo.isCompressed);
-
-        struct BunyArPointer64 loc = bunyArDecodeBlockPointerInfo(fs->node, &fs->blocksHeader, &blockInfo);
-
-        if (archive->memoryBeg)
-        {
-            bunyArMemoryReadPrepare(archive, loc, &srcMemory, &srcSize);
-            if (srcSize != loc.size)
-                return false;
-        }
-        else
+        bunyArMemoryReadPrepare(archive, loc, &srcMemory, &srcSize);
+        if (srcSize != loc.size)
+            return "block is out of archive bounds";
+    }
+    else
+    {
+        if (compressed->memorySize < loc.size)
         {
-            if (!bunyArReadLocation(archive, loc, fs->compressed.memory))
-                return false;
-            srcMemory = fs->compressed.memory;
-            srcSize = loc.size;
+            compressed->memory = (uint8_t*)tf_realloc(compressed->memory, loc.size);
+            compressed->memorySize = loc.size;
         }
+        if (!bunyArReadLocation(archive, loc, compressed->memory))
+            return "failed to read compressed block";
+        srcMemory = compressed->memory;
+        srcSize = loc.size;
     }
 
-    const char* error = NULL;
-
-    // this function fills readSize and writeSize
-    switch (fs->node->format)
+    switch (format)
     {
     case BUNYAR_FILE_FORMAT_LZ4_BLOCKS:
     {
         int decompressedSize = LZ4_decompress_safe((const char*)srcMemory, (char*)dst->memory, (int)srcSize, (int)dst->memorySize);
 
         if (decompressedSize < 0)
-        {
-            error = "compressed data is corrupted";
-            break;
-        }
+            return "compressed data is corrupted";
 
         dst->usedSize = (size_t)decompressedSize;
+        return NULL;
     }
-    break;
     case BUNYAR_FILE_FORMAT_ZSTD_BLOCKS:
     {
-        size_t decompressedSize = ZSTD_decompressDCtx(fs->zstd_ctx, dst->memory, dst->memorySize, srcMemory, srcSize);
+        size_t decompressedSize = zstdDDict
+                                      ? ZSTD_decompress_usingDDict(zstdCtx, dst->memory, dst->memorySize, srcMemory, srcSize, zstdDDict)
+                                      : ZSTD_decompressDCtx(zstdCtx, dst->memory, dst->memorySize, srcMemory, srcSize);
 
         if (ZSTD_isError(decompressedSize))
-        {
-            error = ZSTD_getErrorName(decompressedSize);
-            break;
-        }
+            return ZSTD_getErrorName(decompressedSize);
 
         dst->usedSize = decompressedSize;
+        return NULL;
     }
-    break;
     default:
-        error = "Unexpected node format";
+        return "Unexpected node format";
     }
+}
+
+static bool bunyArReadBlockToBuffer(struct BunyArMetadata* archive, struct BunyArFileStream* fs, BunyArBlockPointer* blockToRead,
+                                    struct BunyArBlockBuffer* dst)
+{
+    struct BunyArBlockInfo blockInfo = bunyArDecodeBlockPointer(*blockToRead);
+
+    ASSERT(blockInfo.isCompressed);
+
+    struct BunyArPointer64 loc = bunyArDecodeBlockPointerInfo(fs->node, &fs->blocksHeader, &blockInfo);
+
+    // staging buffer of the stream is part of the stream allocation, compressed blocks are never larger than blockSize
+    ASSERT(archive->memoryBeg || loc.size <= fs->compressed.memorySize);
+    const char* error =
+        bunyArDecompressBlock(archive, (enum BunyArFileFormat)fs->node->format, loc, fs->zstd_ctx, fs->zstd_ddict, &fs->compressed, dst);
 
     if (!error)
         return true;
@@ -1645,11 +2425,493 @@ static bool bunyArReadBlockToBuffer(struct BunyArMetadata* archive, struct BunyA
     return false;
 }
 
+/************************************************************************/
+// Archive block cache
+/************************************************************************/
+
+static inline uint64_t bunyArCachedBlockKey(struct BunyArMetadata* archive, struct BunyArFileStream* fs, uint64_t blockIndex)
+{
+    uint64_t nodeIndex = (uint64_t)(fs->node - archive->nodes);
+    ASSERT(nodeIndex <= UINT32_MAX && blockIndex <= UINT32_MAX);
+    return (nodeIndex << 32) | blockIndex;
+}
+
+static inline uint64_t bunyArBlockDecompressedSize(struct BunyArFileStream* fs, uint64_t blockIndex)
+{
+    return blockIndex == fs->blocksHeader.blockCount - 1 ? fs->blocksHeader.blockSizeLast : fs->blocksHeader.blockSize;
+}
+
+// All functions below expect cache->mutex to be held
+
+static void bunyArCacheUnlink(struct BunyArBlockCache* cache, struct BunyArCachedBlock* block)
+{
+    if (block->lruPrev)
+        block->lruPrev->lruNext = block->lruNext;
+    else
+        cache->lruHead = block->lruNext;
+    if (block->lruNext)
+        block->lruNext->lruPrev = block->lruPrev;
+    else
+        cache->lruTail = block->lruPrev;
+    block->lruPrev = NULL;
+    block->lruNext = NULL;
+}
+
+static void bunyArCacheTouch(struct BunyArBlockCache* cache, struct BunyArCachedBlock* block)
+{
+    if (cache->lruHead == block)
+        return;
+    if (block->lruPrev || block->lruNext || cache->lruTail == block)
+        bunyArCacheUnlink(cache, block);
+    block->lruNext = cache->lruHead;
+    if (cache->lruHead)
+        cache->lruHead->lruPrev = block;
+    cache->lruHead = block;
+    if (!cache->lruTail)
+        cache->lruTail = block;
+}
+
+static void bunyArCacheRemove(struct BunyArBlockCache* cache, struct BunyArCachedBlock* block)
+{
+    ASSERT(!block->refCount);
+    bunyArCacheUnlink(cache, block);
+    (void)hmdel(cache->blocks, block->key);
+    cache->stats.usedSize -= block->buffer.memorySize;
+    tf_free(block);
+}
+
+// Evicts unreferenced blocks starting from the least recently used one
+static bool bunyArCacheMakeRoom(struct BunyArBlockCache* cache, uint64_t size)
+{
+    struct BunyArCachedBlock* block = cache->lruTail;
+    while (block && cache->stats.usedSize + size > cache->stats.budget)
+    {
+        struct BunyArCachedBlock* prev = block->lruPrev;
+        if (!block->refCount)
+        {
+            bunyArCacheRemove(cache, block);
+            ++cache->stats.evictionCount;
+        }
+        block = prev;
+    }
+    return cache->stats.usedSize + size <= cache->stats.budget;
+}
+
+static struct BunyArCachedBlock* bunyArCacheInsert(struct BunyArBlockCache* cache, struct BunyArMetadata* archive,
+                                                   struct BunyArFileStream* fs, uint64_t blockIndex, uint64_t key)
+{
+    uint64_t                  size = bunyArBlockDecompressedSize(fs, blockIndex);
+    struct BunyArCachedBlock* block = (struct BunyArCachedBlock*)tf_malloc(sizeof(*block) + size);
+    memset(block, 0, sizeof(*block));
+
+    struct BunyArBlockInfo blockInfo = bunyArDecodeBlockPointer(fs->blocks[blockIndex]);
+
+    block->key = key;
+    block->archive = archive;
+    block->refCount = 1;
+    block->state = BUNYAR_CACHED_BLOCK_LOADING;
+    block->format = (enum BunyArFileFormat)fs->node->format;
+    block->ddict = fs->zstd_ddict;
+    block->location = bunyArDecodeBlockPointerInfo(fs->node, &fs->blocksHeader, &blockInfo);
+    block->buffer.memory = (uint8_t*)(block + 1);
+    block->buffer.memorySize = size;
+
+    hmput(cache->blocks, key, block);
+    bunyArCacheTouch(cache, block);
+    cache->stats.usedSize += size;
+    return block;
+}
+
+static void bunyArReadAheadTask(void* user, uint64_t threadId)
+{
+    struct BunyArCachedBlock* block = (struct BunyArCachedBlock*)user;
+    struct BunyArMetadata*    archive = block->archive;
+    struct BunyArBlockCache*  cache = archive->blockCache;
+
+    ASSERT(threadId < cache->readAheadThreadCount);
+    if (block->format == BUNYAR_FILE_FORMAT_ZSTD_BLOCKS && !cache->zstdCtxs[threadId])
+    {
+        cache->zstdCtxs[threadId] = ZSTD_createDCtx_advanced(ZSTD_MEMORY_ALLOCATOR);
+    }
+
+    const char* error = cache->zstdCtxs[threadId] || block->format != BUNYAR_FILE_FORMAT_ZSTD_BLOCKS
+                            ? bunyArDecompressBlock(archive, block->format, block->location, cache->zstdCtxs[threadId], block->ddict,
+                                                    &cache->compressed[threadId], &block->buffer)
+                            : "failed to create ZSTD context";
+    if (error)
+    {
+        LOGF(eERROR, "Failed to decompress read-ahead block: %s", error);
+    }
+
+    acquireMutex(&cache->mutex);
+    block->state = error ? BUNYAR_CACHED_BLOCK_FAILED : BUNYAR_CACHED_BLOCK_READY;
+    --block->refCount;
+    if (error && !block->refCount)
+    {
+        bunyArCacheRemove(cache, block);
+    }
+    wakeAllConditionVariable(&cache->blockLoaded);
+    releaseMutex(&cache->mutex);
+}
+
+// Called on every block change of a stream, sends the blocks after a sequential read to read-ahead threads
+static void bunyArCacheReadAhead(struct BunyArMetadata* archive, struct BunyArFileStream* fs, uint64_t blockIndex)
+{
+    struct BunyArBlockCache* cache = archive->blockCache;
+
+    const bool sequential = blockIndex == fs->nextSequentialBlock;
+    fs->nextSequentialBlock = blockIndex + 1;
+    if (!sequential)
+        fs->readAheadEnd = 0;
+    if (!sequential || !cache->readAheadBlockCount)
+        return;
+
+    uint64_t begin = fs->readAheadEnd > blockIndex + 1 ? fs->readAheadEnd : blockIndex + 1;
+    uint64_t end = blockIndex + 1 + cache->readAheadBlockCount;
+    if (end > fs->blocksHeader.blockCount)
+        end = fs->blocksHeader.blockCount;
+    if (begin >= end)
+        return;
+
+    acquireMutex(&cache->mutex);
+    for (uint64_t i = begin; i < end; ++i)
+    {
+        fs->readAheadEnd = i + 1;
+        if (!bunyArDecodeBlockPointer(fs->blocks[i]).isCompressed)
+            continue;
+
+        uint64_t key = bunyArCachedBlockKey(archive, fs, i);
+        if (hmgeti(cache->blocks, key) >= 0)
+            continue;
+
+        // read-ahead never grows the cache above the budget
+        if (!bunyArCacheMakeRoom(cache, bunyArBlockDecompressedSize(fs, i)))
+            break;
+
+        // reference is owned by the task
+        struct BunyArCachedBlock* block = bunyArCacheInsert(cache, archive, fs, i, key);
+        block->readAhead = true;
+        ++cache->stats.readAheadCount;
+        threadSystemAddTask(cache->readAheadThreads, bunyArReadAheadTask, block);
+    }
+    releaseMutex(&cache->mutex);
+}
+
+static void bunyArCacheReleaseStreamBlock(struct BunyArBlockCache* cache, struct BunyArFileStream* fs)
+{
+    if (!fs->cachedBlock)
+        return;
+
+    acquireMutex(&cache->mutex);
+    --fs->cachedBlock->refCount;
+    releaseMutex(&cache->mutex);
+
+    fs->cachedBlock = NULL;
+    fs->currentBlock = NULL;
+    memset(&fs->decompressed, 0, sizeof(fs->decompressed));
+}
+
+// Full block reads decompress straight into user memory, unless the block is cached already
+static bool bunyArCacheContains(struct BunyArMetadata* archive, struct BunyArFileStream* fs, uint64_t blockIndex)
+{
+    struct BunyArBlockCache* cache = archive->blockCache;
+    uint64_t                 key = bunyArCachedBlockKey(archive, fs, blockIndex);
+
+    acquireMutex(&cache->mutex);
+    bool contains = hmgeti(cache->blocks, key) >= 0;
+    releaseMutex(&cache->mutex);
+    return contains;
+}
+
+// Makes the cached block the staging buffer of the stream, decompresses it on a miss
+static bool bunyArCacheReadBlock(struct BunyArMetadata* archive, struct BunyArFileStream* fs, BunyArBlockPointer* blockToRead)
+{
+    struct BunyArBlockCache* cache = archive->blockCache;
+    uint64_t                 blockIndex = (uint64_t)(blockToRead - fs->blocks);
+    uint64_t                 key = bunyArCachedBlockKey(archive, fs, blockIndex);
+
+    bunyArCacheReleaseStreamBlock(cache, fs);
+
+    acquireMutex(&cache->mutex);
+    struct BunyArCachedBlock* block = hmget(cache->blocks, key);
+    bool                      miss = block == NULL;
+    if (miss)
+    {
+        ++cache->stats.missCount;
+        // the block is needed right now, so the budget can be exceeded if all blocks are referenced
+        bunyArCacheMakeRoom(cache, bunyArBlockDecompressedSize(fs, blockIndex));
+        block = bunyArCacheInsert(cache, archive, fs, blockIndex, key);
+    }
+    else
+    {
+        ++cache->stats.hitCount;
+        if (block->readAhead)
+        {
+            block->readAhead = false;
+            ++cache->stats.readAheadUsedCount;
+        }
+        ++block->refCount;
+        bunyArCacheTouch(cache, block);
+        while (block->state == BUNYAR_CACHED_BLOCK_LOADING)
+        {
+            waitConditionVariable(&cache->blockLoaded, &cache->mutex, TIMEOUT_INFINITE);
+        }
+    }
+    releaseMutex(&cache->mutex);
+
+    bool success = block->state == BUNYAR_CACHED_BLOCK_READY;
+    if (miss)
+    {
+        success = bunyArReadBlockToBuffer(archive, fs, blockToRead, &block->buffer);
+
+        acquireMutex(&cache->mutex);
+        block->state = success ? BUNYAR_CACHED_BLOCK_READY : BUNYAR_CACHED_BLOCK_FAILED;
+        wakeAllConditionVariable(&cache->blockLoaded);
+        releaseMutex(&cache->mutex);
+    }
+
+    if (!success)
+    {
+        acquireMutex(&cache->mutex);
+        // failed blocks are dropped, so the next read tries again
+        if (!--block->refCount && block->state == BUNYAR_CACHED_BLOCK_FAILED)
+            bunyArCacheRemove(cache, block);
+        releaseMutex(&cache->mutex);
+        return false;
+    }
+
+    fs->cachedBlock = block;
+    fs->decompressed = block->buffer;
+    return true;
+}
+
+static bool bunyArCacheInit(struct BunyArMetadata* archive, const struct ArchiveOpenDesc* desc)
+{
+    struct BunyArBlockCache* cache = (struct BunyArBlockCache*)tf_calloc(1, sizeof(*cache));
+    archive->blockCache = cache;
+
+    cache->stats.budget = desc->blockCacheSize;
+    cache->readAheadBlockCount = desc->readAheadBlockCount;
+    if (!initMutex(&cache->mutex) || !initConditionVariable(&cache->blockLoaded))
+        return false;
+
+    if (cache->readAheadBlockCount)
+    {
+        struct ThreadSystemInitDesc threadDesc = gThreadSystemInitDescDefault;
+        threadDesc.threadCount = desc->readAheadThreadCount ? desc->readAheadThreadCount : 1;
+        threadDesc.threadName = "ArchiveReadAhead";
+        if (!threadSystemInit(&cache->readAheadThreads, &threadDesc))
+            return false;
+
+        struct ThreadSystemInfo info;
+        threadSystemGetInfo(cache->readAheadThreads, &info);
+        cache->readAheadThreadCount = (uint32_t)info.threadCount;
+        cache->zstdCtxs = (ZSTD_DCtx**)tf_calloc(cache->readAheadThreadCount, sizeof(*cache->zstdCtxs));
+        cache->compressed = (struct BunyArBlockBuffer*)tf_calloc(cache->readAheadThreadCount, sizeof(*cache->compressed));
+    }
+    return true;
+}
+
+static void bunyArCacheExit(struct BunyArMetadata* archive)
+{
+    struct BunyArBlockCache* cache = archive->blockCache;
+    if (!cache)
+        return;
+
+    if (cache->readAheadThreads)
+    {
+        // waits for pending read-ahead
+        threadSystemExit(&cache->readAheadThreads, &gThreadSystemExitDescDefault);
+    }
+    for (uint32_t i = 0; i < cache->readAheadThreadCount; ++i)
+    {
+        ZSTD_freeDCtx(cache->zstdCtxs[i]);
+        tf_free(cache->compressed[i].memory);
+    }
+    tf_free(cache->zstdCtxs);
+    tf_free(cache->compressed);
+
+    while (cache->lruHead)
+    {
+        struct BunyArCachedBlock* block = cache->lruHead;
+        bunyArCacheUnlink(cache, block);
+        tf_free(block);
+    }
+    hmfree(cache->blocks);
+
+    exitConditionVariable(&cache->blockLoaded);
+    exitMutex(&cache->mutex);
+    tf_free(cache);
+    archive->blockCache = NULL;
+}
+
+/************************************************************************/
+// Parallel block decompression
+/************************************************************************/
+
+struct BunyArParallelRead
+{
+    struct BunyArMetadata*   archive;
+    struct BunyArFileStream* fs;
+    uint64_t                 firstBlock;
+    uint8_t*                 dst;
+    // blocks from this one on are not written, written under BunyArParallelDecompression::mutex
+    volatile uint64_t        failedBlock;
+};
+
+static void bunyArParallelReadChunk(void* user, uint64_t begin, uint64_t end, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    struct BunyArParallelRead*          read = (struct BunyArParallelRead*)user;
+    struct BunyArFileStream*            fs = read->fs;
+    struct BunyArParallelDecompression* pd = read->archive->parallelDecompression;
+    const enum BunyArFileFormat         format = (enum BunyArFileFormat)fs->node->format;
+
+    acquireMutex(&pd->mutex);
+    struct BunyArDecompressionContext* ctx = pd->freeContexts;
+    if (ctx)
+        pd->freeContexts = ctx->next;
+    releaseMutex(&pd->mutex);
+
+    if (!ctx)
+        ctx = (struct BunyArDecompressionContext*)tf_calloc(1, sizeof(*ctx));
+    if (format == BUNYAR_FILE_FORMAT_ZSTD_BLOCKS && !ctx->zstdCtx)
+        ctx->zstdCtx = ZSTD_createDCtx_advanced(ZSTD_MEMORY_ALLOCATOR);
+
+    uint64_t failedBlock = UINT64_MAX;
+    for (uint64_t i = begin; i < end && failedBlock == UINT64_MAX; ++i)
+    {
+        // blocks after a failed one are not returned to the caller anyway
+        if (i > read->failedBlock)
+            break;
+
+        const uint64_t         blockIndex = read->firstBlock + i;
+        struct BunyArBlockInfo blockInfo = bunyArDecodeBlockPointer(fs->blocks[blockIndex]);
+        struct BunyArPointer64 location = bunyArDecodeBlockPointerInfo(fs->node, &fs->blocksHeader, &blockInfo);
+
+        struct BunyArBlockBuffer dst = { 0 };
+        dst.memory = read->dst + i * fs->blocksHeader.blockSize;
+        dst.memorySize = bunyArBlockDecompressedSize(fs, blockIndex);
+
+        const char* error = NULL;
+        if (!blockInfo.isCompressed)
+        {
+            if (location.size != dst.memorySize ||
+                bunyArStreamRead(read->archive, location.offset, location.size, dst.memory) != dst.memorySize)
+                error = "failed to read uncompressed block";
+        }
+        else if (format == BUNYAR_FILE_FORMAT_ZSTD_BLOCKS && !ctx->zstdCtx)
+        {
+            error = "failed to create ZSTD context";
+        }
+        else
+        {
+            error = bunyArDecompressBlock(read->archive, format, location, ctx->zstdCtx, fs->zstd_ddict, &ctx->compressed, &dst);
+            if (!error && dst.usedSize != dst.memorySize)
+                error = "decompressed size is wrong";
+        }
+
+        if (error)
+        {
+            LOGF(eERROR, "Failed to decompress block #%llu: %s", (unsigned long long)blockIndex, error);
+            failedBlock = i;
+        }
+    }
+
+    acquireMutex(&pd->mutex);
+    ctx->next = pd->freeContexts;
+    pd->freeContexts = ctx;
+    if (failedBlock < read->failedBlock)
+        read->failedBlock = failedBlock;
+    releaseMutex(&pd->mutex);
+}
+
+// Number of blocks starting at blockIndex which are fully covered by a read of 'size' bytes
+static uint64_t bunyArParallelReadBlockCount(struct BunyArMetadata* archive, struct BunyArFileStream* fs, uint64_t blockIndex,
+                                             uint64_t size)
+{
+    uint64_t count = 0;
+    for (uint64_t i = blockIndex; i < fs->blocksHeader.blockCount; ++i, ++count)
+    {
+        const uint64_t blockSize = bunyArBlockDecompressedSize(fs, i);
+        if (blockSize > size)
+            break;
+        // cached blocks are copied from the cache instead
+        if (archive->blockCache && bunyArCacheContains(archive, fs, i))
+            break;
+        size -= blockSize;
+    }
+    return count;
+}
+
+// Decompresses blockCount blocks straight into the caller memory, returns the number of written bytes
+static uint64_t bunyArParallelRead(struct BunyArMetadata* archive, struct BunyArFileStream* fs, uint64_t blockIndex, uint64_t blockCount,
+                                   uint8_t* dst)
+{
+    struct BunyArParallelRead read = { 0 };
+    read.archive = archive;
+    read.fs = fs;
+    read.firstBlock = blockIndex;
+    read.dst = dst;
+    read.failedBlock = UINT64_MAX;
+
+    threadSystemParallelFor(archive->parallelDecompression->threads, blockCount, 1, bunyArParallelReadChunk, &read);
+
+    const uint64_t doneCount = read.failedBlock < blockCount ? read.failedBlock : blockCount;
+    uint64_t       size = 0;
+    for (uint64_t i = 0; i < doneCount; ++i)
+        size += bunyArBlockDecompressedSize(fs, blockIndex + i);
+    return size;
+}
+
+static bool bunyArParallelDecompressionInit(struct BunyArMetadata* archive, const struct ArchiveOpenDesc* desc)
+{
+    struct BunyArParallelDecompression* pd = (struct BunyArParallelDecompression*)tf_calloc(1, sizeof(*pd));
+    archive->parallelDecompression = pd;
+
+    if (!initMutex(&pd->mutex))
+        return false;
+
+    struct ThreadSystemInitDesc threadDesc = gThreadSystemInitDescDefault;
+    threadDesc.threadCount = desc->decompressionThreadCount;
+    threadDesc.threadName = "ArchiveDecompression";
+    return threadSystemInit(&pd->threads, &threadDesc);
+}
+
+static void bunyArParallelDecompressionExit(struct BunyArMetadata* archive)
+{
+    struct BunyArParallelDecompression* pd = archive->parallelDecompression;
+    if (!pd)
+        return;
+
+    if (pd->threads)
+        threadSystemExit(&pd->threads, &gThreadSystemExitDescDefault);
+
+    while (pd->freeContexts)
+    {
+        struct BunyArDecompressionContext* ctx = pd->freeContexts;
+        pd->freeContexts = ctx->next;
+        ZSTD_freeDCtx(ctx->zstdCtx);
+        tf_free(ctx->compressed.memory);
+        tf_free(ctx);
+    }
+
+    exitMutex(&pd->mutex);
+    tf_free(pd);
+    archive->parallelDecompression = NULL;
+}
+
 static bool bunyArReadBlockToStagingBuffer(struct BunyArMetadata* archive, struct BunyArFileStream* fs, BunyArBlockPointer* blockToRead)
 {
     if (fs->currentBlock == blockToRead)
         return true;
 
+    if (archive->blockCache)
+    {
+        fs->currentBlock = bunyArCacheReadBlock(archive, fs, blockToRead) ? blockToRead : NULL;
+        return fs->currentBlock != NULL;
+    }
+
     if (bunyArReadBlockToBuffer(archive, fs, blockToRead, &fs->decompressed))
     {
         fs->currentBlock = blockToRead;
@@ -1703,11 +2965,28 @@ static size_t ioArchiveFsRead(FileStream* pFile, void* outputBuffer, size_t outp
 
             BunyArBlockPointer* block = fs->blocks + blockIndex;
 
+            uint64_t parallelBlockCount = 0;
+            if (archive->parallelDecompression && offsetInBlock == 0)
+                parallelBlockCount = bunyArParallelReadBlockCount(archive, fs, blockIndex, sizeToWrite);
+
+            // block changed, blocks of a parallel read are not sent to read-ahead
+            if (archive->blockCache && blockIndex + 1 != fs->nextSequentialBlock && parallelBlockCount < BUNYAR_PARALLEL_READ_MIN_BLOCKS)
+                bunyArCacheReadAhead(archive, fs, blockIndex);
+
             struct BunyArBlockInfo blockInfo = bunyArDecodeBlockPointer(*block);
 
             uint64_t sizeDone = 0;
 
-            if (!blockInfo.isCompressed)
+            if (parallelBlockCount >= BUNYAR_PARALLEL_READ_MIN_BLOCKS)
+            {
+                // Read covers many whole blocks, decompress them straight to user memory on several threads
+                sizeDone = bunyArParallelRead(archive, fs, blockIndex, parallelBlockCount, dstMemory);
+                if (!sizeDone)
+                    break;
+                // next read continues sequentially after the last decompressed block
+                fs->nextSequentialBlock = blockIndex + parallelBlockCount;
+            }
+            else if (!blockInfo.isCompressed)
             {
                 // Block is uncompressed, read it directly
 
@@ -1727,7 +3006,8 @@ static size_t ioArchiveFsRead(FileStream* pFile, void* outputBuffer, size_t outp
                 sizeDone =
                     bunyArStreamRead(archive, location.offset + offsetInBlock, sizeToWrite > sizeLeft ? sizeLeft : sizeToWrite, dstMemory);
             }
-            else if (offsetInBlock == 0 && sizeToWrite >= blockSize)
+            else if (offsetInBlock == 0 && sizeToWrite >= blockSize &&
+                     (!archive->blockCache || !bunyArCacheContains(archive, fs, blockIndex)))
             {
                 // Avoid usage of staging buffer.
                 // We can uncompress entire block to user memory.
@@ -1829,6 +3109,10 @@ static bool ioArchiveMemoryMap(FileStream* fs, size_t* outSize, void const** out
     if (node->format != BUNYAR_FILE_FORMAT_RAW)
         return false;
 
+    // pointer goes straight into the archive memory, so the whole file has to be inside of it
+    if (node->filePointer.offset + node->filePointer.size > (uint64_t)(archive->memoryEnd - archive->memoryBeg))
+        return false;
+
     *outSize = node->filePointer.size;
     *outData = archive->memoryBeg + node->filePointer.offset;
     return true;
@@ -1866,6 +3150,7 @@ void fsArchiveGetDescription(IFileSystem* fs, struct BunyArDescription* outInfo)
 
     outInfo->nodeCount = archive->nodeCount;
     outInfo->hashTable = archive->hashTable;
+    outInfo->perfectHashTable = archive->perfectHashTable;
 }
 
 bool fsArchiveGetNodeDescription(IFileSystem* fs, uint64_t nodeId, struct BunyArNodeDescription* outInfo)
@@ -1891,6 +3176,20 @@ bool fsArchiveGetNodeDescription(IFileSystem* fs, uint64_t nodeId, struct BunyAr
     return true;
 }
 
+bool fsArchiveGetBlockCacheStats(IFileSystem* fs, struct BunyArBlockCacheStats* outStats)
+{
+    memset(outStats, 0, sizeof *outStats);
+
+    struct BunyArBlockCache* cache = getFsArchive(fs)->blockCache;
+    if (!cache)
+        return false;
+
+    acquireMutex(&cache->mutex);
+    *outStats = cache->stats;
+    releaseMutex(&cache->mutex);
+    return true;
+}
+
 bool fsArchiveGetFileBlockMetadata(FileStream* pFile, struct BunyArBlockFormatHeader* outHeader, const BunyArBlockPointer** outBlockPtrs)
 {
     __FS_NO_ERR;
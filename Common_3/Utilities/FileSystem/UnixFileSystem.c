@@ -31,6 +31,23 @@
 #include "../../Utilities/Interfaces/IFileSystem.h"
 #include "../../Utilities/Interfaces/ILog.h"
 
+#if defined(__linux__) && !defined(ANDROID)
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+#include <sys/syscall.h>
+
+#include "../../Utilities/Threading/Atomics.h"
+
+// IORING_OP_READ was added in the same kernel version (5.6) as IORING_FEAT_RW_CUR_POS,
+// with older kernel headers asynchronous reads always use the thread pool
+#if defined(IORING_FEAT_RW_CUR_POS) && defined(__NR_io_uring_setup)
+#define UNIX_ASYNC_READ_IO_URING
+#endif
+#endif
+
 extern ResourceDirectoryInfo gResourceDirectories[RD_COUNT];
 
 #if defined(__APPLE__)
@@ -99,8 +116,9 @@ static bool ioUnixFsOpen(IFileSystem* io, const ResourceDirectory rd, const char
         {
             oflags |= O_APPEND;
         }
-        else
+        else if (!(mode & FM_READ))
         {
+            // RW mode keeps file contents, same as "rb+" on Windows
             oflags |= O_TRUNC;
         }
 
@@ -356,12 +374,314 @@ static void* ioUnixGetSystemHandle(FileStream* fs)
     return (void*)(ssize_t)stream->descriptor;
 }
 
+static size_t ioUnixFsReadAt(FileStream* fs, void* dst, size_t size, uint64_t offset)
+{
+    __FS_NO_ERR;
+    USD(stream, fs);
+
+    // pread can return less than requested even before the end of file
+    size_t bytesRead = 0;
+    while (bytesRead < size)
+    {
+        ssize_t res = pread(stream->descriptor, (uint8_t*)dst + bytesRead, size - bytesRead, (off_t)(offset + bytesRead));
+        if (res < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            __FS_SET_ERR(translateErrno(errno));
+            break;
+        }
+        if (res == 0)
+            break;
+        bytesRead += (size_t)res;
+    }
+    return bytesRead;
+}
+
 static bool ioUnixFsIsAtEnd(FileStream* fs) { return ioUnixFsGetPosition(fs) >= ioUnixFsGetSize(fs); }
 
-IFileSystem gUnixSystemFileIO = { ioUnixFsOpen,          ioUnixFsClose, ioUnixFsRead,    ioUnixFsWrite, ioUnixFsSeek, ioUnixFsGetPosition,
-                                  ioUnixFsGetSize,       ioUnixFsFlush, ioUnixFsIsAtEnd, NULL,          NULL,         ioUnixFsMemoryMap,
-                                  ioUnixGetSystemHandle, NULL };
+IFileSystem gUnixSystemFileIO = {
+    .Open = ioUnixFsOpen,
+    .Close = ioUnixFsClose,
+    .Read = ioUnixFsRead,
+    .Write = ioUnixFsWrite,
+    .Seek = ioUnixFsSeek,
+    .GetSeekPosition = ioUnixFsGetPosition,
+    .GetFileSize = ioUnixFsGetSize,
+    .Flush = ioUnixFsFlush,
+    .IsAtEnd = ioUnixFsIsAtEnd,
+    .MemoryMap = ioUnixFsMemoryMap,
+    .GetSystemHandle = ioUnixGetSystemHandle,
+    .ReadAt = ioUnixFsReadAt,
+};
 
 #if !defined(ANDROID)
 IFileSystem* pSystemFileIO = &gUnixSystemFileIO;
 #endif
+
+/************************************************************************/
+// Asynchronous reads
+/************************************************************************/
+
+#if defined(__linux__) && !defined(ANDROID)
+#if defined(UNIX_ASYNC_READ_IO_URING)
+// io_uring rings are set up with raw syscalls, so there is no dependency on liburing.
+// All functions except unixAsyncReadWait are called with the async read mutex of FileSystem.c held.
+
+// Reads larger than this are split, the remainder is resubmitted once the first part is completed
+#define IO_URING_MAX_READ_SIZE (1u << 30)
+
+static struct
+{
+    int fd;
+
+    void*                sqRing;
+    size_t               sqRingSize;
+    tfrg_atomic32_t*     sqHead;
+    tfrg_atomic32_t*     sqTail;
+    uint32_t             sqMask;
+    uint32_t             sqEntries;
+    struct io_uring_sqe* sqes;
+    size_t               sqesSize;
+    // written to the ring, but not passed to io_uring_enter yet
+    uint32_t             sqUnsubmitted;
+
+    void*                cqRing;
+    size_t               cqRingSize;
+    tfrg_atomic32_t*     cqHead;
+    tfrg_atomic32_t*     cqTail;
+    uint32_t             cqMask;
+    struct io_uring_cqe* cqes;
+} gIoUring = { .fd = -1 };
+
+void unixAsyncReadExit(void);
+
+static int ioUringEnter(uint32_t toSubmit, uint32_t minComplete, uint32_t flags)
+{
+    return (int)syscall(__NR_io_uring_enter, gIoUring.fd, toSubmit, minComplete, flags, NULL, 0);
+}
+
+bool unixAsyncReadInit(uint32_t queueDepth)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof params);
+    int fd = (int)syscall(__NR_io_uring_setup, queueDepth, &params);
+    if (fd < 0)
+    {
+        LOGF(eINFO, "io_uring is not available (%s), asynchronous reads use the thread pool", strerror(errno));
+        return false;
+    }
+
+    // IORING_OP_READ was added in the same kernel version (5.6) as this feature flag
+    if (!(params.features & IORING_FEAT_RW_CUR_POS))
+    {
+        LOGF(eINFO, "io_uring doesn't support IORING_OP_READ, asynchronous reads use the thread pool");
+        close(fd);
+        return false;
+    }
+
+    gIoUring.fd = fd;
+    gIoUring.sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    gIoUring.cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    gIoUring.sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap)
+    {
+        if (gIoUring.cqRingSize > gIoUring.sqRingSize)
+            gIoUring.sqRingSize = gIoUring.cqRingSize;
+        gIoUring.cqRingSize = gIoUring.sqRingSize;
+    }
+
+    gIoUring.sqRing = mmap(NULL, gIoUring.sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    gIoUring.cqRing = gIoUring.sqRing;
+    if (!singleMap)
+    {
+        gIoUring.cqRing = mmap(NULL, gIoUring.cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    }
+    gIoUring.sqes = (struct io_uring_sqe*)mmap(NULL, gIoUring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                               IORING_OFF_SQES);
+    if (gIoUring.sqRing == MAP_FAILED || gIoUring.cqRing == MAP_FAILED || (void*)gIoUring.sqes == MAP_FAILED)
+    {
+        LOGF(eERROR, "Failed to map io_uring rings: %s", strerror(errno));
+        unixAsyncReadExit();
+        return false;
+    }
+
+    uint8_t* sqRing = (uint8_t*)gIoUring.sqRing;
+    gIoUring.sqHead = (tfrg_atomic32_t*)(sqRing + params.sq_off.head);
+    gIoUring.sqTail = (tfrg_atomic32_t*)(sqRing + params.sq_off.tail);
+    gIoUring.sqMask = *(uint32_t*)(sqRing + params.sq_off.ring_mask);
+    gIoUring.sqEntries = params.sq_entries;
+    gIoUring.sqUnsubmitted = 0;
+
+    // SQE indices never get reordered, so the indirection array is the identity
+    uint32_t* sqArray = (uint32_t*)(sqRing + params.sq_off.array);
+    for (uint32_t i = 0; i < params.sq_entries; ++i)
+    {
+        sqArray[i] = i;
+    }
+
+    uint8_t* cqRing = (uint8_t*)gIoUring.cqRing;
+    gIoUring.cqHead = (tfrg_atomic32_t*)(cqRing + params.cq_off.head);
+    gIoUring.cqTail = (tfrg_atomic32_t*)(cqRing + params.cq_off.tail);
+    gIoUring.cqMask = *(uint32_t*)(cqRing + params.cq_off.ring_mask);
+    gIoUring.cqes = (struct io_uring_cqe*)(cqRing + params.cq_off.cqes);
+    return true;
+}
+
+void unixAsyncReadExit(void)
+{
+    if (gIoUring.sqes && (void*)gIoUring.sqes != MAP_FAILED)
+    {
+        munmap(gIoUring.sqes, gIoUring.sqesSize);
+    }
+    if (gIoUring.cqRing && gIoUring.cqRing != MAP_FAILED && gIoUring.cqRing != gIoUring.sqRing)
+    {
+        munmap(gIoUring.cqRing, gIoUring.cqRingSize);
+    }
+    if (gIoUring.sqRing && gIoUring.sqRing != MAP_FAILED)
+    {
+        munmap(gIoUring.sqRing, gIoUring.sqRingSize);
+    }
+    if (gIoUring.fd >= 0)
+    {
+        close(gIoUring.fd);
+    }
+    memset(&gIoUring, 0, sizeof gIoUring);
+    gIoUring.fd = -1;
+}
+
+const char* unixAsyncReadBackendName(void) { return "io_uring"; }
+
+void unixAsyncReadFlush(void)
+{
+    while (gIoUring.sqUnsubmitted)
+    {
+        int res = ioUringEnter(gIoUring.sqUnsubmitted, 0, 0);
+        if (res < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            // EAGAIN/EBUSY: entries stay in the ring and are picked up by the next enter
+            if (errno != EAGAIN && errno != EBUSY)
+            {
+                LOGF(eERROR, "io_uring_enter failed: %s", strerror(errno));
+            }
+            return;
+        }
+        gIoUring.sqUnsubmitted -= (uint32_t)res;
+    }
+}
+
+static void ioUringQueueRead(FsAsyncRead* pRead)
+{
+    uint32_t tail = *gIoUring.sqTail;
+    if (tail - tfrg_atomic32_load_acquire(gIoUring.sqHead) == gIoUring.sqEntries)
+    {
+        // Only happens if the kernel didn't consume previous batch yet
+        unixAsyncReadFlush();
+        while (tail - tfrg_atomic32_load_acquire(gIoUring.sqHead) == gIoUring.sqEntries)
+        {
+            ioUringEnter(gIoUring.sqUnsubmitted, 1, IORING_ENTER_GETEVENTS);
+        }
+    }
+
+    USD(stream, pRead->pStream);
+    const uint64_t remaining = pRead->mSize - pRead->mBytesRead;
+
+    struct io_uring_sqe* sqe = &gIoUring.sqes[tail & gIoUring.sqMask];
+    memset(sqe, 0, sizeof *sqe);
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = stream->descriptor;
+    sqe->off = pRead->mOffset + pRead->mBytesRead;
+    sqe->addr = (uint64_t)(uintptr_t)((uint8_t*)pRead->pDst + pRead->mBytesRead);
+    sqe->len = (uint32_t)(remaining < IO_URING_MAX_READ_SIZE ? remaining : IO_URING_MAX_READ_SIZE);
+    sqe->user_data = (uint64_t)(uintptr_t)pRead;
+
+    tfrg_atomic32_store_release(gIoUring.sqTail, tail + 1);
+    ++gIoUring.sqUnsubmitted;
+}
+
+bool unixAsyncReadSubmit(FsAsyncRead* pRead)
+{
+    if (pRead->pStream->pIO != &gUnixSystemFileIO)
+        return false;
+
+    ioUringQueueRead(pRead);
+    return true;
+}
+
+uint32_t unixAsyncReadReap(FsAsyncRead** ppCompleted)
+{
+    uint32_t completed = 0;
+    uint32_t head = *gIoUring.cqHead;
+    uint32_t tail = tfrg_atomic32_load_acquire(gIoUring.cqTail);
+    for (; head != tail; ++head)
+    {
+        const struct io_uring_cqe* cqe = &gIoUring.cqes[head & gIoUring.cqMask];
+        FsAsyncRead*               pRead = (FsAsyncRead*)(uintptr_t)cqe->user_data;
+        if (cqe->res == -EINTR || cqe->res == -EAGAIN)
+        {
+            ioUringQueueRead(pRead);
+            continue;
+        }
+        if (cqe->res < 0)
+        {
+            pRead->mError = translateErrno((uint32_t)-cqe->res);
+        }
+        else
+        {
+            pRead->mBytesRead += (uint64_t)cqe->res;
+            // Short read or a part of a large read, 0 means end of file
+            if (cqe->res > 0 && pRead->mBytesRead < pRead->mSize)
+            {
+                ioUringQueueRead(pRead);
+                continue;
+            }
+        }
+
+        pRead->pNext = *ppCompleted;
+        *ppCompleted = pRead;
+        ++completed;
+    }
+    tfrg_atomic32_store_release(gIoUring.cqHead, head);
+    unixAsyncReadFlush();
+    return completed;
+}
+
+void unixAsyncReadWait(void)
+{
+    while (ioUringEnter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno == EINTR)
+    {
+    }
+}
+#else
+bool unixAsyncReadInit(uint32_t queueDepth)
+{
+    UNREF_PARAM(queueDepth);
+    LOGF(eINFO, "Built with kernel headers older than Linux 5.6, asynchronous reads use the thread pool");
+    return false;
+}
+
+void unixAsyncReadExit(void) {}
+
+const char* unixAsyncReadBackendName(void) { return "io_uring"; }
+
+void unixAsyncReadFlush(void) {}
+
+bool unixAsyncReadSubmit(FsAsyncRead* pRead)
+{
+    UNREF_PARAM(pRead);
+    return false;
+}
+
+uint32_t unixAsyncReadReap(FsAsyncRead** ppCompleted)
+{
+    UNREF_PARAM(ppCompleted);
+    return 0;
+}
+
+void unixAsyncReadWait(void) {}
+#endif
+#endif
@@ -115,7 +115,7 @@ extern "C"
         //       On other platforms read access is always available.
         FM_ALLOW_READ = 1 << 4,
 
-        // RW mode
+        // RW mode. Existing file contents are kept.
         FM_READ_WRITE = FM_READ | FM_WRITE,
 
         // W mode and set position to the end
@@ -217,11 +217,17 @@ extern "C"
         // Not all platforms are supported.
         // Use fsStreamWrapMemoryMap for strong cross-platform compatibility.
         // This function does read-only memory map.
+        // Archive FS returns a pointer into the archive memory for RAW files of archives opened with mmap or from memory.
         bool (*MemoryMap)(FileStream* fs, size_t* outSize, void const** outData);
 
         // getSystemHandle
         void* (*GetSystemHandle)(FileStream* fs);
 
+        // Reads at 'offset' without using or changing the seek position of the stream.
+        // Can be called from multiple threads on the same stream at the same time.
+        // Returns the number of bytes read. Not all IO implementations support it, use fsReadFromStreamAt.
+        size_t (*ReadAt)(FileStream* pFile, void* outputBuffer, size_t bufferSizeInBytes, uint64_t offset);
+
         void* pUser;
     };
 
@@ -375,6 +381,8 @@ extern "C"
         // Makes archive stream thread-safe
         // It allows to read several files from archive asynchronously.
         // Not used for fsArchiveOpenFromMemory
+        // Not needed if the archive stream supports positional reads (IFileSystem::ReadAt),
+        // those are thread-safe without a lock, e.g. system files on Unix platforms.
         //
         // Allows: (if this flag is set)
         // Thread1: reads file "A"
@@ -392,6 +400,22 @@ extern "C"
 
         // Try to memory map stream using fsStreamMemoryMap
         bool mmap;
+
+        // Memory budget in bytes of the cache of decompressed LZ4/ZSTD blocks shared by all files of the archive.
+        // Blocks are evicted in least recently used order.
+        // If 0, every opened file keeps only its last decompressed block.
+        uint64_t blockCacheSize;
+
+        // Number of blocks decompressed ahead of sequential reads into the block cache.
+        // Requires blockCacheSize, 0 disables read-ahead.
+        uint32_t readAheadBlockCount;
+
+        // Threads decompressing read-ahead blocks, owned by the archive. 0 selects 1 thread.
+        uint32_t readAheadThreadCount;
+
+        // Threads decompressing the blocks of a single large read in parallel, owned by the archive.
+        // The reading thread decompresses blocks as well. 0 decompresses on the reading thread only.
+        uint32_t decompressionThreadCount;
     };
 
     /// 'desc' can be NULL
@@ -472,6 +496,18 @@ extern "C"
         return fs->pIO->Read(fs, pOutputBuffer, bufferSizeInBytes);
     }
 
+    /// Positional read, see IFileSystem::ReadAt.
+    /// Returns the number of bytes read, 0 if the stream doesn't support positional reads.
+    static inline size_t fsReadFromStreamAt(FileStream* fs, void* pOutputBuffer, size_t bufferSizeInBytes, uint64_t offset)
+    {
+        if (!fs->pIO->ReadAt)
+            return 0;
+        return fs->pIO->ReadAt(fs, pOutputBuffer, bufferSizeInBytes, offset);
+    }
+
+    /// Checks if fsReadFromStreamAt can be used with the stream
+    static inline bool fsStreamSupportsReadAt(FileStream* fs) { return fs->pIO->ReadAt != NULL; }
+
     /// Reads at most `bufferSizeInBytes` bytes from sourceBuffer and writes them into the file.
     /// Returns the number of bytes written.
     static inline size_t fsWriteToStream(FileStream* fs, const void* pSourceBuffer, size_t byteCount)
@@ -525,6 +561,82 @@ extern "C"
         return fs->pIO->MemoryMap(fs, outSize, outData);
     }
 
+    /************************************************************************/
+    // MARK: - Asynchronous file IO
+    /************************************************************************/
+
+    typedef struct FsAsyncRead FsAsyncRead;
+
+    /// Called on the thread which collects completions (fsPollAsyncReads/fsWaitAsyncReads).
+    /// The read can be reused or freed from inside of the callback.
+    typedef void (*FsAsyncReadCallback)(FsAsyncRead* pRead);
+
+    /// Memory is owned by the caller and has to stay valid until the read is completed.
+    /// Fill the request with fsReadAsync, all other members are written by the file system.
+    struct FsAsyncRead
+    {
+        FileStream*         pStream;
+        uint64_t            mOffset;
+        uint64_t            mSize;
+        void*               pDst;
+        // Can be NULL, use fsIsAsyncReadDone then
+        FsAsyncReadCallback pCompletion;
+        void*               pUserData;
+
+        // Valid once the read is completed.
+        // mBytesRead is less than mSize if the end of file is reached or an error occured.
+        uint64_t    mBytesRead;
+        FSErrorCode mError;
+
+        // Internal
+        FsAsyncRead*      pNext;
+        volatile uint32_t mDone;
+    };
+
+    typedef struct FsAsyncReadDesc
+    {
+        /// Max number of reads in flight, 0 selects FS_ASYNC_READ_DEFAULT_QUEUE_DEPTH
+        uint32_t mQueueDepth;
+        /// Worker threads of the thread pool backend, 0 selects the CPU core count
+        uint32_t mThreadCount;
+        /// Use the thread pool backend even if the platform provides a native one (io_uring on Linux)
+        bool     mDisableNativeBackend;
+    } FsAsyncReadDesc;
+
+#define FS_ASYNC_READ_DEFAULT_QUEUE_DEPTH 32
+#define FS_ASYNC_READ_MAX_QUEUE_DEPTH     256
+
+    /// Starts the asynchronous read backend.
+    /// Reads of system file streams go through the native backend if it's available,
+    /// every other stream (memory, archive, ...) is read by the thread pool.
+    /// 'pDesc' can be NULL
+    FORGE_API bool fsInitAsyncReads(const FsAsyncReadDesc* pDesc);
+    /// Waits for all queued reads and stops the backend
+    FORGE_API void fsExitAsyncReads(void);
+
+    /// Name of the backend used for system file streams, for logging
+    FORGE_API const char* fsGetAsyncReadBackendName(void);
+
+    /// Queues a read of 'size' bytes at 'offset' of 'pStream' into 'pDst'.
+    /// Seek position of the stream is not affected. Reads of the same stream can be in flight at the same time.
+    /// Nothing is sent to the backend until fsSubmitAsyncReads is called, so reads can be batched.
+    FORGE_API bool fsReadAsync(FileStream* pStream, uint64_t offset, uint64_t size, void* pDst, FsAsyncRead* pRead);
+
+    /// Sends queued reads to the backend, at most FsAsyncReadDesc::mQueueDepth are in flight.
+    /// Returns the number of reads submitted
+    FORGE_API uint32_t fsSubmitAsyncReads(void);
+
+    /// Collects finished reads without blocking, runs their callbacks and submits more of the queued reads.
+    /// Returns the number of completed reads
+    FORGE_API uint32_t fsPollAsyncReads(void);
+
+    /// Same as fsPollAsyncReads, but blocks until at least 'minCompletions' reads are completed
+    /// or nothing is left to wait for. UINT32_MAX waits for all reads.
+    FORGE_API uint32_t fsWaitAsyncReads(uint32_t minCompletions);
+
+    /// Can be called from any thread, the results of the read are visible once it returns true
+    FORGE_API bool fsIsAsyncReadDone(FsAsyncRead* pRead);
+
     /************************************************************************/
     // MARK: - Directory queries
     /************************************************************************/
@@ -589,6 +701,15 @@ extern "C"
         uint32_t size;   // exact size
     };
 
+// Version of archives written and read by this code.
+// 1: BunyArHeader::dictionaryTablePointer, archives with ZSTD dictionaries are compatible with version 1 only
+// 2: BUNYAR_FLAG_PERFECT_HASH_TABLE, archives with BunyArPerfectHashTable are compatible with version 2 only
+#define BUNYAR_VERSION 2
+
+// BunyArHeader::flags
+// Hash table at BunyArHeader::hashTablePointer is BunyArPerfectHashTable instead of BunyArHashTable
+#define BUNYAR_FLAG_PERFECT_HASH_TABLE ((uint64_t)1 << 0)
+
     // Reader can still use archive,
     // if condition "compatible <= X <= actual" is met, where X is reader version.
     struct BunyArVersion
@@ -604,7 +725,7 @@ extern "C"
 
         struct BunyArVersion version;
 
-        // 0, reserved
+        // BUNYAR_FLAG_* bits, 0 before version 2
         uint64_t flags;
 
         // nodeCount = nodesPointer.size / sizeof(BunyArNode)
@@ -618,6 +739,11 @@ extern "C"
         // Hash table present, if size >= sizeof(BunyArHashTable)
         struct BunyArPointer64 hashTablePointer;
 
+        // Version 1. Location of BunyArDictionaryTable.
+        // Dictionaries present, if size >= sizeof(BunyArDictionaryTable)
+        // Header of version 0 archives ends before this pointer.
+        struct BunyArPointer64 dictionaryTablePointer;
+
         // header can be extended in the future by new variables or pointers
     };
 
@@ -697,6 +823,18 @@ extern "C"
         return true;
     }
 
+    // ZSTD dictionaries of small BUNYAR_FILE_FORMAT_ZSTD_BLOCKS files.
+    // Dictionaries are raw content (ZSTD_dct_rawContent), all blocks of a node with a dictionary are compressed with it.
+    struct BunyArDictionaryTable
+    {
+        uint64_t dictionaryCount;
+
+        // tables are located after header
+        // struct BunyArPointer64 dictionaries[dictionaryCount];
+        // dictionary index + 1 for every node, 0 if node doesn't use a dictionary
+        // uint32_t nodeDictionaries[nodeCount];
+    };
+
     struct BunyArHashTable
     {
         uint64_t reserved; // 0 "magic" for later
@@ -716,14 +854,47 @@ extern "C"
 
     static inline uint64_t bunyArHashTableSize(const struct BunyArHashTable* ht) { return ht ? ht->tableSlotCount * 8 + sizeof(*ht) : 0; }
 
+    // Compact alternative to BunyArHashTable, about 4.5 bytes per key instead of 16.
+    // Keys are split into buckets of ~4 keys. Every bucket stores a pilot which moves its keys into free slots:
+    // hash = murmur2(name, seed)
+    // slot = (hash ^ mix(pilots[bucket(hash)])) % slotCount
+    // See bunyArPerfectHashTableLookup for bucket() and mix().
+    // Lookup is one hash, one slot read and a single string compare.
+    // There are 1% more slots than keys to keep construction fast.
+    struct BunyArPerfectHashTable
+    {
+        uint64_t seed;
+        uint64_t bucketCount;
+        uint64_t slotCount;
+
+        // tables are located after header
+        // uint32_t slots[slotCount]; node index, UINT32_MAX for empty slot
+        // uint16_t pilots[bucketCount];
+    };
+
+    // user must deallocate returned pointer using tf_free
+    FORGE_API struct BunyArPerfectHashTable* bunyArPerfectHashTableConstruct(uint64_t nodeCount, const struct BunyArNode* nodes,
+                                                                             const char* nodeNames);
+
+    // In case value >= nodeCount is returned, node by that name is not found
+    FORGE_API uint64_t bunyArPerfectHashTableLookup(const struct BunyArPerfectHashTable* ht, const char* name, uint64_t nodeCount,
+                                                    const struct BunyArNode* nodes, const char* nodeNames);
+
+    static inline uint64_t bunyArPerfectHashTableSize(const struct BunyArPerfectHashTable* ht)
+    {
+        return ht ? sizeof(*ht) + ht->slotCount * sizeof(uint32_t) + ht->bucketCount * sizeof(uint16_t) : 0;
+    }
+
     /************************************************************************/
     // MARK: - Advanced Buny Archive file system IO
     /************************************************************************/
 
     struct BunyArDescription
     {
-        uint64_t                      nodeCount;
-        const struct BunyArHashTable* hashTable;
+        uint64_t                             nodeCount;
+        const struct BunyArHashTable*        hashTable;
+        // archive hash table is either hashTable or perfectHashTable
+        const struct BunyArPerfectHashTable* perfectHashTable;
     };
 
     struct BunyArNodeDescription
@@ -745,6 +916,23 @@ extern "C"
     // to search for file node.
     FORGE_API bool fsArchiveGetNodeId(IFileSystem* fs, const char* fileName, uint64_t* outUid);
 
+    struct BunyArBlockCacheStats
+    {
+        // block reads served from the cache, includes blocks which were still decompressed by read-ahead
+        uint64_t hitCount;
+        uint64_t missCount;
+        // blocks decompressed by read-ahead and how many of them were read before eviction
+        uint64_t readAheadCount;
+        uint64_t readAheadUsedCount;
+        uint64_t evictionCount;
+        // bytes of decompressed blocks in the cache
+        uint64_t usedSize;
+        uint64_t budget;
+    };
+
+    // Returns false if the archive is opened without a block cache (ArchiveOpenDesc::blockCacheSize)
+    FORGE_API bool fsArchiveGetBlockCacheStats(IFileSystem* pArchive, struct BunyArBlockCacheStats* outStats);
+
     FORGE_API bool fsArchiveGetFileBlockMetadata(FileStream* pFile, struct BunyArBlockFormatHeader* outHeader,
                                                  const BunyArBlockPointer** outBlockPtrs);
 
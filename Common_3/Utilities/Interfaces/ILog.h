@@ -130,6 +130,10 @@ extern "C"
 #define RAW_LOGF_IF(log_level, condition, ...) \
     ((condition) ? writeRawLog((log_level), false, __VA_ARGS__) : (void)sizeof(condition)) //-V568
 
+// Usage: BLOGF(LogLevel::eINFO | LogLevel::eDEBUG, "Whatever string %s, this is an int %d", "This is a string", 1)
+// Like LOGF, but formatting is deferred to the decoder of the binary log opened with addBinaryLogFile. The format must be a literal.
+#define BLOGF(log_level, ...) writeBinaryLog((log_level), __FILE__, __LINE__, __VA_ARGS__)
+
 #if defined(FORGE_DEBUG)
 
 // Usage: DLOGF(LogLevel::eINFO | LogLevel::eDEBUG, "Whatever string %s, this is an int %d", "This is a string", 1)
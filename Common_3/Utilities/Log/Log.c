@@ -33,6 +33,8 @@
 #include "../../Utilities/Interfaces/ILog.h"
 #include "../../Utilities/Interfaces/IThread.h"
 #include "../../Utilities/Interfaces/ITime.h"
+#include "../../Utilities/ThirdParty/OpenSource/Nothings/stb_ds.h"
+#include "../../Utilities/Threading/Atomics.h"
 
 #include "../../Utilities/Interfaces/IMemory.h"
 
@@ -81,9 +83,98 @@ static bool              gConsoleLogging = true;
 #define LOG_LEVEL_SIZE     6
 #define LOG_MESSAGE_OFFSET (LOG_PREAMBLE_SIZE + LOG_LEVEL_SIZE)
 
+#define LOG_ASYNC_CACHE_LINE_SIZE 64
+// Microseconds flushLog waits for the log thread to make progress before giving up, e.g. when it crashed itself
+#define LOG_ASYNC_FLUSH_TIMEOUT   1000000
+
+// A formatted message waiting for the log thread
+typedef struct LogRecord
+{
+    tfrg_atomic64_t mSequence;
+    // Callbacks run when their level mask has one of these bits
+    uint32_t        mLevel;
+    bool            mError;
+    char            mMessage[LOG_MAX_BUFFER + 2];
+} LogRecord;
+
+typedef struct AsyncLog
+{
+    // Bounded multi-producer queue (D. Vyukov), the log thread is the only consumer
+    uint8_t           mPadEnqueueBegin[LOG_ASYNC_CACHE_LINE_SIZE];
+    tfrg_atomic64_t   mEnqueuePos;
+    uint8_t           mPadEnqueueEnd[LOG_ASYNC_CACHE_LINE_SIZE - sizeof(tfrg_atomic64_t)];
+    // Position of the next record the log thread reads, everything before it went through the callbacks
+    tfrg_atomic64_t   mDequeuePos;
+    tfrg_atomic32_t   mThreadSleeping;
+    tfrg_atomic32_t   mRun;
+    uint8_t           mPadDequeueEnd[LOG_ASYNC_CACHE_LINE_SIZE - sizeof(tfrg_atomic64_t) - 2 * sizeof(tfrg_atomic32_t)];
+    tfrg_atomic64_t   mDroppedCount;
+    LogRecord*        pRecords;
+    uint64_t          mRecordCount;
+    LogAsyncPolicy    mPolicy;
+    // Only used to put the log thread to sleep when the queue is empty
+    Mutex             mMutex;
+    ConditionVariable mCond;
+    ThreadHandle      mThread;
+    ThreadID          mThreadID;
+} AsyncLog;
+
+static AsyncLog* pAsyncLog = NULL;
+
+// Binary log file layout, all values little endian. Decoded by Common_3/Tools/BinaryLog/BinaryLogDecoder.py
+//   header:  "TFBINLOG", u32 version, u32 header size, i64 time(NULL) and i64 getUSec(false) when the file was opened
+//   string:  u8 LOG_BINARY_RECORD_STRING, u64 pointer, u32 size, chars. Written before the first message using the pointer
+//   thread:  u8 LOG_BINARY_RECORD_THREAD, u64 thread id, u32 size, chars. Written before the first message of a thread
+//   message: u8 LOG_BINARY_RECORD_MESSAGE, u32 level, i64 getUSec(false), u64 thread id, u64 file pointer, u32 line,
+//            u64 format pointer, u32 arguments size, arguments
+// Every argument is a type tag followed by its value: 'i' i64, 'u' u64, 'f' f64, 'p' u64, 's' u32 size and chars
+#define LOG_BINARY_MAGIC          "TFBINLOG"
+#define LOG_BINARY_VERSION        1
+#define LOG_BINARY_HEADER_SIZE    32
+#define LOG_BINARY_BUFFER_SIZE    (64 * 1024)
+#define LOG_BINARY_MESSAGE_SIZE   45
+#define LOG_BINARY_MAX_STRING     LOG_MAX_BUFFER
+#define LOG_BINARY_MAX_DEFINITION (13 + LOG_BINARY_MAX_STRING)
+
+typedef enum LogBinaryRecordType
+{
+    LOG_BINARY_RECORD_STRING = 1,
+    LOG_BINARY_RECORD_THREAD = 2,
+    LOG_BINARY_RECORD_MESSAGE = 3,
+} LogBinaryRecordType;
+
+typedef struct LogBinaryString
+{
+    uint64_t key;
+    bool     value;
+} LogBinaryString;
+
+typedef struct BinaryLog
+{
+    // Guards pBuffer, mSize and pStrings
+    Mutex            mMutex;
+    // Guards mStream and pSpareBuffer while a full buffer is written outside of mMutex
+    Mutex            mWriteMutex;
+    FileStream       mStream;
+    uint32_t         mLevel;
+    uint32_t         mGeneration;
+    uint8_t*         pBuffer;
+    uint8_t*         pSpareBuffer;
+    uint32_t         mSize;
+    uint32_t         mSpareSize;
+    // Format and file pointers already defined in the file
+    LogBinaryString* pStrings;
+} BinaryLog;
+
+static BinaryLog*            pBinaryLog = NULL;
+static uint32_t              gBinaryLogGeneration = 0;
+// Generation of the binary log this thread's name was written to
+static THREAD_LOCAL uint32_t gBinaryLogThreadGeneration = 0;
+
 static void     addInitialLogFile(const char* appName);
 static bool     isLogCallback(const char* id);
 static uint32_t writeLogPreamble(char* buffer, uint32_t buffer_size, const char* file, int line);
+static void     flushBinaryLog(void);
 
 bool fsMergeDirAndFileName(const char* dir, const char* path, char separator, size_t dstSize, char* dst);
 
@@ -152,6 +243,9 @@ void exitLog(void)
 {
     LOGF(eINFO, "Shutting down log system.");
 
+    disableAsyncLog();
+    closeBinaryLogFile();
+
     for (LogCallback* pCallback = gLogger.pCallbacks; pCallback != gLogger.pCallbacks + gLogger.mCallbacksSize; ++pCallback)
     {
         if (pCallback->mClose)
@@ -219,6 +313,662 @@ void addLogCallback(const char* id, uint32_t log_level, void* user_data, LogCall
     releaseMutex(&gLogger.mLogMutex);
 }
 
+static void dispatchLog(uint32_t level, bool error, const char* message)
+{
+    if (gConsoleLogging)
+    {
+        _PrintUnicode(message, error);
+    }
+
+    acquireMutex(&gLogger.mLogMutex);
+    {
+        for (LogCallback* pCallback = gLogger.pCallbacks; pCallback != gLogger.pCallbacks + gLogger.mCallbacksSize; ++pCallback)
+        {
+            if (pCallback->mLevel & level)
+                pCallback->mCallback(pCallback->mUserData, message);
+        }
+    }
+    releaseMutex(&gLogger.mLogMutex);
+}
+
+static bool isAsyncLogRecordAvailable(AsyncLog* pLog)
+{
+    uint64_t   pos = tfrg_atomic64_load_relaxed(&pLog->mDequeuePos);
+    LogRecord* pRecord = &pLog->pRecords[pos & (pLog->mRecordCount - 1)];
+    return tfrg_atomic64_load_acquire(&pRecord->mSequence) == pos + 1;
+}
+
+static void wakeAsyncLog(AsyncLog* pLog)
+{
+    // Pairs with the barrier in asyncLogThreadFunc, either the log thread sees the new record or we see it sleeping
+    tfrg_memorybarrier_full();
+    if (tfrg_atomic32_load_relaxed(&pLog->mThreadSleeping))
+    {
+        // Taking the mutex guarantees the log thread is inside waitConditionVariable and will not miss the wake up
+        acquireMutex(&pLog->mMutex);
+        releaseMutex(&pLog->mMutex);
+        wakeOneConditionVariable(&pLog->mCond);
+    }
+}
+
+// Returns false when the message has to be dispatched by the calling thread
+static bool enqueueLog(uint32_t level, bool error, const char* message, uint32_t size)
+{
+    AsyncLog* pLog = pAsyncLog;
+    // Messages logged by the callbacks themselves cannot wait for the log thread
+    if (!pLog || getCurrentThreadID() == pLog->mThreadID)
+        return false;
+
+    LogRecord* pRecord = NULL;
+    uint64_t   pos = tfrg_atomic64_load_relaxed(&pLog->mEnqueuePos);
+    for (;;)
+    {
+        pRecord = &pLog->pRecords[pos & (pLog->mRecordCount - 1)];
+        int64_t diff = (int64_t)tfrg_atomic64_load_acquire(&pRecord->mSequence) - (int64_t)pos;
+        if (diff == 0)
+        {
+            uint64_t prev = tfrg_atomic64_cas_relaxed(&pLog->mEnqueuePos, pos, pos + 1);
+            if (prev == pos)
+                break;
+            pos = prev;
+        }
+        else if (diff < 0)
+        {
+            // Queue is full
+            if (pLog->mPolicy == LOG_ASYNC_POLICY_DROP)
+            {
+                tfrg_atomic64_add_relaxed(&pLog->mDroppedCount, 1);
+                wakeAsyncLog(pLog);
+                return true;
+            }
+            wakeAsyncLog(pLog);
+            threadSleep(0);
+            pos = tfrg_atomic64_load_relaxed(&pLog->mEnqueuePos);
+        }
+        else
+        {
+            pos = tfrg_atomic64_load_relaxed(&pLog->mEnqueuePos);
+        }
+    }
+
+    size = size < LOG_MAX_BUFFER + 1 ? size : LOG_MAX_BUFFER + 1;
+    memcpy(pRecord->mMessage, message, size);
+    pRecord->mMessage[size] = 0;
+    pRecord->mLevel = level;
+    pRecord->mError = error;
+    tfrg_atomic64_store_release(&pRecord->mSequence, pos + 1);
+
+    wakeAsyncLog(pLog);
+    return true;
+}
+
+static void drainAsyncLog(AsyncLog* pLog, uint64_t* pReportedDropCount)
+{
+    while (isAsyncLogRecordAvailable(pLog))
+    {
+        uint64_t   pos = tfrg_atomic64_load_relaxed(&pLog->mDequeuePos);
+        LogRecord* pRecord = &pLog->pRecords[pos & (pLog->mRecordCount - 1)];
+        dispatchLog(pRecord->mLevel, pRecord->mError, pRecord->mMessage);
+        tfrg_atomic64_store_release(&pRecord->mSequence, pos + pLog->mRecordCount);
+        tfrg_atomic64_store_release(&pLog->mDequeuePos, pos + 1);
+    }
+
+    uint64_t droppedCount = tfrg_atomic64_load_relaxed(&pLog->mDroppedCount);
+    if (droppedCount != *pReportedDropCount)
+    {
+        writeLog(eWARNING, __FILE__, __LINE__, "Asynchronous log queue was full, dropped %llu messages",
+                 (unsigned long long)(droppedCount - *pReportedDropCount));
+        *pReportedDropCount = droppedCount;
+    }
+}
+
+static void asyncLogThreadFunc(void* pData)
+{
+    AsyncLog* pLog = (AsyncLog*)pData;
+    pLog->mThreadID = getCurrentThreadID();
+
+    uint64_t reportedDropCount = 0;
+    for (;;)
+    {
+        drainAsyncLog(pLog, &reportedDropCount);
+        if (!tfrg_atomic32_load_acquire(&pLog->mRun))
+            break;
+
+        acquireMutex(&pLog->mMutex);
+        // Producers check this flag after publishing their record, the full barrier orders the flag store before
+        // the queue check below so either we see the new record or the producer sees us sleeping and wakes us up
+        tfrg_atomic32_store_relaxed(&pLog->mThreadSleeping, 1);
+        tfrg_memorybarrier_full();
+        while (!isAsyncLogRecordAvailable(pLog) && tfrg_atomic32_load_relaxed(&pLog->mRun))
+        {
+            waitConditionVariable(&pLog->mCond, &pLog->mMutex, TIMEOUT_INFINITE);
+        }
+        tfrg_atomic32_store_relaxed(&pLog->mThreadSleeping, 0);
+        releaseMutex(&pLog->mMutex);
+    }
+
+    // Producers may still have published records after the last drain
+    drainAsyncLog(pLog, &reportedDropCount);
+}
+
+void enableAsyncLog(uint32_t recordCount, LogAsyncPolicy policy)
+{
+    ASSERT(gIsLoggerInitialized);
+    if (pAsyncLog)
+        return;
+
+    uint64_t count = 2;
+    while (count < recordCount)
+        count <<= 1;
+
+    AsyncLog* pLog = (AsyncLog*)tf_calloc_memalign(1, LOG_ASYNC_CACHE_LINE_SIZE, sizeof(AsyncLog));
+    ASSERT(pLog);
+    pLog->pRecords = (LogRecord*)tf_calloc_memalign((size_t)count, LOG_ASYNC_CACHE_LINE_SIZE, sizeof(LogRecord));
+    ASSERT(pLog->pRecords);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        pLog->pRecords[i].mSequence = i;
+    }
+    pLog->mRecordCount = count;
+    pLog->mPolicy = policy;
+    pLog->mRun = 1;
+    pLog->mThreadID = INVALID_THREAD_ID;
+    initMutex(&pLog->mMutex);
+    initConditionVariable(&pLog->mCond);
+
+    ThreadDesc threadDesc = { 0 };
+    threadDesc.pFunc = asyncLogThreadFunc;
+    threadDesc.pData = pLog;
+    strncpy(threadDesc.mThreadName, "AsyncLog", sizeof(threadDesc.mThreadName) - 1);
+    if (!initThread(&threadDesc, &pLog->mThread))
+    {
+        writeLog(eERROR, __FILE__, __LINE__, "Failed to create the asynchronous log thread");
+        exitConditionVariable(&pLog->mCond);
+        exitMutex(&pLog->mMutex);
+        tf_free(pLog->pRecords);
+        tf_free(pLog);
+        return;
+    }
+
+    pAsyncLog = pLog;
+}
+
+void disableAsyncLog(void)
+{
+    AsyncLog* pLog = pAsyncLog;
+    if (!pLog)
+        return;
+
+    // Messages logged from now on are dispatched synchronously, the callbacks run by the log thread included
+    pAsyncLog = NULL;
+    tfrg_memorybarrier_full();
+
+    tfrg_atomic32_store_release(&pLog->mRun, 0);
+    // Make sure the log thread is either waiting or will see mRun == 0 before it goes to sleep
+    acquireMutex(&pLog->mMutex);
+    releaseMutex(&pLog->mMutex);
+    wakeOneConditionVariable(&pLog->mCond);
+    joinThread(pLog->mThread);
+
+    // The log thread drained the queue before exiting, pick up records published while it was stopping
+    uint64_t reportedDropCount = tfrg_atomic64_load_relaxed(&pLog->mDroppedCount);
+    drainAsyncLog(pLog, &reportedDropCount);
+
+    exitConditionVariable(&pLog->mCond);
+    exitMutex(&pLog->mMutex);
+    tf_free(pLog->pRecords);
+    tf_free(pLog);
+}
+
+void flushLog(void)
+{
+    if (!gIsLoggerInitialized)
+        return;
+
+    AsyncLog* pLog = pAsyncLog;
+    if (pLog && getCurrentThreadID() != pLog->mThreadID)
+    {
+        // Positions below the enqueue position are either published or about to be published by a running producer
+        uint64_t target = tfrg_atomic64_load_acquire(&pLog->mEnqueuePos);
+        uint64_t pos = tfrg_atomic64_load_acquire(&pLog->mDequeuePos);
+        int64_t  lastProgress = getUSec(false);
+        while (pos < target)
+        {
+            wakeAsyncLog(pLog);
+            threadSleep(0);
+            uint64_t newPos = tfrg_atomic64_load_acquire(&pLog->mDequeuePos);
+            if (newPos != pos)
+                lastProgress = getUSec(false);
+            else if (getUSec(false) - lastProgress > LOG_ASYNC_FLUSH_TIMEOUT)
+                break;
+            pos = newPos;
+        }
+    }
+
+    acquireMutex(&gLogger.mLogMutex);
+    {
+        for (LogCallback* pCallback = gLogger.pCallbacks; pCallback != gLogger.pCallbacks + gLogger.mCallbacksSize; ++pCallback)
+        {
+            if (pCallback->mFlush)
+                pCallback->mFlush(pCallback->mUserData);
+        }
+    }
+    releaseMutex(&gLogger.mLogMutex);
+
+    flushBinaryLog();
+}
+
+uint64_t getAsyncLogDroppedCount(void)
+{
+    AsyncLog* pLog = pAsyncLog;
+    return pLog ? tfrg_atomic64_load_relaxed(&pLog->mDroppedCount) : 0;
+}
+
+static uint8_t* putLogBinaryValue(uint8_t* dst, const void* pValue, uint32_t size)
+{
+    memcpy(dst, pValue, size);
+    return dst + size;
+}
+
+static uint8_t* putLogBinaryArg(uint8_t* dst, char tag, uint64_t value)
+{
+    *dst++ = (uint8_t)tag;
+    return putLogBinaryValue(dst, &value, sizeof(value));
+}
+
+// Walks the printf conversions of the format and stores every argument with its type tag.
+// Stops at the first argument that does not fit, the decoder prints the missing ones as "?".
+static uint32_t encodeLogBinaryArgs(uint8_t* dst, uint32_t dstSize, const char* fmt, va_list args)
+{
+    uint8_t*       ptr = dst;
+    const uint8_t* end = dst + dstSize;
+    for (const char* c = fmt; *c; ++c)
+    {
+        if (*c != '%')
+            continue;
+        ++c;
+        if (*c == '%')
+            continue;
+
+        while (*c == '-' || *c == '+' || *c == ' ' || *c == '#' || *c == '0' || *c == '\'')
+            ++c;
+
+        if (*c == '*')
+        {
+            int width = va_arg(args, int);
+            if (ptr + 9 > end)
+                break;
+            ptr = putLogBinaryArg(ptr, 'i', (uint64_t)(int64_t)width);
+            ++c;
+        }
+        while (*c >= '0' && *c <= '9')
+            ++c;
+
+        int precision = -1;
+        if (*c == '.')
+        {
+            ++c;
+            precision = 0;
+            if (*c == '*')
+            {
+                precision = va_arg(args, int);
+                if (ptr + 9 > end)
+                    break;
+                ptr = putLogBinaryArg(ptr, 'i', (uint64_t)(int64_t)precision);
+                ++c;
+            }
+            while (*c >= '0' && *c <= '9')
+                precision = precision * 10 + (*c++ - '0');
+        }
+
+        // Length modifier, 'L' is long double and I64/I32/I are the MSVC ones
+        char length = 0;
+        if (*c == 'h' || *c == 'l')
+        {
+            length = *c++;
+            if (*c == length)
+            {
+                length = length == 'l' ? 'q' : 'H';
+                ++c;
+            }
+        }
+        else if (*c == 'j' || *c == 'z' || *c == 't' || *c == 'L' || *c == 'q')
+        {
+            length = *c++;
+        }
+        else if (*c == 'I')
+        {
+            ++c;
+            length = 'z';
+            if (c[0] == '6' && c[1] == '4')
+            {
+                length = 'q';
+                c += 2;
+            }
+            else if (c[0] == '3' && c[1] == '2')
+            {
+                length = 0;
+                c += 2;
+            }
+        }
+
+        if (ptr + 9 > end)
+            break;
+
+        switch (*c)
+        {
+        case 'd':
+        case 'i':
+        {
+            int64_t value = 0;
+            switch (length)
+            {
+            case 'l':
+                value = va_arg(args, long);
+                break;
+            case 'q':
+                value = va_arg(args, long long);
+                break;
+            case 'j':
+                value = va_arg(args, intmax_t);
+                break;
+            case 'z':
+                value = (int64_t)va_arg(args, size_t);
+                break;
+            case 't':
+                value = va_arg(args, ptrdiff_t);
+                break;
+            case 'h':
+                value = (short)va_arg(args, int);
+                break;
+            case 'H':
+                value = (signed char)va_arg(args, int);
+                break;
+            default:
+                value = va_arg(args, int);
+                break;
+            }
+            ptr = putLogBinaryArg(ptr, 'i', (uint64_t)value);
+            break;
+        }
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+        {
+            uint64_t value = 0;
+            switch (length)
+            {
+            case 'l':
+                value = va_arg(args, unsigned long);
+                break;
+            case 'q':
+                value = va_arg(args, unsigned long long);
+                break;
+            case 'j':
+                value = va_arg(args, uintmax_t);
+                break;
+            case 'z':
+                value = va_arg(args, size_t);
+                break;
+            case 't':
+                value = (uint64_t)va_arg(args, ptrdiff_t);
+                break;
+            case 'h':
+                value = (unsigned short)va_arg(args, unsigned int);
+                break;
+            case 'H':
+                value = (unsigned char)va_arg(args, unsigned int);
+                break;
+            default:
+                value = va_arg(args, unsigned int);
+                break;
+            }
+            ptr = putLogBinaryArg(ptr, 'u', value);
+            break;
+        }
+        case 'c':
+            ptr = putLogBinaryArg(ptr, 'i', (uint64_t)(int64_t)va_arg(args, int));
+            break;
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+        {
+            double value = length == 'L' ? (double)va_arg(args, long double) : va_arg(args, double);
+            *ptr++ = 'f';
+            ptr = putLogBinaryValue(ptr, &value, sizeof(value));
+            break;
+        }
+        case 'p':
+            ptr = putLogBinaryArg(ptr, 'p', (uint64_t)(uintptr_t)va_arg(args, void*));
+            break;
+        case 's':
+        {
+            const char* str = va_arg(args, const char*);
+            if (!str)
+                str = "(null)";
+            // Precision limited strings do not have to be null terminated
+            uint32_t size = 0;
+            while ((precision < 0 || size < (uint32_t)precision) && str[size])
+                ++size;
+            size = TF_MIN(size, (uint32_t)(end - ptr) - 5);
+            *ptr++ = 's';
+            ptr = putLogBinaryValue(ptr, &size, sizeof(size));
+            ptr = putLogBinaryValue(ptr, str, size);
+            break;
+        }
+        case 'n':
+            // Nothing is written back
+            (void)va_arg(args, void*);
+            break;
+        default:
+            // Unknown conversion, the following arguments can't be located
+            return (uint32_t)(ptr - dst);
+        }
+
+        if (!*c)
+            break;
+    }
+    return (uint32_t)(ptr - dst);
+}
+
+// Called with mMutex held. Makes room for size bytes, returns true when the caller has to write the spare buffer
+static bool reserveBinaryLog(BinaryLog* pLog, uint32_t size)
+{
+    if (pLog->mSize + size <= LOG_BINARY_BUFFER_SIZE)
+        return false;
+
+    // Waits until the previous full buffer has been written, released by writeBinaryLogSpare
+    acquireMutex(&pLog->mWriteMutex);
+    uint8_t* pFull = pLog->pBuffer;
+    pLog->pBuffer = pLog->pSpareBuffer;
+    pLog->pSpareBuffer = pFull;
+    pLog->mSpareSize = pLog->mSize;
+    pLog->mSize = 0;
+    return true;
+}
+
+static void writeBinaryLogSpare(BinaryLog* pLog)
+{
+    fsWriteToStream(&pLog->mStream, pLog->pSpareBuffer, pLog->mSpareSize);
+    pLog->mSpareSize = 0;
+    releaseMutex(&pLog->mWriteMutex);
+}
+
+// Called with mMutex held
+static void defineBinaryLogString(BinaryLog* pLog, uint8_t type, uint64_t key, const char* str)
+{
+    uint32_t size = (uint32_t)strlen(str);
+    size = TF_MIN(size, LOG_BINARY_MAX_STRING);
+
+    uint8_t* ptr = pLog->pBuffer + pLog->mSize;
+    *ptr++ = type;
+    ptr = putLogBinaryValue(ptr, &key, sizeof(key));
+    ptr = putLogBinaryValue(ptr, &size, sizeof(size));
+    ptr = putLogBinaryValue(ptr, str, size);
+    pLog->mSize = (uint32_t)(ptr - pLog->pBuffer);
+}
+
+void writeBinaryLogVaList(uint32_t level, const char* filename, int line_number, const char* message, va_list args)
+{
+    BinaryLog* pLog = pBinaryLog;
+    level &= gLogger.mLogLevel;
+    if (!level)
+        return;
+    if (!pLog || !(pLog->mLevel & level))
+    {
+        writeLogVaList(level, filename, line_number, message, args);
+        return;
+    }
+    // Levels of a multi-level message which the binary log does not record still reach the callbacks
+    if (level & ~pLog->mLevel)
+    {
+        va_list textArgs;
+        va_copy(textArgs, args);
+        writeLogVaList(level & ~pLog->mLevel, filename, line_number, message, textArgs);
+        va_end(textArgs);
+    }
+    level &= pLog->mLevel;
+
+    uint8_t* pRecord = (uint8_t*)gLogBuffer;
+    uint64_t threadID = (uint64_t)getCurrentThreadID();
+    int64_t  timestamp = getUSec(false);
+    uint64_t file = (uint64_t)(uintptr_t)filename;
+    uint32_t line = (uint32_t)line_number;
+    uint64_t format = (uint64_t)(uintptr_t)message;
+
+    uint8_t* ptr = pRecord;
+    *ptr++ = LOG_BINARY_RECORD_MESSAGE;
+    ptr = putLogBinaryValue(ptr, &level, sizeof(level));
+    ptr = putLogBinaryValue(ptr, &timestamp, sizeof(timestamp));
+    ptr = putLogBinaryValue(ptr, &threadID, sizeof(threadID));
+    ptr = putLogBinaryValue(ptr, &file, sizeof(file));
+    ptr = putLogBinaryValue(ptr, &line, sizeof(line));
+    ptr = putLogBinaryValue(ptr, &format, sizeof(format));
+    uint32_t argsSize = encodeLogBinaryArgs(ptr + sizeof(uint32_t), sizeof(gLogBuffer) - LOG_BINARY_MESSAGE_SIZE, message, args);
+    ptr = putLogBinaryValue(ptr, &argsSize, sizeof(argsSize));
+    uint32_t recordSize = LOG_BINARY_MESSAGE_SIZE + argsSize;
+
+    char threadName[MAX_THREAD_NAME_LENGTH + 1] = { 0 };
+    bool defineThread = gBinaryLogThreadGeneration != pLog->mGeneration;
+    if (defineThread)
+    {
+        getCurrentThreadName(threadName, MAX_THREAD_NAME_LENGTH + 1);
+        gBinaryLogThreadGeneration = pLog->mGeneration;
+    }
+
+    acquireMutex(&pLog->mMutex);
+    bool defineFile = hmgeti(pLog->pStrings, file) < 0;
+    bool defineFormat = hmgeti(pLog->pStrings, format) < 0;
+    bool writeSpare = reserveBinaryLog(pLog, recordSize + (defineThread + defineFile + defineFormat) * LOG_BINARY_MAX_DEFINITION);
+    if (defineThread)
+        defineBinaryLogString(pLog, LOG_BINARY_RECORD_THREAD, threadID, threadName[0] ? threadName : "NoName");
+    if (defineFile)
+    {
+        hmput(pLog->pStrings, file, true);
+        defineBinaryLogString(pLog, LOG_BINARY_RECORD_STRING, file, filename);
+    }
+    if (defineFormat && format != file)
+    {
+        hmput(pLog->pStrings, format, true);
+        defineBinaryLogString(pLog, LOG_BINARY_RECORD_STRING, format, message);
+    }
+    memcpy(pLog->pBuffer + pLog->mSize, pRecord, recordSize);
+    pLog->mSize += recordSize;
+    releaseMutex(&pLog->mMutex);
+
+    if (writeSpare)
+        writeBinaryLogSpare(pLog);
+}
+
+void writeBinaryLog(uint32_t level, const char* filename, int line_number, const char* message, ...)
+{
+    va_list args;
+    va_start(args, message);
+    writeBinaryLogVaList(level, filename, line_number, message, args);
+    va_end(args);
+}
+
+bool addBinaryLogFile(const char* filename, LogLevel log_level)
+{
+    ASSERT(gIsLoggerInitialized);
+    if (pBinaryLog || !filename)
+        return false;
+
+    BinaryLog* pLog = (BinaryLog*)tf_calloc(1, sizeof(BinaryLog));
+    ASSERT(pLog);
+    if (!fsOpenStreamFromPath(RD_LOG, filename, FM_WRITE, &pLog->mStream))
+    {
+        writeLog(eERROR, __FILE__, __LINE__, "Failed to create binary log file %s", filename);
+        tf_free(pLog);
+        return false;
+    }
+
+    uint8_t  header[LOG_BINARY_HEADER_SIZE];
+    uint8_t* ptr = putLogBinaryValue(header, LOG_BINARY_MAGIC, 8);
+    uint32_t version = LOG_BINARY_VERSION;
+    uint32_t headerSize = LOG_BINARY_HEADER_SIZE;
+    int64_t  startTime = (int64_t)time(NULL);
+    int64_t  startUSec = getUSec(false);
+    ptr = putLogBinaryValue(ptr, &version, sizeof(version));
+    ptr = putLogBinaryValue(ptr, &headerSize, sizeof(headerSize));
+    ptr = putLogBinaryValue(ptr, &startTime, sizeof(startTime));
+    ptr = putLogBinaryValue(ptr, &startUSec, sizeof(startUSec));
+    fsWriteToStream(&pLog->mStream, header, sizeof(header));
+
+    initMutex(&pLog->mMutex);
+    initMutex(&pLog->mWriteMutex);
+    pLog->mLevel = log_level;
+    // Threads compare their generation with this to know whether their name is in the file
+    pLog->mGeneration = ++gBinaryLogGeneration;
+    pLog->pBuffer = (uint8_t*)tf_malloc(LOG_BINARY_BUFFER_SIZE);
+    pLog->pSpareBuffer = (uint8_t*)tf_malloc(LOG_BINARY_BUFFER_SIZE);
+    ASSERT(pLog->pBuffer && pLog->pSpareBuffer);
+
+    pBinaryLog = pLog;
+    writeLog(eINFO, __FILE__, __LINE__, "Opened binary log file %s", filename);
+    return true;
+}
+
+static void flushBinaryLog(void)
+{
+    BinaryLog* pLog = pBinaryLog;
+    if (!pLog)
+        return;
+
+    acquireMutex(&pLog->mMutex);
+    acquireMutex(&pLog->mWriteMutex);
+    fsWriteToStream(&pLog->mStream, pLog->pBuffer, pLog->mSize);
+    pLog->mSize = 0;
+    fsFlushStream(&pLog->mStream);
+    releaseMutex(&pLog->mWriteMutex);
+    releaseMutex(&pLog->mMutex);
+}
+
+void closeBinaryLogFile(void)
+{
+    BinaryLog* pLog = pBinaryLog;
+    if (!pLog)
+        return;
+
+    flushBinaryLog();
+    // Messages logged by other threads from now on go to the text callbacks
+    pBinaryLog = NULL;
+
+    fsCloseStream(&pLog->mStream);
+    exitMutex(&pLog->mWriteMutex);
+    exitMutex(&pLog->mMutex);
+    hmfree(pLog->pStrings);
+    tf_free(pLog->pSpareBuffer);
+    tf_free(pLog->pBuffer);
+    tf_free(pLog);
+}
+
 typedef char LogStr[LOG_LEVEL_SIZE + 1];
 
 void writeLogVaList(uint32_t level, const char* filename, int line_number, const char* message, va_list args)
@@ -263,20 +1013,8 @@ void writeLogVaList(uint32_t level, const char* filename, int line_number, const
     {
         strncpy(gLogBuffer + preable_end, logLevelPrefixes[log_levels[i]].second, LOG_LEVEL_SIZE);
 
-        if (gConsoleLogging)
-        {
-            _PrintUnicode(gLogBuffer, level & eERROR);
-        }
-
-        acquireMutex(&gLogger.mLogMutex);
-        {
-            for (LogCallback* pCallback = gLogger.pCallbacks; pCallback != gLogger.pCallbacks + gLogger.mCallbacksSize; ++pCallback)
-            {
-                if (pCallback->mLevel & logLevelPrefixes[log_levels[i]].first)
-                    pCallback->mCallback(pCallback->mUserData, gLogBuffer);
-            }
-        }
-        releaseMutex(&gLogger.mLogMutex);
+        if (!enqueueLog(logLevelPrefixes[log_levels[i]].first, level & eERROR, gLogBuffer, offset + 1))
+            dispatchLog(logLevelPrefixes[log_levels[i]].first, level & eERROR, gLogBuffer);
     }
 }
 
@@ -292,23 +1030,14 @@ void writeRawLog(uint32_t level, bool error, const char* message, ...)
 {
     va_list args;
     va_start(args, message);
-    vsnprintf(gLogBuffer, LOG_MAX_BUFFER, message, args);
+    int size = vsnprintf(gLogBuffer, LOG_MAX_BUFFER, message, args);
     va_end(args);
 
-    if (gConsoleLogging)
-    {
-        _PrintUnicode(gLogBuffer, error);
-    }
-
-    acquireMutex(&gLogger.mLogMutex);
-    {
-        for (LogCallback* pCallback = gLogger.pCallbacks; pCallback != gLogger.pCallbacks + gLogger.mCallbacksSize; ++pCallback)
-        {
-            if (pCallback->mLevel & level)
-                pCallback->mCallback(pCallback->mUserData, gLogBuffer);
-        }
-    }
-    releaseMutex(&gLogger.mLogMutex);
+    if (size < 0)
+        return;
+    size = size < LOG_MAX_BUFFER - 1 ? size : LOG_MAX_BUFFER - 1;
+    if (!enqueueLog(level, error, gLogBuffer, (uint32_t)size))
+        dispatchLog(level, error, gLogBuffer);
 }
 
 void _FailedAssert(const char* file, int line, const char* statement, const char* msgFmt, ...)
@@ -339,6 +1068,9 @@ void _FailedAssert(const char* file, int line, const char* statement, const char
             writeLog(eERROR, file, line, "Assert failed: %s\nAssert message: %s", statement, usrMsgBuf);
         else
             writeLog(eERROR, file, line, "Assert failed: %s", statement);
+
+        // The debugger may stop or terminate the process below, make sure the message reached the log file
+        flushLog();
     }
 
     _FailedAssertImpl(file, line, statement, usrMsgBuf[0] ? usrMsgBuf : NULL);
@@ -428,6 +1160,16 @@ void writeLog(uint32_t level, const char* filename, int line_number, const char*
 void writeLog(uint32_t level, const char* filename, int line_number, const char* message, ...) {}
 void writeRawLog(uint32_t level, bool error, const char* message, ...) {}
 
+void     enableAsyncLog(uint32_t recordCount, LogAsyncPolicy policy) {}
+void     disableAsyncLog(void) {}
+void     flushLog(void) {}
+uint64_t getAsyncLogDroppedCount(void) { return 0; }
+
+bool addBinaryLogFile(const char* filename, LogLevel log_level) { return false; }
+void closeBinaryLogFile(void) {}
+void writeBinaryLogVaList(uint32_t level, const char* filename, int line_number, const char* message, va_list args) {}
+void writeBinaryLog(uint32_t level, const char* filename, int line_number, const char* message, ...) {}
+
 void _FailedAssert(const char* file, int line, const char* statement, const char* msgFmt, ...) {}
 #endif
 
@@ -65,6 +65,14 @@ typedef void (*LogCallbackFn)(void* user_data, const char* message);
 typedef void (*LogCloseFn)(void* user_data);
 typedef void (*LogFlushFn)(void* user_data);
 
+typedef enum LogAsyncPolicy
+{
+    // Messages logged while the queue is full are dropped, the log thread reports how many were lost
+    LOG_ASYNC_POLICY_DROP = 0,
+    // Logging threads wait until the log thread made space in the queue
+    LOG_ASYNC_POLICY_BLOCK,
+} LogAsyncPolicy;
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -79,12 +87,36 @@ extern "C"
     FORGE_API void addLogCallback(const char* id, uint32_t log_level, void* user_data, LogCallbackFn callback, LogCloseFn close,
                                   LogFlushFn flush);
 
+    // Asynchronous mode: logging threads format the message and push it into a lock-free queue of recordCount fixed-size records
+    // (rounded up to a power of two), a background thread writes the console and runs the callbacks.
+    // Thread unsafe like initLog/exitLog, call after initLog. exitLog disables asynchronous mode.
+    FORGE_API void enableAsyncLog(uint32_t recordCount, LogAsyncPolicy policy);
+    // Writes every queued message and stops the log thread. No other thread may log while disableAsyncLog or exitLog run,
+    // a message being queued at that moment could be written into the freed queue.
+    FORGE_API void disableAsyncLog(void);
+    // Blocks until every message logged before the call has been passed to the callbacks, then flushes the callbacks and the
+    // binary log. Called on failed asserts and crashes.
+    FORGE_API void flushLog(void);
+    // Messages dropped by LOG_ASYNC_POLICY_DROP since enableAsyncLog
+    FORGE_API uint64_t getAsyncLogDroppedCount(void);
+
     FORGE_API void writeLogVaList(uint32_t level, const char* filename, int line_number, const char* message, va_list args);
     //+V576, function:writeLog, format_arg:4, ellipsis_arg:5
     FORGE_API void writeLog(uint32_t level, const char* filename, int line_number, const char* message, ...);
     //+V576, function:writeRawLog, format_arg:3, ellipsis_arg:4
     FORGE_API void writeRawLog(uint32_t level, bool error, const char* message, ...);
 
+    // Binary log: writeBinaryLog stores the format and file pointers, the raw arguments, a timestamp, the thread ID and the line
+    // into filename (RD_LOG) without formatting anything. Decode the file with Common_3/Tools/BinaryLog/BinaryLogDecoder.py.
+    // The format has to be a string literal. Messages whose level is missing in log_level, or that are logged while no binary log
+    // is open, are formatted and passed to the callbacks. Thread unsafe like initLog/exitLog, exitLog closes the binary log.
+    FORGE_API bool addBinaryLogFile(const char* filename, LogLevel log_level);
+    FORGE_API void closeBinaryLogFile(void);
+
+    FORGE_API void writeBinaryLogVaList(uint32_t level, const char* filename, int line_number, const char* message, va_list args);
+    //+V576, function:writeBinaryLog, format_arg:4, ellipsis_arg:5
+    FORGE_API void writeBinaryLog(uint32_t level, const char* filename, int line_number, const char* message, ...);
+
     //+V576, function:_FailedAssert, format_arg:4, ellipsis_arg:5
     FORGE_API void _FailedAssert(const char* file, int line, const char* statement, const char* msg, ...);
 
@@ -28,6 +28,15 @@
 
 #include "AlgorithmsImpl.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(ARCH_X86_FAMILY)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RADIX_NEON
+#endif
+
 #include "../../Utilities/Interfaces/IMemory.h"
 
 // SIMPLE SORT
@@ -399,3 +408,609 @@ void sortDouble(double* pData, size_t memberCount)
     double tmp;
     quickSortDouble(pData, pData + memberCount, &tmp);
 }
+
+// PARALLEL ALGORITHMS
+
+// Arrays smaller than this aren't split between threads
+#define PARALLEL_MIN_CHUNK_SIZE    16384
+// Merge sort builds runs of this size with insertion sort
+#define MERGE_SORT_RUN_SIZE        32
+// Number of output pieces per thread in parallel merge pass
+#define MERGE_PIECES_PER_THREAD    4
+#define RADIX_SORT_THRESHOLD       256
+
+static uint64_t parallelChunkCount(ThreadSystem threadSystem, size_t memberCount)
+{
+    struct ThreadSystemInfo info;
+    threadSystemGetInfo(threadSystem, &info);
+    uint64_t maxChunkCount = (memberCount + PARALLEL_MIN_CHUNK_SIZE - 1) / PARALLEL_MIN_CHUNK_SIZE;
+    return TF_MAX((uint64_t)1, TF_MIN(info.threadCount + 1, maxChunkCount));
+}
+
+struct ParallelCopyData
+{
+    char*       pDst;
+    const char* pSrc;
+    size_t      memberSize;
+};
+
+static void parallelCopyTask(void* pUser, uint64_t begin, uint64_t end, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    struct ParallelCopyData* pData = (struct ParallelCopyData*)pUser;
+    memcpy(pData->pDst + begin * pData->memberSize, pData->pSrc + begin * pData->memberSize, (end - begin) * pData->memberSize);
+}
+
+// Offset tables are stored after the elements in the same allocation, starting at the next size_t aligned offset
+static size_t parallelOffsetTableStart(size_t memberCount, size_t memberSize)
+{
+    return (memberCount * memberSize + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1);
+}
+
+static void parallelCopy(ThreadSystem threadSystem, void* pDst, const void* pSrc, size_t memberCount, size_t memberSize, uint64_t grainSize)
+{
+    struct ParallelCopyData data = { (char*)pDst, (const char*)pSrc, memberSize };
+    threadSystemParallelFor(threadSystem, memberCount, grainSize, parallelCopyTask, &data);
+}
+
+// PARALLEL MERGE SORT
+
+static void mergeRanges(const char* pA, size_t countA, const char* pB, size_t countB, char* pOut, size_t memberSize, LessFn less,
+                        void* pUserData)
+{
+    const char* pEndA = pA + countA * memberSize;
+    const char* pEndB = pB + countB * memberSize;
+    while (pA < pEndA && pB < pEndB)
+    {
+        // Equal elements are taken from A first to keep the sort stable
+        if (less(pB, pA, pUserData))
+        {
+            memcpy(pOut, pB, memberSize);
+            pB += memberSize;
+        }
+        else
+        {
+            memcpy(pOut, pA, memberSize);
+            pA += memberSize;
+        }
+        pOut += memberSize;
+    }
+    memcpy(pOut, pA, pEndA - pA);
+    pOut += pEndA - pA;
+    memcpy(pOut, pB, pEndB - pB);
+}
+
+// Returns how many elements of A are among the first outCount elements of stable merge of A and B
+static size_t mergeSplit(const char* pA, size_t countA, const char* pB, size_t countB, size_t outCount, size_t memberSize, LessFn less,
+                         void* pUserData)
+{
+    size_t lo = outCount > countB ? outCount - countB : 0;
+    size_t hi = TF_MIN(outCount, countA);
+    while (lo < hi)
+    {
+        size_t i = lo + (hi - lo) / 2;
+        size_t j = outCount - i;
+        // A[i] goes before B[j - 1], so more elements of A are needed
+        if (!less(pB + (j - 1) * memberSize, pA + i * memberSize, pUserData))
+            lo = i + 1;
+        else
+            hi = i;
+    }
+    return lo;
+}
+
+static void mergeSort(char* pData, char* pBuffer, size_t memberCount, size_t memberSize, LessFn less, void* pUserData)
+{
+    for (size_t i = 0; i < memberCount; i += MERGE_SORT_RUN_SIZE)
+        stableSort(pData + i * memberSize, TF_MIN((size_t)MERGE_SORT_RUN_SIZE, memberCount - i), memberSize, less, pUserData);
+
+    char* pSrc = pData;
+    char* pDst = pBuffer;
+    for (size_t runSize = MERGE_SORT_RUN_SIZE; runSize < memberCount; runSize *= 2)
+    {
+        for (size_t i = 0; i < memberCount; i += 2 * runSize)
+        {
+            size_t countA = TF_MIN(runSize, memberCount - i);
+            size_t countB = TF_MIN(runSize, memberCount - i - countA);
+            mergeRanges(pSrc + i * memberSize, countA, pSrc + (i + countA) * memberSize, countB, pDst + i * memberSize, memberSize, less,
+                        pUserData);
+        }
+        char* pTmp = pSrc;
+        pSrc = pDst;
+        pDst = pTmp;
+    }
+
+    if (pSrc != pData)
+        memcpy(pData, pSrc, memberCount * memberSize);
+}
+
+struct ParallelMergeSortData
+{
+    char*  pSrc;
+    char*  pDst;
+    size_t memberCount;
+    size_t memberSize;
+    LessFn less;
+    void*  pUserData;
+    // Size of sorted runs in pSrc
+    size_t runSize;
+};
+
+static void parallelMergeSortRunTask(void* pUser, uint64_t begin, uint64_t end, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    struct ParallelMergeSortData* pData = (struct ParallelMergeSortData*)pUser;
+    mergeSort(pData->pSrc + begin * pData->memberSize, pData->pDst + begin * pData->memberSize, end - begin, pData->memberSize, pData->less,
+              pData->pUserData);
+}
+
+// Merges pairs of runs from pSrc into pDst.
+// Every task writes the output range [begin, end), which can span several pairs of runs.
+static void parallelMergeTask(void* pUser, uint64_t begin, uint64_t end, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    struct ParallelMergeSortData* pData = (struct ParallelMergeSortData*)pUser;
+    const size_t                  memberSize = pData->memberSize;
+    const size_t                  pairSize = pData->runSize * 2;
+
+    for (size_t outBegin = (size_t)begin; outBegin < end;)
+    {
+        size_t      pairBegin = outBegin / pairSize * pairSize;
+        size_t      countA = TF_MIN(pData->runSize, pData->memberCount - pairBegin);
+        size_t      countB = TF_MIN(pData->runSize, pData->memberCount - pairBegin - countA);
+        size_t      outEnd = TF_MIN((size_t)end, pairBegin + countA + countB);
+        const char* pA = pData->pSrc + pairBegin * memberSize;
+        const char* pB = pA + countA * memberSize;
+
+        size_t beginA = mergeSplit(pA, countA, pB, countB, outBegin - pairBegin, memberSize, pData->less, pData->pUserData);
+        size_t endA = mergeSplit(pA, countA, pB, countB, outEnd - pairBegin, memberSize, pData->less, pData->pUserData);
+        size_t beginB = outBegin - pairBegin - beginA;
+        size_t endB = outEnd - pairBegin - endA;
+        mergeRanges(pA + beginA * memberSize, endA - beginA, pB + beginB * memberSize, endB - beginB, pData->pDst + outBegin * memberSize,
+                    memberSize, pData->less, pData->pUserData);
+
+        outBegin = outEnd;
+    }
+}
+
+void parallelStableSort(ThreadSystem threadSystem, void* pData, size_t memberCount, size_t memberSize, LessFn less, void* pUserData)
+{
+    if (memberCount <= MERGE_SORT_RUN_SIZE)
+    {
+        stableSort(pData, memberCount, memberSize, less, pUserData);
+        return;
+    }
+
+    char* pBuffer = (char*)tf_malloc(memberCount * memberSize);
+    if (!pBuffer)
+    {
+        LOGF(eERROR, "Failed to allocate %zu bytes for parallel stable sort", memberCount * memberSize);
+        stableSort(pData, memberCount, memberSize, less, pUserData);
+        return;
+    }
+
+    uint64_t chunkCount = parallelChunkCount(threadSystem, memberCount);
+
+    struct ParallelMergeSortData data = { 0 };
+    data.pSrc = (char*)pData;
+    data.pDst = pBuffer;
+    data.memberCount = memberCount;
+    data.memberSize = memberSize;
+    data.less = less;
+    data.pUserData = pUserData;
+    data.runSize = (memberCount + chunkCount - 1) / chunkCount;
+
+    // Every chunk is sorted into pData by a single thread
+    threadSystemParallelFor(threadSystem, memberCount, data.runSize, parallelMergeSortRunTask, &data);
+
+    // Then runs are merged pairwise, each merge is split between all threads
+    const uint64_t mergeGrainSize = TF_MAX((uint64_t)MERGE_SORT_RUN_SIZE, memberCount / (chunkCount * MERGE_PIECES_PER_THREAD));
+    for (; data.runSize < memberCount; data.runSize *= 2)
+    {
+        threadSystemParallelFor(threadSystem, memberCount, mergeGrainSize, parallelMergeTask, &data);
+        char* pTmp = data.pSrc;
+        data.pSrc = data.pDst;
+        data.pDst = pTmp;
+    }
+
+    if (data.pSrc != pData)
+        parallelCopy(threadSystem, pData, data.pSrc, memberCount, memberSize, (memberCount + chunkCount - 1) / chunkCount);
+
+    tf_free(pBuffer);
+}
+
+// PARALLEL PARTITION
+
+struct ParallelPartitionData
+{
+    char*       pData;
+    char*       pBuffer;
+    const char* pPivot;
+    uint64_t    pivot;
+    size_t      memberSize;
+    LessFn      less;
+    void*       pUserData;
+    uint64_t    grainSize;
+    // Per chunk count of elements less than pivot, converted to output offsets before scattering
+    size_t*     pLessOffsets;
+    size_t*     pGreaterOffsets;
+};
+
+static void parallelPartitionCountTask(void* pUser, uint64_t begin, uint64_t end, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    struct ParallelPartitionData* pData = (struct ParallelPartitionData*)pUser;
+    size_t                        lessCount = 0;
+    for (uint64_t i = begin; i < end; ++i)
+        lessCount += pData->less(pData->pData + i * pData->memberSize, pData->pPivot, pData->pUserData) ? 1 : 0;
+    pData->pLessOffsets[begin / pData->grainSize] = lessCount;
+}
+
+static void parallelPartitionScatterTask(void* pUser, uint64_t begin, uint64_t end, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    struct ParallelPartitionData* pData = (struct ParallelPartitionData*)pUser;
+    const size_t                  memberSize = pData->memberSize;
+    uint64_t                      chunk = begin / pData->grainSize;
+    char*                         pLess = pData->pBuffer + pData->pLessOffsets[chunk] * memberSize;
+    char*                         pGreater = pData->pBuffer + pData->pGreaterOffsets[chunk] * memberSize;
+    for (uint64_t i = begin; i < end; ++i)
+    {
+        if (i == pData->pivot)
+            continue;
+        const char* pCurrent = pData->pData + i * memberSize;
+        if (pData->less(pCurrent, pData->pPivot, pData->pUserData))
+        {
+            memcpy(pLess, pCurrent, memberSize);
+            pLess += memberSize;
+        }
+        else
+        {
+            memcpy(pGreater, pCurrent, memberSize);
+            pGreater += memberSize;
+        }
+    }
+}
+
+size_t parallelPartition(ThreadSystem threadSystem, void* pData, size_t pivot, size_t memberCount, size_t memberSize, LessFn less,
+                         void* pUserData)
+{
+    if (memberCount == 0)
+        return 0;
+
+    ASSERT(pivot < memberCount);
+    uint64_t     chunkCount = parallelChunkCount(threadSystem, memberCount);
+    const size_t offsetTableStart = parallelOffsetTableStart(memberCount, memberSize);
+    char*        pBuffer = (char*)tf_malloc(offsetTableStart + chunkCount * 2 * sizeof(size_t));
+    if (!pBuffer)
+    {
+        LOGF(eERROR, "Failed to allocate %zu bytes for parallel partition", memberCount * memberSize);
+        return partition(pData, pivot, memberCount, memberSize, less, pUserData);
+    }
+
+    struct ParallelPartitionData data = { 0 };
+    data.pData = (char*)pData;
+    data.pBuffer = pBuffer;
+    // pData isn't modified until everything is scattered into pBuffer, so pivot can stay in place
+    data.pPivot = (char*)pData + pivot * memberSize;
+    data.pivot = pivot;
+    data.memberSize = memberSize;
+    data.less = less;
+    data.pUserData = pUserData;
+    data.grainSize = (memberCount + chunkCount - 1) / chunkCount;
+    data.pLessOffsets = (size_t*)(pBuffer + offsetTableStart);
+    data.pGreaterOffsets = data.pLessOffsets + chunkCount;
+
+    threadSystemParallelFor(threadSystem, memberCount, data.grainSize, parallelPartitionCountTask, &data);
+
+    chunkCount = (memberCount + data.grainSize - 1) / data.grainSize;
+    size_t lessTotal = 0;
+    for (uint64_t i = 0; i < chunkCount; ++i)
+        lessTotal += data.pLessOffsets[i];
+
+    // Less elements go to [0, lessTotal), pivot to lessTotal, the rest after it
+    size_t lessOffset = 0;
+    size_t greaterOffset = lessTotal + 1;
+    for (uint64_t i = 0; i < chunkCount; ++i)
+    {
+        size_t lessCount = data.pLessOffsets[i];
+        size_t chunkBegin = (size_t)(i * data.grainSize);
+        size_t chunkSize = TF_MIN((size_t)data.grainSize, memberCount - chunkBegin);
+        // Pivot is never less than itself, but it isn't scattered with the rest of the elements
+        size_t greaterCount = chunkSize - lessCount - ((pivot >= chunkBegin && pivot < chunkBegin + chunkSize) ? 1 : 0);
+        data.pLessOffsets[i] = lessOffset;
+        data.pGreaterOffsets[i] = greaterOffset;
+        lessOffset += lessCount;
+        greaterOffset += greaterCount;
+    }
+
+    threadSystemParallelFor(threadSystem, memberCount, data.grainSize, parallelPartitionScatterTask, &data);
+    memcpy(pBuffer + lessTotal * memberSize, data.pPivot, memberSize);
+    parallelCopy(threadSystem, pData, pBuffer, memberCount, memberSize, data.grainSize);
+
+    tf_free(pBuffer);
+    return lessTotal;
+}
+
+// PARALLEL RADIX SORT
+
+struct ParallelRadixSortData
+{
+    void*    pSrc;
+    void*    pDst;
+    uint64_t grainSize;
+    uint32_t shift;
+    // RADIX_SIZE counters per chunk, converted to output offsets before scattering
+    size_t*  pOffsets;
+};
+
+// Returns false without touching pArr if the scratch buffer couldn't be allocated
+static bool parallelRadixSort(ThreadSystem threadSystem, void* pArr, size_t memberCount, size_t memberSize, ParallelForFunc histogramTask,
+                              ParallelForFunc scatterTask)
+{
+    uint64_t chunkCount = parallelChunkCount(threadSystem, memberCount);
+    uint64_t grainSize = (memberCount + chunkCount - 1) / chunkCount;
+    chunkCount = (memberCount + grainSize - 1) / grainSize;
+
+    const size_t offsetTableStart = parallelOffsetTableStart(memberCount, memberSize);
+    char*        pBuffer = (char*)tf_malloc(offsetTableStart + chunkCount * RADIX_SIZE * sizeof(size_t));
+    if (!pBuffer)
+    {
+        LOGF(eERROR, "Failed to allocate %zu bytes for parallel radix sort", memberCount * memberSize);
+        return false;
+    }
+
+    struct ParallelRadixSortData data = { 0 };
+    data.pSrc = pArr;
+    data.pDst = pBuffer;
+    data.grainSize = grainSize;
+    data.pOffsets = (size_t*)(pBuffer + offsetTableStart);
+
+    for (uint32_t shift = 0; shift < memberSize * 8; shift += RADIX_BITS)
+    {
+        data.shift = shift;
+        threadSystemParallelFor(threadSystem, memberCount, grainSize, histogramTask, &data);
+
+        // Digit major order: chunk writes its elements after elements of previous chunks with the same digit
+        size_t offset = 0;
+        bool   sameDigit = false;
+        for (uint32_t digit = 0; digit < RADIX_SIZE; ++digit)
+        {
+            size_t digitCount = 0;
+            for (uint64_t chunk = 0; chunk < chunkCount; ++chunk)
+            {
+                size_t count = data.pOffsets[chunk * RADIX_SIZE + digit];
+                data.pOffsets[chunk * RADIX_SIZE + digit] = offset;
+                offset += count;
+                digitCount += count;
+            }
+            sameDigit |= digitCount == memberCount;
+        }
+
+        // All elements have the same digit, pass wouldn't change anything
+        if (sameDigit)
+            continue;
+
+        threadSystemParallelFor(threadSystem, memberCount, grainSize, scatterTask, &data);
+        void* pTmp = data.pSrc;
+        data.pSrc = data.pDst;
+        data.pDst = pTmp;
+    }
+
+    if (data.pSrc != pArr)
+        parallelCopy(threadSystem, pArr, data.pSrc, memberCount, memberSize, grainSize);
+
+    tf_free(pBuffer);
+    return true;
+}
+
+#define DEFINE_PARALLEL_RADIX_SORT_FUNCTION(suffix, type, utype, KEY)                                                        \
+    static void CONCAT(parallelRadixHistogramTask, suffix)(void* pUser, uint64_t begin, uint64_t end, uint64_t threadId)     \
+    {                                                                                                                        \
+        UNREF_PARAM(threadId);                                                                                               \
+        struct ParallelRadixSortData* pData = (struct ParallelRadixSortData*)pUser;                                          \
+        const utype*                  pSrc = (const utype*)pData->pSrc;                                                      \
+        size_t*                       pHistogram = pData->pOffsets + (begin / pData->grainSize) * RADIX_SIZE;                \
+        const uint32_t                shift = pData->shift;                                                                  \
+        memset(pHistogram, 0, RADIX_SIZE * sizeof(size_t));                                                                  \
+        for (uint64_t i = begin; i < end; ++i)                                                                               \
+            ++pHistogram[(KEY(utype, pSrc[i]) >> shift) & RADIX_MASK];                                                       \
+    }                                                                                                                        \
+    static void CONCAT(parallelRadixScatterTask, suffix)(void* pUser, uint64_t begin, uint64_t end, uint64_t threadId)       \
+    {                                                                                                                        \
+        UNREF_PARAM(threadId);                                                                                               \
+        struct ParallelRadixSortData* pData = (struct ParallelRadixSortData*)pUser;                                          \
+        const utype*                  pSrc = (const utype*)pData->pSrc;                                                      \
+        utype*                        pDst = (utype*)pData->pDst;                                                            \
+        size_t*                       pOffsets = pData->pOffsets + (begin / pData->grainSize) * RADIX_SIZE;                  \
+        const uint32_t                shift = pData->shift;                                                                  \
+        for (uint64_t i = begin; i < end; ++i)                                                                               \
+        {                                                                                                                    \
+            utype value = pSrc[i];                                                                                           \
+            pDst[pOffsets[(KEY(utype, value) >> shift) & RADIX_MASK]++] = value;                                             \
+        }                                                                                                                    \
+    }                                                                                                                        \
+    void CONCAT(parallelSort, suffix)(ThreadSystem threadSystem, type * pData, size_t memberCount)                           \
+    {                                                                                                                        \
+        /* Small arrays and failed scratch allocations fall back to the serial sort */                                       \
+        if (memberCount <= RADIX_SORT_THRESHOLD ||                                                                           \
+            !parallelRadixSort(threadSystem, pData, memberCount, sizeof(type),                                               \
+                               CONCAT(parallelRadixHistogramTask, suffix), CONCAT(parallelRadixScatterTask, suffix)))        \
+            CONCAT(sort, suffix)(pData, memberCount);                                                                        \
+    }
+
+DEFINE_PARALLEL_RADIX_SORT_FUNCTION(Int8, int8_t, uint8_t, RADIX_KEY_SIGNED)
+DEFINE_PARALLEL_RADIX_SORT_FUNCTION(Int16, int16_t, uint16_t, RADIX_KEY_SIGNED)
+DEFINE_PARALLEL_RADIX_SORT_FUNCTION(Int32, int32_t, uint32_t, RADIX_KEY_SIGNED)
+DEFINE_PARALLEL_RADIX_SORT_FUNCTION(Int64, int64_t, uint64_t, RADIX_KEY_SIGNED)
+
+DEFINE_PARALLEL_RADIX_SORT_FUNCTION(UInt8, uint8_t, uint8_t, RADIX_KEY_UNSIGNED)
+DEFINE_PARALLEL_RADIX_SORT_FUNCTION(UInt16, uint16_t, uint16_t, RADIX_KEY_UNSIGNED)
+DEFINE_PARALLEL_RADIX_SORT_FUNCTION(UInt32, uint32_t, uint32_t, RADIX_KEY_UNSIGNED)
+DEFINE_PARALLEL_RADIX_SORT_FUNCTION(UInt64, uint64_t, uint64_t, RADIX_KEY_UNSIGNED)
+
+DEFINE_PARALLEL_RADIX_SORT_FUNCTION(Float, float, uint32_t, RADIX_KEY_FLOAT)
+DEFINE_PARALLEL_RADIX_SORT_FUNCTION(Double, double, uint64_t, RADIX_KEY_FLOAT)
+
+// KEY/VALUE RADIX SORT
+
+// Keys are converted in blocks, digits of a block are counted while it's still in cache
+#define RADIX_PREPARE_BLOCK_SIZE 1024
+
+static void radixCountDigitsUInt32(const uint32_t* pBits, size_t begin, size_t end, size_t* pHistograms)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        uint32_t bits = pBits[i];
+        ++pHistograms[0 * RADIX_SIZE + (bits & RADIX_MASK)];
+        ++pHistograms[1 * RADIX_SIZE + ((bits >> 8) & RADIX_MASK)];
+        ++pHistograms[2 * RADIX_SIZE + ((bits >> 16) & RADIX_MASK)];
+        ++pHistograms[3 * RADIX_SIZE + (bits >> 24)];
+    }
+}
+
+static void radixCountDigitsUInt64(const uint64_t* pBits, size_t begin, size_t end, size_t* pHistograms)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        uint64_t bits = pBits[i];
+        for (uint32_t pass = 0; pass < 8; ++pass)
+            ++pHistograms[pass * RADIX_SIZE + (size_t)((bits >> (pass * RADIX_BITS)) & RADIX_MASK)];
+    }
+}
+
+static void radixPrepareBitsUInt32(const uint32_t* pKeys, uint32_t* pBits, size_t memberCount, size_t* pHistograms)
+{
+    for (size_t begin = 0; begin < memberCount; begin += RADIX_PREPARE_BLOCK_SIZE)
+    {
+        size_t end = TF_MIN(begin + RADIX_PREPARE_BLOCK_SIZE, memberCount);
+        memcpy(pBits + begin, pKeys + begin, (end - begin) * sizeof(uint32_t));
+        radixCountDigitsUInt32(pBits, begin, end, pHistograms);
+    }
+}
+
+static void radixPrepareBitsUInt64(const uint64_t* pKeys, uint64_t* pBits, size_t memberCount, size_t* pHistograms)
+{
+    for (size_t begin = 0; begin < memberCount; begin += RADIX_PREPARE_BLOCK_SIZE)
+    {
+        size_t end = TF_MIN(begin + RADIX_PREPARE_BLOCK_SIZE, memberCount);
+        memcpy(pBits + begin, pKeys + begin, (end - begin) * sizeof(uint64_t));
+        radixCountDigitsUInt64(pBits, begin, end, pHistograms);
+    }
+}
+
+// Same as RADIX_KEY_FLOAT: sign mask is broadcasted with arithmetic shift and ored with the sign bit
+static void radixPrepareBitsFloat(const float* pKeys, uint32_t* pBits, size_t memberCount, size_t* pHistograms)
+{
+    for (size_t begin = 0; begin < memberCount; begin += RADIX_PREPARE_BLOCK_SIZE)
+    {
+        size_t end = TF_MIN(begin + RADIX_PREPARE_BLOCK_SIZE, memberCount);
+        size_t i = begin;
+#if defined(__AVX2__)
+        const __m256i signBit = _mm256_set1_epi32(INT32_MIN);
+        for (; i + 8 <= end; i += 8)
+        {
+            __m256i bits = _mm256_loadu_si256((const __m256i*)(pKeys + i));
+            __m256i mask = _mm256_or_si256(_mm256_srai_epi32(bits, 31), signBit);
+            _mm256_storeu_si256((__m256i*)(pBits + i), _mm256_xor_si256(bits, mask));
+        }
+#elif defined(ARCH_X86_FAMILY)
+        const __m128i signBit = _mm_set1_epi32(INT32_MIN);
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128i bits = _mm_loadu_si128((const __m128i*)(pKeys + i));
+            __m128i mask = _mm_or_si128(_mm_srai_epi32(bits, 31), signBit);
+            _mm_storeu_si128((__m128i*)(pBits + i), _mm_xor_si128(bits, mask));
+        }
+#elif defined(RADIX_NEON)
+        const int32x4_t signBit = vdupq_n_s32(INT32_MIN);
+        for (; i + 4 <= end; i += 4)
+        {
+            int32x4_t bits = vld1q_s32((const int32_t*)(pKeys + i));
+            int32x4_t mask = vorrq_s32(vshrq_n_s32(bits, 31), signBit);
+            vst1q_u32(pBits + i, vreinterpretq_u32_s32(veorq_s32(bits, mask)));
+        }
+#endif
+        for (; i < end; ++i)
+        {
+            uint32_t bits;
+            memcpy(&bits, &pKeys[i], sizeof(bits));
+            pBits[i] = RADIX_KEY_FLOAT(uint32_t, bits);
+        }
+        radixCountDigitsUInt32(pBits, begin, end, pHistograms);
+    }
+}
+
+static void radixPrepareBitsDouble(const double* pKeys, uint64_t* pBits, size_t memberCount, size_t* pHistograms)
+{
+    for (size_t begin = 0; begin < memberCount; begin += RADIX_PREPARE_BLOCK_SIZE)
+    {
+        size_t end = TF_MIN(begin + RADIX_PREPARE_BLOCK_SIZE, memberCount);
+        size_t i = begin;
+#if defined(__AVX2__)
+        const __m256i signBit = _mm256_set1_epi64x(INT64_MIN);
+        for (; i + 4 <= end; i += 4)
+        {
+            __m256i bits = _mm256_loadu_si256((const __m256i*)(pKeys + i));
+            // No 64 bit arithmetic shift before AVX-512, high dword sign is copied to both halves
+            __m256i sign = _mm256_shuffle_epi32(_mm256_srai_epi32(bits, 31), _MM_SHUFFLE(3, 3, 1, 1));
+            _mm256_storeu_si256((__m256i*)(pBits + i), _mm256_xor_si256(bits, _mm256_or_si256(sign, signBit)));
+        }
+#elif defined(ARCH_X86_FAMILY)
+        const __m128i signBit = _mm_set1_epi64x(INT64_MIN);
+        for (; i + 2 <= end; i += 2)
+        {
+            __m128i bits = _mm_loadu_si128((const __m128i*)(pKeys + i));
+            __m128i sign = _mm_shuffle_epi32(_mm_srai_epi32(bits, 31), _MM_SHUFFLE(3, 3, 1, 1));
+            _mm_storeu_si128((__m128i*)(pBits + i), _mm_xor_si128(bits, _mm_or_si128(sign, signBit)));
+        }
+#elif defined(RADIX_NEON)
+        const int64x2_t signBit = vdupq_n_s64(INT64_MIN);
+        for (; i + 2 <= end; i += 2)
+        {
+            int64x2_t bits = vld1q_s64((const int64_t*)(pKeys + i));
+            int64x2_t mask = vorrq_s64(vshrq_n_s64(bits, 63), signBit);
+            vst1q_u64(pBits + i, vreinterpretq_u64_s64(veorq_s64(bits, mask)));
+        }
+#endif
+        for (; i < end; ++i)
+        {
+            uint64_t bits;
+            memcpy(&bits, &pKeys[i], sizeof(bits));
+            pBits[i] = RADIX_KEY_FLOAT(uint64_t, bits);
+        }
+        radixCountDigitsUInt64(pBits, begin, end, pHistograms);
+    }
+}
+
+void sortUInt32KeyValue(uint32_t* pKeys, uint32_t* pValues, size_t memberCount)
+{
+    RADIX_SORT_KEY_VALUE_IMPL(uint32_t, uint32_t, uint32_t, pKeys, pValues, memberCount, radixPrepareBitsUInt32, RADIX_KEY_UNSIGNED,
+                              RADIX_KEY_UNSIGNED)
+}
+void sortUInt64KeyValue(uint64_t* pKeys, uint64_t* pValues, size_t memberCount)
+{
+    RADIX_SORT_KEY_VALUE_IMPL(uint64_t, uint64_t, uint64_t, pKeys, pValues, memberCount, radixPrepareBitsUInt64, RADIX_KEY_UNSIGNED,
+                              RADIX_KEY_UNSIGNED)
+}
+
+void sortUInt32KeyIndex(uint32_t* pKeys, uint32_t* pIndices, size_t memberCount)
+{
+    RADIX_SORT_KEY_VALUE_IMPL(uint32_t, uint32_t, uint32_t, pKeys, pIndices, memberCount, radixPrepareBitsUInt32, RADIX_KEY_UNSIGNED,
+                              RADIX_KEY_UNSIGNED)
+}
+void sortUInt64KeyIndex(uint64_t* pKeys, uint32_t* pIndices, size_t memberCount)
+{
+    RADIX_SORT_KEY_VALUE_IMPL(uint64_t, uint64_t, uint32_t, pKeys, pIndices, memberCount, radixPrepareBitsUInt64, RADIX_KEY_UNSIGNED,
+                              RADIX_KEY_UNSIGNED)
+}
+void sortFloatKeyIndex(float* pKeys, uint32_t* pIndices, size_t memberCount)
+{
+    RADIX_SORT_KEY_VALUE_IMPL(float, uint32_t, uint32_t, pKeys, pIndices, memberCount, radixPrepareBitsFloat, RADIX_KEY_FLOAT,
+                              RADIX_KEY_FLOAT_INVERSE)
+}
+void sortDoubleKeyIndex(double* pKeys, uint32_t* pIndices, size_t memberCount)
+{
+    RADIX_SORT_KEY_VALUE_IMPL(double, uint64_t, uint32_t, pKeys, pIndices, memberCount, radixPrepareBitsDouble, RADIX_KEY_FLOAT,
+                              RADIX_KEY_FLOAT_INVERSE)
+}
@@ -27,6 +27,8 @@
 
 #include <stdbool.h>
 
+#include "../Threading/ThreadSystem.h"
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -89,6 +91,51 @@ extern "C"
     size_t partitionFloat(float* pData, size_t pivot, size_t memberCount);
     size_t partitionDouble(double* pData, size_t pivot, size_t memberCount);
 
+    /*
+     * Key/value C algorithms
+     * Stable LSD radix sort of pKeys, pValues[i] / pIndices[i] is moved together with pKeys[i].
+     * Floating point keys are ordered by their bits, same as parallelSortFloat.
+     * Falls back to an in place insertion sort if the temporary buffers can't be allocated.
+     * Use DEFINE_RADIX_SORT_KEY_VALUE_FUNCTION from AlgorithmsImpl to create other key/value combinations
+     */
+
+    void sortUInt32KeyValue(uint32_t* pKeys, uint32_t* pValues, size_t memberCount);
+    void sortUInt64KeyValue(uint64_t* pKeys, uint64_t* pValues, size_t memberCount);
+
+    void sortUInt32KeyIndex(uint32_t* pKeys, uint32_t* pIndices, size_t memberCount);
+    void sortUInt64KeyIndex(uint64_t* pKeys, uint32_t* pIndices, size_t memberCount);
+    void sortFloatKeyIndex(float* pKeys, uint32_t* pIndices, size_t memberCount);
+    void sortDoubleKeyIndex(double* pKeys, uint32_t* pIndices, size_t memberCount);
+
+    /*
+     * Parallel C algorithms
+     * Work is split between the calling thread and the workers of threadSystem.
+     * NULL threadSystem runs everything on the calling thread.
+     * All of them allocate a temporary buffer of memberCount * memberSize bytes, the serial version runs if that fails.
+     */
+
+    // Merge sort, same contract as stableSort
+    void parallelStableSort(ThreadSystem threadSystem, void* pData, size_t memberCount, size_t memberSize, LessFn less, void* pUserData);
+
+    // Same contract as partition, additionally keeps relative order of elements on both sides of the pivot
+    size_t parallelPartition(ThreadSystem threadSystem, void* pData, size_t pivot, size_t memberCount, size_t memberSize, LessFn less,
+                             void* pUserData);
+
+    // Stable LSD radix sort, arrays of up to 256 elements fall back to sort<Type>.
+    // Radix sort orders floating point values by their bits: -NaN < -Inf < ... < -0 < +0 < ... < +Inf < +NaN
+    void parallelSortInt8(ThreadSystem threadSystem, int8_t* pData, size_t memberCount);
+    void parallelSortInt16(ThreadSystem threadSystem, int16_t* pData, size_t memberCount);
+    void parallelSortInt32(ThreadSystem threadSystem, int32_t* pData, size_t memberCount);
+    void parallelSortInt64(ThreadSystem threadSystem, int64_t* pData, size_t memberCount);
+
+    void parallelSortUInt8(ThreadSystem threadSystem, uint8_t* pData, size_t memberCount);
+    void parallelSortUInt16(ThreadSystem threadSystem, uint16_t* pData, size_t memberCount);
+    void parallelSortUInt32(ThreadSystem threadSystem, uint32_t* pData, size_t memberCount);
+    void parallelSortUInt64(ThreadSystem threadSystem, uint64_t* pData, size_t memberCount);
+
+    void parallelSortFloat(ThreadSystem threadSystem, float* pData, size_t memberCount);
+    void parallelSortDouble(ThreadSystem threadSystem, double* pData, size_t memberCount);
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
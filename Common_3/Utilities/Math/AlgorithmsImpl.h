@@ -29,6 +29,9 @@
 #define QUICKSORT_THRESHOLD  30
 #define SIMPLESORT_THRESHOLD 4
 #define TMP_BUF_STACK_SIZE   256
+#define RADIX_BITS           8
+#define RADIX_SIZE           (1 << RADIX_BITS)
+#define RADIX_MASK           (RADIX_SIZE - 1)
 
 // PVS-Studio warning suppression
 //-V:DEFINE_SORT_ALGORITHMS_FOR_TYPE:769
@@ -116,6 +119,29 @@
         quickSortImplFn(pData, pData + memberCount, &tmp);               \
     }
 
+/*
+ * Generates definitions for following functions:
+ *
+ * attrs void fnName (keyType* pKeys, valueType* pValues, size_t memberCount)
+ *	stable LSD radix sort of keys, pValues[i] is moved together with pKeys[i]
+ *	keys are reinterpreted as bitsType (unsigned integer of the same size)
+ *	TO_ORDERED(bitsType, bits) maps key bits to unsigned value with the same order,
+ *	FROM_ORDERED(bitsType, bits) is the inverse mapping (RADIX_KEY_* macros below)
+ *
+ * static void fnName##PrepareBits (const keyType* pKeys, bitsType* pBits, size_t memberCount, size_t* pHistograms)
+ *	implementation function, converts keys with TO_ORDERED and counts digits for all passes
+ */
+#define DEFINE_RADIX_SORT_KEY_VALUE_FUNCTION(attrs, fnName, keyType, bitsType, valueType, TO_ORDERED, FROM_ORDERED)         \
+    static void CONCAT(fnName, PrepareBits)(const keyType* pKeys, bitsType* pBits, size_t memberCount, size_t* pHistograms) \
+    {                                                                                                                       \
+        RADIX_PREPARE_BITS_IMPL(bitsType, pKeys, pBits, 0, memberCount, pHistograms, TO_ORDERED)                            \
+    }                                                                                                                       \
+    attrs void fnName(keyType* pKeys, valueType* pValues, size_t memberCount)                                               \
+    {                                                                                                                       \
+        RADIX_SORT_KEY_VALUE_IMPL(keyType, bitsType, valueType, pKeys, pValues, memberCount, CONCAT(fnName, PrepareBits),   \
+                                  TO_ORDERED, FROM_ORDERED)                                                                 \
+    }
+
 #define CONCAT(x, y)      CONCAT_IMPL(x, y)
 #define CONCAT_IMPL(x, y) x##y
 
@@ -255,6 +281,9 @@
         if (LESS(pCurrent, pPivot))                                                                \
         {                                                                                          \
             SWAP(pCurrent, pNewPivot, tmp, COPY);                                                  \
+            /* pivot itself could have been swapped */                                             \
+            if (pNewPivot == pPivot)                                                               \
+                pPivot = pCurrent;                                                                 \
             PTR_INC(pNewPivot);                                                                    \
         }                                                                                          \
     }                                                                                              \
@@ -329,3 +358,116 @@
     pPivot = PARTITION_IMPL_FN(pBegin, pEnd, pPivot);                                                                              \
     QUICKSORT_IMPL_FN(pBegin, pPivot, tmp);                                                                                        \
     QUICKSORT_IMPL_FN(PTR_ADD(pPivot, 1), pEnd, tmp);
+
+// RADIX SORT
+
+// Map unsigned integer bits of a key to unsigned value with the same order and back
+#define RADIX_SIGN_BIT(bitsType)           ((bitsType)1 << (sizeof(bitsType) * 8 - 1))
+#define RADIX_KEY_UNSIGNED(bitsType, bits) (bits)
+#define RADIX_KEY_SIGNED(bitsType, bits)   ((bitsType)((bits) ^ RADIX_SIGN_BIT(bitsType)))
+// Negative floats get all bits flipped, positive ones only the sign bit
+#define RADIX_KEY_FLOAT(bitsType, bits)                                                                        \
+    ((bitsType)((bits) ^ ((bitsType)(0 - ((bits) >> (sizeof(bitsType) * 8 - 1))) | RADIX_SIGN_BIT(bitsType))))
+#define RADIX_KEY_FLOAT_INVERSE(bitsType, bits)                                                                \
+    ((bitsType)((bits) ^ ((bitsType)(((bits) >> (sizeof(bitsType) * 8 - 1)) - 1) | RADIX_SIGN_BIT(bitsType))))
+
+// Converts keys in range [begin, end) and counts digits of every pass
+#define RADIX_PREPARE_BITS_IMPL(bitsType, pKeys, pBits, begin, end, pHistograms, TO_ORDERED)           \
+    for (size_t i = (begin); i < (end); ++i)                                                           \
+    {                                                                                                  \
+        bitsType bits;                                                                                 \
+        memcpy(&bits, &(pKeys)[i], sizeof(bits));                                                      \
+        bits = TO_ORDERED(bitsType, bits);                                                             \
+        (pBits)[i] = bits;                                                                             \
+        for (uint32_t pass = 0; pass < sizeof(bitsType) * 8 / RADIX_BITS; ++pass)                      \
+            ++(pHistograms)[pass * RADIX_SIZE + (size_t)((bits >> (pass * RADIX_BITS)) & RADIX_MASK)]; \
+    }
+
+// Stable insertion sort of keys and values in place, used when radix sort buffers can't be allocated
+#define INSERTION_SORT_KEY_VALUE_IMPL(keyType, bitsType, valueType, pKeys, pValues, memberCount, TO_ORDERED)                \
+    for (size_t i = 1; i < (memberCount); ++i)                                                                              \
+    {                                                                                                                       \
+        keyType   key = (pKeys)[i];                                                                                         \
+        valueType value = (pValues)[i];                                                                                     \
+        bitsType  bits;                                                                                                     \
+        memcpy(&bits, &key, sizeof(bits));                                                                                  \
+        bits = TO_ORDERED(bitsType, bits);                                                                                  \
+        size_t j = i;                                                                                                       \
+        for (; j > 0; --j)                                                                                                  \
+        {                                                                                                                   \
+            bitsType prevBits;                                                                                              \
+            memcpy(&prevBits, &(pKeys)[j - 1], sizeof(prevBits));                                                           \
+            if (TO_ORDERED(bitsType, prevBits) <= bits)                                                                     \
+                break;                                                                                                      \
+            (pKeys)[j] = (pKeys)[j - 1];                                                                                    \
+            (pValues)[j] = (pValues)[j - 1];                                                                                \
+        }                                                                                                                   \
+        (pKeys)[j] = key;                                                                                                   \
+        (pValues)[j] = value;                                                                                               \
+    }
+
+#define RADIX_SORT_KEY_VALUE_IMPL(keyType, bitsType, valueType, pKeys, pValues, memberCount, PREPARE_BITS_FN, TO_ORDERED,   \
+                                  FROM_ORDERED)                                                                             \
+    COMPILE_ASSERT(sizeof(keyType) == sizeof(bitsType));                                                                    \
+    if (memberCount < 2)                                                                                                    \
+        return;                                                                                                             \
+                                                                                                                            \
+    size_t     histograms[sizeof(bitsType) * 8 / RADIX_BITS * RADIX_SIZE] = { 0 };                                          \
+    bitsType*  pBitsBuffer = (bitsType*)tf_malloc(sizeof(bitsType) * 2 * memberCount);                                      \
+    valueType* pValuesBuffer = (valueType*)tf_malloc(sizeof(valueType) * memberCount);                                      \
+    if (!pBitsBuffer || !pValuesBuffer)                                                                                     \
+    {                                                                                                                       \
+        LOGF(eERROR, "Failed to allocate radix sort buffers for %zu elements, using insertion sort", (size_t)memberCount);  \
+        tf_free(pBitsBuffer);                                                                                               \
+        tf_free(pValuesBuffer);                                                                                             \
+        INSERTION_SORT_KEY_VALUE_IMPL(keyType, bitsType, valueType, pKeys, pValues, memberCount, TO_ORDERED)                \
+        return;                                                                                                             \
+    }                                                                                                                       \
+    PREPARE_BITS_FN(pKeys, pBitsBuffer, memberCount, histograms);                                                           \
+                                                                                                                            \
+    bitsType*  pSrcBits = pBitsBuffer;                                                                                      \
+    bitsType*  pDstBits = pBitsBuffer + memberCount;                                                                        \
+    valueType* pSrcValues = pValues;                                                                                        \
+    valueType* pDstValues = pValuesBuffer;                                                                                  \
+    for (uint32_t pass = 0; pass < sizeof(bitsType) * 8 / RADIX_BITS; ++pass)                                               \
+    {                                                                                                                       \
+        const uint32_t shift = pass * RADIX_BITS;                                                                           \
+        size_t*        pOffsets = &histograms[pass * RADIX_SIZE];                                                           \
+        /* all keys have the same digit, pass wouldn't change anything */                                                   \
+        if (pOffsets[(pSrcBits[0] >> shift) & RADIX_MASK] == memberCount)                                                   \
+            continue;                                                                                                       \
+                                                                                                                            \
+        size_t offset = 0;                                                                                                  \
+        for (uint32_t digit = 0; digit < RADIX_SIZE; ++digit)                                                               \
+        {                                                                                                                   \
+            size_t count = pOffsets[digit];                                                                                 \
+            pOffsets[digit] = offset;                                                                                       \
+            offset += count;                                                                                                \
+        }                                                                                                                   \
+                                                                                                                            \
+        for (size_t i = 0; i < memberCount; ++i)                                                                            \
+        {                                                                                                                   \
+            bitsType bits = pSrcBits[i];                                                                                    \
+            size_t   dst = pOffsets[(bits >> shift) & RADIX_MASK]++;                                                        \
+            pDstBits[dst] = bits;                                                                                           \
+            pDstValues[dst] = pSrcValues[i];                                                                                \
+        }                                                                                                                   \
+                                                                                                                            \
+        bitsType* pTmpBits = pSrcBits;                                                                                      \
+        pSrcBits = pDstBits;                                                                                                \
+        pDstBits = pTmpBits;                                                                                                \
+        valueType* pTmpValues = pSrcValues;                                                                                 \
+        pSrcValues = pDstValues;                                                                                            \
+        pDstValues = pTmpValues;                                                                                            \
+    }                                                                                                                       \
+                                                                                                                            \
+    for (size_t i = 0; i < memberCount; ++i)                                                                                \
+    {                                                                                                                       \
+        bitsType bits = FROM_ORDERED(bitsType, pSrcBits[i]);                                                                \
+        memcpy(&(pKeys)[i], &bits, sizeof(bits));                                                                           \
+    }                                                                                                                       \
+    if (pSrcValues != pValues)                                                                                              \
+        memcpy(pValues, pSrcValues, sizeof(valueType) * memberCount);                                                       \
+                                                                                                                            \
+    tf_free(pValuesBuffer);                                                                                                 \
+    tf_free(pBitsBuffer);
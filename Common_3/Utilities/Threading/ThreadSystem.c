@@ -34,10 +34,62 @@
 
 #define OPTIMAL_TASK_SLOTS_COUNT 128
 
+// Work stealing scheduler limits, both have to be a power of two
+#define WS_DEQUE_CAPACITY        256
+#define WS_INJECT_QUEUE_CAPACITY 1024
+// Number of failed attempts to find a task before worker goes to sleep
+#define WS_SPIN_COUNT            64
+#define WS_CACHE_LINE_SIZE       64
+
+// Marks the end of ThreadSystemJoinHandle::dependents list, once the handle is done
+#define JOIN_HANDLE_DONE         ((uintptr_t)1)
+
 struct ThreadSystemTask
 {
-    TaskFunc func;
-    void*    user;
+    TaskFunc                       func;
+    void*                          user;
+    struct ThreadSystemJoinHandle* handle;
+};
+
+// Contiguous part of a task group added by threadSystemAddTasks.
+// Workers split it in halves until a single task is left.
+struct ThreadSystemTaskRange
+{
+    TaskFunc                       func;
+    uint8_t*                       users;
+    uint64_t                       userSize;
+    uint64_t                       begin;
+    uint64_t                       end;
+    struct ThreadSystemJoinHandle* handle;
+};
+
+// Chase-Lev deque. Only the owning worker pushes and pops at the bottom, other threads steal from the top.
+struct ThreadSystemDeque
+{
+    tfrg_atomic64_t top;
+    uint8_t         padTop[WS_CACHE_LINE_SIZE - sizeof(tfrg_atomic64_t)];
+    tfrg_atomic64_t bottom;
+    uint64_t        stealSeed;
+    uint8_t         padBottom[WS_CACHE_LINE_SIZE - sizeof(tfrg_atomic64_t) - sizeof(uint64_t)];
+
+    struct ThreadSystemTaskRange ranges[WS_DEQUE_CAPACITY];
+};
+
+struct ThreadSystemInjectCell
+{
+    tfrg_atomic64_t              sequence;
+    struct ThreadSystemTaskRange range;
+};
+
+// Bounded multi-producer/multi-consumer queue (D. Vyukov) for tasks added from threads outside of the pool
+struct ThreadSystemInjectQueue
+{
+    tfrg_atomic64_t enqueuePos;
+    uint8_t         padEnqueue[WS_CACHE_LINE_SIZE - sizeof(tfrg_atomic64_t)];
+    tfrg_atomic64_t dequeuePos;
+    uint8_t         padDequeue[WS_CACHE_LINE_SIZE - sizeof(tfrg_atomic64_t)];
+
+    struct ThreadSystemInjectCell cells[WS_INJECT_QUEUE_CAPACITY];
 };
 
 struct ThreadSystemData
@@ -45,12 +97,24 @@ struct ThreadSystemData
     Mutex mutex;
 
     // const
-    const char* name;
-    uint64_t    threadCount;
+    const char*           name;
+    uint64_t              threadCount;
+    ThreadSystemScheduler scheduler;
 
     // [threadCount]
     ThreadHandle* threads;
 
+    // THREAD_SYSTEM_SCHEDULER_WORK_STEALING only
+    // [threadCount]
+    struct ThreadSystemDeque*       deques;
+    struct ThreadSystemInjectQueue* injectQueue;
+    // tasks which are added but not started yet
+    tfrg_atomic64_t                 queuedTaskCount_Atomic;
+    // tasks which are added but not finished yet
+    tfrg_atomic64_t                 pendingTaskCount_Atomic;
+    tfrg_atomic32_t                 sleepingThreadCount_Atomic;
+    //
+
     // Protected by mutex
     // TODO optimize queued task IO
     struct ThreadSystemTask* tasks;
@@ -58,6 +122,7 @@ struct ThreadSystemData
     uint64_t                 tasksQueued;
     ConditionVariable        conditionTasks;
     ConditionVariable        conditionIsIdle;
+    ConditionVariable        conditionJoin;
     tfrg_atomic32_t          activatedThreadCount_Atomic;
     uint32_t                 idleThreadCount;
     //
@@ -75,8 +140,10 @@ static void threadSystemCleanup(struct ThreadSystemData* t)
     exitMutex(&t->mutex);
     exitConditionVariable(&t->conditionTasks);
     exitConditionVariable(&t->conditionIsIdle);
+    exitConditionVariable(&t->conditionJoin);
 
     arrfree(t->tasks);
+    tf_free(t->injectQueue);
     tf_free(t);
 }
 
@@ -108,10 +175,11 @@ static struct ThreadSystemTask getTask(struct ThreadSystemData* t, uint64_t tid)
             break;
         }
 
-        if (t->stop)
+        // threadSystemAssist must not block when there is nothing to do
+        if (t->stop || tid == UINT64_MAX)
             break;
 
-        if (!idleSet && tid != UINT64_MAX)
+        if (!idleSet)
         {
             idleSet = true;
             ++t->idleThreadCount;
@@ -144,6 +212,354 @@ static struct ThreadSystemTask getTask(struct ThreadSystemData* t, uint64_t tid)
     return task;
 }
 
+/************************************************************************/
+// Join handles
+/************************************************************************/
+static void addTasks(struct ThreadSystemData* t, TaskFunc func, uint64_t count, uint64_t userSize, void* users,
+                     struct ThreadSystemJoinHandle* handle);
+
+static void startJoinHandleTasks(struct ThreadSystemJoinHandle* h);
+
+static void completeJoinHandle(struct ThreadSystemJoinHandle* h)
+{
+    struct ThreadSystemData* t = h->threadSystem;
+
+    // After this exchange no new dependents can be linked to the handle
+    uintptr_t link = tfrg_atomicptr_store_relaxed(&h->dependents, JOIN_HANDLE_DONE);
+    while (link)
+    {
+        struct ThreadSystemJoinHandleLink* pLink = (struct ThreadSystemJoinHandleLink*)link;
+        struct ThreadSystemJoinHandle*     dependent = pLink->handle;
+        // Read next link before the dependent can be started, finished and reused
+        link = pLink->next;
+        if (tfrg_atomic32_add_relaxed(&dependent->pendingDependencyCount, -1) == 1)
+            startJoinHandleTasks(dependent);
+    }
+
+    // Handle memory can be released by the owner as soon as 'done' is set, don't touch it afterwards
+    tfrg_atomic32_store_release(&h->done, 1);
+
+    if (t)
+    {
+        acquireMutex(&t->mutex);
+        wakeAllConditionVariable(&t->conditionJoin);
+        releaseMutex(&t->mutex);
+    }
+}
+
+static void startJoinHandleTasks(struct ThreadSystemJoinHandle* h)
+{
+    if (h->count == 0)
+        completeJoinHandle(h);
+    else
+        addTasks(h->threadSystem, h->func, h->count, h->userSize, h->userArray, h);
+}
+
+static inline void finishJoinHandleTasks(struct ThreadSystemJoinHandle* h, uint64_t count)
+{
+    if (h && (uint64_t)tfrg_atomic64_add_relaxed(&h->pendingTaskCount, -(int64_t)count) == count)
+        completeJoinHandle(h);
+}
+
+/************************************************************************/
+// Work stealing scheduler
+/************************************************************************/
+// Pool and deque index of the worker running on the current thread
+static THREAD_LOCAL struct ThreadSystemData* tCurrentThreadSystem = NULL;
+static THREAD_LOCAL uint64_t                 tCurrentWorkerIndex = UINT64_MAX;
+
+static bool wsDequePush(struct ThreadSystemDeque* d, const struct ThreadSystemTaskRange* range)
+{
+    int64_t b = (int64_t)tfrg_atomic64_load_relaxed(&d->bottom);
+    int64_t t = (int64_t)tfrg_atomic64_load_acquire(&d->top);
+    if (b - t >= WS_DEQUE_CAPACITY)
+        return false;
+
+    d->ranges[b & (WS_DEQUE_CAPACITY - 1)] = *range;
+    tfrg_atomic64_store_release(&d->bottom, (uint64_t)(b + 1));
+    return true;
+}
+
+static bool wsDequePop(struct ThreadSystemDeque* d, struct ThreadSystemTaskRange* outRange)
+{
+    int64_t b = (int64_t)tfrg_atomic64_load_relaxed(&d->bottom) - 1;
+    tfrg_atomic64_store_relaxed(&d->bottom, (uint64_t)b);
+    tfrg_memorybarrier_full();
+    int64_t t = (int64_t)tfrg_atomic64_load_relaxed(&d->top);
+
+    if (t > b)
+    {
+        // empty
+        tfrg_atomic64_store_relaxed(&d->bottom, (uint64_t)(b + 1));
+        return false;
+    }
+
+    *outRange = d->ranges[b & (WS_DEQUE_CAPACITY - 1)];
+    if (t == b)
+    {
+        // last element, race against thieves
+        bool won = (int64_t)tfrg_atomic64_cas_relaxed(&d->top, (uint64_t)t, (uint64_t)(t + 1)) == t;
+        tfrg_atomic64_store_relaxed(&d->bottom, (uint64_t)(b + 1));
+        return won;
+    }
+    return true;
+}
+
+static bool wsDequeSteal(struct ThreadSystemDeque* d, struct ThreadSystemTaskRange* outRange)
+{
+    int64_t t = (int64_t)tfrg_atomic64_load_acquire(&d->top);
+    tfrg_memorybarrier_full();
+    int64_t b = (int64_t)tfrg_atomic64_load_acquire(&d->bottom);
+    if (t >= b)
+        return false;
+
+    // Slot can only be overwritten by the owner after 'top' moves forward, in which case CAS below fails
+    struct ThreadSystemTaskRange range = d->ranges[t & (WS_DEQUE_CAPACITY - 1)];
+    if ((int64_t)tfrg_atomic64_cas_relaxed(&d->top, (uint64_t)t, (uint64_t)(t + 1)) != t)
+        return false;
+
+    *outRange = range;
+    return true;
+}
+
+static bool wsInjectEnqueue(struct ThreadSystemInjectQueue* q, const struct ThreadSystemTaskRange* range)
+{
+    struct ThreadSystemInjectCell* cell = NULL;
+    uint64_t                       pos = tfrg_atomic64_load_relaxed(&q->enqueuePos);
+    for (;;)
+    {
+        cell = &q->cells[pos & (WS_INJECT_QUEUE_CAPACITY - 1)];
+        int64_t diff = (int64_t)tfrg_atomic64_load_acquire(&cell->sequence) - (int64_t)pos;
+        if (diff == 0)
+        {
+            uint64_t prev = tfrg_atomic64_cas_relaxed(&q->enqueuePos, pos, pos + 1);
+            if (prev == pos)
+                break;
+            pos = prev;
+        }
+        else if (diff < 0)
+        {
+            // full
+            return false;
+        }
+        else
+        {
+            pos = tfrg_atomic64_load_relaxed(&q->enqueuePos);
+        }
+    }
+
+    cell->range = *range;
+    tfrg_atomic64_store_release(&cell->sequence, pos + 1);
+    return true;
+}
+
+static bool wsInjectDequeue(struct ThreadSystemInjectQueue* q, struct ThreadSystemTaskRange* outRange)
+{
+    struct ThreadSystemInjectCell* cell = NULL;
+    uint64_t                       pos = tfrg_atomic64_load_relaxed(&q->dequeuePos);
+    for (;;)
+    {
+        cell = &q->cells[pos & (WS_INJECT_QUEUE_CAPACITY - 1)];
+        int64_t diff = (int64_t)tfrg_atomic64_load_acquire(&cell->sequence) - (int64_t)(pos + 1);
+        if (diff == 0)
+        {
+            uint64_t prev = tfrg_atomic64_cas_relaxed(&q->dequeuePos, pos, pos + 1);
+            if (prev == pos)
+                break;
+            pos = prev;
+        }
+        else if (diff < 0)
+        {
+            // empty
+            return false;
+        }
+        else
+        {
+            pos = tfrg_atomic64_load_relaxed(&q->dequeuePos);
+        }
+    }
+
+    *outRange = cell->range;
+    tfrg_atomic64_store_release(&cell->sequence, pos + WS_INJECT_QUEUE_CAPACITY);
+    return true;
+}
+
+static void wsWakeSleepingThreads(struct ThreadSystemData* t, uint64_t taskCount)
+{
+    if (tfrg_atomic32_load_relaxed(&t->sleepingThreadCount_Atomic) == 0)
+        return;
+
+    acquireMutex(&t->mutex);
+    if (taskCount == 1)
+        wakeOneConditionVariable(&t->conditionTasks);
+    else
+        wakeAllConditionVariable(&t->conditionTasks);
+    releaseMutex(&t->mutex);
+}
+
+// Makes range visible to other threads. Called for ranges which are already accounted in queuedTaskCount_Atomic.
+static bool wsTryPublishRange(struct ThreadSystemData* t, const struct ThreadSystemTaskRange* range)
+{
+    if (tCurrentThreadSystem == t && wsDequePush(&t->deques[tCurrentWorkerIndex], range))
+        return true;
+    return wsInjectEnqueue(t->injectQueue, range);
+}
+
+static bool wsGetRange(struct ThreadSystemData* t, struct ThreadSystemTaskRange* outRange)
+{
+    uint64_t workerIndex = tCurrentThreadSystem == t ? tCurrentWorkerIndex : UINT64_MAX;
+
+    if (workerIndex != UINT64_MAX && wsDequePop(&t->deques[workerIndex], outRange))
+        return true;
+
+    if (wsInjectDequeue(t->injectQueue, outRange))
+        return true;
+
+    // Start stealing from a random victim so that thieves don't fight over the same deque
+    uint64_t start = 0;
+    if (workerIndex != UINT64_MAX)
+    {
+        uint64_t* seed = &t->deques[workerIndex].stealSeed;
+        *seed ^= *seed << 13;
+        *seed ^= *seed >> 7;
+        *seed ^= *seed << 17;
+        start = *seed;
+    }
+
+    for (uint64_t i = 0; i < t->threadCount; ++i)
+    {
+        uint64_t victim = (start + i) % t->threadCount;
+        if (victim == workerIndex)
+            continue;
+        if (wsDequeSteal(&t->deques[victim], outRange))
+            return true;
+    }
+
+    return false;
+}
+
+static void wsExecuteRange(struct ThreadSystemData* t, struct ThreadSystemTaskRange range, uint64_t tid)
+{
+    if (tCurrentThreadSystem == t)
+    {
+        // Keep the lower half, expose the upper half to thieves
+        struct ThreadSystemDeque* d = &t->deques[tCurrentWorkerIndex];
+        while (range.end - range.begin > 1)
+        {
+            struct ThreadSystemTaskRange upper = range;
+            upper.begin = range.begin + (range.end - range.begin) / 2;
+            if (!wsDequePush(d, &upper))
+                break;
+            range.end = upper.begin;
+        }
+    }
+    else if (range.end - range.begin > 1)
+    {
+        // Threads outside of the pool have no deque, run one task and give the rest back
+        struct ThreadSystemTaskRange rest = range;
+        rest.begin = range.begin + 1;
+        if (wsInjectEnqueue(t->injectQueue, &rest))
+            range.end = rest.begin;
+    }
+
+    uint64_t count = range.end - range.begin;
+    tfrg_atomic64_add_relaxed(&t->queuedTaskCount_Atomic, -(int64_t)count);
+
+    for (uint64_t ti = range.begin; ti < range.end; ++ti)
+        range.func(range.users ? range.users + ti * range.userSize : NULL, tid);
+
+    finishJoinHandleTasks(range.handle, count);
+
+    uint64_t pending = tfrg_atomic64_add_relaxed(&t->pendingTaskCount_Atomic, -(int64_t)count);
+    if (pending == count)
+    {
+        acquireMutex(&t->mutex);
+        wakeAllConditionVariable(&t->conditionIsIdle);
+        releaseMutex(&t->mutex);
+    }
+}
+
+static void wsTaskThreadFunc(struct ThreadSystemData* t, uint64_t tid)
+{
+    tCurrentThreadSystem = t;
+    tCurrentWorkerIndex = tid;
+    t->deques[tid].stealSeed = 0x9E3779B97F4A7C15ull * (tid + 1);
+
+    uint32_t failedAttempts = 0;
+    while (!t->stopAbandon)
+    {
+        struct ThreadSystemTaskRange range;
+        if (wsGetRange(t, &range))
+        {
+            wsExecuteRange(t, range, tid);
+            failedAttempts = 0;
+            continue;
+        }
+
+        if (t->stop && tfrg_atomic64_load_relaxed(&t->queuedTaskCount_Atomic) == 0)
+            break;
+
+        if (++failedAttempts < WS_SPIN_COUNT)
+            continue;
+        failedAttempts = 0;
+
+        acquireMutex(&t->mutex);
+        // Full barrier of the increment pairs with the one in threadSystemAddTasks, so either
+        // we see the new tasks here or the producer sees us sleeping and wakes us up
+        tfrg_atomic32_add_relaxed(&t->sleepingThreadCount_Atomic, 1);
+        if (!t->stop && tfrg_atomic64_load_relaxed(&t->queuedTaskCount_Atomic) == 0)
+            waitConditionVariable(&t->conditionTasks, &t->mutex, TIMEOUT_INFINITE);
+        tfrg_atomic32_add_relaxed(&t->sleepingThreadCount_Atomic, -1);
+        releaseMutex(&t->mutex);
+    }
+
+    tCurrentThreadSystem = NULL;
+    tCurrentWorkerIndex = UINT64_MAX;
+}
+
+static void wsAddTasks(struct ThreadSystemData* t, TaskFunc func, uint64_t count, uint64_t userSize, void* users,
+                       struct ThreadSystemJoinHandle* handle)
+{
+    tfrg_atomic64_add_relaxed(&t->pendingTaskCount_Atomic, count);
+    tfrg_atomic64_add_relaxed(&t->queuedTaskCount_Atomic, count);
+
+    // Workers split ranges on their own, one range per worker is enough to get everybody started
+    uint64_t rangeCount = tCurrentThreadSystem == t ? 1 : TF_MIN(count, t->threadCount);
+    uint64_t begin = 0;
+    for (uint64_t ri = 0; ri < rangeCount; ++ri)
+    {
+        struct ThreadSystemTaskRange range = { func, (uint8_t*)users, userSize, begin, begin + count / rangeCount, handle };
+        if (ri < count % rangeCount)
+            ++range.end;
+        begin = range.end;
+
+        while (!wsTryPublishRange(t, &range))
+        {
+            // Queue is full, help with the work until a slot is freed
+            struct ThreadSystemTaskRange other;
+            if (wsGetRange(t, &other))
+                wsExecuteRange(t, other, tCurrentThreadSystem == t ? tCurrentWorkerIndex : UINT64_MAX);
+        }
+    }
+    ASSERT(begin == count);
+
+    wsWakeSleepingThreads(t, count);
+}
+
+static bool wsAssist(struct ThreadSystemData* t)
+{
+    struct ThreadSystemTaskRange range;
+    if (!wsGetRange(t, &range))
+        return false;
+    wsExecuteRange(t, range, tCurrentThreadSystem == t ? tCurrentWorkerIndex : UINT64_MAX);
+    return true;
+}
+
+static bool wsIsIdle(struct ThreadSystemData* t) { return tfrg_atomic64_load_relaxed(&t->pendingTaskCount_Atomic) == 0; }
+
+/************************************************************************/
+// Shared queue scheduler / public interface
+/************************************************************************/
 static void taskThreadFunc(void* threadUserData)
 {
     struct ThreadSystemData* t = threadUserData;
@@ -156,12 +572,20 @@ static void taskThreadFunc(void* threadUserData)
         setCurrentThreadName(buffer);
     }
 
+    if (t->scheduler == THREAD_SYSTEM_SCHEDULER_WORK_STEALING)
+    {
+        wsTaskThreadFunc(t, tid);
+        releaseThreadSystemHandle(t);
+        return;
+    }
+
     struct ThreadSystemTask task = { 0 };
     while (!t->stopAbandon)
     {
         if (task.func)
         {
             task.func(task.user, tid);
+            finishJoinHandleTasks(task.handle, 1);
             memset(&task, 0, sizeof task);
         }
 
@@ -188,12 +612,32 @@ bool threadSystemInit(ThreadSystem* out, const struct ThreadSystemInitDesc* desc
     if (count == 0) // something went wrong (maybe getNumCPUCores returned 0)
         return false;
 
-    struct ThreadSystemData* t = tf_calloc(1, sizeof(*t) + sizeof(ThreadHandle) * count);
+    bool workStealing = desc->scheduler == THREAD_SYSTEM_SCHEDULER_WORK_STEALING;
+
+    size_t dequesOffset = sizeof(struct ThreadSystemData) + sizeof(ThreadHandle) * count;
+    dequesOffset = (dequesOffset + WS_CACHE_LINE_SIZE - 1) & ~((size_t)WS_CACHE_LINE_SIZE - 1);
+    size_t allocSize = workStealing ? dequesOffset + sizeof(struct ThreadSystemDeque) * count : dequesOffset;
+
+    struct ThreadSystemData* t = tf_calloc_memalign(1, WS_CACHE_LINE_SIZE, allocSize);
     if (!t)
         return false;
 
     t->threads = (ThreadHandle*)(t + 1);
     t->name = desc->threadName ? desc->threadName : "ThreadSystem";
+    t->scheduler = desc->scheduler;
+
+    if (workStealing)
+    {
+        t->deques = (struct ThreadSystemDeque*)((uint8_t*)t + dequesOffset);
+        t->injectQueue = tf_calloc_memalign(1, WS_CACHE_LINE_SIZE, sizeof(struct ThreadSystemInjectQueue));
+        if (!t->injectQueue)
+        {
+            tf_free(t);
+            return false;
+        }
+        for (uint64_t ci = 0; ci < WS_INJECT_QUEUE_CAPACITY; ++ci)
+            t->injectQueue->cells[ci].sequence = ci;
+    }
 
     bool success = false;
 
@@ -217,6 +661,12 @@ bool threadSystemInit(ThreadSystem* out, const struct ThreadSystemInitDesc* desc
             break;
         }
 
+        if (!initConditionVariable(&t->conditionJoin))
+        {
+            memset(&t->conditionJoin, 0, sizeof t->conditionJoin);
+            break;
+        }
+
         success = true;
     } while (false);
 
@@ -292,19 +742,20 @@ void threadSystemExit(ThreadSystem* thandle, const struct ThreadSystemExitDesc*
     releaseThreadSystemHandle(t);
 }
 
-void threadSystemAddTasks(ThreadSystem thandle, TaskFunc func, uint64_t count, uint64_t userSize, void* users)
+static void addTasks(struct ThreadSystemData* t, TaskFunc func, uint64_t count, uint64_t userSize, void* users,
+                     struct ThreadSystemJoinHandle* handle)
 {
-    if (count == 0)
-        return;
-    if (!VERIFY(func))
-        return;
-
-    struct ThreadSystemData* t = thandle;
-
     if (!t) // dummy run
     {
         for (uint64_t ti = 0; ti < count; ++ti)
             func((uint8_t*)users + ti * userSize, 0);
+        finishJoinHandleTasks(handle, count);
+        return;
+    }
+
+    if (t->scheduler == THREAD_SYSTEM_SCHEDULER_WORK_STEALING)
+    {
+        wsAddTasks(t, func, count, userSize, users, handle);
         return;
     }
 
@@ -330,6 +781,7 @@ void threadSystemAddTasks(ThreadSystem thandle, TaskFunc func, uint64_t count, u
         t->tasks[offset + ti] = (struct ThreadSystemTask){
             func,
             users ? ((uint8_t*)users + ti * userSize) : NULL,
+            handle,
         };
     }
 
@@ -342,15 +794,112 @@ void threadSystemAddTasks(ThreadSystem thandle, TaskFunc func, uint64_t count, u
     return;
 }
 
+void threadSystemAddTasks(ThreadSystem thandle, TaskFunc func, uint64_t count, uint64_t userSize, void* users)
+{
+    if (count == 0)
+        return;
+    if (!VERIFY(func))
+        return;
+
+    addTasks(thandle, func, count, userSize, users, NULL);
+}
+
+bool threadSystemAddDependentTasks(ThreadSystem thandle, const struct ThreadSystemDependentTasksDesc* desc,
+                                   struct ThreadSystemJoinHandle* h)
+{
+    memset(h, 0, sizeof *h);
+    h->threadSystem = thandle;
+
+    // Rejected handles are done right away, so joining them or depending on them doesn't block
+    if (desc->dependencyCount > THREAD_SYSTEM_MAX_DEPENDENCIES)
+    {
+        LOGF(eERROR, "Tasks can't depend on %u handles, THREAD_SYSTEM_MAX_DEPENDENCIES is %u", desc->dependencyCount,
+             (uint32_t)THREAD_SYSTEM_MAX_DEPENDENCIES);
+        h->dependents = JOIN_HANDLE_DONE;
+        h->done = 1;
+        return false;
+    }
+    if (desc->count && !VERIFY(desc->func))
+    {
+        h->dependents = JOIN_HANDLE_DONE;
+        h->done = 1;
+        return false;
+    }
+
+    h->func = desc->func;
+    h->count = desc->count;
+    h->userSize = desc->userSize;
+    h->userArray = desc->userArray;
+    h->pendingTaskCount = desc->count;
+    // Extra dependency keeps the handle from being started while dependencies are being linked
+    h->pendingDependencyCount = desc->dependencyCount + 1;
+
+    uint32_t doneDependencyCount = 0;
+    for (uint32_t di = 0; di < desc->dependencyCount; ++di)
+    {
+        struct ThreadSystemJoinHandle* dependency = desc->dependencies[di];
+
+        uintptr_t head = dependency ? tfrg_atomicptr_load_acquire(&dependency->dependents) : JOIN_HANDLE_DONE;
+        for (;;)
+        {
+            if (head == JOIN_HANDLE_DONE)
+            {
+                ++doneDependencyCount;
+                break;
+            }
+
+            h->dependencyLinks[di].handle = h;
+            h->dependencyLinks[di].next = head;
+            uintptr_t prev = tfrg_atomicptr_cas_relaxed(&dependency->dependents, head, (uintptr_t)&h->dependencyLinks[di]);
+            if (prev == head)
+                break;
+            head = prev;
+        }
+    }
+
+    uint32_t startCount = doneDependencyCount + 1;
+    if ((uint32_t)tfrg_atomic32_add_relaxed(&h->pendingDependencyCount, -(int32_t)startCount) == startCount)
+        startJoinHandleTasks(h);
+    return true;
+}
+
+void threadSystemJoin(ThreadSystem thandle, struct ThreadSystemJoinHandle* h)
+{
+    struct ThreadSystemData* t = thandle;
+    if (!t) // dummy run, tasks are executed by threadSystemAddDependentTasks
+    {
+        ASSERT(h->done);
+        return;
+    }
+
+    while (!tfrg_atomic32_load_acquire(&h->done))
+    {
+        if (threadSystemAssist(t))
+            continue;
+
+        // Nothing to help with, remaining tasks are running on other threads
+        acquireMutex(&t->mutex);
+        if (!tfrg_atomic32_load_acquire(&h->done))
+            waitConditionVariable(&t->conditionJoin, &t->mutex, TIMEOUT_INFINITE);
+        releaseMutex(&t->mutex);
+    }
+}
+
 bool threadSystemAssist(ThreadSystem thandle)
 {
     struct ThreadSystemData* t = thandle;
     if (!t)
         return false;
 
+    if (t->scheduler == THREAD_SYSTEM_SCHEDULER_WORK_STEALING)
+        return wsAssist(t);
+
     struct ThreadSystemTask task = getTask(t, UINT64_MAX);
     if (task.func)
+    {
         task.func(task.user, UINT64_MAX);
+        finishJoinHandleTasks(task.handle, 1);
+    }
     return task.func;
 }
 
@@ -367,7 +916,10 @@ bool threadSystemWaitIdleTimeout(ThreadSystem thandle, uint32_t timeout_ms)
     acquireMutex(&t->mutex);
     for (;;)
     {
-        idle = (t->tasksTaken >= t->tasksQueued) && (t->idleThreadCount >= tfrg_atomic32_load_relaxed(&t->references_Atomic) - 1);
+        if (t->scheduler == THREAD_SYSTEM_SCHEDULER_WORK_STEALING)
+            idle = wsIsIdle(t);
+        else
+            idle = (t->tasksTaken >= t->tasksQueued) && (t->idleThreadCount >= tfrg_atomic32_load_relaxed(&t->references_Atomic) - 1);
         if (idle || timeout_ms == 0)
             break;
 
@@ -400,3 +952,139 @@ void threadSystemGetInfo(ThreadSystem thandle, struct ThreadSystemInfo* outInfo)
     outInfo->activeThreadCount = tfrg_atomic32_load_relaxed(&t->references_Atomic) - 1;
     outInfo->threadName = t->name;
 }
+
+/************************************************************************/
+// Parallel algorithms
+/************************************************************************/
+// Chunks per thread for automatic grain size. More chunks balance uneven work better, less chunks have less overhead.
+#define PARALLEL_FOR_CHUNKS_PER_THREAD 4
+
+struct ParallelForData
+{
+    ParallelForFunc     func;
+    ParallelReduceFunc  reduce;
+    ParallelCombineFunc combine;
+    void*               user;
+    uint64_t            count;
+    uint64_t            grainSize;
+    uint64_t            chunkCount;
+    tfrg_atomic64_t     nextChunk;
+    // threadSystemParallelReduce only
+    uint64_t            resultSize;
+    const void*         identity;
+    // [chunkCount * resultSize]
+    uint8_t*            partialResults;
+};
+
+static void parallelForTask(void* user, uint64_t threadId)
+{
+    struct ParallelForData* data = user;
+
+    // Chunks are handed out one by one, so threads which got cheap chunks simply take more of them
+    for (;;)
+    {
+        uint64_t chunk = tfrg_atomic64_add_relaxed(&data->nextChunk, 1);
+        if (chunk >= data->chunkCount)
+            break;
+
+        uint64_t begin = chunk * data->grainSize;
+        uint64_t end = TF_MIN(begin + data->grainSize, data->count);
+        if (data->func)
+        {
+            data->func(data->user, begin, end, threadId);
+        }
+        else
+        {
+            uint8_t* result = data->partialResults + chunk * data->resultSize;
+            memcpy(result, data->identity, data->resultSize);
+            data->reduce(data->user, begin, end, result, threadId);
+        }
+    }
+}
+
+static void parallelForRun(struct ThreadSystemData* t, struct ParallelForData* data)
+{
+    uint64_t helperCount = 0;
+    if (t)
+    {
+        // Calling thread takes part, so one chunk less needs a helper
+        helperCount = TF_MIN(t->threadCount, data->chunkCount - 1);
+    }
+
+    if (helperCount == 0)
+    {
+        parallelForTask(data, UINT64_MAX);
+        return;
+    }
+
+    // Every helper task gets the same shared data (userSize is 0)
+    struct ThreadSystemDependentTasksDesc desc = { 0 };
+    desc.func = parallelForTask;
+    desc.count = helperCount;
+    desc.userArray = data;
+
+    struct ThreadSystemJoinHandle handle;
+    threadSystemAddDependentTasks(t, &desc, &handle);
+    parallelForTask(data, UINT64_MAX);
+    // Helpers which started late find no chunks left and return immediately
+    threadSystemJoin(t, &handle);
+}
+
+static uint64_t parallelForGrainSize(struct ThreadSystemData* t, uint64_t count, uint64_t grainSize)
+{
+    if (grainSize)
+        return grainSize;
+
+    uint64_t chunkCount = ((t ? t->threadCount : 0) + 1) * PARALLEL_FOR_CHUNKS_PER_THREAD;
+    return TF_MAX((uint64_t)1, (count + chunkCount - 1) / chunkCount);
+}
+
+void threadSystemParallelFor(ThreadSystem thandle, uint64_t count, uint64_t grainSize, ParallelForFunc func, void* user)
+{
+    if (count == 0)
+        return;
+    if (!VERIFY(func))
+        return;
+
+    struct ThreadSystemData* t = thandle;
+
+    struct ParallelForData data = { 0 };
+    data.func = func;
+    data.user = user;
+    data.count = count;
+    data.grainSize = parallelForGrainSize(t, count, grainSize);
+    data.chunkCount = (count + data.grainSize - 1) / data.grainSize;
+    parallelForRun(t, &data);
+}
+
+void threadSystemParallelReduce(ThreadSystem thandle, uint64_t count, uint64_t grainSize, uint64_t resultSize, const void* identity,
+                                ParallelReduceFunc reduce, ParallelCombineFunc combine, void* user, void* outResult)
+{
+    memcpy(outResult, identity, resultSize);
+    if (count == 0)
+        return;
+    if (!VERIFY(reduce && combine))
+        return;
+
+    struct ThreadSystemData* t = thandle;
+
+    struct ParallelForData data = { 0 };
+    data.reduce = reduce;
+    data.combine = combine;
+    data.user = user;
+    data.count = count;
+    data.grainSize = parallelForGrainSize(t, count, grainSize);
+    data.chunkCount = (count + data.grainSize - 1) / data.grainSize;
+    data.resultSize = resultSize;
+    data.identity = identity;
+    data.partialResults = tf_malloc(data.chunkCount * resultSize);
+    if (!data.partialResults)
+        return;
+
+    parallelForRun(t, &data);
+
+    for (uint64_t ci = 0; ci < data.chunkCount; ++ci)
+        combine(user, outResult, data.partialResults + ci * resultSize);
+
+    tf_free(data.partialResults);
+}
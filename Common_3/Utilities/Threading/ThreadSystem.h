@@ -36,6 +36,23 @@ extern "C"
     // e.g. when threadSystemAssist() is used
     typedef void (*TaskFunc)(void* user, uint64_t threadId);
 
+    // Processes elements [begin, end) of a parallel for
+    typedef void (*ParallelForFunc)(void* user, uint64_t begin, uint64_t end, uint64_t threadId);
+    // Accumulates elements [begin, end) of a parallel reduce into 'result'
+    typedef void (*ParallelReduceFunc)(void* user, uint64_t begin, uint64_t end, void* result, uint64_t threadId);
+    // Combines 'rhs' into 'lhs'. Partial results are combined in element order.
+    typedef void (*ParallelCombineFunc)(void* user, void* lhs, const void* rhs);
+
+    typedef enum ThreadSystemScheduler
+    {
+        // All scheduled tasks are stored in one array guarded by a mutex.
+        THREAD_SYSTEM_SCHEDULER_SHARED_QUEUE = 0,
+        // Every worker owns a lock-free deque, idle workers steal from each other.
+        // Task groups are queued as ranges which are split lazily by the workers,
+        // so adding a large group costs the same as adding a single task.
+        THREAD_SYSTEM_SCHEDULER_WORK_STEALING,
+    } ThreadSystemScheduler;
+
     struct ThreadSystemInitDesc
     {
         // same as affinity mask from struct ThreadDesc, but for all threads in pool
@@ -53,6 +70,9 @@ extern "C"
         // Thread namings are "ThreadName 1", "ThreadName 2", ...
         // pointer must be valid until threadSystemExit
         const char* threadName;
+
+        // Task queue implementation, see ThreadSystemScheduler
+        ThreadSystemScheduler scheduler;
     };
 
     struct ThreadSystemExitDesc
@@ -90,11 +110,58 @@ extern "C"
 
     typedef void* ThreadSystem;
 
+#define THREAD_SYSTEM_MAX_DEPENDENCIES 8
+
+    struct ThreadSystemJoinHandleLink
+    {
+        struct ThreadSystemJoinHandle* handle;
+        uintptr_t                      next;
+    };
+
+    // Join handle of tasks added with threadSystemAddDependentTasks.
+    // Can be waited on and used as a dependency of other tasks.
+    //
+    // Memory is owned by the caller and has to stay valid until the handle is done,
+    // all members are internal.
+    struct ThreadSystemJoinHandle
+    {
+        ThreadSystem threadSystem;
+        TaskFunc     func;
+        uint64_t     count;
+        uint64_t     userSize;
+        void*        userArray;
+
+        // tasks which are not finished yet
+        volatile uint64_t  pendingTaskCount;
+        // dependencies which are not finished yet
+        volatile uint32_t  pendingDependencyCount;
+        volatile uint32_t  done;
+        // list of dependent handles waiting for this one
+        volatile uintptr_t dependents;
+
+        struct ThreadSystemJoinHandleLink dependencyLinks[THREAD_SYSTEM_MAX_DEPENDENCIES];
+    };
+
+    struct ThreadSystemDependentTasksDesc
+    {
+        TaskFunc func;
+        // Can be 0, handle is then done as soon as all dependencies are done (e.g. to join multiple handles into one)
+        uint64_t count;
+        uint64_t userSize;
+        void*    userArray;
+
+        // Tasks are started only after all these handles are done.
+        // NULL entries and handles which are already done are allowed.
+        struct ThreadSystemJoinHandle* const* dependencies;
+        uint32_t                              dependencyCount;
+    };
+
     static const struct ThreadSystemInitDesc gThreadSystemInitDescDefault = {
         0,
         { 0 },
         UINT64_MAX,
         NULL,
+        THREAD_SYSTEM_SCHEDULER_SHARED_QUEUE,
     };
 
     static const struct ThreadSystemExitDesc gThreadSystemExitDescDefault = {
@@ -118,6 +185,29 @@ extern "C"
 
     void threadSystemGetInfo(ThreadSystem ts, struct ThreadSystemInfo* outInfo);
 
+    // Adds tasks which are started once all dependencies are done.
+    // 'outHandle' becomes done when all of the added tasks are finished, dependents of it are started at that point.
+    // Returns false without adding tasks if desc is invalid (more than THREAD_SYSTEM_MAX_DEPENDENCIES dependencies or no func),
+    // 'outHandle' is done right away in that case.
+    bool threadSystemAddDependentTasks(ThreadSystem ts, const struct ThreadSystemDependentTasksDesc* desc,
+                                       struct ThreadSystemJoinHandle* outHandle);
+
+    // Executes scheduled tasks on the calling thread until the handle is done.
+    // Unlike threadSystemWaitIdle, tasks unrelated to the handle are allowed to keep running.
+    void threadSystemJoin(ThreadSystem ts, struct ThreadSystemJoinHandle* handle);
+
+    // Splits [0, count) into chunks of at least 'grainSize' elements and processes them on the thread system.
+    // Calling thread takes chunks as well and returns once all of them are processed.
+    // If grainSize is 0 it is selected from the element and thread count.
+    void threadSystemParallelFor(ThreadSystem ts, uint64_t count, uint64_t grainSize, ParallelForFunc func, void* user);
+
+    // Same splitting as threadSystemParallelFor. Every chunk accumulates into its own copy of 'identity',
+    // copies are combined in chunk order, so the result doesn't depend on thread timings.
+    void threadSystemParallelReduce(ThreadSystem ts, uint64_t count, uint64_t grainSize, uint64_t resultSize, const void* identity,
+                                    ParallelReduceFunc reduce, ParallelCombineFunc combine, void* user, void* outResult);
+
+    static inline bool threadSystemIsJoinHandleDone(const struct ThreadSystemJoinHandle* handle) { return handle->done != 0; }
+
     static inline void threadSystemAddTask(ThreadSystem ts, TaskFunc func, void* user) { threadSystemAddTasks(ts, func, 1, 0, user); }
 
     static inline bool threadSystemIsIdle(ThreadSystem ts) { return threadSystemWaitIdleTimeout(ts, 0); }
@@ -157,6 +247,65 @@ public:
         threadSystemAddTaskGroup(threadSystem, func, count, dataArray);
     }
 
+    bool addDependentTasks(const ThreadSystemDependentTasksDesc* desc, ThreadSystemJoinHandle* outHandle) const
+    {
+        return threadSystemAddDependentTasks(threadSystem, desc, outHandle);
+    }
+
+    template<typename T>
+    bool addTasksAfter(TaskFunc func, uint64_t count, T* dataArray, uint32_t dependencyCount, ThreadSystemJoinHandle* const* dependencies,
+                       ThreadSystemJoinHandle* outHandle) const
+    {
+        ThreadSystemDependentTasksDesc desc = {};
+        desc.func = func;
+        desc.count = count;
+        desc.userSize = sizeof *dataArray;
+        desc.userArray = dataArray;
+        desc.dependencies = dependencies;
+        desc.dependencyCount = dependencyCount;
+        return threadSystemAddDependentTasks(threadSystem, &desc, outHandle);
+    }
+
+    template<typename T>
+    bool addTasksAfter(TaskFunc func, uint64_t count, T* dataArray, ThreadSystemJoinHandle* dependency, ThreadSystemJoinHandle* outHandle) const
+    {
+        return addTasksAfter(func, count, dataArray, 1, &dependency, outHandle);
+    }
+
+    void join(ThreadSystemJoinHandle* handle) const { threadSystemJoin(threadSystem, handle); }
+
+    void parallelFor(uint64_t count, uint64_t grainSize, ParallelForFunc func, void* user) const
+    {
+        threadSystemParallelFor(threadSystem, count, grainSize, func, user);
+    }
+
+    // 'func' is called as func(begin, end)
+    template<typename F>
+    void parallelFor(uint64_t count, uint64_t grainSize, F& func) const
+    {
+        threadSystemParallelFor(
+            threadSystem, count, grainSize, [](void* user, uint64_t begin, uint64_t end, uint64_t) { (*(F*)user)(begin, end); }, &func);
+    }
+
+    // 'reduce' is called as reduce(begin, end, T& result), 'combine' as combine(T& lhs, const T& rhs).
+    // T is copied with memcpy, so it has to be trivially copyable.
+    template<typename T, typename R, typename C>
+    T parallelReduce(uint64_t count, uint64_t grainSize, const T& identity, R& reduce, C& combine) const
+    {
+        struct Funcs
+        {
+            R* reduce;
+            C* combine;
+        } funcs = { &reduce, &combine };
+
+        T result;
+        threadSystemParallelReduce(
+            threadSystem, count, grainSize, sizeof(T), &identity,
+            [](void* user, uint64_t begin, uint64_t end, void* result, uint64_t) { (*((Funcs*)user)->reduce)(begin, end, *(T*)result); },
+            [](void* user, void* lhs, const void* rhs) { (*((Funcs*)user)->combine)(*(T*)lhs, *(const T*)rhs); }, &funcs, &result);
+        return result;
+    }
+
     bool assist() const { return threadSystemAssist(threadSystem); }
 
     void assistUntilDone() const
@@ -38,6 +38,7 @@
 #include "../../../../Common_3/Utilities/Interfaces/IThread.h"
 #include "../../../../Common_3/Utilities/Interfaces/ITime.h"
 
+#include "../../../../Common_3/Utilities/Math/Algorithms.h"
 #include "../../../../Common_3/Utilities/Math/MathTypes.h"
 #include "../../../../Common_3/Utilities/RingBuffer.h"
 #include "../../../../Common_3/Utilities/Threading/ThreadSystem.h"
@@ -171,6 +172,15 @@ ICameraController* pCameraController = NULL;
 
 static ThreadSystem gThreadSystem;
 
+// Floods the resource loader request queue from all worker threads, it only runs with --resource-loader-stress-test
+static bool gRunResourceLoaderStressTest = false;
+// Reloads the sample textures with 0..8 io threads, it only runs with --io-thread-benchmark
+static bool gRunIoThreadBenchmark = false;
+// Uploads 256 low priority buffers ahead of a high priority one, it only runs with --priority-test
+static bool gRunPriorityTest = false;
+// Allocates and frees geometry buffer ranges in a loop, it only runs with --geometry-allocator-benchmark
+static bool gRunGeometryAllocatorBenchmark = false;
+
 ProfileToken gGpuProfiletokens[gMaxThreadCount + 1] = {};
 
 CpuGraphData* pCpuData;
@@ -204,6 +214,261 @@ void RunScript(void* pUserData)
     luaQueueScriptToRun(&runDesc);
 }
 
+// Resource loader stress test: all worker threads call addResource at the same time with tiny buffers so the time spent
+// in addResource is dominated by request submission. Runs during Init on request and logs the latency distribution.
+#define RESOURCE_LOADER_STRESS_BUFFERS_PER_THREAD 512
+#define RESOURCE_LOADER_STRESS_BUFFER_SIZE        64
+
+struct ResourceLoaderStressData
+{
+    Buffer** ppBuffers;
+    int64_t* pLatencies; // microseconds spent in each addResource call
+    uint32_t mBufferCount;
+};
+
+static void ResourceLoaderStressTask(void* pData, uint64_t)
+{
+    ResourceLoaderStressData* pStress = (ResourceLoaderStressData*)pData;
+
+    uint8_t data[RESOURCE_LOADER_STRESS_BUFFER_SIZE] = {};
+
+    BufferLoadDesc loadDesc = {};
+    loadDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_BUFFER;
+    loadDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+    loadDesc.mDesc.mStartState = RESOURCE_STATE_COMMON;
+    loadDesc.mDesc.mSize = sizeof(data);
+    loadDesc.pData = data;
+    for (uint32_t i = 0; i < pStress->mBufferCount; ++i)
+    {
+        loadDesc.ppBuffer = &pStress->ppBuffers[i];
+        int64_t start = getUSec(true);
+        addResource(&loadDesc, NULL);
+        pStress->pLatencies[i] = getUSec(true) - start;
+    }
+}
+
+static void StressTestResourceLoader(ThreadSystem threadSystem)
+{
+    ThreadSystemInfo info = {};
+    threadSystemGetInfo(threadSystem, &info);
+    const uint32_t taskCount = max(1u, (uint32_t)info.threadCount);
+    const uint32_t bufferCount = taskCount * RESOURCE_LOADER_STRESS_BUFFERS_PER_THREAD;
+
+    Buffer**                  ppBuffers = (Buffer**)tf_calloc(bufferCount, sizeof(Buffer*));
+    int64_t*                  pLatencies = (int64_t*)tf_calloc(bufferCount, sizeof(int64_t));
+    ResourceLoaderStressData* pTasks = (ResourceLoaderStressData*)tf_calloc(taskCount, sizeof(ResourceLoaderStressData));
+    for (uint32_t i = 0; i < taskCount; ++i)
+    {
+        pTasks[i].ppBuffers = ppBuffers + i * RESOURCE_LOADER_STRESS_BUFFERS_PER_THREAD;
+        pTasks[i].pLatencies = pLatencies + i * RESOURCE_LOADER_STRESS_BUFFERS_PER_THREAD;
+        pTasks[i].mBufferCount = RESOURCE_LOADER_STRESS_BUFFERS_PER_THREAD;
+    }
+
+    int64_t start = getUSec(true);
+    threadSystemAddTaskGroup(threadSystem, ResourceLoaderStressTask, taskCount, pTasks);
+    threadSystemWaitIdle(threadSystem);
+    int64_t enqueueTime = getUSec(true) - start;
+    waitForAllResourceLoads();
+    int64_t totalTime = getUSec(true) - start;
+
+    sortInt64(pLatencies, bufferCount);
+    LOGF(LogLevel::eINFO, "Resource loader stress test: %u threads, %u buffers, enqueue %.3f ms, complete %.3f ms", taskCount,
+         bufferCount, enqueueTime / 1000.0, totalTime / 1000.0);
+    LOGF(LogLevel::eINFO, "    addResource latency (us): p50 %lld, p99 %lld, p99.9 %lld, max %lld",
+         (long long)pLatencies[bufferCount / 2], (long long)pLatencies[(uint64_t)bufferCount * 99 / 100],
+         (long long)pLatencies[(uint64_t)bufferCount * 999 / 1000], (long long)pLatencies[bufferCount - 1]);
+
+    for (uint32_t i = 0; i < bufferCount; ++i)
+    {
+        ASSERT(ppBuffers[i]);
+        removeResource(ppBuffers[i]);
+    }
+    tf_free(pTasks);
+    tf_free(pLatencies);
+    tf_free(ppBuffers);
+}
+
+// Queues a backlog of low priority buffer uploads followed by one high priority upload and cancels half of the backlog.
+// Checks that the backlog completes in FIFO order, that cancelled loads still complete and logs how much of the backlog
+// was still pending when the high priority upload completed.
+#define RESOURCE_LOADER_PRIORITY_TEST_BUFFERS 256
+#define RESOURCE_LOADER_PRIORITY_TEST_SIZE    (256 * 1024)
+
+static void TestResourceLoaderPriorities()
+{
+    const uint32_t bufferCount = RESOURCE_LOADER_PRIORITY_TEST_BUFFERS + 1;
+    Buffer**       ppBuffers = (Buffer**)tf_calloc(bufferCount, sizeof(Buffer*));
+    SyncToken*     pTokens = (SyncToken*)tf_calloc(bufferCount, sizeof(SyncToken));
+    void*          pData = tf_calloc(1, RESOURCE_LOADER_PRIORITY_TEST_SIZE);
+
+    BufferLoadDesc loadDesc = {};
+    loadDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_BUFFER;
+    loadDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+    loadDesc.mDesc.mStartState = RESOURCE_STATE_COMMON;
+    loadDesc.mDesc.mSize = RESOURCE_LOADER_PRIORITY_TEST_SIZE;
+    loadDesc.pData = pData;
+    for (uint32_t i = 0; i < bufferCount; ++i)
+    {
+        loadDesc.mPriority = i < RESOURCE_LOADER_PRIORITY_TEST_BUFFERS ? RESOURCE_LOAD_PRIORITY_LOW : RESOURCE_LOAD_PRIORITY_HIGH;
+        loadDesc.ppBuffer = &ppBuffers[i];
+        addResource(&loadDesc, &pTokens[i]);
+    }
+    for (uint32_t i = 0; i < RESOURCE_LOADER_PRIORITY_TEST_BUFFERS; i += 2)
+    {
+        cancelResourceLoad(&pTokens[i]);
+    }
+
+    waitForToken(&pTokens[bufferCount - 1]);
+    // Low priority uploads are recorded in FIFO order, cancelled ones included, so once one of them is pending every later one is
+    // still pending as well. Later tokens are checked first, as the backlog keeps completing while we check.
+    uint32_t pendingCount = 0;
+    for (uint32_t i = RESOURCE_LOADER_PRIORITY_TEST_BUFFERS; i-- > 0;)
+    {
+        const bool completed = isTokenCompleted(&pTokens[i]);
+        ASSERT(completed || pendingCount == RESOURCE_LOADER_PRIORITY_TEST_BUFFERS - 1 - i);
+        pendingCount += !completed;
+    }
+    LOGF(LogLevel::eINFO, "Resource loader priority test: %u of %u low priority uploads pending when the high priority upload completed",
+         pendingCount, RESOURCE_LOADER_PRIORITY_TEST_BUFFERS);
+
+    waitForAllResourceLoads();
+    for (uint32_t i = 0; i < bufferCount; ++i)
+    {
+        // Cancelled loads complete like the others and keep their buffer
+        ASSERT(isTokenCompleted(&pTokens[i]));
+        ASSERT(ppBuffers[i]);
+        removeResource(ppBuffers[i]);
+    }
+    tf_free(pData);
+    tf_free(pTokens);
+    tf_free(ppBuffers);
+}
+
+// Resource loader IO benchmark: loads every texture of this sample many times and measures the time until the last token
+// completes for different numbers of resource loader IO threads. 0 IO threads reads the files on the streamer thread.
+#define RESOURCE_LOADER_IO_BENCHMARK_COPIES 16
+
+static void BenchmarkResourceLoaderIoThreads()
+{
+    const uint32_t ioThreadCounts[] = { 0, 1, 2, 4, 8 };
+    const uint32_t imageCount = TF_ARRAY_COUNT(pImageFileNames);
+    const uint32_t fileCount = imageCount + TF_ARRAY_COUNT(pSkyBoxImageFileNames);
+    const uint32_t textureCount = fileCount * RESOURCE_LOADER_IO_BENCHMARK_COPIES;
+    Texture**      ppTextures = (Texture**)tf_calloc(textureCount, sizeof(Texture*));
+
+    for (uint32_t t = 0; t < TF_ARRAY_COUNT(ioThreadCounts); ++t)
+    {
+        exitResourceLoaderInterface(&pRenderer, 1);
+        ResourceLoaderDesc resourceLoaderDesc = gDefaultResourceLoaderDesc;
+        resourceLoaderDesc.mIoThreadCount = ioThreadCounts[t];
+        initResourceLoaderInterface(&pRenderer, 1, &resourceLoaderDesc);
+
+        int64_t   start = getUSec(true);
+        SyncToken token = {};
+        for (uint32_t i = 0; i < textureCount; ++i)
+        {
+            uint32_t        fileIndex = i % fileCount;
+            TextureLoadDesc textureDesc = {};
+            textureDesc.pFileName = fileIndex < imageCount ? pImageFileNames[fileIndex] : pSkyBoxImageFileNames[fileIndex - imageCount];
+            textureDesc.ppTexture = &ppTextures[i];
+            textureDesc.mCreationFlag = TEXTURE_CREATION_FLAG_SRGB;
+            addResource(&textureDesc, &token);
+        }
+        waitForToken(&token);
+        int64_t time = getUSec(true) - start;
+
+        LOGF(LogLevel::eINFO, "Resource loader IO benchmark: %u IO threads, %u textures, last token after %.3f ms", ioThreadCounts[t],
+             textureCount, time / 1000.0);
+
+        for (uint32_t i = 0; i < textureCount; ++i)
+        {
+            removeResource(ppTextures[i]);
+            ppTextures[i] = NULL;
+        }
+    }
+
+    exitResourceLoaderInterface(&pRenderer, 1);
+    initResourceLoaderInterface(&pRenderer, 1, &gDefaultResourceLoaderDesc);
+
+    tf_free(ppTextures);
+}
+
+// Geometry buffer allocator benchmark: keeps a GeometryBuffer index buffer full of randomly sized parts and replaces random parts
+// with new ones, logging the average addGeometryBufferPart / removeGeometryBufferPart time and the resulting fragmentation.
+#define GEOMETRY_BUFFER_BENCHMARK_SIZE       (64u * 1024u * 1024u)
+#define GEOMETRY_BUFFER_BENCHMARK_PARTS      32768
+#define GEOMETRY_BUFFER_BENCHMARK_ITERATIONS 262144
+
+static uint32_t GeometryBufferBenchmarkRandom(uint32_t* pState)
+{
+    // xorshift32
+    uint32_t x = *pState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *pState = x;
+    return x;
+}
+
+static void BenchmarkGeometryBufferAllocator()
+{
+    static const uint32_t alignments[] = { 0, 4, 12, 16, 20, 32 };
+
+    GeometryBuffer*        pGeometryBuffer = NULL;
+    GeometryBufferLoadDesc bufferDesc = {};
+    bufferDesc.mStartState = RESOURCE_STATE_COMMON;
+    bufferDesc.mIndicesSize = GEOMETRY_BUFFER_BENCHMARK_SIZE;
+    bufferDesc.pNameIndexBuffer = "GeometryBuffer allocator benchmark";
+    bufferDesc.pOutGeometryBuffer = &pGeometryBuffer;
+    addGeometryBuffer(&bufferDesc);
+    waitForAllResourceLoads();
+
+    BufferChunkAllocator* pAllocator = &pGeometryBuffer->mIndex;
+    BufferChunk*          pParts = (BufferChunk*)tf_calloc(GEOMETRY_BUFFER_BENCHMARK_PARTS, sizeof(BufferChunk));
+    uint32_t              seed = 0x9E3779B9u;
+
+    for (uint32_t i = 0; i < GEOMETRY_BUFFER_BENCHMARK_PARTS; ++i)
+    {
+        const uint32_t size = 64 + GeometryBufferBenchmarkRandom(&seed) % 2048;
+        const uint32_t alignment = alignments[GeometryBufferBenchmarkRandom(&seed) % TF_ARRAY_COUNT(alignments)];
+        addGeometryBufferPart(pAllocator, size, alignment, &pParts[i]);
+    }
+
+    int64_t addTime = 0;
+    int64_t removeTime = 0;
+    for (uint32_t i = 0; i < GEOMETRY_BUFFER_BENCHMARK_ITERATIONS; ++i)
+    {
+        BufferChunk*   pPart = &pParts[GeometryBufferBenchmarkRandom(&seed) % GEOMETRY_BUFFER_BENCHMARK_PARTS];
+        const uint32_t size = 64 + GeometryBufferBenchmarkRandom(&seed) % 2048;
+        const uint32_t alignment = alignments[GeometryBufferBenchmarkRandom(&seed) % TF_ARRAY_COUNT(alignments)];
+
+        int64_t start = getUSec(true);
+        removeGeometryBufferPart(pAllocator, pPart);
+        int64_t mid = getUSec(true);
+        addGeometryBufferPart(pAllocator, size, alignment, pPart);
+        int64_t end = getUSec(true);
+
+        removeTime += mid - start;
+        addTime += end - mid;
+    }
+
+    BufferChunkAllocatorStats stats = {};
+    getBufferChunkAllocatorStats(pAllocator, &stats);
+    LOGF(LogLevel::eINFO,
+         "Geometry buffer allocator benchmark: %u parts, %u iterations, add %.3f us, remove %.3f us, %u unused chunks, %u unused bytes, "
+         "largest unused chunk %u bytes, fragmentation %.3f",
+         stats.mUsedChunkCount, GEOMETRY_BUFFER_BENCHMARK_ITERATIONS, (double)addTime / GEOMETRY_BUFFER_BENCHMARK_ITERATIONS,
+         (double)removeTime / GEOMETRY_BUFFER_BENCHMARK_ITERATIONS, stats.mUnusedChunkCount, stats.mUnusedSize, stats.mLargestUnusedChunk,
+         stats.mFragmentation);
+
+    for (uint32_t i = 0; i < GEOMETRY_BUFFER_BENCHMARK_PARTS; ++i)
+    {
+        removeGeometryBufferPart(pAllocator, &pParts[i]);
+    }
+    tf_free(pParts);
+    removeGeometryBuffer(pGeometryBuffer);
+}
+
 class MultiThread: public IApp
 {
 public:
@@ -217,6 +482,22 @@ public:
         gTotalParticleCount = 750000;
         bShowThreadsPlot = false;
 #endif // ANDROID
+        ReadCmdArgs();
+    }
+
+    void ReadCmdArgs()
+    {
+        for (int i = 0; i < argc; i += 1)
+        {
+            if (strcmp(argv[i], "--resource-loader-stress-test") == 0)
+                gRunResourceLoaderStressTest = true;
+            else if (strcmp(argv[i], "--io-thread-benchmark") == 0)
+                gRunIoThreadBenchmark = true;
+            else if (strcmp(argv[i], "--priority-test") == 0)
+                gRunPriorityTest = true;
+            else if (strcmp(argv[i], "--geometry-allocator-benchmark") == 0)
+                gRunGeometryAllocatorBenchmark = true;
+        }
     }
 
     bool Init() override
@@ -489,6 +770,15 @@ public:
         waitForAllResourceLoads();
         LOGF(LogLevel::eINFO, "Load Time %lld", getHiresTimerUSec(&timer, false) / 1000);
 
+        if (gRunResourceLoaderStressTest)
+            StressTestResourceLoader(gThreadSystem);
+        if (gRunGeometryAllocatorBenchmark)
+            BenchmarkGeometryBufferAllocator();
+        if (gRunPriorityTest)
+            TestResourceLoaderPriorities();
+        if (gRunIoThreadBenchmark)
+            BenchmarkResourceLoaderIoThreads();
+
         CameraMotionParameters cmp{ 100.0f, 800.0f, 1000.0f };
         vec3                   camPos{ 24.0f, 24.0f, 10.0f };
         vec3                   lookAt{ 0 };
@@ -38,6 +38,7 @@
 #include "../../../../Common_3/Resources/ResourceLoader/Interfaces/IResourceLoader.h"
 #include "../../../../Common_3/Utilities/Interfaces/IFileSystem.h"
 #include "../../../../Common_3/Utilities/Interfaces/ILog.h"
+#include "../../../../Common_3/Utilities/Interfaces/IThread.h"
 #include "../../../../Common_3/Utilities/Interfaces/ITime.h"
 
 #include "../../../../Common_3/Utilities/RingBuffer.h"
@@ -166,6 +167,9 @@ VertexLayout gVertexLayoutDefault = {};
 
 IFileSystem gArchiveFileSystem = { 0 };
 
+// The asynchronous read benchmark writes and reads several hundred MB, it only runs with --async-read-benchmark
+bool gRunAsyncReadBenchmark = false;
+
 // numbers stored in a file they way each 8 byte value is an index (0,1,2,3,4,5,...).
 // This way we can easily test seek feature for various compression formats.
 const int   gNumbersFileCount = 3;
@@ -578,6 +582,535 @@ static bool runArchiveSeekTests()
     return testSuccess;
 }
 
+// Every thread reads all numbers files of its own archive stream view ARCHIVE_READER_PASSES times
+#define ARCHIVE_READER_MAX_THREADS 16
+#define ARCHIVE_READER_PASSES      4
+
+struct ArchiveReaderThreadData
+{
+    IFileSystem* pArchive;
+    uint64_t     mBytesRead;
+    bool         mSuccess;
+};
+
+static void archiveReaderThread(void* pData)
+{
+    ArchiveReaderThreadData* pThread = (ArchiveReaderThreadData*)pData;
+    for (uint32_t pass = 0; pass < ARCHIVE_READER_PASSES && pThread->mSuccess; ++pass)
+    {
+        for (int i = 0; i < gNumbersFileCount && pThread->mSuccess; ++i)
+        {
+            uint64_t   nodeId = 0;
+            FileStream fs;
+            if (!fsArchiveGetNodeId(pThread->pArchive, gNumbersFileNames[i], &nodeId) ||
+                !fsIoOpenByUid(pThread->pArchive, nodeId, FM_READ, &fs))
+            {
+                pThread->mSuccess = false;
+                break;
+            }
+
+            uint64_t buffer[8 * 1024];
+            uint64_t index = 0;
+            size_t   readSize;
+            while ((readSize = fsReadFromStream(&fs, buffer, sizeof(buffer))) != 0)
+            {
+                pThread->mSuccess = pThread->mSuccess && buffer[0] == index;
+                index += readSize / 8;
+                pThread->mBytesRead += readSize;
+            }
+            fsCloseStream(&fs);
+        }
+    }
+}
+
+static bool runArchiveReaderThreads(IFileSystem* pArchive, const char* name)
+{
+    bool success = true;
+    for (uint32_t threadCount = 1; threadCount <= ARCHIVE_READER_MAX_THREADS && success; threadCount *= 2)
+    {
+        ArchiveReaderThreadData threadData[ARCHIVE_READER_MAX_THREADS] = {};
+        ThreadHandle            threads[ARCHIVE_READER_MAX_THREADS] = {};
+
+        int64_t startTime = getUSec(true);
+        for (uint32_t t = 0; t < threadCount; ++t)
+        {
+            threadData[t].pArchive = pArchive;
+            threadData[t].mSuccess = true;
+
+            ThreadDesc threadDesc = {};
+            threadDesc.pFunc = archiveReaderThread;
+            threadDesc.pData = &threadData[t];
+            snprintf(threadDesc.mThreadName, MAX_THREAD_NAME_LENGTH, "ArchiveReader %u", t);
+            if (!initThread(&threadDesc, &threads[t]))
+            {
+                // the thread runs on the calling thread then
+                archiveReaderThread(&threadData[t]);
+                threads[t] = {};
+            }
+        }
+
+        uint64_t bytesRead = 0;
+        for (uint32_t t = 0; t < threadCount; ++t)
+        {
+            joinThread(threads[t]);
+            success = success && threadData[t].mSuccess;
+            bytesRead += threadData[t].mBytesRead;
+        }
+        int64_t time = getUSec(true) - startTime;
+
+        LOGF(eINFO, "Archive %s, %2u reader threads: %s (%.1f MB/s)", name, threadCount, humanReadableTime(time).str,
+             (double)bytesRead / (double)max(time, (int64_t)1));
+    }
+    return success;
+}
+
+// Compares concurrent reads of an archive opened on a file stream:
+// positional reads without a lock against seek+read pairs serialized by ArchiveOpenDesc::protectStreamCriticalSection
+static bool runArchiveReaderThreadBenchmark()
+{
+    struct ArchiveOpenDesc openDesc = { 0 };
+    openDesc.protectStreamCriticalSection = true;
+
+    FileStream stream = {};
+    if (!fsOpenStreamFromPath(RD_OTHER_FILES, pZipReadFile, FM_READ, &stream))
+        return false;
+    const bool readAt = fsStreamSupportsReadAt(&stream);
+
+    IFileSystem archive = {};
+    bool        success = fsArchiveOpenFromStream(&stream, &openDesc, &archive);
+    if (success)
+    {
+        success = runArchiveReaderThreads(&archive, readAt ? "positional reads" : "seek+read with lock");
+        fsArchiveClose(&archive);
+    }
+
+    // Same stream without positional reads, archive falls back to seek+read under the lock
+    if (success && readAt)
+    {
+        IFileSystem  seekReadIO = *stream.pIO;
+        IFileSystem* pStreamIO = stream.pIO;
+        seekReadIO.ReadAt = NULL;
+        stream.pIO = &seekReadIO;
+        success = fsArchiveOpenFromStream(&stream, &openDesc, &archive);
+        if (success)
+        {
+            success = runArchiveReaderThreads(&archive, "seek+read with lock");
+            fsArchiveClose(&archive);
+        }
+        stream.pIO = pStreamIO;
+    }
+
+    fsCloseStream(&stream);
+    return success;
+}
+
+// Random access reads ARCHIVE_CACHE_RANDOM_READS spans of 64 numbers at pseudo random offsets
+#define ARCHIVE_CACHE_RANDOM_READS 4096
+
+static bool runArchiveCacheWorkload(IFileSystem* pArchive, bool randomAccess, uint64_t* pOutBytesRead)
+{
+    uint32_t seed = 0x2545F491;
+    for (int i = 0; i < gNumbersFileCount; ++i)
+    {
+        uint64_t   nodeId = 0;
+        FileStream fs;
+        if (!fsArchiveGetNodeId(pArchive, gNumbersFileNames[i], &nodeId) || !fsIoOpenByUid(pArchive, nodeId, FM_READ, &fs))
+            return false;
+
+        bool           success = true;
+        const uint64_t numberCount = (uint64_t)fsGetStreamFileSize(&fs) / 8;
+        uint64_t       buffer[512];
+        if (randomAccess)
+        {
+            const uint64_t spanCount = 64;
+            for (uint32_t r = 0; r < ARCHIVE_CACHE_RANDOM_READS && success && numberCount > spanCount; ++r)
+            {
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                const uint64_t index = seed % (numberCount - spanCount);
+                success = fsSeekStream(&fs, SBO_START_OF_FILE, (ssize_t)(index * 8)) &&
+                          fsReadFromStream(&fs, buffer, spanCount * 8) == spanCount * 8 && buffer[0] == index &&
+                          buffer[spanCount - 1] == index + spanCount - 1;
+                *pOutBytesRead += spanCount * 8;
+            }
+        }
+        else
+        {
+            uint64_t index = 0;
+            size_t   readSize;
+            while (success && (readSize = fsReadFromStream(&fs, buffer, sizeof(buffer))) != 0)
+            {
+                success = buffer[0] == index && buffer[readSize / 8 - 1] == index + readSize / 8 - 1;
+                index += readSize / 8;
+                *pOutBytesRead += readSize;
+            }
+            success = success && index == numberCount;
+        }
+        fsCloseStream(&fs);
+
+        if (!success)
+            return false;
+    }
+    return true;
+}
+
+// Compares sequential and random access reads of an archive without a block cache,
+// with the decompressed block cache and with the cache plus read-ahead
+static bool runArchiveBlockCacheBenchmark()
+{
+    struct ArchiveOpenDesc openDescs[3] = {};
+    openDescs[1].blockCacheSize = 32 * 1024 * 1024;
+    openDescs[2].blockCacheSize = 32 * 1024 * 1024;
+    openDescs[2].readAheadBlockCount = 8;
+    openDescs[2].readAheadThreadCount = 2;
+    const char* configNames[] = { "no cache", "block cache", "block cache + read-ahead" };
+
+    bool success = true;
+    for (uint32_t c = 0; c < TF_ARRAY_COUNT(openDescs) && success; ++c)
+    {
+        for (uint32_t randomAccess = 0; randomAccess < 2 && success; ++randomAccess)
+        {
+            IFileSystem archive = {};
+            if (!fsArchiveOpen(RD_OTHER_FILES, pZipReadFile, &openDescs[c], &archive))
+                return false;
+
+            uint64_t bytesRead = 0;
+            int64_t  startTime = getUSec(true);
+            // second pass shows the warm cache
+            for (uint32_t pass = 0; pass < 2 && success; ++pass)
+                success = runArchiveCacheWorkload(&archive, randomAccess, &bytesRead);
+            int64_t time = getUSec(true) - startTime;
+
+            struct BunyArBlockCacheStats stats = {};
+            if (fsArchiveGetBlockCacheStats(&archive, &stats))
+            {
+                const uint64_t lookups = max(stats.hitCount + stats.missCount, (uint64_t)1);
+                LOGF(eINFO,
+                     "Archive %s, %s reads: %s (%.1f MB/s), hit rate %.1f%%, read-ahead %llu/%llu used, %llu evictions, %s of %s used",
+                     configNames[c], randomAccess ? "random" : "sequential", humanReadableTime(time).str,
+                     (double)bytesRead / (double)max(time, (int64_t)1), 100.0 * (double)stats.hitCount / (double)lookups,
+                     (unsigned long long)stats.readAheadUsedCount, (unsigned long long)stats.readAheadCount,
+                     (unsigned long long)stats.evictionCount, humanReadableSize(stats.usedSize).str,
+                     humanReadableSize(stats.budget).str);
+            }
+            else
+            {
+                LOGF(eINFO, "Archive %s, %s reads: %s (%.1f MB/s)", configNames[c], randomAccess ? "random" : "sequential",
+                     humanReadableTime(time).str, (double)bytesRead / (double)max(time, (int64_t)1));
+            }
+
+            fsArchiveClose(&archive);
+        }
+    }
+
+    if (!success)
+        LOGF(eERROR, "Archive block cache benchmark failed.");
+    return success;
+}
+
+// Reads every numbers file with a single read call, so all blocks of a file are decompressed in parallel
+static bool runArchiveParallelDecompressionBenchmark()
+{
+    const uint32_t coreCount = getNumCPUCores();
+
+    bool success = true;
+    // 0 threads decompresses on the reading thread only, the reading thread takes part in every other case as well
+    for (uint32_t threadCount = 0; threadCount < coreCount * 2 && success; threadCount = threadCount ? threadCount * 2 : 1)
+    {
+        struct ArchiveOpenDesc openDesc = {};
+        openDesc.decompressionThreadCount = threadCount;
+
+        IFileSystem archive = {};
+        if (!fsArchiveOpen(RD_OTHER_FILES, pZipReadFile, &openDesc, &archive))
+            return false;
+
+        for (int i = 0; i < gNumbersFileCount && success; ++i)
+        {
+            uint64_t   nodeId = 0;
+            FileStream fs;
+            if (!fsArchiveGetNodeId(&archive, gNumbersFileNames[i], &nodeId) || !fsIoOpenByUid(&archive, nodeId, FM_READ, &fs))
+            {
+                success = false;
+                break;
+            }
+
+            const size_t fileSize = (size_t)fsGetStreamFileSize(&fs);
+            uint64_t*    numbers = (uint64_t*)tf_malloc(fileSize);
+
+            const uint32_t passCount = 4;
+            int64_t        startTime = getUSec(true);
+            for (uint32_t pass = 0; pass < passCount && success; ++pass)
+            {
+                success = fsSeekStream(&fs, SBO_START_OF_FILE, 0) && fsReadFromStream(&fs, numbers, fileSize) == fileSize;
+            }
+            int64_t time = getUSec(true) - startTime;
+
+            for (size_t n = 0; n < fileSize / 8 && success; ++n)
+                success = numbers[n] == n;
+
+            tf_free(numbers);
+            fsCloseStream(&fs);
+
+            LOGF(eINFO, "Archive file %s read in one call, %u decompression threads, %u cores: %s (%.1f MB/s)", gNumbersFileNames[i],
+                 threadCount, coreCount, humanReadableTime(time / passCount).str,
+                 (double)fileSize * passCount / (double)max(time, (int64_t)1));
+        }
+
+        fsArchiveClose(&archive);
+    }
+
+    if (!success)
+        LOGF(eERROR, "Archive parallel decompression benchmark failed.");
+    return success;
+}
+
+// Async reads of archive streams go through the thread pool, every read checks the values of numbers files
+static bool runAsyncReadTests()
+{
+    const uint32_t readCount = 64;
+    const uint64_t readSize = 4 * 1024;
+
+    bool success = true;
+    for (int i = 0; i < gNumbersFileCount && success; ++i)
+    {
+        FileStream fs;
+        if (!fsOpenStreamFromPath(RD_ARCHIVE_TEST, gNumbersFileNames[i], FM_READ, &fs))
+            return false;
+
+        const uint64_t fileSize = (uint64_t)fsGetStreamFileSize(&fs);
+        uint64_t*      pData = (uint64_t*)tf_malloc(readCount * readSize);
+        FsAsyncRead    reads[readCount] = {};
+        for (uint32_t r = 0; r < readCount; ++r)
+        {
+            // reads are spread over the whole file in reverse order
+            const uint64_t offset = ((readCount - 1 - r) * (fileSize / readCount)) & ~7ull;
+            fsReadAsync(&fs, offset, readSize, pData + r * readSize / 8, &reads[r]);
+        }
+        fsSubmitAsyncReads();
+        fsWaitAsyncReads(UINT32_MAX);
+
+        for (uint32_t r = 0; r < readCount && success; ++r)
+        {
+            const uint64_t* pValues = pData + r * readSize / 8;
+            success = fsIsAsyncReadDone(&reads[r]) && reads[r].mBytesRead == readSize && reads[r].mError == FS_SUCCESS &&
+                      pValues[0] == reads[r].mOffset / 8 && pValues[readSize / 8 - 1] == reads[r].mOffset / 8 + readSize / 8 - 1;
+        }
+        // Seek position of the stream is not affected by async reads
+        success = success && fsGetStreamSeekPosition(&fs) == 0;
+
+        tf_free(pData);
+        fsCloseStream(&fs);
+        LOGF(eINFO, "Async read test for file %s %s.", gNumbersFileNames[i], success ? "success" : "failure");
+    }
+    return success;
+}
+
+// Files of the async read benchmark are generated into RD_LOG once.
+// Set ASYNC_READ_LARGE_FILE_SIZE to a few GB to benchmark large files, the OS file cache makes the results optimistic otherwise.
+#define ASYNC_READ_SMALL_FILE_COUNT 10000
+#define ASYNC_READ_SMALL_FILE_SIZE  (4 * 1024)
+// small files are opened in batches to stay below the open file limit
+#define ASYNC_READ_SMALL_FILE_BATCH 512
+#define ASYNC_READ_LARGE_FILE_COUNT 2
+#define ASYNC_READ_LARGE_FILE_SIZE  ((uint64_t)256 * 1024 * 1024)
+#define ASYNC_READ_LARGE_BLOCK_SIZE (1024 * 1024)
+#define ASYNC_READ_MAX_QUEUE_DEPTH  64
+
+// Every 8 byte value of the file is its own index, same as the numbers files
+static bool prepareAsyncReadFile(const char* fileName, uint64_t size)
+{
+    FileStream fs;
+    if (fsOpenStreamFromPath(RD_LOG, fileName, FM_READ, &fs))
+    {
+        const bool valid = fsGetStreamFileSize(&fs) == (ssize_t)size;
+        fsCloseStream(&fs);
+        if (valid)
+            return true;
+    }
+
+    if (!fsOpenStreamFromPath(RD_LOG, fileName, FM_WRITE, &fs))
+        return false;
+
+    uint64_t block[512];
+    bool     success = true;
+    for (uint64_t offset = 0; offset < size && success; offset += sizeof(block))
+    {
+        for (uint64_t i = 0; i < TF_ARRAY_COUNT(block); ++i)
+            block[i] = offset / 8 + i;
+        const size_t writeSize = (size_t)min((uint64_t)sizeof(block), size - offset);
+        success = fsWriteToStream(&fs, block, writeSize) == writeSize;
+    }
+    fsCloseStream(&fs);
+    return success;
+}
+
+struct AsyncReadBenchmarkSlot
+{
+    FsAsyncRead mRead;
+    uint64_t*   pBuffer;
+    uint64_t    mFileSize;
+    uint64_t    mStride;
+    uint64_t    mBytesRead;
+    bool        mValid;
+};
+
+// Every slot reads each queue depth'th block of the file, the next block is queued from the completion of the previous one
+static void onAsyncReadBenchmarkBlock(FsAsyncRead* pRead)
+{
+    AsyncReadBenchmarkSlot* pSlot = (AsyncReadBenchmarkSlot*)pRead->pUserData;
+    pSlot->mBytesRead += pRead->mBytesRead;
+    pSlot->mValid = pSlot->mValid && pRead->mError == FS_SUCCESS && pRead->mBytesRead && pSlot->pBuffer[0] == pRead->mOffset / 8;
+
+    const uint64_t nextOffset = pRead->mOffset + pSlot->mStride;
+    if (pSlot->mValid && nextOffset < pSlot->mFileSize)
+    {
+        const uint64_t size = min((uint64_t)ASYNC_READ_LARGE_BLOCK_SIZE, pSlot->mFileSize - nextOffset);
+        fsReadAsync(pRead->pStream, nextOffset, size, pSlot->pBuffer, pRead);
+        pRead->pCompletion = onAsyncReadBenchmarkBlock;
+        pRead->pUserData = pSlot;
+    }
+}
+
+static bool runAsyncReadSmallFiles(uint64_t* pOutBytesRead)
+{
+    FileStream* pStreams = (FileStream*)tf_calloc(ASYNC_READ_SMALL_FILE_BATCH, sizeof(FileStream));
+    FsAsyncRead* pReads = (FsAsyncRead*)tf_calloc(ASYNC_READ_SMALL_FILE_BATCH, sizeof(FsAsyncRead));
+    uint64_t*    pData = (uint64_t*)tf_malloc(ASYNC_READ_SMALL_FILE_BATCH * ASYNC_READ_SMALL_FILE_SIZE);
+
+    bool success = true;
+    for (uint32_t first = 0; first < ASYNC_READ_SMALL_FILE_COUNT && success; first += ASYNC_READ_SMALL_FILE_BATCH)
+    {
+        const uint32_t count = min((uint32_t)ASYNC_READ_SMALL_FILE_BATCH, (uint32_t)ASYNC_READ_SMALL_FILE_COUNT - first);
+        for (uint32_t i = 0; i < count && success; ++i)
+        {
+            char fileName[64];
+            snprintf(fileName, sizeof(fileName), "AsyncReadSmall_%05u.bin", first + i);
+            success = fsOpenStreamFromPath(RD_LOG, fileName, FM_READ, &pStreams[i]) &&
+                      fsReadAsync(&pStreams[i], 0, ASYNC_READ_SMALL_FILE_SIZE, pData + i * ASYNC_READ_SMALL_FILE_SIZE / 8, &pReads[i]);
+        }
+        fsSubmitAsyncReads();
+        fsWaitAsyncReads(UINT32_MAX);
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            success = success && pReads[i].mBytesRead == ASYNC_READ_SMALL_FILE_SIZE &&
+                      pData[i * ASYNC_READ_SMALL_FILE_SIZE / 8 + ASYNC_READ_SMALL_FILE_SIZE / 8 - 1] == ASYNC_READ_SMALL_FILE_SIZE / 8 - 1;
+            *pOutBytesRead += pReads[i].mBytesRead;
+            fsCloseStream(&pStreams[i]);
+        }
+    }
+
+    tf_free(pData);
+    tf_free(pReads);
+    tf_free(pStreams);
+    return success;
+}
+
+static bool runAsyncReadLargeFiles(uint32_t queueDepth, uint64_t* pOutBytesRead)
+{
+    AsyncReadBenchmarkSlot slots[ASYNC_READ_MAX_QUEUE_DEPTH] = {};
+    uint64_t*              pData = (uint64_t*)tf_malloc((size_t)queueDepth * ASYNC_READ_LARGE_BLOCK_SIZE);
+
+    bool success = true;
+    for (uint32_t f = 0; f < ASYNC_READ_LARGE_FILE_COUNT && success; ++f)
+    {
+        char fileName[64];
+        snprintf(fileName, sizeof(fileName), "AsyncReadLarge_%u.bin", f);
+        FileStream fs;
+        if (!fsOpenStreamFromPath(RD_LOG, fileName, FM_READ, &fs))
+        {
+            success = false;
+            break;
+        }
+
+        for (uint32_t i = 0; i < queueDepth; ++i)
+        {
+            AsyncReadBenchmarkSlot* pSlot = &slots[i];
+            pSlot->pBuffer = pData + (size_t)i * ASYNC_READ_LARGE_BLOCK_SIZE / 8;
+            pSlot->mFileSize = ASYNC_READ_LARGE_FILE_SIZE;
+            pSlot->mStride = (uint64_t)queueDepth * ASYNC_READ_LARGE_BLOCK_SIZE;
+            pSlot->mBytesRead = 0;
+            pSlot->mValid = true;
+
+            const uint64_t offset = (uint64_t)i * ASYNC_READ_LARGE_BLOCK_SIZE;
+            if (offset >= ASYNC_READ_LARGE_FILE_SIZE)
+                continue;
+            fsReadAsync(&fs, offset, min((uint64_t)ASYNC_READ_LARGE_BLOCK_SIZE, ASYNC_READ_LARGE_FILE_SIZE - offset), pSlot->pBuffer,
+                        &pSlot->mRead);
+            pSlot->mRead.pCompletion = onAsyncReadBenchmarkBlock;
+            pSlot->mRead.pUserData = pSlot;
+        }
+        fsSubmitAsyncReads();
+        fsWaitAsyncReads(UINT32_MAX);
+
+        uint64_t bytesRead = 0;
+        for (uint32_t i = 0; i < queueDepth; ++i)
+        {
+            success = success && slots[i].mValid;
+            bytesRead += slots[i].mBytesRead;
+        }
+        success = success && bytesRead == ASYNC_READ_LARGE_FILE_SIZE;
+        *pOutBytesRead += bytesRead;
+        fsCloseStream(&fs);
+    }
+
+    tf_free(pData);
+    return success;
+}
+
+static bool runAsyncReadBenchmark()
+{
+    for (uint32_t i = 0; i < ASYNC_READ_SMALL_FILE_COUNT; ++i)
+    {
+        char fileName[64];
+        snprintf(fileName, sizeof(fileName), "AsyncReadSmall_%05u.bin", i);
+        if (!prepareAsyncReadFile(fileName, ASYNC_READ_SMALL_FILE_SIZE))
+            return false;
+    }
+    for (uint32_t i = 0; i < ASYNC_READ_LARGE_FILE_COUNT; ++i)
+    {
+        char fileName[64];
+        snprintf(fileName, sizeof(fileName), "AsyncReadLarge_%u.bin", i);
+        if (!prepareAsyncReadFile(fileName, ASYNC_READ_LARGE_FILE_SIZE))
+            return false;
+    }
+
+    // native backend first, then the thread pool fallback for comparison
+    bool success = true;
+    for (uint32_t backend = 0; backend < 2 && success; ++backend)
+    {
+        for (uint32_t queueDepth = 1; queueDepth <= ASYNC_READ_MAX_QUEUE_DEPTH && success; queueDepth *= 2)
+        {
+            FsAsyncReadDesc desc = {};
+            desc.mQueueDepth = queueDepth;
+            desc.mDisableNativeBackend = backend != 0;
+            if (!fsInitAsyncReads(&desc))
+                return false;
+
+            uint64_t smallBytes = 0;
+            int64_t  smallTime = getUSec(true);
+            success = runAsyncReadSmallFiles(&smallBytes);
+            smallTime = getUSec(true) - smallTime;
+
+            uint64_t largeBytes = 0;
+            int64_t  largeTime = getUSec(true);
+            success = success && runAsyncReadLargeFiles(queueDepth, &largeBytes);
+            largeTime = getUSec(true) - largeTime;
+
+            LOGF(eINFO, "Async read %s, queue depth %2u: %u small files %s (%.1f MB/s), %u large files %s (%.1f MB/s)",
+                 fsGetAsyncReadBackendName(), queueDepth, ASYNC_READ_SMALL_FILE_COUNT, humanReadableTime(smallTime).str,
+                 (double)smallBytes / (double)max(smallTime, (int64_t)1), ASYNC_READ_LARGE_FILE_COUNT, humanReadableTime(largeTime).str,
+                 (double)largeBytes / (double)max(largeTime, (int64_t)1));
+            fsExitAsyncReads();
+        }
+    }
+
+    if (!success)
+        LOGF(eERROR, "Async read benchmark failed.");
+    return success;
+}
+
 static bool runTests()
 {
     if (!testFindStream("forward", fsFindStream))
@@ -593,6 +1126,21 @@ static bool runTests()
         return false;
     if (!runArchiveSeekTests())
         return false;
+    if (!runArchiveReaderThreadBenchmark())
+        return false;
+    if (!runArchiveBlockCacheBenchmark())
+        return false;
+    if (!runArchiveParallelDecompressionBenchmark())
+        return false;
+
+    if (!fsInitAsyncReads(NULL))
+        return false;
+    const bool asyncReadSuccess = runAsyncReadTests();
+    fsExitAsyncReads();
+    if (!asyncReadSuccess)
+        return false;
+    if (gRunAsyncReadBenchmark && !runAsyncReadBenchmark())
+        return false;
 
     LOGF(eINFO, "Archive tests succeded.");
 
@@ -602,6 +1150,17 @@ static bool runTests()
 class FileSystemUnitTest: public IApp
 {
 public:
+    FileSystemUnitTest() { ReadCmdArgs(); }
+
+    void ReadCmdArgs()
+    {
+        for (int i = 0; i < argc; i += 1)
+        {
+            if (strcmp(argv[i], "--async-read-benchmark") == 0)
+                gRunAsyncReadBenchmark = true;
+        }
+    }
+
     bool Init()
     {
         // Generate sphere vertex buffer
@@ -29,8 +29,11 @@
 #include "../../../../Common_3/Application/Interfaces/IFont.h"
 #include "../../../../Common_3/Application/Interfaces/IUI.h"
 #include "../../../../Common_3/Utilities/Interfaces/ILog.h"
+#include "../../../../Common_3/Utilities/Math/Algorithms.h"
 
 #include "AlgorithmsTest.h"
+#include "LogTest.h"
+#include "ThreadSystemTest.h"
 
 // Renderer
 #include "../../../../Common_3/Graphics/Interfaces/IGraphics.h"
@@ -47,6 +50,11 @@
 
 static const char appName[] = "36_AlgorithmsAndContainers";
 
+// The log benchmark floods the console and the log file from several threads, it only runs with --log-benchmark
+static bool gRunLogBenchmark = false;
+// Sort and thread system benchmarks take seconds on up to 100M elements, they only run with --benchmarks
+static bool gRunBenchmarks = false;
+
 #ifdef AUTOMATED_TESTING
 // This variable disables actual assertions for testing purposes
 // Should be initialized to true for bstrlib tests
@@ -54,10 +62,24 @@ extern "C" bool gIsBstrlibTest;
 #endif
 
 int testMatrices();
+int testGeometryBufferMovePlanner();
 
 class Transformations: public IApp
 {
 public:
+    Transformations() { ReadCmdArgs(); }
+
+    void ReadCmdArgs()
+    {
+        for (int i = 0; i < argc; i += 1)
+        {
+            if (strcmp(argv[i], "--log-benchmark") == 0)
+                gRunLogBenchmark = true;
+            else if (strcmp(argv[i], "--benchmarks") == 0)
+                gRunBenchmarks = true;
+        }
+    }
+
     bool Init()
     {
         //////////////////////////////////////////////
@@ -74,6 +96,67 @@ public:
             return false;
         }
 
+        ret = testKeyValueSort();
+        if (ret == 0)
+            LOGF(eINFO, "Key/value sort test success");
+        else
+        {
+            LOGF(eERROR, "Key/value sort test failed.");
+            ASSERT(false);
+            return false;
+        }
+        if (gRunBenchmarks)
+            benchmarkKeyValueSort();
+
+        ret = testThreadSystem();
+        if (ret == 0)
+            LOGF(eINFO, "Thread system test success");
+        else
+        {
+            LOGF(eERROR, "Thread system test failed.");
+            ASSERT(false);
+            return false;
+        }
+        if (gRunBenchmarks)
+        {
+            benchmarkThreadSystem();
+            benchmarkParallelFor();
+        }
+
+        ret = testParallelSort();
+        if (ret == 0)
+            LOGF(eINFO, "Parallel sort test success");
+        else
+        {
+            LOGF(eERROR, "Parallel sort test failed.");
+            ASSERT(false);
+            return false;
+        }
+        if (gRunBenchmarks)
+            benchmarkParallelSort();
+
+        ret = testAsyncLog();
+        if (ret == 0)
+            LOGF(eINFO, "Async log test success");
+        else
+        {
+            LOGF(eERROR, "Async log test failed.");
+            ASSERT(false);
+            return false;
+        }
+
+        ret = testBinaryLog();
+        if (ret == 0)
+            LOGF(eINFO, "Binary log test success");
+        else
+        {
+            LOGF(eERROR, "Binary log test failed.");
+            ASSERT(false);
+            return false;
+        }
+        if (gRunLogBenchmark)
+            benchmarkAsyncLog();
+
         ret = testMatrices();
         if (ret == 0)
             LOGF(eINFO, "Matrices test success");
@@ -84,6 +167,16 @@ public:
             return false;
         }
 
+        ret = testGeometryBufferMovePlanner();
+        if (ret == 0)
+            LOGF(eINFO, "Geometry buffer move planner test success");
+        else
+        {
+            LOGF(eERROR, "Geometry buffer move planner test failed.");
+            ASSERT(false);
+            return false;
+        }
+
 #ifdef AUTOMATED_TESTING
         gIsBstrlibTest = true;
         ret = runBstringTests();
@@ -219,3 +312,142 @@ int testMatrices()
 
     return 0;
 }
+
+// Unused chunks between the parts, parts sorted by offset
+static void geometryBufferGaps(const BufferChunk* pSortedParts, uint32_t partCount, uint32_t bufferSize, BufferChunk** ppOutGaps)
+{
+    arrsetlen(*ppOutGaps, 0);
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i <= partCount; ++i)
+    {
+        const uint32_t end = i < partCount ? pSortedParts[i].mOffset : bufferSize;
+        if (end > offset)
+        {
+            BufferChunk gap = { offset, end - offset };
+            arrpush(*ppOutGaps, gap);
+        }
+        if (i < partCount)
+            offset = pSortedParts[i].mOffset + pSortedParts[i].mSize;
+    }
+}
+
+static bool bufferChunkOffsetLess(const void* pLhs, const void* pRhs, void* pUserData)
+{
+    UNREF_PARAM(pUserData);
+    return ((const BufferChunk*)pLhs)->mOffset < ((const BufferChunk*)pRhs)->mOffset;
+}
+
+// Moves parts of a fragmented buffer with planGeometryBufferMoves until it converges, validating every step like the resource loader
+// would use it: destinations inside unused memory and not overlapping each other, aligned, within budget and closer to the buffer start.
+int testGeometryBufferMovePlanner()
+{
+    static const uint32_t alignments[] = { 0, 2, 4, 12, 16, 20 };
+    static const uint32_t budgets[] = { 0, 4096, 65536 };
+    const uint32_t        bufferSize = 1u << 20;
+    const uint32_t        maxParts = 2048;
+
+    BufferChunk*        pParts = (BufferChunk*)tf_calloc(maxParts, sizeof(BufferChunk));
+    uint32_t*           pAlignments = (uint32_t*)tf_calloc(maxParts, sizeof(uint32_t));
+    GeometryBufferMove* pMoves = (GeometryBufferMove*)tf_calloc(maxParts, sizeof(GeometryBufferMove));
+    BufferChunk*        pGaps = NULL;
+    int                 result = 0;
+
+    for (uint32_t test = 0; test < 12 && !result; ++test)
+    {
+        // Fragmented layout: parts separated by random holes
+        uint32_t partCount = 0;
+        uint32_t offset = 0;
+        while (partCount < maxParts)
+        {
+            const uint32_t alignment = alignments[randomInt(0, TF_ARRAY_COUNT(alignments))];
+            const uint32_t size = (uint32_t)randomInt(1, 64) * (alignment ? alignment : 3);
+            offset += (uint32_t)randomInt(0, 2048);
+            if (alignment > 1)
+                offset = (offset + alignment - 1) / alignment * alignment;
+            if (offset + size > bufferSize)
+                break;
+            pParts[partCount] = { offset, size };
+            pAlignments[partCount] = alignment;
+            ++partCount;
+            offset += size;
+        }
+
+        const uint32_t budget = budgets[test % TF_ARRAY_COUNT(budgets)];
+        uint32_t       round = 0;
+        for (;; ++round)
+        {
+            // The planner doesn't care about the part order, keep them shuffled with respect to offsets
+            BufferChunk* pSorted = (BufferChunk*)tf_malloc(partCount * sizeof(BufferChunk));
+            memcpy(pSorted, pParts, partCount * sizeof(BufferChunk));
+            sort(pSorted, partCount, sizeof(BufferChunk), bufferChunkOffsetLess, NULL);
+            geometryBufferGaps(pSorted, partCount, bufferSize, &pGaps);
+            tf_free(pSorted);
+
+            GeometryBufferMovePlanDesc planDesc = {};
+            planDesc.pUnusedChunks = pGaps;
+            planDesc.mUnusedChunkCount = (uint32_t)arrlenu(pGaps);
+            planDesc.pParts = pParts;
+            planDesc.pAlignments = pAlignments;
+            planDesc.mPartCount = partCount;
+            planDesc.mMaxBytes = budget;
+            const uint32_t moveCount = planGeometryBufferMoves(&planDesc, pMoves, maxParts);
+            if (!moveCount)
+                break;
+
+            uint64_t movedBytes = 0;
+            for (uint32_t m = 0; m < moveCount && !result; ++m)
+            {
+                const GeometryBufferMove* pMove = &pMoves[m];
+                const uint32_t            alignment = pAlignments[pMove->mPartIndex];
+                movedBytes += pMove->mDst.mSize;
+
+                bool inGap = false;
+                for (uint32_t g = 0; g < arrlenu(pGaps); ++g)
+                    inGap |= pGaps[g].mOffset <= pMove->mDst.mOffset &&
+                             pMove->mDst.mOffset + pMove->mDst.mSize <= pGaps[g].mOffset + pGaps[g].mSize;
+                for (uint32_t o = 0; o < m; ++o)
+                    inGap &= pMoves[o].mDst.mOffset + pMoves[o].mDst.mSize <= pMove->mDst.mOffset ||
+                             pMove->mDst.mOffset + pMove->mDst.mSize <= pMoves[o].mDst.mOffset;
+
+                if (!inGap || pMove->mSrc.mOffset != pParts[pMove->mPartIndex].mOffset || pMove->mDst.mSize != pMove->mSrc.mSize ||
+                    pMove->mDst.mOffset >= pMove->mSrc.mOffset || (alignment > 1 && pMove->mDst.mOffset % alignment))
+                {
+                    LOGF(eERROR, "Invalid move of part %u from %u to %u", pMove->mPartIndex, pMove->mSrc.mOffset, pMove->mDst.mOffset);
+                    result = 1;
+                }
+            }
+            if (budget && movedBytes > budget)
+            {
+                LOGF(eERROR, "Planned %llu bytes with a %u bytes budget", (unsigned long long)movedBytes, budget);
+                result = 1;
+            }
+            if (result || round > partCount)
+            {
+                result = 1;
+                break;
+            }
+
+            for (uint32_t m = 0; m < moveCount; ++m)
+                pParts[pMoves[m].mPartIndex] = pMoves[m].mDst;
+        }
+
+        uint32_t usedSize = 0;
+        uint32_t usedEnd = 0;
+        for (uint32_t i = 0; i < partCount; ++i)
+        {
+            usedSize += pParts[i].mSize;
+            usedEnd = max(usedEnd, pParts[i].mOffset + pParts[i].mSize);
+        }
+        LOGF(eINFO, "Geometry buffer move planner: %u parts, %u bytes used, packed into %u bytes after %u steps of %u bytes", partCount,
+             usedSize, usedEnd, round, budget);
+        // Only alignment padding should be left between the parts
+        if (usedEnd > usedSize + usedSize / 16)
+            result = 1;
+    }
+
+    arrfree(pGaps);
+    tf_free(pMoves);
+    tf_free(pAlignments);
+    tf_free(pParts);
+    return result;
+}
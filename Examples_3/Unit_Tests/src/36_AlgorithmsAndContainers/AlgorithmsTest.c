@@ -23,12 +23,21 @@
  */
 
 #include "../../../../Common_3/Utilities/Interfaces/ILog.h"
+#include "../../../../Common_3/Utilities/Interfaces/IThread.h"
+#include "../../../../Common_3/Utilities/Interfaces/ITime.h"
 
 #include "../../../../Common_3/Utilities/Math/Algorithms.h"
+#include "../../../../Common_3/Utilities/Math/AlgorithmsImpl.h"
+
+#include "../../../../Common_3/Utilities/Interfaces/IMemory.h"
+
+#define PARALLEL_SORT_TEST_THREAD_COUNT 3
+// Generic sort and partition benchmarks stop at 10M elements, radix sort goes up to 100M
+#define SORT_BENCHMARK_GENERIC_MAX_COUNT (10 * 1000 * 1000)
 
 //-V:TEST_STABLE_SORT:736
-#define TEST_STABLE_SORT(arr, expected, comp)                                 \
-    (checkassert(sizeof(arr) == sizeof(expected) && &arr[0] != &expected[0]), \
+#define TEST_STABLE_SORT(arr, expected, comp)                                               \
+    (checkassert(sizeof(arr) == sizeof(expected) && &arr[0] != &expected[0]),               \
      testStableSortImpl(arr, expected, sizeof(arr) / sizeof(arr[0]), sizeof(arr[0]), comp))
 
 #define ARR_SIZE(arr) sizeof(arr) / sizeof(arr[0])
@@ -161,3 +170,398 @@ int testStableSort(void)
 
     return 0;
 }
+
+/************************************************************************/
+// Parallel sort / partition
+/************************************************************************/
+typedef struct KeyIndex
+{
+    uint32_t key;
+    uint32_t index;
+} KeyIndex;
+
+static uint32_t nextRandom(uint32_t* pState)
+{
+    // xorshift32
+    uint32_t x = *pState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *pState = x;
+    return x;
+}
+
+static bool keyIndexLess(const void* pLhs, const void* pRhs, void* pUserData)
+{
+    UNREF_PARAM(pUserData);
+    return ((const KeyIndex*)pLhs)->key < ((const KeyIndex*)pRhs)->key;
+}
+
+static void fillKeyIndex(KeyIndex* pArr, size_t count, uint32_t keyRange, uint32_t* pSeed)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        pArr[i].key = nextRandom(pSeed) % keyRange;
+        pArr[i].index = (uint32_t)i;
+    }
+}
+
+static int testParallelStableSort(ThreadSystem threadSystem, size_t count, uint32_t* pSeed)
+{
+    KeyIndex* pArr = (KeyIndex*)tf_malloc(sizeof(KeyIndex) * count);
+    fillKeyIndex(pArr, count, 1000, pSeed);
+    parallelStableSort(threadSystem, pArr, count, sizeof(KeyIndex), keyIndexLess, NULL);
+
+    int ret = 0;
+    for (size_t i = 1; i < count; ++i)
+    {
+        if (pArr[i].key < pArr[i - 1].key || (pArr[i].key == pArr[i - 1].key && pArr[i].index < pArr[i - 1].index))
+        {
+            LOGF(eERROR, "Parallel stable sort of %zu elements failed at %zu", count, i);
+            ret = -1;
+            break;
+        }
+    }
+    tf_free(pArr);
+    return ret;
+}
+
+static int testParallelPartition(ThreadSystem threadSystem, size_t count, uint32_t* pSeed)
+{
+    if (count == 0)
+        return 0;
+
+    KeyIndex* pArr = (KeyIndex*)tf_malloc(sizeof(KeyIndex) * count);
+    KeyIndex* pExpected = (KeyIndex*)tf_malloc(sizeof(KeyIndex) * count);
+    fillKeyIndex(pArr, count, 1000, pSeed);
+    memcpy(pExpected, pArr, sizeof(KeyIndex) * count);
+
+    size_t   pivot = nextRandom(pSeed) % count;
+    KeyIndex pivotValue = pArr[pivot];
+    size_t   expectedPivot = partition(pExpected, pivot, count, sizeof(KeyIndex), keyIndexLess, NULL);
+    size_t   newPivot = parallelPartition(threadSystem, pArr, pivot, count, sizeof(KeyIndex), keyIndexLess, NULL);
+
+    int ret = 0;
+    if (newPivot != expectedPivot || memcmp(&pArr[newPivot], &pivotValue, sizeof(KeyIndex)) != 0)
+    {
+        LOGF(eERROR, "Parallel partition of %zu elements returned %zu, expected %zu", count, newPivot, expectedPivot);
+        ret = -1;
+    }
+    for (size_t i = 0; i < count && ret == 0; ++i)
+    {
+        if (i == newPivot)
+            continue;
+        // Both sides have to keep the original order of elements
+        bool wrongSide = (pArr[i].key < pivotValue.key) != (i < newPivot);
+        bool wrongOrder = i > 0 && i != newPivot + 1 && pArr[i].index < pArr[i - 1].index;
+        if (wrongSide || wrongOrder)
+        {
+            LOGF(eERROR, "Parallel partition of %zu elements failed at %zu", count, i);
+            ret = -1;
+        }
+    }
+
+    tf_free(pExpected);
+    tf_free(pArr);
+    return ret;
+}
+
+//-V:TEST_PARALLEL_RADIX_SORT:736
+// Compares parallel radix sort with the serial sort of the same type
+#define TEST_PARALLEL_RADIX_SORT(threadSystem, suffix, type, count, pSeed, GENERATE)                      \
+    {                                                                                                     \
+        type* pArr = (type*)tf_malloc(sizeof(type) * (count) + 1);                                        \
+        type* pExpected = (type*)tf_malloc(sizeof(type) * (count) + 1);                                   \
+        for (size_t i = 0; i < (count); ++i)                                                              \
+            pArr[i] = (type)(GENERATE(nextRandom(pSeed)));                                                \
+        memcpy(pExpected, pArr, sizeof(type) * (count));                                                  \
+        sort##suffix(pExpected, (count));                                                                 \
+        parallelSort##suffix((threadSystem), pArr, (count));                                              \
+        int result = memcmp(pArr, pExpected, sizeof(type) * (count));                                     \
+        tf_free(pExpected);                                                                               \
+        tf_free(pArr);                                                                                    \
+        if (result != 0)                                                                                  \
+        {                                                                                                 \
+            LOGF(eERROR, "Parallel sort" #suffix " of %zu elements doesn't match sort" #suffix, (count)); \
+            return -1;                                                                                    \
+        }                                                                                                 \
+    }
+
+#define RANDOM_BITS(x)      (x)
+#define RANDOM_SIGNED64(x)  ((int64_t)(((uint64_t)(x) << 32) - ((uint64_t)(x) << 7)))
+#define RANDOM_FLOAT(x)     (((float)(x) - 2147483648.0f) * 0.37f)
+#define RANDOM_DOUBLE(x)    (((double)(x) - 2147483648.0) * 1.0e-3)
+#define RANDOM_FEW_KEYS(x)  ((x) % 3)
+
+static int testParallelSortWith(ThreadSystem threadSystem)
+{
+    static const size_t counts[] = { 0, 1, 2, 31, 33, 257, 1000, 20000, 100003 };
+    uint32_t            seed = 0x9747b28c;
+
+    for (uint32_t i = 0; i < TF_ARRAY_COUNT(counts); ++i)
+    {
+        size_t count = counts[i];
+        if (testParallelStableSort(threadSystem, count, &seed) != 0 || testParallelPartition(threadSystem, count, &seed) != 0)
+            return -1;
+
+        TEST_PARALLEL_RADIX_SORT(threadSystem, Int8, int8_t, count, &seed, RANDOM_BITS);
+        TEST_PARALLEL_RADIX_SORT(threadSystem, Int16, int16_t, count, &seed, RANDOM_BITS);
+        TEST_PARALLEL_RADIX_SORT(threadSystem, Int32, int32_t, count, &seed, RANDOM_BITS);
+        TEST_PARALLEL_RADIX_SORT(threadSystem, Int64, int64_t, count, &seed, RANDOM_SIGNED64);
+        TEST_PARALLEL_RADIX_SORT(threadSystem, UInt8, uint8_t, count, &seed, RANDOM_BITS);
+        TEST_PARALLEL_RADIX_SORT(threadSystem, UInt16, uint16_t, count, &seed, RANDOM_BITS);
+        TEST_PARALLEL_RADIX_SORT(threadSystem, UInt32, uint32_t, count, &seed, RANDOM_BITS);
+        TEST_PARALLEL_RADIX_SORT(threadSystem, UInt32, uint32_t, count, &seed, RANDOM_FEW_KEYS);
+        TEST_PARALLEL_RADIX_SORT(threadSystem, UInt64, uint64_t, count, &seed, RANDOM_SIGNED64);
+        TEST_PARALLEL_RADIX_SORT(threadSystem, Float, float, count, &seed, RANDOM_FLOAT);
+        TEST_PARALLEL_RADIX_SORT(threadSystem, Double, double, count, &seed, RANDOM_DOUBLE);
+    }
+    return 0;
+}
+
+int testParallelSort(void)
+{
+    if (testParallelSortWith(NULL) != 0)
+        return -1;
+
+    struct ThreadSystemInitDesc desc = gThreadSystemInitDescDefault;
+    desc.threadCount = PARALLEL_SORT_TEST_THREAD_COUNT;
+    desc.threadName = "TestParallelSort";
+
+    int ret = -1;
+    for (uint32_t scheduler = 0; scheduler < 2; ++scheduler)
+    {
+        desc.scheduler = (ThreadSystemScheduler)scheduler;
+        ThreadSystem threadSystem = NULL;
+        if (!threadSystemInit(&threadSystem, &desc))
+            return -1;
+        ret = testParallelSortWith(threadSystem);
+        threadSystemExit(&threadSystem, &gThreadSystemExitDescDefault);
+        if (ret != 0)
+            break;
+    }
+    return ret;
+}
+
+static int64_t benchmarkBegin(void* pDst, const void* pSrc, size_t size)
+{
+    memcpy(pDst, pSrc, size);
+    return getUSec(true);
+}
+
+static void logBenchmarkTime(const char* name, size_t count, int64_t serialTime, int64_t time)
+{
+    LOGF(eINFO, "%-30s %10zu elements: %10.3f ms (x%5.2f)", name, count, (double)time / 1000.0,
+         (double)serialTime / (double)TF_MAX(time, 1));
+}
+
+int benchmarkParallelSort(void)
+{
+    static const size_t counts[] = { 1000 * 1000, 10 * 1000 * 1000, 100 * 1000 * 1000 };
+
+    struct ThreadSystemInitDesc desc = gThreadSystemInitDescDefault;
+    desc.scheduler = THREAD_SYSTEM_SCHEDULER_WORK_STEALING;
+    desc.threadCount = getNumCPUCores() - 1;
+    desc.threadName = "BenchParallelSort";
+
+    ThreadSystem threadSystem = NULL;
+    if (!threadSystemInit(&threadSystem, &desc))
+        return -1;
+
+    LOGF(eINFO, "Parallel sort benchmark, %u threads, speedup is relative to serial version", (uint32_t)desc.threadCount + 1);
+
+    uint32_t seed = 0x9747b28c;
+    for (uint32_t i = 0; i < TF_ARRAY_COUNT(counts); ++i)
+    {
+        const size_t count = counts[i];
+        uint32_t*    pSource = (uint32_t*)tf_malloc(sizeof(uint32_t) * count);
+        uint32_t*    pArr = (uint32_t*)tf_malloc(sizeof(uint32_t) * count);
+        if (!pSource || !pArr)
+        {
+            LOGF(eWARNING, "Not enough memory to benchmark sorting of %zu elements", count);
+            tf_free(pSource);
+            tf_free(pArr);
+            break;
+        }
+        for (size_t j = 0; j < count; ++j)
+            pSource[j] = nextRandom(&seed);
+
+        int64_t start = benchmarkBegin(pArr, pSource, sizeof(uint32_t) * count);
+        sortUInt32(pArr, count);
+        int64_t serialTime = getUSec(true) - start;
+        logBenchmarkTime("sortUInt32", count, serialTime, serialTime);
+
+        start = benchmarkBegin(pArr, pSource, sizeof(uint32_t) * count);
+        parallelSortUInt32(NULL, pArr, count);
+        logBenchmarkTime("parallelSortUInt32 (1 thread)", count, serialTime, getUSec(true) - start);
+
+        start = benchmarkBegin(pArr, pSource, sizeof(uint32_t) * count);
+        parallelSortUInt32(threadSystem, pArr, count);
+        logBenchmarkTime("parallelSortUInt32", count, serialTime, getUSec(true) - start);
+
+        for (size_t j = 0; j < count; ++j)
+            ((float*)pSource)[j] = (float)pSource[j] * 1.0e-3f - 2.0e6f;
+
+        start = benchmarkBegin(pArr, pSource, sizeof(float) * count);
+        sortFloat((float*)pArr, count);
+        serialTime = getUSec(true) - start;
+        logBenchmarkTime("sortFloat", count, serialTime, serialTime);
+
+        start = benchmarkBegin(pArr, pSource, sizeof(float) * count);
+        parallelSortFloat(threadSystem, (float*)pArr, count);
+        logBenchmarkTime("parallelSortFloat", count, serialTime, getUSec(true) - start);
+
+        tf_free(pArr);
+        tf_free(pSource);
+
+        if (count > SORT_BENCHMARK_GENERIC_MAX_COUNT)
+            continue;
+
+        KeyIndex* pKeySource = (KeyIndex*)tf_malloc(sizeof(KeyIndex) * count);
+        KeyIndex* pKeys = (KeyIndex*)tf_malloc(sizeof(KeyIndex) * count);
+        fillKeyIndex(pKeySource, count, UINT32_MAX, &seed);
+
+        start = benchmarkBegin(pKeys, pKeySource, sizeof(KeyIndex) * count);
+        sort(pKeys, count, sizeof(KeyIndex), keyIndexLess, NULL);
+        serialTime = getUSec(true) - start;
+        logBenchmarkTime("sort", count, serialTime, serialTime);
+
+        start = benchmarkBegin(pKeys, pKeySource, sizeof(KeyIndex) * count);
+        parallelStableSort(NULL, pKeys, count, sizeof(KeyIndex), keyIndexLess, NULL);
+        logBenchmarkTime("parallelStableSort (1 thread)", count, serialTime, getUSec(true) - start);
+
+        start = benchmarkBegin(pKeys, pKeySource, sizeof(KeyIndex) * count);
+        parallelStableSort(threadSystem, pKeys, count, sizeof(KeyIndex), keyIndexLess, NULL);
+        logBenchmarkTime("parallelStableSort", count, serialTime, getUSec(true) - start);
+
+        start = benchmarkBegin(pKeys, pKeySource, sizeof(KeyIndex) * count);
+        partition(pKeys, count / 2, count, sizeof(KeyIndex), keyIndexLess, NULL);
+        serialTime = getUSec(true) - start;
+        logBenchmarkTime("partition", count, serialTime, serialTime);
+
+        start = benchmarkBegin(pKeys, pKeySource, sizeof(KeyIndex) * count);
+        parallelPartition(threadSystem, pKeys, count / 2, count, sizeof(KeyIndex), keyIndexLess, NULL);
+        logBenchmarkTime("parallelPartition", count, serialTime, getUSec(true) - start);
+
+        tf_free(pKeys);
+        tf_free(pKeySource);
+    }
+
+    threadSystemExit(&threadSystem, &gThreadSystemExitDescDefault);
+    return 0;
+}
+
+/************************************************************************/
+// Key/value radix sort
+/************************************************************************/
+// Custom key/value type generated with the macro
+DEFINE_RADIX_SORT_KEY_VALUE_FUNCTION(static, sortInt16KeyUInt8Value, int16_t, uint16_t, uint8_t, RADIX_KEY_SIGNED, RADIX_KEY_SIGNED)
+
+//-V:TEST_KEY_VALUE_SORT:736
+// Sorts keys with their indices as values. Keys have to match sort<Type> and every value has to point
+// to its original key, with increasing indices for equal keys
+#define TEST_KEY_VALUE_SORT(keySuffix, sortFn, keyType, valueType, count, pSeed, GENERATE)                            \
+    {                                                                                                                 \
+        keyType*   pKeys = (keyType*)tf_malloc(sizeof(keyType) * (count) + 1);                                        \
+        keyType*   pSource = (keyType*)tf_malloc(sizeof(keyType) * (count) + 1);                                      \
+        keyType*   pExpected = (keyType*)tf_malloc(sizeof(keyType) * (count) + 1);                                    \
+        valueType* pValues = (valueType*)tf_malloc(sizeof(valueType) * (count) + 1);                                  \
+        for (size_t i = 0; i < (count); ++i)                                                                          \
+        {                                                                                                             \
+            pSource[i] = (keyType)(GENERATE(nextRandom(pSeed)));                                                      \
+            pValues[i] = (valueType)i;                                                                                \
+        }                                                                                                             \
+        memcpy(pKeys, pSource, sizeof(keyType) * (count));                                                            \
+        memcpy(pExpected, pSource, sizeof(keyType) * (count));                                                        \
+        sort##keySuffix(pExpected, (count));                                                                          \
+        sortFn(pKeys, pValues, (count));                                                                              \
+        bool failed = memcmp(pKeys, pExpected, sizeof(keyType) * (count)) != 0;                                       \
+        for (size_t i = 0; i < (count) && !failed; ++i)                                                               \
+        {                                                                                                             \
+            failed |= memcmp(&pSource[pValues[i]], &pKeys[i], sizeof(keyType)) != 0;                                  \
+            failed |= i > 0 && memcmp(&pKeys[i], &pKeys[i - 1], sizeof(keyType)) == 0 && pValues[i] < pValues[i - 1]; \
+        }                                                                                                             \
+        tf_free(pValues);                                                                                             \
+        tf_free(pExpected);                                                                                           \
+        tf_free(pSource);                                                                                             \
+        tf_free(pKeys);                                                                                               \
+        if (failed)                                                                                                   \
+        {                                                                                                             \
+            LOGF(eERROR, #sortFn " of %zu elements failed", (size_t)(count));                                         \
+            return -1;                                                                                                \
+        }                                                                                                             \
+    }
+
+#define RANDOM_BYTE(x)     ((x) & 0xFF)
+#define RANDOM_INT16(x)    ((int16_t)(x))
+#define RANDOM_HIGH_BITS(x) ((uint64_t)(x) << 40)
+
+int testKeyValueSort(void)
+{
+    // 70000 doesn't fit into 16 bit indices
+    static const size_t counts[] = { 0, 1, 2, 3, 100, 1001, 70000 };
+    uint32_t            seed = 0x9747b28c;
+
+    for (uint32_t i = 0; i < TF_ARRAY_COUNT(counts); ++i)
+    {
+        size_t count = counts[i];
+        TEST_KEY_VALUE_SORT(UInt32, sortUInt32KeyValue, uint32_t, uint32_t, count, &seed, RANDOM_BITS);
+        TEST_KEY_VALUE_SORT(UInt32, sortUInt32KeyValue, uint32_t, uint32_t, count, &seed, RANDOM_FEW_KEYS);
+        TEST_KEY_VALUE_SORT(UInt64, sortUInt64KeyValue, uint64_t, uint64_t, count, &seed, RANDOM_SIGNED64);
+        TEST_KEY_VALUE_SORT(UInt32, sortUInt32KeyIndex, uint32_t, uint32_t, count, &seed, RANDOM_BYTE);
+        TEST_KEY_VALUE_SORT(UInt64, sortUInt64KeyIndex, uint64_t, uint32_t, count, &seed, RANDOM_HIGH_BITS);
+        TEST_KEY_VALUE_SORT(Float, sortFloatKeyIndex, float, uint32_t, count, &seed, RANDOM_FLOAT);
+        TEST_KEY_VALUE_SORT(Float, sortFloatKeyIndex, float, uint32_t, count, &seed, RANDOM_FEW_KEYS);
+        TEST_KEY_VALUE_SORT(Double, sortDoubleKeyIndex, double, uint32_t, count, &seed, RANDOM_DOUBLE);
+        if (count < 256)
+            TEST_KEY_VALUE_SORT(Int16, sortInt16KeyUInt8Value, int16_t, uint8_t, count, &seed, RANDOM_INT16);
+    }
+    return 0;
+}
+
+typedef struct DrawKeyLookup
+{
+    const float* pKeys;
+} DrawKeyLookup;
+
+static bool drawIndexLess(const void* pLhs, const void* pRhs, void* pUserData)
+{
+    const float* pKeys = ((const DrawKeyLookup*)pUserData)->pKeys;
+    return pKeys[*(const uint32_t*)pLhs] < pKeys[*(const uint32_t*)pRhs];
+}
+
+int benchmarkKeyValueSort(void)
+{
+    static const size_t counts[] = { 100 * 1000, 1000 * 1000, 10 * 1000 * 1000 };
+    uint32_t            seed = 0x9747b28c;
+
+    LOGF(eINFO, "Key/index sort benchmark, speedup is relative to sorting indices with a key lookup comparator");
+    for (uint32_t i = 0; i < TF_ARRAY_COUNT(counts); ++i)
+    {
+        const size_t count = counts[i];
+        float*       pSource = (float*)tf_malloc(sizeof(float) * count);
+        float*       pKeys = (float*)tf_malloc(sizeof(float) * count);
+        uint32_t*    pIndices = (uint32_t*)tf_malloc(sizeof(uint32_t) * count);
+        for (size_t j = 0; j < count; ++j)
+            pSource[j] = RANDOM_FLOAT(nextRandom(&seed));
+
+        DrawKeyLookup lookup = { pSource };
+        for (size_t j = 0; j < count; ++j)
+            pIndices[j] = (uint32_t)j;
+        int64_t start = getUSec(true);
+        sort(pIndices, count, sizeof(uint32_t), drawIndexLess, &lookup);
+        int64_t comparatorTime = getUSec(true) - start;
+        logBenchmarkTime("sort (key lookup)", count, comparatorTime, comparatorTime);
+
+        for (size_t j = 0; j < count; ++j)
+            pIndices[j] = (uint32_t)j;
+        start = benchmarkBegin(pKeys, pSource, sizeof(float) * count);
+        sortFloatKeyIndex(pKeys, pIndices, count);
+        logBenchmarkTime("sortFloatKeyIndex", count, comparatorTime, getUSec(true) - start);
+
+        tf_free(pIndices);
+        tf_free(pKeys);
+        tf_free(pSource);
+    }
+    return 0;
+}
@@ -28,6 +28,10 @@ extern "C"
 #endif // __cplusplus
 
     int testStableSort();
+    int testParallelSort();
+    int benchmarkParallelSort();
+    int testKeyValueSort();
+    int benchmarkKeyValueSort();
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,495 @@
+/*
+ * Copyright (c) 2017-2025 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "../../../../Common_3/Utilities/Interfaces/IFileSystem.h"
+#include "../../../../Common_3/Utilities/Interfaces/ILog.h"
+#include "../../../../Common_3/Utilities/Interfaces/IThread.h"
+#include "../../../../Common_3/Utilities/Interfaces/ITime.h"
+
+#include "../../../../Common_3/Utilities/Math/Algorithms.h"
+#include "../../../../Common_3/Utilities/Threading/Atomics.h"
+
+#include "../../../../Common_3/Utilities/Interfaces/IMemory.h"
+
+#define TEST_LOG_THREAD_COUNT    16
+#define TEST_LOG_MESSAGE_COUNT   256
+#define TEST_LOG_QUEUE_SIZE      64
+#define BENCHMARK_LOG_MESSAGES   512
+#define BENCHMARK_LOG_QUEUE_SIZE 4096
+
+// Offsets into a binary log message record, see the layout above LOG_BINARY_MAGIC in Log.c
+#define BINARY_LOG_MESSAGE_LEVEL     1
+#define BINARY_LOG_MESSAGE_FORMAT    33
+#define BINARY_LOG_MESSAGE_ARGS_SIZE 41
+#define BINARY_LOG_MESSAGE_ARGS      45
+
+#define BINARY_LOG_ROUND_TRIP_COUNT  24
+#define BINARY_LOG_ROUND_TRIP_LENGTH 128
+
+struct LogTestState
+{
+    // Callbacks can't be removed, the test callback ignores messages while inactive
+    bool     active;
+    bool     outOfOrder;
+    uint32_t received;
+    uint32_t lastIndex[TEST_LOG_THREAD_COUNT];
+};
+
+static struct LogTestState gLogTestState;
+
+struct LogTestThreadData
+{
+    tfrg_atomic32_t* pStartCounter;
+    int64_t*         pLatencies;
+    uint32_t         threadIndex;
+    uint32_t         messageCount;
+    bool             binary;
+};
+
+static void checkLogTestMessage(struct LogTestState* pState, uint32_t threadIndex, uint32_t index)
+{
+    if (threadIndex >= TEST_LOG_THREAD_COUNT)
+        return;
+
+    // Messages of one thread have to come out in the order they were logged
+    if (index <= pState->lastIndex[threadIndex])
+        pState->outOfOrder = true;
+    pState->lastIndex[threadIndex] = index;
+    ++pState->received;
+}
+
+// Called with the log mutex held, either by the logging thread or by the asynchronous log thread
+static void logTestCallback(void* pUserData, const char* message)
+{
+    struct LogTestState* pState = (struct LogTestState*)pUserData;
+    const char*          pTag = strstr(message, "LogTest ");
+    uint32_t             threadIndex = 0;
+    uint32_t             index = 0;
+    if (pState->active && pTag && sscanf(pTag, "LogTest %u %u", &threadIndex, &index) == 2)
+        checkLogTestMessage(pState, threadIndex, index);
+}
+
+static void logTestThreadFunc(void* pData)
+{
+    struct LogTestThreadData* pThreadData = (struct LogTestThreadData*)pData;
+
+    // Start all threads at once so that they contend for the queue
+    tfrg_atomic32_add_relaxed(pThreadData->pStartCounter, 1);
+    while (tfrg_atomic32_load_acquire(pThreadData->pStartCounter) < TEST_LOG_THREAD_COUNT)
+        threadSleep(0);
+
+    for (uint32_t i = 0; i < pThreadData->messageCount; ++i)
+    {
+        int64_t start = getUSec(true);
+        if (pThreadData->binary)
+            BLOGF(eDEBUG, "LogTest %u %u payload %f", pThreadData->threadIndex, i + 1, (double)i * 0.25);
+        else
+            LOGF(eDEBUG, "LogTest %u %u payload %f", pThreadData->threadIndex, i + 1, (double)i * 0.25);
+        if (pThreadData->pLatencies)
+            pThreadData->pLatencies[i] = getUSec(true) - start;
+    }
+}
+
+// Logs messageCount messages from each of TEST_LOG_THREAD_COUNT threads, returns the wall time in microseconds
+static int64_t runLogThreads(uint32_t messageCount, int64_t* pLatencies, bool binary)
+{
+    struct LogTestThreadData threadData[TEST_LOG_THREAD_COUNT];
+    ThreadHandle             threads[TEST_LOG_THREAD_COUNT];
+    tfrg_atomic32_t          startCounter = 0;
+
+    int64_t start = getUSec(true);
+    for (uint32_t i = 0; i < TEST_LOG_THREAD_COUNT; ++i)
+    {
+        threadData[i].pStartCounter = &startCounter;
+        threadData[i].pLatencies = pLatencies ? pLatencies + i * messageCount : NULL;
+        threadData[i].threadIndex = i;
+        threadData[i].messageCount = messageCount;
+        threadData[i].binary = binary;
+
+        ThreadDesc threadDesc = { 0 };
+        threadDesc.pFunc = logTestThreadFunc;
+        threadDesc.pData = &threadData[i];
+        snprintf(threadDesc.mThreadName, sizeof(threadDesc.mThreadName), "LogTest%u", i);
+        initThread(&threadDesc, &threads[i]);
+    }
+    for (uint32_t i = 0; i < TEST_LOG_THREAD_COUNT; ++i)
+        joinThread(threads[i]);
+    return getUSec(true) - start;
+}
+
+static void resetLogTestState(void)
+{
+    memset(&gLogTestState, 0, sizeof(gLogTestState));
+    gLogTestState.active = true;
+}
+
+int testAsyncLog(void)
+{
+    addLogCallback("LogTest", eDEBUG, &gLogTestState, logTestCallback, NULL, NULL);
+    const uint32_t totalCount = TEST_LOG_THREAD_COUNT * TEST_LOG_MESSAGE_COUNT;
+    int            ret = 0;
+
+    // A small queue makes the threads wait for the log thread all the time
+    resetLogTestState();
+    enableAsyncLog(TEST_LOG_QUEUE_SIZE, LOG_ASYNC_POLICY_BLOCK);
+    runLogThreads(TEST_LOG_MESSAGE_COUNT, NULL, false);
+    flushLog();
+    uint32_t received = gLogTestState.received;
+    disableAsyncLog();
+    gLogTestState.active = false;
+    if (received != totalCount || gLogTestState.outOfOrder)
+    {
+        LOGF(eERROR, "Async log (block): received %u of %u messages after flush, out of order %d", received, totalCount,
+             gLogTestState.outOfOrder);
+        ret = -1;
+    }
+
+    // Every message is either received or counted as dropped
+    resetLogTestState();
+    enableAsyncLog(TEST_LOG_QUEUE_SIZE, LOG_ASYNC_POLICY_DROP);
+    runLogThreads(TEST_LOG_MESSAGE_COUNT, NULL, false);
+    uint64_t dropped = getAsyncLogDroppedCount();
+    disableAsyncLog();
+    gLogTestState.active = false;
+    if (gLogTestState.received + dropped != totalCount || gLogTestState.outOfOrder)
+    {
+        LOGF(eERROR, "Async log (drop): received %u + dropped %llu of %u messages, out of order %d", gLogTestState.received,
+             (unsigned long long)dropped, totalCount, gLogTestState.outOfOrder);
+        ret = -1;
+    }
+
+    return ret;
+}
+
+static uint8_t* readBinaryLogFile(const char* fileName, size_t* pSize)
+{
+    FileStream fh = { 0 };
+    if (!fsOpenStreamFromPath(RD_LOG, fileName, FM_READ, &fh))
+    {
+        LOGF(eERROR, "Binary log: failed to open %s", fileName);
+        return NULL;
+    }
+    size_t   size = (size_t)fsGetStreamFileSize(&fh);
+    uint8_t* pData = (uint8_t*)tf_malloc(size);
+    *pSize = fsReadFromStream(&fh, pData, size);
+    fsCloseStream(&fh);
+    return pData;
+}
+
+// Returns the size of the record at pos, 0 when it is corrupted
+static uint32_t binaryLogRecordSize(const uint8_t* pData, size_t pos, size_t size)
+{
+    uint32_t recordSize = 0;
+    if (pData[pos] == 3 && pos + BINARY_LOG_MESSAGE_ARGS <= size)
+    {
+        memcpy(&recordSize, pData + pos + BINARY_LOG_MESSAGE_ARGS_SIZE, sizeof(recordSize));
+        recordSize += BINARY_LOG_MESSAGE_ARGS;
+    }
+    else if ((pData[pos] == 1 || pData[pos] == 2) && pos + 13 <= size)
+    {
+        memcpy(&recordSize, pData + pos + 9, sizeof(recordSize));
+        recordSize += 13;
+    }
+    return pos + recordSize <= size ? recordSize : 0;
+}
+
+// Formats the arguments of a binary log message one conversion at a time with 64 bit values, like BinaryLogDecoder.py does
+static void formatBinaryLogArgs(const char* fmt, const uint8_t* pArgs, uint32_t argsSize, char* pOut, size_t outSize)
+{
+    const uint8_t* pEnd = pArgs + argsSize;
+    size_t         length = 0;
+    for (const char* c = fmt; *c && length + 1 < outSize;)
+    {
+        if (*c != '%' || c[1] == '%')
+        {
+            pOut[length++] = *c;
+            c += *c == '%' ? 2 : 1;
+            continue;
+        }
+
+        char   spec[32] = "%";
+        size_t specLength = 1;
+        size_t precisionStart = 0;
+        for (++c; *c == '-' || *c == '+' || *c == ' ' || *c == '#' || *c == '0'; ++c)
+            spec[specLength++] = *c;
+        for (int part = 0; part < 2; ++part)
+        {
+            if (part == 1)
+            {
+                if (*c != '.')
+                    break;
+                precisionStart = specLength;
+                spec[specLength++] = *c++;
+            }
+            if (*c == '*' && pArgs + 9 <= pEnd)
+            {
+                int64_t value = 0;
+                memcpy(&value, pArgs + 1, sizeof(value));
+                pArgs += 9;
+                specLength += snprintf(spec + specLength, sizeof(spec) - specLength, "%d", (int)value);
+                ++c;
+            }
+            while (*c >= '0' && *c <= '9')
+                spec[specLength++] = *c++;
+        }
+        while (*c == 'h' || *c == 'l' || *c == 'j' || *c == 'z' || *c == 't' || *c == 'L' || *c == 'q')
+            ++c;
+        const char conversion = *c++;
+
+        char           tag = pArgs < pEnd ? (char)*pArgs : 0;
+        uint64_t       value = 0;
+        uint32_t       stringSize = 0;
+        const uint8_t* pString = NULL;
+        if (tag == 's' && pArgs + 5 <= pEnd)
+        {
+            memcpy(&stringSize, pArgs + 1, sizeof(stringSize));
+            pString = pArgs + 5;
+            pArgs += 5 + stringSize;
+        }
+        else if (tag && pArgs + 9 <= pEnd)
+        {
+            memcpy(&value, pArgs + 1, sizeof(value));
+            pArgs += 9;
+        }
+
+        char* pDst = pOut + length;
+        int   written = 0;
+        spec[specLength + 1] = 0;
+        if (tag == 's')
+        {
+            // Strings are stored without terminator, already cut to the precision
+            memcpy(spec + (precisionStart ? precisionStart : specLength), ".*s", 4);
+            written = snprintf(pDst, outSize - length, spec, (int)stringSize, (const char*)pString);
+        }
+        else if (tag == 'f')
+        {
+            double number = 0.0;
+            memcpy(&number, &value, sizeof(number));
+            spec[specLength] = conversion;
+            written = snprintf(pDst, outSize - length, spec, number);
+        }
+        else if (conversion == 'c')
+        {
+            spec[specLength] = conversion;
+            written = snprintf(pDst, outSize - length, spec, (int)value);
+        }
+        else if (tag == 'i' || tag == 'u')
+        {
+            memcpy(spec + specLength, "ll", 2);
+            spec[specLength + 2] = conversion;
+            spec[specLength + 3] = 0;
+            written = tag == 'i' ? snprintf(pDst, outSize - length, spec, (long long)value)
+                                 : snprintf(pDst, outSize - length, spec, (unsigned long long)value);
+        }
+        length += written > 0 ? TF_MIN((size_t)written, outSize - length - 1) : 0;
+    }
+    pOut[length] = 0;
+}
+
+// Logs every conversion the encoder handles and compares the decoded file against snprintf of the same arguments
+static int testBinaryLogRoundTrip(void)
+{
+    static const char fileName[] = "36_AlgorithmsAndContainersRoundTrip.blog";
+
+    char        expected[BINARY_LOG_ROUND_TRIP_COUNT][BINARY_LOG_ROUND_TRIP_LENGTH];
+    const char* formats[BINARY_LOG_ROUND_TRIP_COUNT];
+    uint32_t    count = 0;
+
+#define BINARY_LOG_ROUND_TRIP(fmt, ...)                                              \
+    do                                                                               \
+    {                                                                                \
+        formats[count] = fmt;                                                        \
+        snprintf(expected[count++], BINARY_LOG_ROUND_TRIP_LENGTH, fmt, __VA_ARGS__); \
+        BLOGF(eINFO, fmt, __VA_ARGS__);                                              \
+    } while (0)
+
+    if (!addBinaryLogFile(fileName, eINFO))
+        return -1;
+    BINARY_LOG_ROUND_TRIP("%d %i|%5d|%-5d|%+d|%05d", 0, -1, 42, 42, 7, -7);
+    BINARY_LOG_ROUND_TRIP("%hd %hd %hhd %hhd", 70000, -40000, 200, -129);
+    BINARY_LOG_ROUND_TRIP("%hu %hhu %hx %hhX", 70000, 300, 0x12345, 0x1ff);
+    BINARY_LOG_ROUND_TRIP("%u %x %X %o %#x %#o", 4000000000u, 0xbeefu, 0xbeefu, 8u, 255u, 15u);
+    BINARY_LOG_ROUND_TRIP("%ld %lu %lld %llu", -123456L, 123456UL, -1234567890123LL, 18446744073709551615ULL);
+    BINARY_LOG_ROUND_TRIP("%llx %zu %zd %td", 0xdeadbeefcafeULL, (size_t)42, (ssize_t)-42, (ptrdiff_t)-3);
+    BINARY_LOG_ROUND_TRIP("%f %.2f %10.3f %-10.1f|", 1.5, 3.14159, -2.0, 0.25);
+    BINARY_LOG_ROUND_TRIP("%e %E %.3g %G %g", 12345.678, 0.000123, 1234567.0, 1e-10, 100.0);
+    BINARY_LOG_ROUND_TRIP("%a %a %A %.2a", 1.5, 1.0, -0.1, 3.0);
+    BINARY_LOG_ROUND_TRIP("%c%c %3c|%-3c|", 'o', 'k', 'x', 'y');
+    BINARY_LOG_ROUND_TRIP("%s|%8s|%-8s|%.2s|%5.1s|", "abc", "abc", "abc", "abcdef", "xyz");
+    BINARY_LOG_ROUND_TRIP("%*d|%-*d|%.*f|%*.*f|%.*s|", 6, -42, 6, 42, 2, 3.14159, 8, 3, 2.5, 3, "abcdef");
+    BINARY_LOG_ROUND_TRIP("%d%% done, %s", 99, "100%");
+
+    // Levels the binary log does not record are formatted and passed to the callbacks
+    resetLogTestState();
+    BLOGF(eDEBUG | eINFO, "LogTest 0 1 multi-level");
+    gLogTestState.active = false;
+    uint32_t textReceived = gLogTestState.received;
+    closeBinaryLogFile();
+#undef BINARY_LOG_ROUND_TRIP
+    ASSERT(count <= BINARY_LOG_ROUND_TRIP_COUNT);
+
+    size_t   size = 0;
+    uint8_t* pData = readBinaryLogFile(fileName, &size);
+    if (!pData)
+        return -1;
+
+    int      ret = 0;
+    uint32_t decoded = 0;
+    uint32_t headerSize = 0;
+    memcpy(&headerSize, pData + 12, sizeof(headerSize));
+    for (size_t pos = headerSize; pos < size;)
+    {
+        const uint32_t recordSize = binaryLogRecordSize(pData, pos, size);
+        if (!recordSize)
+        {
+            ret = -1;
+            break;
+        }
+        if (pData[pos] == 3 && decoded < count)
+        {
+            uint64_t format = 0;
+            uint32_t argsSize = 0;
+            memcpy(&format, pData + pos + BINARY_LOG_MESSAGE_FORMAT, sizeof(format));
+            memcpy(&argsSize, pData + pos + BINARY_LOG_MESSAGE_ARGS_SIZE, sizeof(argsSize));
+            char message[BINARY_LOG_ROUND_TRIP_LENGTH];
+            formatBinaryLogArgs(formats[decoded], pData + pos + BINARY_LOG_MESSAGE_ARGS, argsSize, message, sizeof(message));
+            if (format != (uint64_t)(uintptr_t)formats[decoded] || strcmp(message, expected[decoded]) != 0)
+            {
+                LOGF(eERROR, "Binary log round trip of \"%s\": decoded \"%s\", expected \"%s\"", formats[decoded], message,
+                     expected[decoded]);
+                ret = -1;
+            }
+            ++decoded;
+        }
+        else if (pData[pos] == 3)
+        {
+            // The multi-level message only keeps the recorded level
+            uint32_t level = 0;
+            memcpy(&level, pData + pos + BINARY_LOG_MESSAGE_LEVEL, sizeof(level));
+            if (level != eINFO)
+                ret = -1;
+            ++decoded;
+        }
+        pos += recordSize;
+    }
+    tf_free(pData);
+
+    if (ret || decoded != count + 1 || textReceived != 1)
+    {
+        LOGF(eERROR, "Binary log round trip: %u of %u messages decoded, %u multi-level messages in the text log", decoded, count + 1,
+             textReceived);
+        return -1;
+    }
+    return 0;
+}
+
+int testBinaryLog(void)
+{
+    static const char fileName[] = "36_AlgorithmsAndContainers.blog";
+    const uint32_t    totalCount = TEST_LOG_THREAD_COUNT * TEST_LOG_MESSAGE_COUNT;
+
+    if (!addBinaryLogFile(fileName, eDEBUG))
+        return -1;
+    // The text callbacks must not see the binary messages
+    resetLogTestState();
+    runLogThreads(TEST_LOG_MESSAGE_COUNT, NULL, true);
+    closeBinaryLogFile();
+    gLogTestState.active = false;
+    uint32_t textReceived = gLogTestState.received;
+
+    size_t   size = 0;
+    uint8_t* pData = readBinaryLogFile(fileName, &size);
+    if (!pData)
+        return -1;
+
+    // Walk the records, the first two arguments of every message are the thread index and the message index
+    resetLogTestState();
+    gLogTestState.active = false;
+    uint32_t headerSize = 0;
+    memcpy(&headerSize, pData + 12, sizeof(headerSize));
+    bool corrupted = size < headerSize || memcmp(pData, "TFBINLOG", 8) != 0;
+    for (size_t pos = headerSize; !corrupted && pos < size;)
+    {
+        const uint32_t recordSize = binaryLogRecordSize(pData, pos, size);
+        corrupted = !recordSize;
+        if (!corrupted && pData[pos] == 3)
+        {
+            uint64_t threadIndex = 0;
+            uint64_t index = 0;
+            memcpy(&threadIndex, pData + pos + BINARY_LOG_MESSAGE_ARGS + 1, sizeof(threadIndex));
+            memcpy(&index, pData + pos + BINARY_LOG_MESSAGE_ARGS + 10, sizeof(index));
+            checkLogTestMessage(&gLogTestState, (uint32_t)threadIndex, (uint32_t)index);
+        }
+        pos += recordSize;
+    }
+    tf_free(pData);
+
+    if (corrupted || textReceived || gLogTestState.received != totalCount || gLogTestState.outOfOrder)
+    {
+        LOGF(eERROR, "Binary log: corrupted %d, %u messages in the file of %u, %u in the text log, out of order %d", corrupted,
+             gLogTestState.received, totalCount, textReceived, gLogTestState.outOfOrder);
+        return -1;
+    }
+    return testBinaryLogRoundTrip();
+}
+
+int benchmarkAsyncLog(void)
+{
+    static const char* modeNames[] = { "sync", "async block", "async drop", "binary" };
+
+    const uint32_t latencyCount = TEST_LOG_THREAD_COUNT * BENCHMARK_LOG_MESSAGES;
+    int64_t*       pLatencies = (int64_t*)tf_malloc(sizeof(int64_t) * latencyCount);
+    int64_t        results[TF_ARRAY_COUNT(modeNames)][5] = { { 0 } };
+    uint64_t       dropped[TF_ARRAY_COUNT(modeNames)] = { 0 };
+
+    // The benchmark messages go to the console and the log file, results are printed once all runs are done
+    for (uint32_t mode = 0; mode < TF_ARRAY_COUNT(modeNames); ++mode)
+    {
+        if (mode == 1 || mode == 2)
+            enableAsyncLog(BENCHMARK_LOG_QUEUE_SIZE, mode == 1 ? LOG_ASYNC_POLICY_BLOCK : LOG_ASYNC_POLICY_DROP);
+        if (mode == 3)
+            addBinaryLogFile("36_AlgorithmsAndContainersBenchmark.blog", eDEBUG);
+        results[mode][0] = runLogThreads(BENCHMARK_LOG_MESSAGES, pLatencies, mode == 3);
+        dropped[mode] = getAsyncLogDroppedCount();
+        disableAsyncLog();
+        closeBinaryLogFile();
+
+        sortInt64(pLatencies, latencyCount);
+        results[mode][1] = pLatencies[latencyCount / 2];
+        results[mode][2] = pLatencies[latencyCount * 99 / 100];
+        results[mode][3] = pLatencies[latencyCount * 999 / 1000];
+        results[mode][4] = pLatencies[latencyCount - 1];
+    }
+
+    LOGF(eINFO, "Log benchmark, %u threads x %u messages", TEST_LOG_THREAD_COUNT, BENCHMARK_LOG_MESSAGES);
+    for (uint32_t mode = 0; mode < TF_ARRAY_COUNT(modeNames); ++mode)
+    {
+        LOGF(eINFO, "%-11s: %8.3f ms, latency us p50 %5lld p99 %5lld p99.9 %5lld max %6lld, dropped %llu", modeNames[mode],
+             (double)results[mode][0] / 1000.0, (long long)results[mode][1], (long long)results[mode][2], (long long)results[mode][3],
+             (long long)results[mode][4], (unsigned long long)dropped[mode]);
+    }
+
+    tf_free(pLatencies);
+    return 0;
+}
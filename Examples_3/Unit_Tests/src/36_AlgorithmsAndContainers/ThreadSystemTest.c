@@ -0,0 +1,638 @@
+/*
+ * Copyright (c) 2017-2025 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include "../../../../Common_3/Utilities/Interfaces/ILog.h"
+#include "../../../../Common_3/Utilities/Interfaces/IThread.h"
+#include "../../../../Common_3/Utilities/Interfaces/ITime.h"
+
+#include "../../../../Common_3/Utilities/Math/Algorithms.h"
+#include "../../../../Common_3/Utilities/Threading/Atomics.h"
+#include "../../../../Common_3/Utilities/Threading/ThreadSystem.h"
+
+#include <math.h>
+
+#include "../../../../Common_3/Utilities/Interfaces/IMemory.h"
+
+#define TEST_TASK_COUNT           100000
+#define TEST_SINGLE_TASK_COUNT    5000
+#define TEST_NESTED_TASK_COUNT    64
+#define TEST_NESTED_SUBTASK_COUNT 256
+#define TEST_GRAPH_TASK_COUNT     1024
+#define TEST_FAN_OUT_COUNT        8
+
+#define BENCHMARK_FRAME_COUNT     64
+#define BENCHMARK_TASK_WORK       256
+#define BENCHMARK_PARALLEL_COUNT  (4 * 1024 * 1024)
+#define BENCHMARK_PARALLEL_RUNS   8
+
+static const char* gSchedulerNames[] = { "SharedQueue", "WorkStealing" };
+
+struct TestTaskData
+{
+    tfrg_atomic32_t* pCounters;
+    ThreadSystem     threadSystem;
+    uint32_t         index;
+};
+
+static tfrg_atomic32_t gTestNullUserCounter;
+
+static void testIncrementTask(void* pUser, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    tfrg_atomic32_add_relaxed((tfrg_atomic32_t*)pUser, 1);
+}
+
+static void testNullUserTask(void* pUser, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    ASSERT(pUser == NULL);
+    tfrg_atomic32_add_relaxed(&gTestNullUserCounter, 1);
+}
+
+static void testNestedTask(void* pUser, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    struct TestTaskData* pData = (struct TestTaskData*)pUser;
+    threadSystemAddTasks(pData->threadSystem, testIncrementTask, TEST_NESTED_SUBTASK_COUNT, sizeof(tfrg_atomic32_t),
+                         (void*)(pData->pCounters + pData->index * TEST_NESTED_SUBTASK_COUNT));
+}
+
+static int checkCounters(const char* testName, ThreadSystemScheduler scheduler, tfrg_atomic32_t* pCounters, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (pCounters[i] != 1)
+        {
+            LOGF(eERROR, "%s (%s): task %u executed %u times", testName, gSchedulerNames[scheduler], i, pCounters[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int testThreadSystemScheduler(ThreadSystemScheduler scheduler)
+{
+    struct ThreadSystemInitDesc desc = gThreadSystemInitDescDefault;
+    desc.scheduler = scheduler;
+    desc.threadName = "TestThreadSystem";
+
+    ThreadSystem threadSystem = NULL;
+    if (!threadSystemInit(&threadSystem, &desc))
+        return -1;
+
+    int              ret = 0;
+    tfrg_atomic32_t* pCounters = (tfrg_atomic32_t*)tf_calloc(TEST_TASK_COUNT, sizeof(tfrg_atomic32_t));
+
+    // One large group
+    threadSystemAddTasks(threadSystem, testIncrementTask, TEST_TASK_COUNT, sizeof(tfrg_atomic32_t), (void*)pCounters);
+    threadSystemWaitIdle(threadSystem);
+    ret |= checkCounters("Large group", scheduler, pCounters, TEST_TASK_COUNT);
+
+    // Many single tasks, more than fits into any internal queue
+    memset((void*)pCounters, 0, TEST_TASK_COUNT * sizeof(tfrg_atomic32_t));
+    for (uint32_t i = 0; i < TEST_SINGLE_TASK_COUNT; ++i)
+        threadSystemAddTask(threadSystem, testIncrementTask, (void*)(pCounters + i));
+    threadSystemWaitIdle(threadSystem);
+    ret |= checkCounters("Single tasks", scheduler, pCounters, TEST_SINGLE_TASK_COUNT);
+
+    // Tasks without user data
+    gTestNullUserCounter = 0;
+    threadSystemAddTasks(threadSystem, testNullUserTask, TEST_TASK_COUNT, 0, NULL);
+    threadSystemWaitIdle(threadSystem);
+    if (gTestNullUserCounter != TEST_TASK_COUNT)
+    {
+        LOGF(eERROR, "Null user tasks (%s): executed %u of %u", gSchedulerNames[scheduler], gTestNullUserCounter, TEST_TASK_COUNT);
+        ret = -1;
+    }
+
+    // Tasks adding tasks from worker threads
+    memset((void*)pCounters, 0, TEST_TASK_COUNT * sizeof(tfrg_atomic32_t));
+    struct TestTaskData nested[TEST_NESTED_TASK_COUNT];
+    for (uint32_t i = 0; i < TEST_NESTED_TASK_COUNT; ++i)
+        nested[i] = (struct TestTaskData){ pCounters, threadSystem, i };
+    threadSystemAddTaskGroup(threadSystem, testNestedTask, TEST_NESTED_TASK_COUNT, nested);
+    threadSystemWaitIdle(threadSystem);
+    ret |= checkCounters("Nested tasks", scheduler, pCounters, TEST_NESTED_TASK_COUNT * TEST_NESTED_SUBTASK_COUNT);
+
+    // Calling thread participates
+    memset((void*)pCounters, 0, TEST_TASK_COUNT * sizeof(tfrg_atomic32_t));
+    threadSystemAddTasks(threadSystem, testIncrementTask, TEST_TASK_COUNT, sizeof(tfrg_atomic32_t), (void*)pCounters);
+    while (threadSystemAssist(threadSystem))
+        ;
+    threadSystemWaitIdle(threadSystem);
+    ret |= checkCounters("Assist", scheduler, pCounters, TEST_TASK_COUNT);
+
+    if (!threadSystemIsIdle(threadSystem))
+    {
+        LOGF(eERROR, "Thread system (%s) is not idle after all tasks finished", gSchedulerNames[scheduler]);
+        ret = -1;
+    }
+
+    threadSystemExit(&threadSystem, &gThreadSystemExitDescDefault);
+    tf_free((void*)pCounters);
+    return ret;
+}
+
+/************************************************************************/
+// Task graphs
+/************************************************************************/
+struct TestGraphTask
+{
+    tfrg_atomic32_t* pClock;
+    uint32_t         start;
+    uint32_t         end;
+};
+
+struct TestGraphStage
+{
+    struct TestGraphTask          tasks[TEST_GRAPH_TASK_COUNT];
+    struct ThreadSystemJoinHandle handle;
+};
+
+static void testGraphTask(void* pUser, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    struct TestGraphTask* pTask = (struct TestGraphTask*)pUser;
+    pTask->start = tfrg_atomic32_add_relaxed(pTask->pClock, 1) + 1;
+    // Give other threads a chance to run tasks of the dependent stages too early
+    for (volatile uint32_t i = 0; i < 64; ++i)
+        ;
+    pTask->end = tfrg_atomic32_add_relaxed(pTask->pClock, 1) + 1;
+}
+
+static void addGraphStage(ThreadSystem threadSystem, struct TestGraphStage* pStage, tfrg_atomic32_t* pClock, uint32_t taskCount,
+                          uint32_t dependencyCount, struct ThreadSystemJoinHandle* const* dependencies)
+{
+    for (uint32_t i = 0; i < taskCount; ++i)
+        pStage->tasks[i] = (struct TestGraphTask){ pClock, 0, 0 };
+
+    struct ThreadSystemDependentTasksDesc desc = { 0 };
+    desc.func = testGraphTask;
+    desc.count = taskCount;
+    desc.userSize = sizeof(struct TestGraphTask);
+    desc.userArray = pStage->tasks;
+    desc.dependencies = dependencies;
+    desc.dependencyCount = dependencyCount;
+    threadSystemAddDependentTasks(threadSystem, &desc, &pStage->handle);
+}
+
+// Returns true if every task of 'pFirst' finished before any task of 'pSecond' started
+static bool checkGraphOrder(const char* testName, const char* schedulerName, const struct TestGraphStage* pFirst, uint32_t firstCount,
+                            const struct TestGraphStage* pSecond, uint32_t secondCount)
+{
+    uint32_t firstEnd = 0;
+    uint32_t secondStart = UINT32_MAX;
+    for (uint32_t i = 0; i < firstCount; ++i)
+        firstEnd = TF_MAX(firstEnd, pFirst->tasks[i].end);
+    for (uint32_t i = 0; i < secondCount; ++i)
+        secondStart = TF_MIN(secondStart, pSecond->tasks[i].start);
+
+    if (firstEnd == 0 || secondStart == 0 || firstEnd > secondStart)
+    {
+        LOGF(eERROR, "%s (%s): dependency violated, last end %u, first dependent start %u", testName, schedulerName, firstEnd, secondStart);
+        return false;
+    }
+    return true;
+}
+
+static int testThreadSystemGraphs(ThreadSystem threadSystem, const char* schedulerName)
+{
+    int             ret = 0;
+    tfrg_atomic32_t clock = 0;
+
+    struct TestGraphStage* pStages = (struct TestGraphStage*)tf_calloc(TEST_FAN_OUT_COUNT + 3, sizeof(struct TestGraphStage));
+
+    // Diamond: A -> (B, C) -> D
+    {
+        struct TestGraphStage* a = &pStages[0];
+        struct TestGraphStage* b = &pStages[1];
+        struct TestGraphStage* c = &pStages[2];
+        struct TestGraphStage* d = &pStages[3];
+
+        struct ThreadSystemJoinHandle* depsA[] = { &a->handle };
+        struct ThreadSystemJoinHandle* depsD[] = { &b->handle, &c->handle };
+
+        addGraphStage(threadSystem, a, &clock, TEST_GRAPH_TASK_COUNT, 0, NULL);
+        addGraphStage(threadSystem, b, &clock, TEST_GRAPH_TASK_COUNT, 1, depsA);
+        addGraphStage(threadSystem, c, &clock, TEST_GRAPH_TASK_COUNT, 1, depsA);
+        addGraphStage(threadSystem, d, &clock, TEST_GRAPH_TASK_COUNT, 2, depsD);
+        threadSystemJoin(threadSystem, &d->handle);
+
+        if (!threadSystemIsJoinHandleDone(&a->handle) || !threadSystemIsJoinHandleDone(&b->handle) ||
+            !threadSystemIsJoinHandleDone(&c->handle))
+        {
+            LOGF(eERROR, "Diamond (%s): dependencies not done after join", schedulerName);
+            ret = -1;
+        }
+
+        if (!checkGraphOrder("Diamond A->B", schedulerName, a, TEST_GRAPH_TASK_COUNT, b, TEST_GRAPH_TASK_COUNT) ||
+            !checkGraphOrder("Diamond A->C", schedulerName, a, TEST_GRAPH_TASK_COUNT, c, TEST_GRAPH_TASK_COUNT) ||
+            !checkGraphOrder("Diamond B->D", schedulerName, b, TEST_GRAPH_TASK_COUNT, d, TEST_GRAPH_TASK_COUNT) ||
+            !checkGraphOrder("Diamond C->D", schedulerName, c, TEST_GRAPH_TASK_COUNT, d, TEST_GRAPH_TASK_COUNT))
+            ret = -1;
+    }
+
+    // Fan-out/fan-in: root -> TEST_FAN_OUT_COUNT stages -> empty join -> last
+    {
+        struct TestGraphStage* root = &pStages[0];
+        struct TestGraphStage* fan = &pStages[1];
+        struct TestGraphStage* last = &pStages[TEST_FAN_OUT_COUNT + 1];
+
+        struct ThreadSystemJoinHandle  join;
+        struct ThreadSystemJoinHandle* depsRoot[] = { &root->handle };
+        struct ThreadSystemJoinHandle* depsFan[TEST_FAN_OUT_COUNT];
+        struct ThreadSystemJoinHandle* depsJoin[] = { &join };
+
+        addGraphStage(threadSystem, root, &clock, 1, 0, NULL);
+        for (uint32_t i = 0; i < TEST_FAN_OUT_COUNT; ++i)
+        {
+            addGraphStage(threadSystem, &fan[i], &clock, TEST_GRAPH_TASK_COUNT, 1, depsRoot);
+            depsFan[i] = &fan[i].handle;
+        }
+
+        struct ThreadSystemDependentTasksDesc joinDesc = { 0 };
+        joinDesc.dependencies = depsFan;
+        joinDesc.dependencyCount = TEST_FAN_OUT_COUNT;
+        threadSystemAddDependentTasks(threadSystem, &joinDesc, &join);
+
+        addGraphStage(threadSystem, last, &clock, 1, 1, depsJoin);
+        threadSystemJoin(threadSystem, &last->handle);
+
+        for (uint32_t i = 0; i < TEST_FAN_OUT_COUNT; ++i)
+        {
+            if (!checkGraphOrder("Fan-out", schedulerName, root, 1, &fan[i], TEST_GRAPH_TASK_COUNT) ||
+                !checkGraphOrder("Fan-in", schedulerName, &fan[i], TEST_GRAPH_TASK_COUNT, last, 1))
+                ret = -1;
+        }
+    }
+
+    // Dependency which is already done
+    {
+        struct TestGraphStage*         first = &pStages[0];
+        struct TestGraphStage*         second = &pStages[1];
+        struct ThreadSystemJoinHandle* deps[] = { &first->handle, NULL };
+
+        addGraphStage(threadSystem, first, &clock, TEST_GRAPH_TASK_COUNT, 0, NULL);
+        threadSystemJoin(threadSystem, &first->handle);
+        addGraphStage(threadSystem, second, &clock, TEST_GRAPH_TASK_COUNT, 2, deps);
+        threadSystemJoin(threadSystem, &second->handle);
+
+        if (!checkGraphOrder("Done dependency", schedulerName, first, TEST_GRAPH_TASK_COUNT, second, TEST_GRAPH_TASK_COUNT))
+            ret = -1;
+    }
+
+    // Too many dependencies, tasks are rejected and the handle is done right away
+    {
+        struct ThreadSystemJoinHandle         rejected;
+        struct ThreadSystemJoinHandle*        deps[THREAD_SYSTEM_MAX_DEPENDENCIES + 1] = { 0 };
+        struct ThreadSystemDependentTasksDesc desc = { 0 };
+        desc.dependencies = deps;
+        desc.dependencyCount = THREAD_SYSTEM_MAX_DEPENDENCIES + 1;
+        if (threadSystemAddDependentTasks(threadSystem, &desc, &rejected) || !threadSystemIsJoinHandleDone(&rejected))
+        {
+            LOGF(eERROR, "Too many dependencies (%s): tasks weren't rejected", schedulerName);
+            ret = -1;
+        }
+        threadSystemJoin(threadSystem, &rejected);
+    }
+
+    threadSystemWaitIdle(threadSystem);
+    tf_free(pStages);
+    return ret;
+}
+
+/************************************************************************/
+// Parallel for / reduce
+/************************************************************************/
+struct TestParallelData
+{
+    tfrg_atomic32_t* pCounters;
+    uint64_t         count;
+    uint64_t         grainSize;
+    tfrg_atomic32_t  badChunkCount;
+};
+
+static void testParallelForFunc(void* pUser, uint64_t begin, uint64_t end, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    struct TestParallelData* pData = (struct TestParallelData*)pUser;
+    // All chunks but the last one have exactly grainSize elements
+    if (begin >= end || (pData->grainSize && end - begin != pData->grainSize && end != pData->count))
+        tfrg_atomic32_add_relaxed(&pData->badChunkCount, 1);
+    for (uint64_t i = begin; i < end; ++i)
+        tfrg_atomic32_add_relaxed(&pData->pCounters[i], 1);
+}
+
+static void testParallelSumFunc(void* pUser, uint64_t begin, uint64_t end, void* pResult, uint64_t threadId)
+{
+    UNREF_PARAM(pUser);
+    UNREF_PARAM(threadId);
+    for (uint64_t i = begin; i < end; ++i)
+        *(uint64_t*)pResult += i;
+}
+
+static void testParallelSumCombine(void* pUser, void* pLhs, const void* pRhs)
+{
+    UNREF_PARAM(pUser);
+    *(uint64_t*)pLhs += *(const uint64_t*)pRhs;
+}
+
+static void testParallelFloatSumFunc(void* pUser, uint64_t begin, uint64_t end, void* pResult, uint64_t threadId)
+{
+    UNREF_PARAM(pUser);
+    UNREF_PARAM(threadId);
+    for (uint64_t i = begin; i < end; ++i)
+        *(float*)pResult += 1.0f / (float)(i + 1);
+}
+
+static void testParallelFloatSumCombine(void* pUser, void* pLhs, const void* pRhs)
+{
+    UNREF_PARAM(pUser);
+    *(float*)pLhs += *(const float*)pRhs;
+}
+
+static int testThreadSystemParallel(ThreadSystem threadSystem, const char* schedulerName)
+{
+    static const uint64_t counts[] = { 0, 1, 7, 1000, 100003 };
+    static const uint64_t grainSizes[] = { 0, 1, 64, 1 << 20 };
+
+    tfrg_atomic32_t* pCounters = (tfrg_atomic32_t*)tf_calloc(100003, sizeof(tfrg_atomic32_t));
+    int              ret = 0;
+
+    for (uint32_t ci = 0; ci < TF_ARRAY_COUNT(counts); ++ci)
+    {
+        for (uint32_t gi = 0; gi < TF_ARRAY_COUNT(grainSizes); ++gi)
+        {
+            uint64_t count = counts[ci];
+            memset((void*)pCounters, 0, count * sizeof(tfrg_atomic32_t));
+
+            struct TestParallelData data = { pCounters, count, grainSizes[gi], 0 };
+            threadSystemParallelFor(threadSystem, count, grainSizes[gi], testParallelForFunc, &data);
+            if (data.badChunkCount || checkCounters("Parallel for", 0, pCounters, (uint32_t)count) != 0)
+            {
+                LOGF(eERROR, "Parallel for (%s) failed, count %llu grain size %llu", schedulerName, (unsigned long long)count,
+                     (unsigned long long)grainSizes[gi]);
+                ret = -1;
+            }
+
+            uint64_t identity = 0;
+            uint64_t sum = UINT64_MAX;
+            threadSystemParallelReduce(threadSystem, count, grainSizes[gi], sizeof(sum), &identity, testParallelSumFunc,
+                                       testParallelSumCombine, NULL, &sum);
+            if (sum != (count ? count * (count - 1) / 2 : 0))
+            {
+                LOGF(eERROR, "Parallel reduce (%s) failed, count %llu grain size %llu, sum %llu", schedulerName, (unsigned long long)count,
+                     (unsigned long long)grainSizes[gi], (unsigned long long)sum);
+                ret = -1;
+            }
+        }
+    }
+
+    // Floating point result has to be the same on every run
+    float floatIdentity = 0.0f;
+    float floatSums[2] = { 0 };
+    for (uint32_t i = 0; i < TF_ARRAY_COUNT(floatSums); ++i)
+        threadSystemParallelReduce(threadSystem, 100003, 100, sizeof(float), &floatIdentity, testParallelFloatSumFunc,
+                                   testParallelFloatSumCombine, NULL, &floatSums[i]);
+    if (memcmp(&floatSums[0], &floatSums[1], sizeof(float)) != 0)
+    {
+        LOGF(eERROR, "Parallel reduce (%s) is not deterministic: %f != %f", schedulerName, floatSums[0], floatSums[1]);
+        ret = -1;
+    }
+
+    tf_free((void*)pCounters);
+    return ret;
+}
+
+int testThreadSystem(void)
+{
+    if (testThreadSystemScheduler(THREAD_SYSTEM_SCHEDULER_SHARED_QUEUE) != 0)
+        return -1;
+    if (testThreadSystemScheduler(THREAD_SYSTEM_SCHEDULER_WORK_STEALING) != 0)
+        return -1;
+
+    for (uint32_t scheduler = 0; scheduler < TF_ARRAY_COUNT(gSchedulerNames); ++scheduler)
+    {
+        struct ThreadSystemInitDesc desc = gThreadSystemInitDescDefault;
+        desc.scheduler = (ThreadSystemScheduler)scheduler;
+        desc.threadName = "TestThreadSystem";
+
+        ThreadSystem threadSystem = NULL;
+        if (!threadSystemInit(&threadSystem, &desc))
+            return -1;
+        int ret = testThreadSystemGraphs(threadSystem, gSchedulerNames[scheduler]);
+        ret |= testThreadSystemParallel(threadSystem, gSchedulerNames[scheduler]);
+        threadSystemExit(&threadSystem, &gThreadSystemExitDescDefault);
+        if (ret != 0)
+            return -1;
+    }
+
+    // Dummy mode, everything is executed on the calling thread
+    if (testThreadSystemGraphs(NULL, "Dummy") != 0)
+        return -1;
+    if (testThreadSystemParallel(NULL, "Dummy") != 0)
+        return -1;
+
+    return 0;
+}
+
+/************************************************************************/
+// Benchmarks
+/************************************************************************/
+struct BenchmarkTaskData
+{
+    int64_t  submitTime;
+    int64_t  latency;
+    uint32_t result;
+};
+
+static void benchmarkTask(void* pUser, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    struct BenchmarkTaskData* pData = (struct BenchmarkTaskData*)pUser;
+    pData->latency = getUSec(true) - pData->submitTime;
+
+    // Tiny amount of work, so that queue overhead dominates
+    uint32_t x = (uint32_t)pData->submitTime;
+    for (uint32_t i = 0; i < BENCHMARK_TASK_WORK; ++i)
+        x = x * 1664525u + 1013904223u;
+    pData->result = x;
+}
+
+static void benchmarkThreadSystemScheduler(ThreadSystemScheduler scheduler, uint32_t taskCount, bool singleTasks)
+{
+    struct ThreadSystemInitDesc desc = gThreadSystemInitDescDefault;
+    desc.scheduler = scheduler;
+    desc.threadName = "BenchThreadSystem";
+
+    ThreadSystem threadSystem = NULL;
+    if (!threadSystemInit(&threadSystem, &desc))
+        return;
+
+    struct BenchmarkTaskData* pTasks = (struct BenchmarkTaskData*)tf_calloc(taskCount, sizeof(struct BenchmarkTaskData));
+    int64_t*                  pLatencies = (int64_t*)tf_malloc(sizeof(int64_t) * taskCount * BENCHMARK_FRAME_COUNT);
+
+    int64_t totalTime = 0;
+    for (uint32_t frame = 0; frame < BENCHMARK_FRAME_COUNT; ++frame)
+    {
+        int64_t start = getUSec(true);
+        for (uint32_t i = 0; i < taskCount; ++i)
+            pTasks[i].submitTime = start;
+
+        if (singleTasks)
+        {
+            for (uint32_t i = 0; i < taskCount; ++i)
+                threadSystemAddTask(threadSystem, benchmarkTask, pTasks + i);
+        }
+        else
+        {
+            threadSystemAddTaskGroup(threadSystem, benchmarkTask, taskCount, pTasks);
+        }
+        while (threadSystemAssist(threadSystem))
+            ;
+        threadSystemWaitIdle(threadSystem);
+        totalTime += getUSec(true) - start;
+
+        for (uint32_t i = 0; i < taskCount; ++i)
+            pLatencies[frame * taskCount + i] = pTasks[i].latency;
+    }
+
+    uint64_t latencyCount = (uint64_t)taskCount * BENCHMARK_FRAME_COUNT;
+    sortInt64(pLatencies, latencyCount);
+
+    double tasksPerSecond = (double)latencyCount * 1e6 / (double)(totalTime ? totalTime : 1);
+    LOGF(eINFO, "%-12s %-6s tasks %6u: %10.0f tasks/s, latency us p50 %5lld p99 %5lld p99.9 %5lld max %5lld", gSchedulerNames[scheduler],
+         singleTasks ? "single" : "group", taskCount, tasksPerSecond, (long long)pLatencies[latencyCount / 2],
+         (long long)pLatencies[latencyCount * 99 / 100], (long long)pLatencies[latencyCount * 999 / 1000],
+         (long long)pLatencies[latencyCount - 1]);
+
+    tf_free(pLatencies);
+    tf_free(pTasks);
+    threadSystemExit(&threadSystem, &gThreadSystemExitDescDefault);
+}
+
+int benchmarkThreadSystem(void)
+{
+    static const uint32_t taskCounts[] = { 64, 1024, 16384 };
+
+    LOGF(eINFO, "ThreadSystem benchmark, %u frames per run", BENCHMARK_FRAME_COUNT);
+    for (uint32_t i = 0; i < TF_ARRAY_COUNT(taskCounts); ++i)
+    {
+        for (uint32_t single = 0; single < 2; ++single)
+        {
+            benchmarkThreadSystemScheduler(THREAD_SYSTEM_SCHEDULER_SHARED_QUEUE, taskCounts[i], single);
+            benchmarkThreadSystemScheduler(THREAD_SYSTEM_SCHEDULER_WORK_STEALING, taskCounts[i], single);
+        }
+    }
+    return 0;
+}
+
+struct BenchmarkParallelData
+{
+    const float* pInput;
+    float*       pOutput;
+};
+
+static void benchmarkParallelForFunc(void* pUser, uint64_t begin, uint64_t end, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    struct BenchmarkParallelData* pData = (struct BenchmarkParallelData*)pUser;
+    for (uint64_t i = begin; i < end; ++i)
+        pData->pOutput[i] = sqrtf(pData->pInput[i]) * 0.5f + pData->pInput[i] * pData->pInput[i];
+}
+
+static void benchmarkParallelReduceFunc(void* pUser, uint64_t begin, uint64_t end, void* pResult, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    struct BenchmarkParallelData* pData = (struct BenchmarkParallelData*)pUser;
+    double                        sum = 0.0;
+    for (uint64_t i = begin; i < end; ++i)
+        sum += sqrt((double)pData->pInput[i]);
+    *(double*)pResult += sum;
+}
+
+static void benchmarkParallelCombineFunc(void* pUser, void* pLhs, const void* pRhs)
+{
+    UNREF_PARAM(pUser);
+    *(double*)pLhs += *(const double*)pRhs;
+}
+
+int benchmarkParallelFor(void)
+{
+    struct BenchmarkParallelData data = { 0 };
+    data.pInput = (float*)tf_malloc(sizeof(float) * BENCHMARK_PARALLEL_COUNT);
+    data.pOutput = (float*)tf_malloc(sizeof(float) * BENCHMARK_PARALLEL_COUNT);
+    for (uint32_t i = 0; i < BENCHMARK_PARALLEL_COUNT; ++i)
+        ((float*)data.pInput)[i] = (float)(i % 1000);
+
+    uint32_t coreCount = getNumCPUCores();
+    int64_t  baseTimes[2] = { 0 };
+
+    LOGF(eINFO, "Parallel for/reduce benchmark, %u elements, best of %u runs", BENCHMARK_PARALLEL_COUNT, BENCHMARK_PARALLEL_RUNS);
+    for (uint32_t cores = 1; cores <= coreCount; cores = cores < coreCount ? TF_MIN(cores * 2, coreCount) : coreCount + 1)
+    {
+        // Calling thread is one of the cores, 0 worker threads is the dummy mode
+        struct ThreadSystemInitDesc desc = gThreadSystemInitDescDefault;
+        desc.scheduler = THREAD_SYSTEM_SCHEDULER_WORK_STEALING;
+        desc.threadCount = cores - 1;
+        desc.threadName = "BenchParallelFor";
+
+        ThreadSystem threadSystem = NULL;
+        if (!threadSystemInit(&threadSystem, &desc))
+            break;
+
+        int64_t bestTimes[2] = { INT64_MAX, INT64_MAX };
+        double  result = 0.0;
+        for (uint32_t run = 0; run < BENCHMARK_PARALLEL_RUNS; ++run)
+        {
+            int64_t start = getUSec(true);
+            threadSystemParallelFor(threadSystem, BENCHMARK_PARALLEL_COUNT, 0, benchmarkParallelForFunc, &data);
+            int64_t middle = getUSec(true);
+
+            double identity = 0.0;
+            threadSystemParallelReduce(threadSystem, BENCHMARK_PARALLEL_COUNT, 0, sizeof(double), &identity, benchmarkParallelReduceFunc,
+                                       benchmarkParallelCombineFunc, &data, &result);
+            int64_t end = getUSec(true);
+
+            bestTimes[0] = TF_MIN(bestTimes[0], middle - start);
+            bestTimes[1] = TF_MIN(bestTimes[1], end - middle);
+        }
+        threadSystemExit(&threadSystem, &gThreadSystemExitDescDefault);
+
+        if (cores == 1)
+        {
+            baseTimes[0] = bestTimes[0];
+            baseTimes[1] = bestTimes[1];
+        }
+
+        LOGF(eINFO, "cores %2u: for %8.3f ms (x%5.2f), reduce %8.3f ms (x%5.2f), result %f", cores, (double)bestTimes[0] / 1000.0,
+             (double)baseTimes[0] / (double)TF_MAX(bestTimes[0], 1), (double)bestTimes[1] / 1000.0,
+             (double)baseTimes[1] / (double)TF_MAX(bestTimes[1], 1), result);
+    }
+
+    tf_free(data.pOutput);
+    tf_free((void*)data.pInput);
+    return 0;
+}